@@ -4,11 +4,14 @@
 #include <cassert>
 #include <chrono>
 #include <exception>
+#include <future>
 #include <memory>
+#include <stdexcept>
 #include <mutex>
 #include <string>
 #include <string_view>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include <Utils/PluginManager.hpp>
@@ -33,7 +36,27 @@ namespace Bot
 
 using namespace std::literals;
 
-ElanorBot::ElanorBot() = default;
+namespace
+{
+
+const Utils::ConfigKey PLUGINS_FOLDER_KEY("/path/PluginsFolder");
+const Utils::ConfigKey BOT_FOLDER_KEY("/path/BotFolder");
+const Utils::ConfigKey SUID_KEY("/suid");
+const Utils::ConfigKey LOG_KEY("/log");
+const Utils::ConfigKey LOG_CONSOLE_KEY("/log/console");
+const Utils::ConfigKey LOG_FILES_KEY("/log/files");
+
+std::string FormatDuration(std::chrono::nanoseconds duration)
+{
+	return std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(duration).count()) + "ms";
+}
+
+} // namespace
+
+ElanorBot::ElanorBot()
+{
+	this->_LogSubscription = this->_config.Subscribe(LOG_KEY, [this] { this->_ConfigureLogger(); });
+}
 
 void ElanorBot::_run()
 {
@@ -49,113 +72,334 @@ void ElanorBot::_stop()
 	this->_running = false;
 }
 
-void ElanorBot::_LoadPlugins(const std::filesystem::path& folder)
+bool ElanorBot::PluginSlot::acquire()
 {
-	for (const auto& entry : std::filesystem::directory_iterator(folder))
+	this->InFlight++;
+	// Checked after the increment, so that unloading either sees this call or this call sees the slot inactive
+	if (this->active) return true;
+	this->release();
+	return false;
+}
+
+void ElanorBot::PluginSlot::release()
+{
+	if (--this->InFlight == 0)
 	{
-		if (entry.is_regular_file())
-		{
-			try
-			{
-				PluginLibrary lib;
-				lib.Open(entry.path());
+		std::lock_guard<std::mutex> lk(this->mtx);
+		this->cv.notify_all();
+	}
+}
 
-				if (!lib.GetSym("ApiTable"))
-				{
-					LOG_WARN(Utils::GetLogger(),
-					         "Failed to load symbol `ApiTable` from plugin " + entry.path().filename().string()
-					             + ", plugin ignored");
-					lib.Close();
-					continue;
-				}
+void ElanorBot::PluginSlot::drain()
+{
+	this->active = false;
+	std::unique_lock<std::mutex> lk(this->mtx);
+	this->cv.wait(lk, [this] { return this->InFlight == 0; });
+}
 
-				this->_plugins.emplace_back(std::move(lib));
-			}
-			catch (const std::exception& e)
-			{
-				LOG_WARN(Utils::GetLogger(), e.what());
-			}
-		}
+void ElanorBot::PluginSlot::unload()
+{
+	// Commands and triggers are deleted by the library, so they must go before it is closed
+	this->commands.clear();
+	this->triggers.clear();
+	if (!this->lib.IsOpen()) return;
+
+	API* ApiTable = static_cast<API*>(this->lib.GetSym("ApiTable"));
+	if (ApiTable)
+		ApiTable->ClosePlugin();
+	else
+		LOG_WARN(Utils::GetLogger(), "Failed to close plugin " + this->name + ", the library may be overwritten.");
+	this->lib.Close();
+}
+
+std::shared_ptr<ElanorBot::PluginSlot> ElanorBot::_LoadPlugin(const std::filesystem::path& path, LoadTimings& timings)
+{
+	using Clock = std::chrono::steady_clock;
+
+	auto slot = std::make_shared<PluginSlot>();
+	slot->name = path.stem().string();
+	slot->path = path;
+
+	auto begin = Clock::now();
+	try
+	{
+		slot->lib.Open(path);
+	}
+	catch (const std::exception& e)
+	{
+		LOG_WARN(Utils::GetLogger(), e.what());
+		return nullptr;
 	}
+	timings.dlopen += Clock::now() - begin;
 
-	for (int i = 0; i < this->_plugins.size(); i++)
+	API* ApiTable = static_cast<API*>(slot->lib.GetSym("ApiTable"));
+	if (!ApiTable)
 	{
-		const auto& plugin = this->_plugins.at(i);
-		API* ApiTable = static_cast<API*>(plugin.GetSym("ApiTable"));
+		LOG_WARN(Utils::GetLogger(),
+		         "Failed to load symbol `ApiTable` from plugin " + path.filename().string() + ", plugin ignored");
+		slot->lib.Close();
+		return nullptr;
+	}
 
-		ApiTable->InitPlugin();
-		LOG_INFO(Utils::GetLogger(), "Loaded plugin "s + ApiTable->GetPluginName() + ": " + ApiTable->GetPluginInfo());
+	{
+		std::lock_guard<std::mutex> lk(this->_InitMtx);
+		begin = Clock::now();
+		ApiTable->InitPlugin(this->_config);
+		timings.init += Clock::now() - begin;
+	}
+	LOG_INFO(Utils::GetLogger(), "Loaded plugin "s + ApiTable->GetPluginName() + ": " + ApiTable->GetPluginInfo());
 
-		size_t command_count = ApiTable->GetGroupCommandCount();
-		size_t trigger_count = ApiTable->GetTriggerCount();
-		LOG_DEBUG(Utils::GetLogger(),
-		          "Found "s + std::to_string(command_count) + " Group Commands, " + std::to_string(trigger_count)
-		              + " Triggers");
+	size_t command_count = ApiTable->GetGroupCommandCount();
+	size_t trigger_count = ApiTable->GetTriggerCount();
+	LOG_DEBUG(Utils::GetLogger(),
+	          "Found "s + std::to_string(command_count) + " Group Commands, " + std::to_string(trigger_count)
+	              + " Triggers");
 
-		auto command_deleter = ApiTable->DeleteGroupCommand;
-		auto trigger_deleter = ApiTable->DeleteTrigger;
+	begin = Clock::now();
+	auto command_deleter = ApiTable->DeleteGroupCommand;
+	auto trigger_deleter = ApiTable->DeleteTrigger;
 
-		for (size_t idx = 0; idx < command_count; idx++)
-		{
-			this->_GroupCommands.emplace_back(
-				ApiTable->GetGroupCommandName(idx),
-				std::move(std::unique_ptr<GroupCommand::IGroupCommand, void (*)(GroupCommand::IGroupCommand*)>{
-					ApiTable->GetGroupCommand(idx), command_deleter}),
-				i);
-			LOG_DEBUG(Utils::GetLogger(), string(ApiTable->GetGroupCommandName(idx)) + " <GroupCommand> loaded");
-		}
+	for (size_t idx = 0; idx < command_count; idx++)
+	{
+		slot->commands.emplace_back(
+			ApiTable->GetGroupCommandName(idx),
+			std::unique_ptr<GroupCommand::IGroupCommand, void (*)(GroupCommand::IGroupCommand*)>{
+				ApiTable->GetGroupCommand(idx), command_deleter});
+		LOG_DEBUG(Utils::GetLogger(), string(ApiTable->GetGroupCommandName(idx)) + " <GroupCommand> loaded");
+	}
 
-		for (size_t idx = 0; idx < trigger_count; idx++)
-		{
-			this->_triggers.emplace_back(ApiTable->GetTriggerName(idx),
-			                             std::move(std::unique_ptr<Trigger::ITrigger, void (*)(Trigger::ITrigger*)>{
-											 ApiTable->GetTrigger(idx), trigger_deleter}),
-			                             i);
-			LOG_DEBUG(Utils::GetLogger(), string(ApiTable->GetTriggerName(idx)) + " <Trigger> loaded");
-		}
+	for (size_t idx = 0; idx < trigger_count; idx++)
+	{
+		slot->triggers.emplace_back(ApiTable->GetTriggerName(idx),
+		                            std::unique_ptr<Trigger::ITrigger, void (*)(Trigger::ITrigger*)>{
+										ApiTable->GetTrigger(idx), trigger_deleter});
+		LOG_DEBUG(Utils::GetLogger(), string(ApiTable->GetTriggerName(idx)) + " <Trigger> loaded");
+	}
+	timings.commands += Clock::now() - begin;
+
+	return slot;
+}
+
+void ElanorBot::_LoadPlugins(const std::filesystem::path& folder, LoadTimings& timings)
+{
+	// Plugins are loaded in parallel, only their InitPlugin calls are serialized (see _InitMtx)
+	std::vector<std::future<std::pair<std::shared_ptr<PluginSlot>, LoadTimings>>> tasks;
+	for (const auto& entry : std::filesystem::directory_iterator(folder))
+	{
+		if (!entry.is_regular_file()) continue;
+
+		tasks.push_back(std::async(std::launch::async,
+		                           [this, path = entry.path()]
+		                           {
+									   LoadTimings t;
+									   auto slot = this->_LoadPlugin(path, t);
+									   return std::make_pair(std::move(slot), t);
+								   }));
+	}
+
+	for (auto& task : tasks)
+	{
+		auto [slot, t] = task.get();
+		timings += t;
+		if (slot) this->_plugins.push_back(std::move(slot));
+	}
+	this->_UpdateDispatch();
+}
+
+void ElanorBot::_UpdateDispatch()
+{
+	auto dispatch = std::make_shared<DispatchTable>();
+	for (const auto& slot : this->_plugins)
+	{
+		if (!slot->active) continue;
+		for (const auto& p : slot->commands)
+			dispatch->push_back({p.data.get(), p.data->Priority(), slot});
+	}
+
+	std::stable_sort(dispatch->begin(), dispatch->end(),
+	                 [](const CommandEntry& a, const CommandEntry& b) { return a.priority > b.priority; });
+	this->_dispatch = std::move(dispatch);
+}
+
+void ElanorBot::_RegisterPlugins()
+{
+	std::vector<std::pair<std::string, int>> command_list;
+	std::vector<std::pair<std::string, bool>> trigger_list;
+	for (const auto& slot : this->_plugins)
+	{
+		for (const auto& p : slot->commands)
+			command_list.emplace_back(p.name, p.data->Permission());
+		for (const auto& p : slot->triggers)
+			if (!p.data->isGlobal()) trigger_list.emplace_back(p.name, p.data->isDefaultOn());
 	}
+	this->_groups.SetCommands(std::move(command_list));
+	this->_groups.SetTriggers(std::move(trigger_list));
+}
 
-	std::sort(this->_GroupCommands.begin(), this->_GroupCommands.end(),
-	          [](const Tag<GroupCommand::IGroupCommand>& a, const Tag<GroupCommand::IGroupCommand>& b)
-	          { return a.data->Priority() > b.data->Priority(); });
+void ElanorBot::_LaunchTriggers(PluginSlot& slot)
+{
+	for (const auto& p : slot.triggers)
+	{
+		Trigger::ITrigger* trigger = p.data.get();
+		slot.timers.push_back(
+			this->_timer.Launch([this, trigger] { trigger->Action(this->_groups, this->_client, this->_config); },
+		                        [trigger] { return trigger->GetNext(); }));
+	}
 }
 
 void ElanorBot::_OffloadPlugins()
 {
-	this->_GroupCommands.clear();
-	this->_triggers.clear();
-	for (auto&& p : this->_plugins)
+	std::lock_guard<std::mutex> lk(this->_PluginMtx);
+	for (auto& slot : this->_plugins)
+		slot->active = false;
+	this->_UpdateDispatch();
+
+	for (auto& slot : this->_plugins)
 	{
-		API* ApiTable = static_cast<API*>(p.GetSym("ApiTable"));
-		if (ApiTable)
-			ApiTable->ClosePlugin();
-		else
-			LOG_WARN(Utils::GetLogger(), "Failed to close plugin, the library may be overwritten.");
-		p.Close();
+		for (auto id : slot->timers)
+			this->_timer.Stop(id);
+		slot->drain();
+		slot->unload();
 	}
 	this->_plugins.clear();
 }
 
-void ElanorBot::Start(const Mirai::SessionConfigs& opts)
+bool ElanorBot::ReloadPlugin(const std::string& name)
 {
+	std::lock_guard<std::mutex> lk(this->_PluginMtx);
+	auto it = std::find_if(this->_plugins.begin(), this->_plugins.end(),
+	                       [&name](const auto& slot) { return slot->name == name; });
+	if (it == this->_plugins.end())
 	{
-		std::lock_guard<std::mutex> lk(this->_MemberMtx);
-		this->_LoadPlugins(this->_config.Get("/path/PluginsFolder", "Plugins"));
+		LOG_WARN(Utils::GetLogger(), "Plugin " + name + " not found, nothing to reload");
+		return false;
+	}
 
-		this->_groups.SetSuid(this->_config.Get("/suid", Mirai::QQ_t{}));
+	auto slot = *it;
+	LOG_INFO(Utils::GetLogger(), "Reloading plugin " + name + "...");
 
-		std::vector<std::pair<std::string, int>> command_list;
-		for (const auto& p : this->_GroupCommands)
-			command_list.emplace_back(p.name, p.data->Permission());
-		this->_groups.SetCommands(std::move(command_list));
+	// Quiesce: new messages skip the plugin, then wait for running triggers and commands
+	slot->active = false;
+	this->_UpdateDispatch();
+	for (auto id : slot->timers)
+		this->_timer.Stop(id);
+	slot->drain();
+
+	// dlopen returns the old handle as long as it is still open, so it must be closed first
+	std::filesystem::path path = slot->path;
+	slot->unload();
+	this->_plugins.erase(it);
+
+	LoadTimings timings;
+	auto reloaded = this->_LoadPlugin(path, timings);
+	if (!reloaded)
+	{
+		this->_UpdateDispatch();
+		LOG_ERROR(Utils::GetLogger(), "Failed to reload plugin " + name + ", plugin is now unloaded");
+		return false;
+	}
+
+	this->_plugins.push_back(reloaded);
+	this->_UpdateDispatch();
+	this->_RegisterPlugins();
+
+	bool running = false;
+	{
+		std::lock_guard<std::mutex> member_lk(this->_MemberMtx);
+		running = this->_ready;
+	}
+	if (running) this->_LaunchTriggers(*reloaded);
+
+	LOG_INFO(Utils::GetLogger(),
+	         "Plugin " + name + " reloaded in " + FormatDuration(timings.dlopen + timings.init + timings.commands));
+	return true;
+}
 
-		std::vector<std::pair<std::string, bool>> trigger_list;
-		for (const auto& p : this->_triggers)
-			trigger_list.emplace_back(p.name, p.data->isDefaultOn());
-		this->_groups.SetTriggers(std::move(trigger_list));
+bool ElanorBot::SetConfig(const std::string& filepath)
+{
+	this->_ConfigPath = filepath;
+	return this->_config.FromFile(filepath);
+}
+
+void ElanorBot::_ReloadConfig()
+{
+	if (this->_config.FromFile(this->_ConfigPath))
+		LOG_INFO(Utils::GetLogger(), "Config reloaded from " + this->_ConfigPath);
+	else
+		LOG_WARN(Utils::GetLogger(), "Config reload failed, keeping the previous config");
+}
+
+void ElanorBot::_ConfigureLogger()
+{
+	static const std::unordered_map<std::string_view, Mirai::LoggingLevels> LEVELS = {
+		{"trace", Mirai::LoggingLevels::TRACE}, {"debug", Mirai::LoggingLevels::DEBUG},
+		{"info", Mirai::LoggingLevels::INFO},   {"warn", Mirai::LoggingLevels::WARN},
+		{"error", Mirai::LoggingLevels::ERROR}, {"fatal", Mirai::LoggingLevels::FATAL}};
+
+	auto& logger = Utils::GetLogger();
+	logger.SetConsole(this->_config.Get(LOG_CONSOLE_KEY, true));
+
+	std::vector<Utils::FileSinkOptions> sinks;
+	auto files = this->_config.Get<nlohmann::json>(LOG_FILES_KEY);
+	if (!files || !files->is_array()) files = nlohmann::json::array();
+	for (const auto& file : *files)
+	{
+		try
+		{
+			Utils::FileSinkOptions sink;
+			sink.path = file.at("path").get<std::string>();
+			if (file.contains("levels"))
+			{
+				sink.levels = 0;
+				for (const auto& level : file.at("levels"))
+				{
+					auto it = LEVELS.find(level.get<std::string>());
+					if (it == LEVELS.end()) throw std::runtime_error("Unknown log level " + level.dump());
+					sink.levels |= Utils::LevelMask(it->second);
+				}
+			}
+			sink.MaxFileSize = file.value("MaxSize", sink.MaxFileSize);
+			sink.MaxBackups = file.value("MaxBackups", sink.MaxBackups);
+			sink.compress = file.value("compress", sink.compress);
 
-		this->_groups.LoadGroups(this->_config.Get("/path/BotFolder", std::filesystem::path("Bots")));
+			sinks.push_back(std::move(sink));
+		}
+		catch (const std::exception& e)
+		{
+			LOG_WARN(Utils::GetLogger(), "Invalid log sink " + file.dump() + ": " + e.what());
+		}
 	}
+	// Unchanged sinks stay open, so a reload neither rotates their files nor drops lines
+	logger.SetFileSinks(sinks);
+}
+
+void ElanorBot::Start(const Mirai::SessionConfigs& opts)
+{
+	using Clock = std::chrono::steady_clock;
+	const auto StartTime = Clock::now();
+
+	this->_groups.SetSuid(this->_config.Get(SUID_KEY, Mirai::QQ_t{}));
+
+	// Plugins, groups and the MAH connection do not depend on each other until commands are registered
+	LoadTimings timings;
+	std::chrono::nanoseconds PluginTime{};
+	auto plugins = std::async(std::launch::async,
+	                          [this, &timings, &PluginTime]
+	                          {
+								  auto begin = Clock::now();
+								  std::lock_guard<std::mutex> lk(this->_PluginMtx);
+								  this->_LoadPlugins(this->_config.Get(PLUGINS_FOLDER_KEY, "Plugins"), timings);
+								  PluginTime = Clock::now() - begin;
+							  });
+
+	std::chrono::nanoseconds GroupTime{};
+	auto groups = std::async(std::launch::async,
+	                         [this, &GroupTime]
+	                         {
+								 auto begin = Clock::now();
+								 this->_groups.LoadGroups(this->_config.Get(BOT_FOLDER_KEY, std::filesystem::path("Bots")));
+								 GroupTime = Clock::now() - begin;
+							 });
 
 	this->_timer.LaunchLoop(
 		[this]
@@ -163,7 +407,7 @@ void ElanorBot::Start(const Mirai::SessionConfigs& opts)
 			auto groups = this->_groups.GetAllGroups();
 			for (const auto& p : groups)
 			{
-				p->ToFile(this->_config.Get("/path/BotFolder", std::filesystem::path("Bots")) / p->gid.to_string());
+				p->ToFile(this->_config.Get(BOT_FOLDER_KEY, std::filesystem::path("Bots")) / p->gid.to_string());
 			}
 		},
 		1h);
@@ -185,8 +429,11 @@ void ElanorBot::Start(const Mirai::SessionConfigs& opts)
 	this->_client->On<Mirai::ClientParseErrorEvent>([this](Mirai::ClientParseErrorEvent e)
 	                                                { this->_ParseErrorHandler(e); });
 
+	const auto ConnectBegin = Clock::now();
+	int attempts = 0;
 	while (true)
 	{
+		attempts++;
 		try
 		{
 			LOG_INFO(Utils::GetLogger(), "尝试与 mirai-api-http 建立连接...");
@@ -199,6 +446,7 @@ void ElanorBot::Start(const Mirai::SessionConfigs& opts)
 		}
 		std::this_thread::sleep_for(3s);
 	}
+	const std::chrono::nanoseconds ConnectTime = Clock::now() - ConnectBegin;
 
 	try
 	{
@@ -215,14 +463,35 @@ void ElanorBot::Start(const Mirai::SessionConfigs& opts)
 		LOG_WARN(Utils::GetLogger(), ex.what());
 	}
 
+	plugins.get();
+	groups.get();
 	{
-		std::lock_guard<std::mutex> lk(this->_MemberMtx);
-		this->_running = true;
-		for (const auto& p : this->_triggers)
+		std::lock_guard<std::mutex> lk(this->_PluginMtx);
+		this->_RegisterPlugins();
 		{
-			Trigger::ITrigger* trigger = p.data.get();
-			this->_timer.Launch([this, trigger] { trigger->Action(this->_groups, this->_client, this->_config); },
-			                    [trigger] { return trigger->GetNext(); });
+			std::lock_guard<std::mutex> member_lk(this->_MemberMtx);
+			this->_running = true;
+			this->_ready = true;
+		}
+		for (const auto& slot : this->_plugins)
+			this->_LaunchTriggers(*slot);
+	}
+
+	LOG_INFO(Utils::GetLogger(),
+	         "Startup finished in " + FormatDuration(Clock::now() - StartTime) + ": plugins " + FormatDuration(PluginTime)
+	             + " (summed over plugins: dlopen " + FormatDuration(timings.dlopen) + ", InitPlugin " + FormatDuration(timings.init)
+	             + ", commands " + FormatDuration(timings.commands) + "), groups " + FormatDuration(GroupTime)
+	             + ", MAH handshake " + FormatDuration(ConnectTime) + " (" + std::to_string(attempts) + " attempts)");
+
+	if (!this->_ConfigPath.empty())
+	{
+		try
+		{
+			this->_watcher.Start(this->_ConfigPath, [this] { this->_ReloadConfig(); });
+		}
+		catch (const std::exception& e)
+		{
+			LOG_WARN(Utils::GetLogger(), "Config hot reload disabled: "s + e.what());
 		}
 	}
 
@@ -232,33 +501,34 @@ void ElanorBot::Start(const Mirai::SessionConfigs& opts)
 void ElanorBot::Stop()
 {
 	LOG_INFO(Utils::GetLogger(), "Shutting down Elanor...");
+	this->_watcher.Stop();
 	{
 		std::lock_guard<std::mutex> lk(this->_MemberMtx);
 		this->_timer.StopAll();
 		LOG_INFO(Utils::GetLogger(), "Timers stopped");
 		this->_running = false;
+		this->_ready = false;
 	}
 
 	this->_client.Disconnect();
 	LOG_INFO(Utils::GetLogger(), "mirai-api-http disconnected");
 
-	{
-		std::lock_guard<std::mutex> lk(this->_MemberMtx);
-		this->_OffloadPlugins();
-	}
-	
+	this->_OffloadPlugins();
+
 	auto groups = this->_groups.GetAllGroups();
 	for (const auto& p : groups)
 	{
-		p->ToFile(this->_config.Get("/path/BotFolder", std::filesystem::path("Bots")) / p->gid.to_string());
+		p->ToFile(this->_config.Get(BOT_FOLDER_KEY, std::filesystem::path("Bots")) / p->gid.to_string());
 	}
+
+	Utils::GetLogger().flush();
 }
 
 void ElanorBot::_NudgeEventHandler(Mirai::NudgeEvent& e)
 {
 	{
 		std::lock_guard<std::mutex> lk(this->_MemberMtx);
-		if (!this->_running) return;
+		if (!this->_running || !this->_ready) return;
 	}
 
 	try
@@ -314,22 +584,27 @@ void ElanorBot::_GroupMessageEventHandler(Mirai::GroupMessageEvent& gm)
 {
 	{
 		std::lock_guard<std::mutex> lk(this->_MemberMtx);
-		if (!this->_running) return;
+		if (!this->_running || !this->_ready) return;
 	}
 
 	if (gm.GetSender().id == this->_client->GetBotQQ()) return;
 
 	Group& group = this->_groups.GetGroup(gm.GetSender().group.id);
 
+	auto dispatch = this->_dispatch.load();
 	int priority = -1;
-	for (const auto& p : this->_GroupCommands)
+	for (const auto& entry : *dispatch)
 	{
-		if ((p.data)->Priority() < priority) break;
+		if (entry.priority < priority) break;
+
+		if (!entry.slot->acquire()) continue;
+		std::unique_ptr<PluginSlot, void (*)(PluginSlot*)> guard(entry.slot.get(),
+		                                                        [](PluginSlot* slot) { slot->release(); });
 
 		bool matched = false;
 		try
 		{
-			matched = (p.data)->Execute(gm, group, this->_client, this->_config);
+			matched = entry.command->Execute(gm, group, this->_client, this->_config);
 		}
 		catch (const Mirai::NetworkException& e)
 		{
@@ -349,7 +624,7 @@ void ElanorBot::_GroupMessageEventHandler(Mirai::GroupMessageEvent& gm)
 			LOG_ERROR(Utils::GetLogger(), e.what());
 			this->_client.SendGroupMessage(group.gid, Mirai::MessageChain().Plain("Error: " + string(e.what())));
 		}
-		if (matched) priority = (p.data)->Priority();
+		if (matched) priority = entry.priority;
 	}
 }
 
@@ -1,12 +1,18 @@
 #ifndef _ELANOR_BOT_HPP_
 #define _ELANOR_BOT_HPP_
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <filesystem>
 #include <memory>
 #include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+#include <Utils/ConfigWatcher.hpp>
 #include <Utils/PluginManager.hpp>
 #include <Utils/Timer.hpp>
 
@@ -33,25 +39,86 @@ protected:
 	{
 		std::string name{};
 		std::unique_ptr<T, void (*)(T*)> data;
-		int LibIdx = -1;
 	};
 
-	std::vector<Tag<GroupCommand::IGroupCommand>> _GroupCommands{};
-	std::vector<Tag<Trigger::ITrigger>> _triggers{};
-	std::vector<PluginLibrary> _plugins{};
+	// Everything loaded from one plugin library, replaced as a whole on reload
+	struct PluginSlot
+	{
+		std::string name{};
+		std::filesystem::path path{};
+		PluginLibrary lib{};
+		std::vector<Tag<GroupCommand::IGroupCommand>> commands{};
+		std::vector<Tag<Trigger::ITrigger>> triggers{};
+		std::vector<std::size_t> timers{};
+
+		// Commands are only executed while active, unloading waits for InFlight to drop to zero
+		std::atomic<bool> active = true;
+		std::atomic<std::size_t> InFlight = 0;
+		std::mutex mtx;
+		std::condition_variable cv;
+
+		bool acquire();
+		void release();
+		void drain();
+		void unload();
+
+		~PluginSlot() { this->unload(); }
+	};
+
+	struct CommandEntry
+	{
+		GroupCommand::IGroupCommand* command = nullptr;
+		int priority = 0;
+		std::shared_ptr<PluginSlot> slot;
+	};
+	using DispatchTable = std::vector<CommandEntry>;
+
+	// Time spent in each step of plugin loading, summed over all plugins
+	struct LoadTimings
+	{
+		std::chrono::nanoseconds dlopen{};
+		std::chrono::nanoseconds init{};
+		std::chrono::nanoseconds commands{};
+
+		LoadTimings& operator+=(const LoadTimings& rhs)
+		{
+			this->dlopen += rhs.dlopen;
+			this->init += rhs.init;
+			this->commands += rhs.commands;
+			return *this;
+		}
+	};
+
+	// Serializes loading and unloading, message handlers only read _dispatch
+	mutable std::mutex _PluginMtx;
+	// InitPlugin runs one plugin at a time. Several plugins call VIPS_INIT, which must not run concurrently
+	std::mutex _InitMtx;
+	std::vector<std::shared_ptr<PluginSlot>> _plugins{};
+	std::atomic<std::shared_ptr<const DispatchTable>> _dispatch{std::make_shared<const DispatchTable>()};
 
 	GroupList _groups;
 	Client _client{};
 	Utils::Timer _timer{};
 	Utils::BotConfig _config{};
+	std::string _ConfigPath{};
+	Utils::ConfigWatcher _watcher{};
+	Utils::BotConfig::Subscription _LogSubscription{};
 
 	bool _running = false;
+	// Set once plugins and groups are loaded, MAH may already be connected before that
+	bool _ready = false;
 
 	void _run();
 	void _stop();
 
-	void _LoadPlugins(const std::filesystem::path& folder);
+	void _LoadPlugins(const std::filesystem::path& folder, LoadTimings& timings);
+	std::shared_ptr<PluginSlot> _LoadPlugin(const std::filesystem::path& path, LoadTimings& timings);
 	void _OffloadPlugins();
+	void _UpdateDispatch();
+	void _RegisterPlugins();
+	void _LaunchTriggers(PluginSlot& slot);
+	void _ConfigureLogger();
+	void _ReloadConfig();
 
 	void _NudgeEventHandler(Mirai::NudgeEvent& e);
 	void _GroupMessageEventHandler(Mirai::GroupMessageEvent& gm);
@@ -67,12 +134,19 @@ public:
 	ElanorBot(ElanorBot&&) = delete;
 	ElanorBot& operator=(ElanorBot&&) = delete;
 
-	bool SetConfig(const std::string& filepath) { return this->_config.FromFile(filepath); }
+	bool SetConfig(const std::string& filepath);
 
 	void Start(const Mirai::SessionConfigs& opts);
 	void Stop();
 
-	~ElanorBot() { this->_stop(); }
+	// Reloads the plugin library whose file stem is name, other plugins keep serving meanwhile
+	bool ReloadPlugin(const std::string& name);
+
+	~ElanorBot()
+	{
+		this->_watcher.Stop();
+		this->_stop();
+	}
 };
 
 } // namespace Bot
@@ -0,0 +1,120 @@
+#include "ConfigWatcher.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <Core/Utils/Logger.hpp>
+
+namespace Utils
+{
+
+void ConfigWatcher::Start(std::filesystem::path file, std::function<void()> callback,
+                          std::chrono::milliseconds debounce)
+{
+	this->Stop();
+
+	file = std::filesystem::absolute(file);
+	this->_InotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (this->_InotifyFd < 0)
+		throw std::runtime_error("Failed to initialize inotify <ConfigWatcher>: " + std::string(std::strerror(errno)));
+
+	if (inotify_add_watch(this->_InotifyFd, file.parent_path().c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+	{
+		std::string err = std::strerror(errno);
+		this->Stop();
+		throw std::runtime_error("Failed to watch " + file.parent_path().string() + " <ConfigWatcher>: " + err);
+	}
+
+	this->_EventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (this->_EventFd < 0)
+	{
+		std::string err = std::strerror(errno);
+		this->Stop();
+		throw std::runtime_error("Failed to create eventfd <ConfigWatcher>: " + err);
+	}
+
+	this->_th = std::thread([this, file = std::move(file), callback = std::move(callback), debounce]() mutable
+	                        { this->_run(std::move(file), std::move(callback), debounce); });
+}
+
+void ConfigWatcher::Stop()
+{
+	if (this->_th.joinable())
+	{
+		uint64_t one = 1;
+		(void)::write(this->_EventFd, &one, sizeof(one));
+		this->_th.join();
+	}
+
+	if (this->_InotifyFd >= 0) ::close(this->_InotifyFd);
+	if (this->_EventFd >= 0) ::close(this->_EventFd);
+	this->_InotifyFd = -1;
+	this->_EventFd = -1;
+}
+
+void ConfigWatcher::_run(std::filesystem::path file, std::function<void()> callback,
+                         std::chrono::milliseconds debounce)
+{
+	const std::string filename = file.filename().string();
+
+	// NOLINTNEXTLINE(*-avoid-c-arrays)
+	alignas(inotify_event) char buffer[4096];
+	// Only events for the file itself push this back, the rest of the directory may be busy (e.g. log files)
+	std::optional<std::chrono::steady_clock::time_point> deadline;
+	while (true)
+	{
+		// NOLINTNEXTLINE(*-avoid-c-arrays)
+		pollfd fds[] = {{this->_InotifyFd, POLLIN, 0}, {this->_EventFd, POLLIN, 0}};
+		int timeout = -1;
+		if (deadline)
+			timeout = static_cast<int>(std::max<std::chrono::milliseconds::rep>(
+				std::chrono::ceil<std::chrono::milliseconds>(*deadline - std::chrono::steady_clock::now()).count(), 0));
+		int n = poll(fds, 2, timeout);
+		if (n < 0)
+		{
+			if (errno == EINTR) continue;
+			LOG_ERROR(GetLogger(), "poll failed <ConfigWatcher>: " + std::string(std::strerror(errno)));
+			return;
+		}
+		if (fds[1].revents & POLLIN) return;
+
+		ssize_t len{};
+		while ((len = ::read(this->_InotifyFd, buffer, sizeof(buffer))) > 0)
+		{
+			for (char* ptr = buffer; ptr < buffer + len;)
+			{
+				const auto* event = reinterpret_cast<const inotify_event*>(ptr); // NOLINT
+				if (event->len > 0 && filename == event->name)
+					deadline = std::chrono::steady_clock::now() + debounce;
+				ptr += sizeof(inotify_event) + event->len;
+			}
+		}
+
+		if (deadline && std::chrono::steady_clock::now() >= *deadline)
+		{
+			// Quiet for a whole debounce period, the writer should be done by now
+			deadline.reset();
+			LOG_INFO(GetLogger(), "Detected change in " + file.string() + " <ConfigWatcher>");
+			try
+			{
+				callback();
+			}
+			catch (const std::exception& e)
+			{
+				LOG_ERROR(GetLogger(), "Reload callback failed <ConfigWatcher>: " + std::string(e.what()));
+			}
+		}
+	}
+}
+
+} // namespace Utils
@@ -0,0 +1,40 @@
+#ifndef _CONFIG_WATCHER_HPP_
+#define _CONFIG_WATCHER_HPP_
+
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <thread>
+
+namespace Utils
+{
+
+// Watches a single file through inotify on its parent directory, so that both in-place writes
+// and editors that save by renaming a temporary file are picked up
+class ConfigWatcher
+{
+public:
+	ConfigWatcher() = default;
+	ConfigWatcher(const ConfigWatcher&) = delete;
+	ConfigWatcher& operator=(const ConfigWatcher&) = delete;
+	ConfigWatcher(ConfigWatcher&&) = delete;
+	ConfigWatcher& operator=(ConfigWatcher&&) = delete;
+
+	// callback runs on the watcher thread once the file saw no further events within debounce
+	void Start(std::filesystem::path file, std::function<void()> callback,
+	           std::chrono::milliseconds debounce = std::chrono::milliseconds(500));
+	void Stop();
+
+	~ConfigWatcher() { this->Stop(); }
+
+private:
+	int _InotifyFd = -1;
+	int _EventFd = -1;
+	std::thread _th;
+
+	void _run(std::filesystem::path file, std::function<void()> callback, std::chrono::milliseconds debounce);
+};
+
+} // namespace Utils
+
+#endif
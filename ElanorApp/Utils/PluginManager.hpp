@@ -26,6 +26,7 @@ public:
 	void Open(const std::string& libpath);
 	void Close();
 
+	[[nodiscard]] bool IsOpen() const { return this->handle != nullptr; }
 	[[nodiscard]] void* GetSym(const char* name) const;
 };
 
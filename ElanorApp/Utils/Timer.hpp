@@ -28,16 +28,22 @@ public:
 
 	void Stop(size_t id)
 	{
-		for (auto& p : this->_worker)
+		// The worker needs _mtx to observe the stop flag, so join only after releasing it
+		std::thread th;
 		{
 			std::lock_guard<std::mutex> lk(this->_mtx);
-			if (p.second.id == id)
+			for (auto& p : this->_worker)
 			{
-				p.second.stop = true;
-				this->_cv.notify_all();
-				if (p.first.joinable()) p.first.join();
+				if (p.second.id == id)
+				{
+					p.second.stop = true;
+					th = std::move(p.first);
+					break;
+				}
 			}
+			this->_cv.notify_all();
 		}
+		if (th.joinable()) th.join();
 	}
 
 	void StopAll()
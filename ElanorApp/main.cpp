@@ -34,6 +34,11 @@ int main()
 			Bot.Stop();
 			break;
 		}
+		if (cmd == "reload")
+		{
+			string name;
+			if (std::cin >> name) Bot.ReloadPlugin(name);
+		}
 	}
 	return 0;
 }
\ No newline at end of file
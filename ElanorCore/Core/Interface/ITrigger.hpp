@@ -34,6 +34,8 @@ public:
 	virtual void Action(Bot::GroupList& groups, Bot::Client& client, Utils::BotConfig& config) = 0;
 	virtual time_t GetNext() = 0;
 	virtual bool isDefaultOn() const { return false; }
+	// Global triggers run regardless of the group settings and cannot be toggled per group
+	virtual bool isGlobal() const { return false; }
 
 	virtual ~ITrigger() = default;
 };
@@ -24,7 +24,7 @@ extern "C"
 {
 	struct API
 	{
-		void (*InitPlugin)();
+		void (*InitPlugin)(const Utils::BotConfig&);
 
 		const char* (*GetPluginName)();
 		const char* (*GetPluginInfo)();
@@ -44,7 +44,7 @@ extern "C"
 
 #ifdef PLUGIN_ENTRY_IMPL
 
-	void InitPlugin();
+	void InitPlugin(const Utils::BotConfig& config);
 
 	const char* GetPluginName();
 	const char* GetPluginInfo();
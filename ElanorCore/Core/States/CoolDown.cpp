@@ -41,6 +41,19 @@ std::unique_ptr<CoolDown::Token> CoolDown::GetRemaining(const std::string& id, c
 	}
 }
 
+std::chrono::seconds CoolDown::PeekRemaining(const std::string& id, const std::chrono::seconds& _cd) const
+{
+	using namespace std::chrono;
+	std::lock_guard<std::mutex> lk(this->_mtx);
+	auto it = this->_cd.find(id);
+	if (it == this->_cd.end()) return 0s;
+	if (it->second.isUsing) return _cd;
+	if (!it->second.LastUsed.has_value()) return 0s;
+
+	auto passed = floor<seconds>(system_clock::now() - it->second.LastUsed.value());
+	return passed >= _cd ? 0s : _cd - passed;
+}
+
 json CoolDown::Serialize()
 {
 	std::lock_guard<std::mutex> lk(this->_mtx);
@@ -51,6 +51,8 @@ public:
 
 	std::unique_ptr<Token> GetRemaining(const std::string& _id, const std::chrono::seconds& _cd,
 	                                    std::chrono::seconds& remaining);
+	// Remaining time without taking the cooldown, 0s if GetRemaining would succeed now
+	std::chrono::seconds PeekRemaining(const std::string& _id, const std::chrono::seconds& _cd) const;
 
 	nlohmann::json Serialize() override;
 	void Deserialize(const nlohmann::json& content) override;
@@ -1,7 +1,9 @@
 #include "Common.hpp"
 
+#include <charconv>
 #include <fstream>
 #include <random>
+#include <stdexcept>
 #include <string>
 
 #include <Core/Utils/Logger.hpp>
@@ -17,6 +19,93 @@ std::mt19937& GetRngEngine()
 	return rng;
 }
 
+ConfigKey::ConfigKey(std::string_view path) : _path(path)
+{
+	if (path.empty()) return;
+	if (path.front() != '/') throw std::invalid_argument("Invalid config key <ConfigKey>: " + this->_path);
+
+	path.remove_prefix(1);
+	while (true)
+	{
+		auto pos = path.find('/');
+		std::string token;
+		std::string_view raw = path.substr(0, pos);
+		token.reserve(raw.size());
+		for (size_t i = 0; i < raw.size(); i++)
+		{
+			if (raw[i] != '~')
+			{
+				token += raw[i];
+				continue;
+			}
+			if (i + 1 < raw.size() && (raw[i + 1] == '0' || raw[i + 1] == '1'))
+			{
+				token += (raw[i + 1] == '0') ? '~' : '/';
+				i++;
+			}
+			else
+				throw std::invalid_argument("Invalid escape sequence in config key <ConfigKey>: " + this->_path);
+		}
+		this->_tokens.push_back(std::move(token));
+
+		if (pos == std::string_view::npos) break;
+		path.remove_prefix(pos + 1);
+	}
+}
+
+const json* ConfigKey::resolve(const json& root) const
+{
+	const json* node = &root;
+	for (const auto& token : this->_tokens)
+	{
+		if (node->is_object())
+		{
+			auto it = node->find(token);
+			if (it == node->end()) return nullptr;
+			node = &(*it);
+		}
+		else if (node->is_array())
+		{
+			// Same rules as json_pointer: digits only, no leading zeros
+			if (token.empty() || (token.size() > 1 && token.front() == '0')) return nullptr;
+			size_t idx = 0;
+			auto [ptr, ec] = std::from_chars(token.data(), token.data() + token.size(), idx);
+			if (ec != std::errc() || ptr != token.data() + token.size() || idx >= node->size()) return nullptr;
+			node = &(*node)[idx];
+		}
+		else
+			return nullptr;
+	}
+	return node;
+}
+
+namespace
+{
+
+bool IsCompatible(const json& prev, const json& curr, const std::string& path, std::string& reason)
+{
+	// null is used to disable optional sections such as proxies
+	if (prev.is_null() || curr.is_null()) return true;
+	if (prev.is_number() && curr.is_number()) return true;
+	if (prev.type() != curr.type())
+	{
+		reason = (path.empty() ? "/" : path) + " changed from " + prev.type_name() + " to " + curr.type_name();
+		return false;
+	}
+	if (prev.is_object())
+	{
+		for (const auto& [key, value] : prev.items())
+		{
+			auto it = curr.find(key);
+			if (it == curr.end()) continue;
+			if (!IsCompatible(value, *it, path + "/" + key, reason)) return false;
+		}
+	}
+	return true;
+}
+
+} // namespace
+
 bool BotConfig::FromFile(const std::string& filepath)
 {
 	std::ifstream ifile(filepath);
@@ -25,17 +114,76 @@ bool BotConfig::FromFile(const std::string& filepath)
 		LOG_WARN(GetLogger(), "Failed to open file <BotConfig>: " + filepath);
 		return false;
 	}
+	json config;
 	try
 	{
-		std::lock_guard<std::mutex> lk(this->_mtx);
-		this->_config = json::parse(ifile);
+		config = json::parse(ifile);
 	}
 	catch (const std::exception& e)
 	{
 		LOG_WARN(GetLogger(), "Failed to parse file <BotConfig>: " + std::string(e.what()));
 		return false;
 	}
+
+	if (!config.is_object())
+	{
+		LOG_WARN(GetLogger(), "Invalid config <BotConfig>: root must be an object");
+		return false;
+	}
+
+	auto prev = this->GetSnapshot();
+	std::string reason;
+	if (!IsCompatible(*prev, config, "", reason))
+	{
+		LOG_WARN(GetLogger(), "Invalid config <BotConfig>: " + reason);
+		return false;
+	}
+
+	auto curr = std::make_shared<const json>(std::move(config));
+	this->_config = curr;
+	this->_notify(*prev, *curr);
 	return true;
 }
 
+BotConfig::Subscription BotConfig::Subscribe(ConfigKey key, std::function<void()> callback) const
+{
+	std::lock_guard<std::mutex> lk(this->_registry->mtx);
+	std::size_t id = ++this->_registry->NextId;
+	this->_registry->callbacks.emplace(id, std::make_pair(std::move(key), std::move(callback)));
+	return {this->_registry, id};
+}
+
+void BotConfig::_notify(const json& prev, const json& curr) const
+{
+	std::lock_guard<std::mutex> lk(this->_registry->mtx);
+	for (const auto& [id, entry] : this->_registry->callbacks)
+	{
+		const auto& [key, callback] = entry;
+		const json* before = key.resolve(prev);
+		const json* after = key.resolve(curr);
+		bool changed = (before == nullptr || after == nullptr) ? (before != after) : (*before != *after);
+		if (!changed) continue;
+
+		try
+		{
+			callback();
+		}
+		catch (const std::exception& e)
+		{
+			LOG_WARN(GetLogger(), "Config callback for " + key.str() + " failed <BotConfig>: " + e.what());
+		}
+	}
+}
+
+void BotConfig::Subscription::reset()
+{
+	auto registry = this->_registry.lock();
+	if (registry)
+	{
+		std::lock_guard<std::mutex> lk(registry->mtx);
+		registry->callbacks.erase(this->_id);
+	}
+	this->_registry.reset();
+}
+
 } // namespace Utils
\ No newline at end of file
@@ -1,9 +1,18 @@
 #ifndef _ELANOR_CORE_UTILS_COMMON_HPP_
 #define _ELANOR_CORE_UTILS_COMMON_HPP_
 
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
 #include <mutex>
 #include <optional>
 #include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 #include <nlohmann/json.hpp>
 
@@ -12,79 +21,161 @@ namespace Utils
 
 std::mt19937& GetRngEngine();
 
+// Pre-parsed JSON pointer, construct once (e.g. as a static) and reuse for lookups
+class ConfigKey
+{
+protected:
+	std::string _path;
+	std::vector<std::string> _tokens;
+
+public:
+	ConfigKey(std::string_view path);
+	ConfigKey(const char* path) : ConfigKey(std::string_view(path)) {}
+	ConfigKey(const std::string& path) : ConfigKey(std::string_view(path)) {}
+
+	const std::string& str() const { return this->_path; }
+
+	// Single walk down the tree, returns nullptr if any token is missing
+	const nlohmann::json* resolve(const nlohmann::json& root) const;
+};
+
+// Reads from one snapshot, for callers whose keys have to agree with each other (e.g. a proxy host and port)
+// even when the config is reloaded in between. Holds on to the snapshot for as long as it lives
+class ConfigView
+{
+protected:
+	std::shared_ptr<const nlohmann::json> _snapshot;
+
+public:
+	explicit ConfigView(std::shared_ptr<const nlohmann::json> snapshot) : _snapshot(std::move(snapshot)) {}
+
+	template<typename ValueType>
+	auto Get(const ConfigKey& key, ValueType&& value) const
+	{
+		using ReturnType = decltype(std::declval<const nlohmann::json&>().value(
+			std::declval<const nlohmann::json::json_pointer&>(), std::forward<ValueType>(value)));
+		const auto* node = key.resolve(*this->_snapshot);
+		if (node)
+			return node->template get<ReturnType>();
+		else
+			return (ReturnType)std::forward<ValueType>(value);
+	}
+
+	template<typename ValueType>
+	std::optional<ValueType> Get(const ConfigKey& key) const
+	{
+		const auto* node = key.resolve(*this->_snapshot);
+		if (node) return node->template get<ValueType>();
+		else
+			return std::nullopt;
+	}
+
+	bool exist(const ConfigKey& key) const
+	{
+		return key.resolve(*this->_snapshot) != nullptr;
+	}
+
+	bool IsNull(const ConfigKey& key) const
+	{
+		const auto* node = key.resolve(*this->_snapshot);
+		return node != nullptr && node->is_null();
+	}
+};
+
 class BotConfig
 {
+public:
+	using Snapshot = std::shared_ptr<const nlohmann::json>;
+
 private:
-	nlohmann::json _config;
-	mutable std::mutex _mtx;
+	struct Registry
+	{
+		std::mutex mtx;
+		std::size_t NextId = 0;
+		std::map<std::size_t, std::pair<ConfigKey, std::function<void()>>> callbacks;
+	};
+
+	// Replaced as a whole on reload, readers keep whatever snapshot they loaded
+	std::atomic<Snapshot> _config{std::make_shared<const nlohmann::json>()};
+	std::shared_ptr<Registry> _registry = std::make_shared<Registry>();
+
+	void _notify(const nlohmann::json& prev, const nlohmann::json& curr) const;
 
 public:
+	// Unsubscribes on destruction, safe to outlive the BotConfig it came from
+	class Subscription
+	{
+	private:
+		std::weak_ptr<Registry> _registry;
+		std::size_t _id = 0;
+
+		Subscription(std::weak_ptr<Registry> registry, std::size_t id) : _registry(std::move(registry)), _id(id) {}
+		friend class BotConfig;
+
+	public:
+		Subscription() = default;
+		Subscription(const Subscription&) = delete;
+		Subscription& operator=(const Subscription&) = delete;
+		Subscription(Subscription&& rhs) noexcept : _registry(std::move(rhs._registry)), _id(rhs._id) {}
+		Subscription& operator=(Subscription&& rhs) noexcept
+		{
+			if (this == &rhs) return *this;
+			this->reset();
+			this->_registry = std::move(rhs._registry);
+			this->_id = rhs._id;
+			return *this;
+		}
+		~Subscription() { this->reset(); }
+
+		void reset();
+	};
+
 	BotConfig() = default;
-	BotConfig(nlohmann::json config) : _config(std::move(config)) {}
+	BotConfig(nlohmann::json config) : _config(std::make_shared<const nlohmann::json>(std::move(config))) {}
 	BotConfig& operator=(const BotConfig& rhs)
 	{
 		if (this == &rhs) return *this;
-
-		std::scoped_lock lk(this->_mtx, rhs._mtx);
-		this->_config = rhs._config;
+		this->_config = rhs._config.load();
 		return *this;
 	}
 	BotConfig(const BotConfig& rhs) { *this = rhs; }
-	BotConfig& operator=(BotConfig&& rhs)
+	BotConfig& operator=(BotConfig&& rhs) noexcept
 	{
 		if (this == &rhs) return *this;
-
-		std::scoped_lock lk(this->_mtx, rhs._mtx);
-		this->_config = std::move(rhs._config);
+		this->_config = rhs._config.exchange(std::make_shared<const nlohmann::json>());
 		return *this;
 	}
-	BotConfig(BotConfig&& rhs) { *this = rhs; }
+	BotConfig(BotConfig&& rhs) noexcept { *this = std::move(rhs); }
 	~BotConfig() = default;
 
+	// Rejects files whose root is not an object or that change the type of an existing entry,
+	// the previous snapshot is kept in that case
 	bool FromFile(const std::string& filepath);
 
-	template<typename ValueType, typename KeyType>
-	auto Get(KeyType&& key, ValueType&& value) const
-	{
-		using ReturnType = decltype(std::declval<typename nlohmann::json>().value(std::forward<KeyType>(key),
-		                                                                          std::forward<ValueType>(value)));
-		std::lock_guard<std::mutex> lk(this->_mtx);
-		auto jp = nlohmann::json::json_pointer(key);
-		if (this->_config.contains(jp)) 
-			return this->_config.at(jp).template get<ReturnType>();
-		else
-			return (ReturnType)std::forward<ValueType>(value);
-	}
+	// callback is invoked after a reload whenever the subtree under key differs from the previous snapshot.
+	// It runs with the registry locked and must not subscribe or unsubscribe itself
+	[[nodiscard]] Subscription Subscribe(ConfigKey key, std::function<void()> callback) const;
+
+	Snapshot GetSnapshot() const { return this->_config.load(); }
 
-	template<typename ValueType, typename KeyType>
-	std::optional<ValueType> Get(KeyType&& key) const
+	// Every read through the view sees the same snapshot, the methods below load a new one each time
+	ConfigView View() const { return ConfigView(this->GetSnapshot()); }
+
+	template<typename ValueType>
+	auto Get(const ConfigKey& key, ValueType&& value) const
 	{
-		std::lock_guard<std::mutex> lk(this->_mtx);
-		auto jp = nlohmann::json::json_pointer(key);
-		if (this->_config.contains(jp)) return this->_config.at(jp).get<ValueType>();
-		else
-			return std::nullopt;
+		return this->View().Get(key, std::forward<ValueType>(value));
 	}
 
-	template <typename KeyType>
-	bool exist(KeyType&& key) const
+	template<typename ValueType>
+	std::optional<ValueType> Get(const ConfigKey& key) const
 	{
-		std::lock_guard<std::mutex> lk(this->_mtx);
-		auto jp = nlohmann::json::json_pointer(key);
-		return this->_config.contains(jp);
+		return this->View().template Get<ValueType>(key);
 	}
 
-	template <typename KeyType>
-	bool IsNull(KeyType&& key) const
-	{
-		std::lock_guard<std::mutex> lk(this->_mtx);
-		auto jp = nlohmann::json::json_pointer(key);
-		if (this->_config.contains(jp)) 
-			return this->_config.at(jp).is_null();
-		else
-			return false;
+	bool exist(const ConfigKey& key) const { return this->View().exist(key); }
 
-	}
+	bool IsNull(const ConfigKey& key) const { return this->View().IsNull(key); }
 };
 
 } // namespace Utils
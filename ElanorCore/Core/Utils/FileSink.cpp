@@ -0,0 +1,330 @@
+#include "FileSink.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+namespace Utils
+{
+
+namespace
+{
+
+// Errors of the sink itself cannot go through the logger
+void ReportError(const std::string& msg)
+{
+	std::cerr << ("[FileSink] " + msg + ": " + std::strerror(errno) + "\n") << std::flush;
+}
+
+std::string GetFileTimestamp()
+{
+	std::time_t t = std::time(nullptr);
+
+	constexpr size_t BUFFER_SIZE = 32;
+	char buf[BUFFER_SIZE]; // NOLINT(*-avoid-c-arrays)
+	std::strftime(buf, BUFFER_SIZE, "%Y%m%d-%H%M%S", std::localtime(&t));
+	return {buf};
+}
+
+// Rotated files are named <stem>.<timestamp>[-<n>]<ext>[.gz], n counts files rotated within the same second.
+// A plain name comparison would put the suffixed ones before the first file of that second
+std::pair<std::string, long> BackupOrder(const std::filesystem::path& file, std::size_t PrefixLen)
+{
+	constexpr std::size_t TIMESTAMP_LEN = 15; // %Y%m%d-%H%M%S
+	const std::string name = file.filename().string().substr(PrefixLen);
+	std::string timestamp = name.substr(0, TIMESTAMP_LEN);
+	long n = 0;
+	if (name.size() > TIMESTAMP_LEN && name[TIMESTAMP_LEN] == '-')
+		n = std::strtol(name.c_str() + TIMESTAMP_LEN + 1, nullptr, 10); // NOLINT(*-avoid-magic-numbers)
+	return {std::move(timestamp), n};
+}
+
+bool CompressFile(const std::filesystem::path& src, const std::filesystem::path& dst)
+{
+	int in = ::open(src.c_str(), O_RDONLY | O_CLOEXEC);
+	if (in < 0) return false;
+
+	gzFile out = gzopen(dst.c_str(), "wb6");
+	if (out == nullptr)
+	{
+		::close(in);
+		return false;
+	}
+
+	constexpr size_t BUFFER_SIZE = 256 * 1024;
+	std::vector<char> buffer(BUFFER_SIZE);
+	bool success = true;
+	ssize_t n{};
+	while ((n = ::read(in, buffer.data(), buffer.size())) > 0)
+	{
+		if (gzwrite(out, buffer.data(), static_cast<unsigned>(n)) != n)
+		{
+			success = false;
+			break;
+		}
+	}
+	if (n < 0) success = false;
+
+	::close(in);
+	if (gzclose(out) != Z_OK) success = false;
+	return success;
+}
+
+} // namespace
+
+FileSink::FileSink(FileSinkOptions opts, bool resume) : _opts(std::move(opts))
+{
+	this->_buffer.reserve(this->_opts.BufferSize);
+	this->_open(resume);
+
+	this->_writer = std::thread([this] { this->_WriterLoop(); });
+	if (this->_opts.compress) this->_compressor = std::thread([this] { this->_CompressorLoop(); });
+}
+
+FileSink::~FileSink()
+{
+	{
+		std::lock_guard<std::mutex> lk(this->_mtx);
+		this->_stop = true;
+	}
+	this->_cv.notify_all();
+	this->_cv_drained.notify_all();
+	if (this->_writer.joinable()) this->_writer.join();
+
+	{
+		std::lock_guard<std::mutex> lk(this->_FileMtx);
+		this->_close();
+	}
+
+	{
+		std::lock_guard<std::mutex> lk(this->_CompressorMtx);
+		this->_CompressorStop = true;
+	}
+	this->_CompressorCv.notify_all();
+	if (this->_compressor.joinable()) this->_compressor.join();
+}
+
+void FileSink::write(std::string_view line)
+{
+	std::unique_lock<std::mutex> lk(this->_mtx);
+
+	// Writer cannot keep up, hold the caller back instead of dropping lines
+	const size_t MAX_PENDING = 4 * this->_opts.BufferSize;
+	this->_cv_drained.wait(lk, [this, MAX_PENDING] { return this->_buffer.size() < MAX_PENDING || this->_stop; });
+
+	this->_buffer.append(line);
+	if (this->_buffer.size() >= this->_opts.BufferSize) this->_cv.notify_one();
+}
+
+void FileSink::flush()
+{
+	std::lock_guard<std::mutex> file_lk(this->_FileMtx);
+	std::string batch;
+	{
+		std::lock_guard<std::mutex> lk(this->_mtx);
+		batch.swap(this->_buffer);
+		this->_buffer.reserve(this->_opts.BufferSize);
+	}
+	this->_cv_drained.notify_all();
+	this->_WriteAll(batch);
+}
+
+void FileSink::_WriterLoop()
+{
+	std::string batch;
+	batch.reserve(this->_opts.BufferSize);
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lk(this->_mtx);
+			this->_cv.wait_for(lk, this->_opts.FlushInterval,
+			                   [this] { return this->_stop || this->_buffer.size() >= this->_opts.BufferSize; });
+		}
+
+		std::lock_guard<std::mutex> file_lk(this->_FileMtx);
+		bool stop = false;
+		{
+			std::lock_guard<std::mutex> lk(this->_mtx);
+			batch.swap(this->_buffer);
+			stop = this->_stop;
+		}
+		this->_cv_drained.notify_all();
+
+		this->_WriteAll(batch);
+		batch.clear();
+
+		if (stop) return;
+	}
+}
+
+void FileSink::_WriteAll(std::string_view data)
+{
+	if (this->_fd < 0)
+	{
+		// Retry opening in case the previous rotation failed
+		this->_open();
+		if (this->_fd < 0) return;
+	}
+
+	while (!data.empty())
+	{
+		ssize_t n = ::write(this->_fd, data.data(), data.size());
+		if (n < 0)
+		{
+			if (errno == EINTR) continue;
+			ReportError("Failed to write to " + this->_opts.path.string());
+			return;
+		}
+		data.remove_prefix(static_cast<size_t>(n));
+		this->_written += static_cast<size_t>(n);
+	}
+
+	if (this->_written >= this->_opts.MaxFileSize) this->_rotate();
+}
+
+void FileSink::_open(bool resume)
+{
+	std::error_code ec;
+	if (this->_opts.path.has_parent_path()) std::filesystem::create_directories(this->_opts.path.parent_path(), ec);
+
+	// Rotate leftovers from the previous run so that each file starts fresh
+	if (!resume && std::filesystem::file_size(this->_opts.path, ec) > 0 && !ec) this->_archive();
+
+	// Appending, the sink being replaced on a reload may still flush its last lines into the same file
+	this->_fd = ::open(this->_opts.path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644); // NOLINT
+	if (this->_fd < 0)
+	{
+		ReportError("Failed to open " + this->_opts.path.string());
+		return;
+	}
+	struct stat st{};
+	this->_written = (::fstat(this->_fd, &st) == 0) ? static_cast<size_t>(st.st_size) : 0;
+
+	// Reserve the blocks up front without changing the visible file size, failure is harmless
+	(void)::fallocate(this->_fd, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(this->_opts.MaxFileSize));
+}
+
+void FileSink::_close()
+{
+	if (this->_fd < 0) return;
+
+	// Release the preallocated blocks that were never written. The file may have grown past _written
+	// through another sink, so the size is taken from the file itself
+	struct stat st{};
+	if (::fstat(this->_fd, &st) == 0) (void)::ftruncate(this->_fd, st.st_size);
+	::close(this->_fd);
+	this->_fd = -1;
+}
+
+void FileSink::_rotate()
+{
+	this->_close();
+	this->_archive();
+	this->_open();
+}
+
+void FileSink::_archive()
+{
+	const auto& path = this->_opts.path;
+	const std::string stamp = GetFileTimestamp();
+	const std::string prefix = (path.parent_path() / path.stem()).string() + "." + stamp;
+	auto name = [&](int n) -> std::filesystem::path
+	{ return prefix + (n > 0 ? "-" + std::to_string(n) : "") + path.extension().string(); };
+
+	// Names freed by pruning are not reused, they would sort before the files rotated earlier in the same second
+	int n = (stamp == this->_ArchiveStamp) ? this->_ArchiveSeq + 1 : 0;
+	while (std::filesystem::exists(name(n)) || std::filesystem::exists(name(n).string() + ".gz"))
+		n++;
+	std::filesystem::path target = name(n);
+	this->_ArchiveStamp = stamp;
+	this->_ArchiveSeq = n;
+
+	std::error_code ec;
+	std::filesystem::rename(path, target, ec);
+	if (ec)
+	{
+		std::cerr << ("[FileSink] Failed to rotate " + path.string() + ": " + ec.message() + "\n") << std::flush;
+		return;
+	}
+
+	if (this->_opts.compress)
+	{
+		std::lock_guard<std::mutex> lk(this->_CompressorMtx);
+		this->_pending.push(std::move(target));
+		this->_CompressorCv.notify_one();
+	}
+	else
+		this->_prune();
+}
+
+void FileSink::_prune()
+{
+	const auto& path = this->_opts.path;
+	const std::string prefix = path.stem().string() + ".";
+
+	std::vector<std::filesystem::path> backups;
+	std::error_code ec;
+	auto folder = path.has_parent_path() ? path.parent_path() : std::filesystem::path(".");
+	for (const auto& entry : std::filesystem::directory_iterator(folder, ec))
+	{
+		auto filename = entry.path().filename().string();
+		if (!entry.is_regular_file() || filename == path.filename().string()) continue;
+		if (filename.rfind(prefix, 0) != 0 || filename.ends_with(".tmp")) continue;
+		backups.push_back(entry.path());
+	}
+
+	if (backups.size() <= this->_opts.MaxBackups) return;
+
+	std::sort(backups.begin(), backups.end(),
+	          [&prefix](const auto& a, const auto& b)
+	          { return BackupOrder(a, prefix.size()) < BackupOrder(b, prefix.size()); });
+	for (size_t i = 0; i < backups.size() - this->_opts.MaxBackups; i++)
+		std::filesystem::remove(backups[i], ec);
+}
+
+void FileSink::_CompressorLoop()
+{
+	while (true)
+	{
+		std::filesystem::path file;
+		{
+			std::unique_lock<std::mutex> lk(this->_CompressorMtx);
+			this->_CompressorCv.wait(lk, [this] { return !this->_pending.empty() || this->_CompressorStop; });
+			if (this->_pending.empty()) return;
+			file = std::move(this->_pending.front());
+			this->_pending.pop();
+		}
+
+		// Already pruned while it was waiting
+		std::error_code ec;
+		if (!std::filesystem::exists(file, ec)) continue;
+
+		std::filesystem::path tmp = file.string() + ".gz.tmp";
+		if (CompressFile(file, tmp))
+		{
+			std::filesystem::rename(tmp, file.string() + ".gz", ec);
+			if (!ec) std::filesystem::remove(file, ec);
+		}
+		else
+		{
+			ReportError("Failed to compress " + file.string());
+			std::filesystem::remove(tmp, ec);
+		}
+
+		std::lock_guard<std::mutex> lk(this->_FileMtx);
+		this->_prune();
+	}
+}
+
+} // namespace Utils
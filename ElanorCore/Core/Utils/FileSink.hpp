@@ -0,0 +1,99 @@
+#ifndef _ELANOR_CORE_FILE_SINK_HPP_
+#define _ELANOR_CORE_FILE_SINK_HPP_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include <libmirai/Utils/Logger.hpp>
+
+namespace Utils
+{
+
+constexpr uint32_t LevelMask(Mirai::LoggingLevels level)
+{
+	return 1U << static_cast<uint32_t>(level);
+}
+
+constexpr uint32_t ALL_LEVELS = ~0U;
+
+struct FileSinkOptions
+{
+	std::filesystem::path path;
+	uint32_t levels = ALL_LEVELS;
+
+	// Rotate once the active file grows beyond MaxFileSize, keep at most MaxBackups rotated files
+	std::size_t MaxFileSize = 64 * 1024 * 1024;     // NOLINT(*-avoid-magic-numbers)
+	std::size_t MaxBackups = 8;                     // NOLINT(*-avoid-magic-numbers)
+	std::size_t BufferSize = 1024 * 1024;           // NOLINT(*-avoid-magic-numbers)
+	std::chrono::milliseconds FlushInterval{1000};  // NOLINT(*-avoid-magic-numbers)
+	bool compress = true;
+
+	bool operator==(const FileSinkOptions&) const = default;
+};
+
+class FileSink
+{
+protected:
+	const FileSinkOptions _opts;
+
+	// Guards the file descriptor, batches are written in the order they were taken from _buffer
+	std::mutex _FileMtx;
+	int _fd = -1;
+	std::size_t _written = 0;
+	// Name of the last rotated file, see _archive
+	std::string _ArchiveStamp;
+	int _ArchiveSeq = 0;
+
+	// Lines are appended to _buffer by the loggers and handed over to the writer thread in batches
+	std::string _buffer;
+	bool _stop = false;
+	mutable std::mutex _mtx;
+	std::condition_variable _cv;
+	std::condition_variable _cv_drained;
+	std::thread _writer;
+
+	std::queue<std::filesystem::path> _pending;
+	bool _CompressorStop = false;
+	std::mutex _CompressorMtx;
+	std::condition_variable _CompressorCv;
+	std::thread _compressor;
+
+	// Archives a non-empty file first unless resume is set, then the file is appended to
+	void _open(bool resume = false);
+	void _close();
+	void _archive();
+	void _rotate();
+	void _WriteAll(std::string_view data);
+	void _prune();
+
+	void _WriterLoop();
+	void _CompressorLoop();
+
+public:
+	// resume continues the existing file, for a sink replacing another one on the same path
+	explicit FileSink(FileSinkOptions opts, bool resume = false);
+	FileSink(const FileSink&) = delete;
+	FileSink& operator=(const FileSink&) = delete;
+	FileSink(FileSink&&) = delete;
+	FileSink& operator=(FileSink&&) = delete;
+
+	const FileSinkOptions& options() const { return this->_opts; }
+	bool accept(Mirai::LoggingLevels level) const { return (this->_opts.levels & LevelMask(level)) != 0; }
+
+	void write(std::string_view line);
+	void flush();
+
+	~FileSink();
+};
+
+} // namespace Utils
+
+#endif
@@ -1,5 +1,6 @@
 #include "Logger.hpp"
 
+#include <algorithm>
 #include <chrono>
 #include <ctime>
 #include <iostream>
@@ -9,7 +10,7 @@
 namespace
 {
 
-std::string GetTimestamp()
+std::string GetTimestamp(bool colored = true)
 {
 	using namespace std::chrono;
 	auto tp = system_clock::now();
@@ -17,7 +18,8 @@ std::string GetTimestamp()
 
 	constexpr size_t BUFFER_SIZE = 128;
 	char buf[BUFFER_SIZE]; // NOLINT(*-avoid-c-arrays)
-	std::strftime(buf, BUFFER_SIZE, "\x1b[95m%Y-%m-%d %H:%M:%S\x1b[0m", std::localtime(&t));
+	std::strftime(buf, BUFFER_SIZE, (colored) ? "\x1b[95m%Y-%m-%d %H:%M:%S\x1b[0m" : "%Y-%m-%d %H:%M:%S",
+	              std::localtime(&t));
 	return {buf};
 }
 
@@ -42,6 +44,27 @@ constexpr std::string_view GetLevelStr(Mirai::LoggingLevels level)
 	}
 }
 
+constexpr std::string_view GetPlainLevelStr(Mirai::LoggingLevels level)
+{
+	switch (level)
+	{
+	case Mirai::LoggingLevels::TRACE:
+		return " [TRACE] ";
+	case Mirai::LoggingLevels::DEBUG:
+		return " [DEBUG] ";
+	case Mirai::LoggingLevels::INFO:
+		return " [INFO] ";
+	case Mirai::LoggingLevels::WARN:
+		return " [WARN] ";
+	case Mirai::LoggingLevels::ERROR:
+		return " [ERROR] ";
+	case Mirai::LoggingLevels::FATAL:
+		return " [FATAL] ";
+	default:
+		return "";
+	}
+}
+
 } // namespace
 
 namespace Utils
@@ -49,10 +72,53 @@ namespace Utils
 
 void Logger::log(const std::string& msg, Mirai::LoggingLevels level)
 {
-	std::string text;
-	text = GetTimestamp() + std::string(GetLevelStr(level)) + msg + '\n';
-	std::cout << text;
+	if (this->_console)
+	{
+		std::string text;
+		text = GetTimestamp() + std::string(GetLevelStr(level)) + msg + '\n';
+		std::cout << text;
+		std::cout.flush();
+	}
+
+	auto sinks = this->_sinks.load();
+	if (sinks->empty()) return;
+
+	std::string line;
+	for (const auto& sink : *sinks)
+	{
+		if (!sink->accept(level)) continue;
+		if (line.empty()) line = GetTimestamp(false) + std::string(GetPlainLevelStr(level)) + msg + '\n';
+		sink->write(line);
+	}
+}
+
+void Logger::SetFileSinks(const std::vector<FileSinkOptions>& sinks)
+{
+	auto current = this->_sinks.load();
+	auto updated = std::make_shared<SinkList>();
+	for (const auto& opts : sinks)
+	{
+		auto same = std::find_if(current->begin(), current->end(),
+		                         [&opts](const auto& sink) { return sink->options() == opts; });
+		if (same != current->end())
+		{
+			updated->push_back(*same);
+			continue;
+		}
+		const bool resume = std::any_of(current->begin(), current->end(),
+		                                [&opts](const auto& sink) { return sink->options().path == opts.path; });
+		updated->push_back(std::make_shared<FileSink>(opts, resume));
+	}
+
+	// Dropped sinks flush and close once the last logging thread releases them
+	this->_sinks.store(std::move(updated));
+}
+
+void Logger::flush()
+{
 	std::cout.flush();
+	for (const auto& sink : *this->_sinks.load())
+		sink->flush();
 }
 
 namespace
@@ -1,17 +1,34 @@
 #ifndef _ELANOR_CORE_LOGGER_HPP_
 #define _ELANOR_CORE_LOGGER_HPP_
 
+#include <atomic>
 #include <memory>
+#include <vector>
 
 #include <libmirai/Utils/Logger.hpp>
 
+#include "FileSink.hpp"
+
 namespace Utils
 {
 
 class Logger : public Mirai::ILogger
 {
+protected:
+	using SinkList = std::vector<std::shared_ptr<FileSink>>;
+
+	// Swapped as a whole so that logging threads never wait on reconfiguration
+	std::atomic<std::shared_ptr<const SinkList>> _sinks{std::make_shared<const SinkList>()};
+	std::atomic<bool> _console = true;
+
 public:
 	void log(const std::string& msg, Mirai::LoggingLevels level) override;
+
+	// Replaces the file sinks in a single swap. Sinks whose options did not change are kept as they are,
+	// a changed sink continues the file of the one it replaces
+	void SetFileSinks(const std::vector<FileSinkOptions>& sinks);
+	void SetConsole(bool enable) { this->_console = enable; }
+	void flush();
 };
 
 std::shared_ptr<Logger> GetLoggerPtr();
@@ -19,4 +36,4 @@ Logger& GetLogger();
 
 } // namespace Utils
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,212 @@
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <gtest/gtest.h>
+#include <nlohmann/json.hpp>
+
+#include <Core/Utils/Common.hpp>
+
+// NOLINTBEGIN
+
+using json = nlohmann::json;
+
+namespace
+{
+
+namespace fs = std::filesystem;
+
+class BotConfigTest : public ::testing::Test
+{
+protected:
+	fs::path path;
+
+	void SetUp() override
+	{
+		path = fs::temp_directory_path() / ("elanor-bot-config-" + std::to_string(std::random_device{}()) + ".json");
+	}
+
+	void TearDown() override { fs::remove(path); }
+
+	bool Load(Utils::BotConfig& config, const std::string& content) const
+	{
+		std::ofstream(path) << content;
+		return config.FromFile(path.string());
+	}
+};
+
+const json TREE = json::parse(R"({
+	"bot": {"name": "elanor", "admins": [10, 20, 30]},
+	"a/b": 1,
+	"m~n": 2,
+	"proxy": null,
+	"": {"empty": true}
+})");
+
+} // namespace
+
+TEST(ConfigKeyTest, ResolvesLikeJsonPointer)
+{
+	for (const auto* path :
+	     {"", "/bot", "/bot/name", "/bot/admins", "/bot/admins/0", "/bot/admins/2", "/a~1b", "/m~0n", "/proxy", "/",
+	      "//empty"})
+	{
+		const auto* node = Utils::ConfigKey(path).resolve(TREE);
+		ASSERT_NE(node, nullptr) << path;
+		EXPECT_EQ(*node, TREE.at(json::json_pointer(path))) << path;
+	}
+	EXPECT_EQ(Utils::ConfigKey("").resolve(TREE), &TREE);
+	EXPECT_EQ(Utils::ConfigKey("/bot/admins").str(), "/bot/admins");
+}
+
+TEST(ConfigKeyTest, MissingNodesAreNull)
+{
+	for (const auto* path :
+	     {"/missing", "/bot/missing", "/bot/name/x", "/bot/admins/3", "/bot/admins/-", "/bot/admins/01",
+	      "/bot/admins/1x", "/bot/admins/", "/proxy/host", "/a/b"})
+		EXPECT_EQ(Utils::ConfigKey(path).resolve(TREE), nullptr) << path;
+}
+
+TEST(ConfigKeyTest, RejectsMalformedKeys)
+{
+	EXPECT_THROW(Utils::ConfigKey("bot"), std::invalid_argument);
+	EXPECT_THROW(Utils::ConfigKey("/a~2b"), std::invalid_argument);
+	EXPECT_THROW(Utils::ConfigKey("/a~"), std::invalid_argument);
+}
+
+TEST(ConfigViewTest, ReadsValuesWithDefaults)
+{
+	Utils::BotConfig config(TREE);
+	auto view = config.View();
+	EXPECT_EQ(view.Get("/bot/name", std::string("x")), "elanor");
+	EXPECT_EQ(view.Get("/bot/nick", "x"), "x");
+	EXPECT_EQ(view.Get("/bot/admins/1", 0), 20);
+	EXPECT_EQ(view.Get<int>("/bot/admins/1"), 20);
+	EXPECT_EQ(view.Get<int>("/bot/admins/5"), std::nullopt);
+
+	EXPECT_TRUE(view.exist("/proxy"));
+	EXPECT_TRUE(view.IsNull("/proxy"));
+	EXPECT_FALSE(view.exist("/proxy/host"));
+	EXPECT_FALSE(view.IsNull("/proxy/host"));
+	EXPECT_FALSE(view.IsNull("/bot"));
+
+	// Types that don't fit are errors rather than defaults
+	EXPECT_THROW(view.Get("/bot/name", 0), json::type_error);
+}
+
+TEST_F(BotConfigTest, ViewKeepsItsSnapshotAcrossReloads)
+{
+	Utils::BotConfig config;
+	ASSERT_TRUE(Load(config, R"({"proxy": {"host": "a", "port": 1}})"));
+	auto view = config.View();
+
+	ASSERT_TRUE(Load(config, R"({"proxy": {"host": "b", "port": 2}})"));
+	EXPECT_EQ(view.Get("/proxy/host", std::string()), "a");
+	EXPECT_EQ(view.Get("/proxy/port", 0), 1);
+	EXPECT_EQ(config.Get("/proxy/host", std::string()), "b");
+	EXPECT_EQ(config.View().Get("/proxy/port", 0), 2);
+}
+
+TEST_F(BotConfigTest, RejectedFilesKeepThePreviousSnapshot)
+{
+	Utils::BotConfig config;
+	ASSERT_TRUE(Load(config, R"({"bot": {"name": "elanor", "limit": 1}, "proxy": {"host": "a"}})"));
+	const auto snapshot = config.GetSnapshot();
+
+	EXPECT_FALSE(Load(config, R"({"bot": )"));
+	EXPECT_FALSE(Load(config, R"([1, 2])"));
+	EXPECT_FALSE(Load(config, R"({"bot": {"name": 1}})"));
+	EXPECT_FALSE(Load(config, R"({"bot": []})"));
+	EXPECT_FALSE(config.FromFile((path.string() + ".missing")));
+	EXPECT_EQ(config.GetSnapshot(), snapshot);
+
+	// Numbers may change kind, null switches sections off and entries may come and go
+	EXPECT_TRUE(Load(config, R"({"bot": {"name": "elanor", "limit": 1.5, "new": true}, "proxy": null})"));
+	EXPECT_DOUBLE_EQ(config.Get("/bot/limit", 0.0), 1.5);
+	EXPECT_TRUE(config.IsNull("/proxy"));
+	EXPECT_TRUE(Load(config, R"({"proxy": {"host": "b"}})"));
+	EXPECT_FALSE(config.exist("/bot"));
+}
+
+TEST_F(BotConfigTest, SubscribersRunOnlyWhenTheirSubtreeChanges)
+{
+	Utils::BotConfig config;
+	ASSERT_TRUE(Load(config, R"({"bot": {"name": "elanor"}, "proxy": {"host": "a", "port": 1}})"));
+
+	int proxy = 0, port = 0, missing = 0;
+	auto s1 = config.Subscribe("/proxy", [&proxy] { proxy++; });
+	auto s2 = config.Subscribe("/proxy/port", [&port] { port++; });
+	auto s3 = config.Subscribe("/media", [&missing] { missing++; });
+
+	ASSERT_TRUE(Load(config, R"({"bot": {"name": "other"}, "proxy": {"host": "a", "port": 1}})"));
+	EXPECT_EQ(proxy, 0);
+	EXPECT_EQ(port, 0);
+
+	ASSERT_TRUE(Load(config, R"({"bot": {"name": "other"}, "proxy": {"host": "b", "port": 1}})"));
+	EXPECT_EQ(proxy, 1);
+	EXPECT_EQ(port, 0);
+
+	ASSERT_TRUE(Load(config, R"({"bot": {"name": "other"}, "proxy": {"host": "b", "port": 2}})"));
+	EXPECT_EQ(proxy, 2);
+	EXPECT_EQ(port, 1);
+
+	// Appearing and disappearing count as changes
+	ASSERT_TRUE(Load(config, R"({"proxy": {"host": "b", "port": 2}, "media": "/tmp"})"));
+	ASSERT_TRUE(Load(config, R"({"proxy": {"host": "b", "port": 2}})"));
+	EXPECT_EQ(missing, 2);
+
+	// Nothing runs for a rejected file
+	EXPECT_FALSE(Load(config, R"({"proxy": []})"));
+	EXPECT_EQ(proxy, 2);
+}
+
+TEST_F(BotConfigTest, SubscriptionEndsWithItsHandle)
+{
+	Utils::BotConfig config;
+	ASSERT_TRUE(Load(config, R"({"value": 0})"));
+
+	int a = 0, b = 0;
+	auto first = config.Subscribe("/value", [&a] { a++; });
+	{
+		auto second = config.Subscribe("/value", [&b] { b++; });
+		ASSERT_TRUE(Load(config, R"({"value": 1})"));
+	}
+	ASSERT_TRUE(Load(config, R"({"value": 2})"));
+	EXPECT_EQ(a, 2);
+	EXPECT_EQ(b, 1);
+
+	// Moving hands the subscription over, reset ends it
+	Utils::BotConfig::Subscription moved = std::move(first);
+	ASSERT_TRUE(Load(config, R"({"value": 3})"));
+	EXPECT_EQ(a, 3);
+	moved.reset();
+	ASSERT_TRUE(Load(config, R"({"value": 4})"));
+	EXPECT_EQ(a, 3);
+}
+
+TEST_F(BotConfigTest, FailingSubscriberDoesNotStopTheOthers)
+{
+	Utils::BotConfig config;
+	ASSERT_TRUE(Load(config, R"({"value": 0})"));
+
+	int count = 0;
+	auto failing = config.Subscribe("/value", [] { throw std::runtime_error("failed"); });
+	auto counting = config.Subscribe("/value", [&count] { count++; });
+	EXPECT_TRUE(Load(config, R"({"value": 1})"));
+	EXPECT_EQ(count, 1);
+	EXPECT_EQ(config.Get("/value", 0), 1);
+}
+
+TEST(BotConfigSubscriptionTest, MayOutliveTheConfig)
+{
+	Utils::BotConfig::Subscription subscription;
+	{
+		auto config = std::make_unique<Utils::BotConfig>(json::object());
+		subscription = config->Subscribe("/value", [] {});
+	}
+	EXPECT_NO_FATAL_FAILURE(subscription.reset());
+}
+
+// NOLINTEND
@@ -0,0 +1,248 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include <zlib.h>
+
+#include <Core/Utils/FileSink.hpp>
+
+// NOLINTBEGIN
+
+namespace
+{
+
+namespace fs = std::filesystem;
+
+class FileSinkTest : public ::testing::Test
+{
+protected:
+	fs::path dir;
+	fs::path path;
+
+	void SetUp() override
+	{
+		dir = fs::temp_directory_path() / ("elanor-file-sink-" + std::to_string(std::random_device{}()));
+		fs::remove_all(dir);
+		path = dir / "bot.log";
+	}
+
+	void TearDown() override { fs::remove_all(dir); }
+
+	Utils::FileSinkOptions Options() const
+	{
+		Utils::FileSinkOptions opts;
+		opts.path = path;
+		opts.compress = false;
+		return opts;
+	}
+
+	// Rotated files next to the active one
+	std::vector<fs::path> Backups() const
+	{
+		std::vector<fs::path> result;
+		for (const auto& entry : fs::directory_iterator(dir))
+			if (entry.path() != path) result.push_back(entry.path());
+		std::sort(result.begin(), result.end());
+		return result;
+	}
+
+	static std::string Read(const fs::path& file)
+	{
+		if (file.extension() == ".gz")
+		{
+			gzFile in = gzopen(file.c_str(), "rb");
+			EXPECT_NE(in, nullptr);
+			std::string result;
+			char buffer[4096];
+			int n = 0;
+			while ((n = gzread(in, buffer, sizeof(buffer))) > 0)
+				result.append(buffer, n);
+			EXPECT_EQ(n, 0);
+			gzclose(in);
+			return result;
+		}
+		std::ifstream in(file, std::ios::binary);
+		std::stringstream ss;
+		ss << in.rdbuf();
+		return ss.str();
+	}
+
+	static void Touch(const fs::path& file, const std::string& content)
+	{
+		fs::create_directories(file.parent_path());
+		std::ofstream(file, std::ios::binary) << content;
+	}
+};
+
+std::string Line(int i)
+{
+	return "line " + std::to_string(i) + "\n";
+}
+
+} // namespace
+
+TEST_F(FileSinkTest, LinesAreWrittenOnFlushAndDestruction)
+{
+	{
+		Utils::FileSink sink(Options());
+		sink.write(Line(0));
+		sink.flush();
+		EXPECT_EQ(Read(path), Line(0));
+
+		sink.write(Line(1));
+	}
+	// The preallocated space is released again
+	EXPECT_EQ(Read(path), Line(0) + Line(1));
+	EXPECT_EQ(fs::file_size(path), (Line(0) + Line(1)).size());
+	EXPECT_TRUE(Backups().empty());
+}
+
+TEST_F(FileSinkTest, AcceptsConfiguredLevels)
+{
+	auto opts = Options();
+	opts.levels = Utils::LevelMask(Mirai::LoggingLevels::WARN) | Utils::LevelMask(Mirai::LoggingLevels::ERROR);
+	Utils::FileSink sink(opts);
+	EXPECT_TRUE(sink.accept(Mirai::LoggingLevels::WARN));
+	EXPECT_TRUE(sink.accept(Mirai::LoggingLevels::ERROR));
+	EXPECT_FALSE(sink.accept(Mirai::LoggingLevels::INFO));
+	EXPECT_FALSE(sink.accept(Mirai::LoggingLevels::FATAL));
+}
+
+TEST_F(FileSinkTest, RotatesBySize)
+{
+	auto opts = Options();
+	opts.MaxFileSize = 3 * Line(0).size();
+	opts.MaxBackups = 100;
+	{
+		Utils::FileSink sink(opts);
+		for (int i = 0; i < 10; i++)
+		{
+			sink.write(Line(i));
+			sink.flush();
+		}
+	}
+
+	// Every third line fills a file, the tenth one is left in the active file
+	const auto backups = Backups();
+	ASSERT_EQ(backups.size(), 3);
+	std::string all;
+	for (const auto& backup : backups)
+	{
+		EXPECT_EQ(backup.extension(), ".log");
+		const auto content = Read(backup);
+		EXPECT_EQ(content.size(), opts.MaxFileSize);
+		all += content;
+	}
+	EXPECT_EQ(Read(path), Line(9));
+
+	// Nothing is lost or duplicated across the files
+	for (int i = 0; i < 9; i++)
+		EXPECT_NE(all.find(Line(i)), std::string::npos) << i;
+	EXPECT_EQ(all.size(), 9 * Line(0).size());
+}
+
+TEST_F(FileSinkTest, CompressesRotatedFiles)
+{
+	auto opts = Options();
+	opts.compress = true;
+	opts.MaxFileSize = 50;
+	opts.MaxBackups = 100;
+	std::string expected;
+	{
+		Utils::FileSink sink(opts);
+		for (int i = 0; i < 50; i++)
+		{
+			sink.write(Line(i));
+			expected += Line(i);
+			if (i % 10 == 9) sink.flush();
+		}
+	}
+
+	// The compressor finishes its queue before the sink is gone
+	const auto backups = Backups();
+	ASSERT_EQ(backups.size(), 5);
+	std::string all;
+	for (const auto& backup : backups)
+	{
+		EXPECT_EQ(backup.extension(), ".gz") << backup;
+		all += Read(backup);
+	}
+	EXPECT_EQ(Read(path), "");
+
+	std::vector<std::string> lines, expected_lines;
+	for (std::stringstream ss(all); std::getline(ss, lines.emplace_back());) {}
+	for (std::stringstream ss(expected); std::getline(ss, expected_lines.emplace_back());) {}
+	std::sort(lines.begin(), lines.end());
+	std::sort(expected_lines.begin(), expected_lines.end());
+	EXPECT_EQ(lines, expected_lines);
+}
+
+TEST_F(FileSinkTest, KeepsAtMostMaxBackups)
+{
+	for (bool compress : {false, true})
+	{
+		fs::remove_all(dir);
+		auto opts = Options();
+		opts.compress = compress;
+		opts.MaxFileSize = Line(0).size();
+		opts.MaxBackups = 2;
+		{
+			Utils::FileSink sink(opts);
+			for (int i = 0; i < 6; i++)
+			{
+				sink.write(Line(i));
+				sink.flush();
+			}
+		}
+		// The newest ones are kept, even though the ones rotated within the same second get a suffix
+		std::vector<std::string> kept;
+		for (const auto& backup : Backups())
+			kept.push_back(Read(backup));
+		std::sort(kept.begin(), kept.end());
+		EXPECT_EQ(kept, (std::vector<std::string>{Line(4), Line(5)})) << "compress " << compress;
+	}
+}
+
+TEST_F(FileSinkTest, LeftoversAreArchivedUnlessResumed)
+{
+	Touch(path, "previous run\n");
+	Touch(dir / "other.log", "not ours\n");
+	{
+		Utils::FileSink sink(Options());
+		sink.write(Line(0));
+	}
+	EXPECT_EQ(Read(path), Line(0));
+	auto backups = Backups();
+	ASSERT_EQ(backups.size(), 2);
+	EXPECT_EQ(Read(dir / "other.log"), "not ours\n");
+	EXPECT_EQ(Read(backups[0].filename() == "other.log" ? backups[1] : backups[0]), "previous run\n");
+
+	// A sink replacing another one on a reload carries on with the same file
+	{
+		Utils::FileSink sink(Options(), true);
+		sink.write(Line(1));
+	}
+	EXPECT_EQ(Read(path), Line(0) + Line(1));
+	EXPECT_EQ(Backups().size(), 2);
+}
+
+TEST_F(FileSinkTest, ResumedSinkDoesNotClobberTheOldOne)
+{
+	auto old = std::make_unique<Utils::FileSink>(Options());
+	old->write(Line(0));
+	old->flush();
+
+	Utils::FileSink sink(Options(), true);
+	old->write(Line(1));
+	old.reset();
+	sink.write(Line(2));
+	sink.flush();
+	EXPECT_EQ(Read(path), Line(0) + Line(1) + Line(2));
+}
+
+// NOLINTEND
@@ -29,11 +29,11 @@ bool BlackList::Execute(const Mirai::GroupMessageEvent& gm, Bot::Group& group, B
 	string str = Utils::ReplaceMark(Utils::GetText(gm.GetMessage()));
 	if (!Utils::trim(str).empty() && Utils::trim(str)[0] != '#') return false;
 
-	vector<string> tokens;
-	if (Utils::Tokenize(str, tokens) < 2) return false;
+	Utils::TokenList<2> head(str);
+	if (head.size() < 2 || !(Utils::iequals(head[0], "#black") || Utils::iequals(head[0], "#黑名单") || Utils::iequals(head[0], "#blacklist"))) return false;
 
-	string command = Utils::toLower(tokens[0]);
-	if (command != "#black" && command != "#黑名单" && command != "#blacklist") return false;
+	vector<string> tokens;
+	Utils::Tokenize(str, tokens);
 
 
 	LOG_INFO(Utils::GetLogger(), "Calling BlackList <BlackList>" + Utils::GetDescription(gm.GetSender()));
@@ -45,7 +45,7 @@ bool BlackList::Execute(const Mirai::GroupMessageEvent& gm, Bot::Group& group, B
 		return true;
 	}
 
-	command = Utils::toLower(tokens[1]);
+	string command = Utils::toLower(tokens[1]);
 	if (command == "help" || command == "h" || command == "帮助")
 	{
 		LOG_INFO(Utils::GetLogger(), "帮助文档 <BlackList>" + Utils::GetDescription(gm.GetSender(), false));
@@ -30,11 +30,11 @@ bool CommandAuth::Execute(const Mirai::GroupMessageEvent& gm, Bot::Group& group,
 	string str = Utils::ReplaceMark(Utils::GetText(gm.GetMessage()));
 	if (!Utils::trim(str).empty() && Utils::trim(str)[0] != '#') return false;
 
-	vector<string> tokens;
-	if (Utils::Tokenize(str, tokens) < 2) return false;
+	Utils::TokenList<2> head(str);
+	if (head.size() < 2 || !(Utils::iequals(head[0], "#auth") || Utils::iequals(head[0], "#权限"))) return false;
 
-	string command = Utils::toLower(tokens[0]);
-	if (command != "#auth" && command != "#权限") return false;
+	vector<string> tokens;
+	Utils::Tokenize(str, tokens);
 
 
 	LOG_INFO(Utils::GetLogger(), "Calling Auth <CommandAuth>" + Utils::GetDescription(gm.GetSender()));
@@ -47,7 +47,7 @@ bool CommandAuth::Execute(const Mirai::GroupMessageEvent& gm, Bot::Group& group,
 	}
 
 
-	command = Utils::toLower(tokens[1]);
+	string command = Utils::toLower(tokens[1]);
 
 	if (command == "help" || command == "h" || command == "帮助")
 	{
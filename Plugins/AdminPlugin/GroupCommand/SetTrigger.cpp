@@ -27,11 +27,11 @@ bool SetTrigger::Execute(const Mirai::GroupMessageEvent& gm, Bot::Group& group,
 	string str = Utils::ReplaceMark(Utils::GetText(gm.GetMessage()));
 	if (!Utils::trim(str).empty() && Utils::trim(str)[0] != '#') return false;
 
-	vector<string> tokens;
-	if (Utils::Tokenize(str, tokens) < 2) return false;
+	Utils::TokenList<2> head(str);
+	if (head.size() < 2 || !(Utils::iequals(head[0], "#trig") || Utils::iequals(head[0], "#trigger") || Utils::iequals(head[0], "#触发器"))) return false;
 
-	string command = Utils::toLower(tokens[0]);
-	if (command != "#trig" && command != "#trigger" && command != "#触发器") return false;
+	vector<string> tokens;
+	Utils::Tokenize(str, tokens);
 
 
 	LOG_INFO(Utils::GetLogger(), "Calling SetTrigger <SetTrigger>" + Utils::GetDescription(gm.GetSender()));
@@ -43,7 +43,7 @@ bool SetTrigger::Execute(const Mirai::GroupMessageEvent& gm, Bot::Group& group,
 		return true;
 	}
 
-	command = Utils::toLower(tokens[1]);
+	string command = Utils::toLower(tokens[1]);
 
 	if (command == "help" || command == "h" || command == "帮助")
 	{
@@ -27,11 +27,11 @@ bool WhiteList::Execute(const Mirai::GroupMessageEvent& gm, Bot::Group& group, B
 	string str = Utils::ReplaceMark(Utils::GetText(gm.GetMessage()));
 	if (!Utils::trim(str).empty() && Utils::trim(str)[0] != '#') return false;
 
-	vector<string> tokens;
-	if (Utils::Tokenize(str, tokens) < 2) return false;
+	Utils::TokenList<2> head(str);
+	if (head.size() < 2 || !(Utils::iequals(head[0], "#white") || Utils::iequals(head[0], "#白名单") || Utils::iequals(head[0], "#whitelist"))) return false;
 
-	string command = Utils::toLower(tokens[0]);
-	if (command != "#white" && command != "#白名单" && command != "#whitelist") return false;
+	vector<string> tokens;
+	Utils::Tokenize(str, tokens);
 
 
 	LOG_INFO(Utils::GetLogger(), "Calling WhiteList <WhiteList>" + Utils::GetDescription(gm.GetSender()));
@@ -44,7 +44,7 @@ bool WhiteList::Execute(const Mirai::GroupMessageEvent& gm, Bot::Group& group, B
 	}
 
 
-	command = Utils::toLower(tokens[1]);
+	string command = Utils::toLower(tokens[1]);
 	if (command == "help" || command == "h" || command == "帮助")
 	{
 		LOG_INFO(Utils::GetLogger(), "帮助文档 <WhiteList>" + Utils::GetDescription(gm.GetSender(), false));
@@ -15,7 +15,7 @@ using TriggerList = Utils::TypeList<>;
 extern "C"
 {
 
-	void InitPlugin() {}
+	void InitPlugin(const Utils::BotConfig& /*config*/) {}
 
 
 	const char* GetPluginName()
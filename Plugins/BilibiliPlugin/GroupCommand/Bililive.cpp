@@ -48,11 +48,11 @@ bool Bililive::Execute(const Mirai::GroupMessageEvent& gm, Bot::Group& group, Bo
 	string str = Utils::ReplaceMark(Utils::GetText(gm.GetMessage()));
 	if (!Utils::trim(str).empty() && Utils::trim(str)[0] != '#') return false;
 
-	vector<string> tokens;
-	if (Utils::Tokenize(str, tokens) < 2) return false;
+	Utils::TokenList<2> head(str);
+	if (head.size() < 2 || !(Utils::iequals(head[0], "#live") || Utils::iequals(head[0], "#直播"))) return false;
 
-	string command = Utils::toLower(tokens[0]);
-	if (command != "#live" && command != "#直播") return false;
+	vector<string> tokens;
+	Utils::Tokenize(str, tokens);
 
 
 	LOG_INFO(Utils::GetLogger(), "Calling Bililive <Bililive>" + Utils::GetDescription(gm.GetSender()));
@@ -65,7 +65,7 @@ bool Bililive::Execute(const Mirai::GroupMessageEvent& gm, Bot::Group& group, Bo
 	}
 
 
-	command = Utils::toLower(tokens[1]);
+	string command = Utils::toLower(tokens[1]);
 
 	if (command == "help" || command == "h" || command == "帮助")
 	{
@@ -75,8 +75,8 @@ bool Bililive::Execute(const Mirai::GroupMessageEvent& gm, Bot::Group& group, Bo
 		return true;
 	}
 
-	httplib::Client cli("https://api.live.bilibili.com");
-	SetClientOptions(cli);
+	auto cli = Utils::GetHttpClient("https://api.live.bilibili.com");
+	SetClientOptions(*cli);
 
 	auto state = group.GetState<State::CustomState>();
 	auto bililist =
@@ -87,7 +87,7 @@ bool Bililive::Execute(const Mirai::GroupMessageEvent& gm, Bot::Group& group, Bo
 		string message = "直播间列表: ";
 		for (const auto& [uid, info] : bililist.user_list)
 		{
-			auto result = cli.Get(
+			auto result = cli->Get(
 				"/live_user/v1/Master/info", 
 				{{"uid", std::to_string(uid)}},
 				{
@@ -118,7 +118,7 @@ bool Bililive::Execute(const Mirai::GroupMessageEvent& gm, Bot::Group& group, Bo
 			}
 			message += "\n" + content["data"]["info"]["uname"].get<string>() + " (" + std::to_string(uid) + "): ";
 
-			result = cli.Get(
+			result = cli->Get(
 				"/room/v1/Room/get_info", 
 				{{"id", std::to_string(info.room_id)}},
 				{
@@ -187,7 +187,7 @@ bool Bililive::Execute(const Mirai::GroupMessageEvent& gm, Bot::Group& group, Bo
 				return true;
 			}
 
-			auto result = cli.Get(
+			auto result = cli->Get(
 				"/live_user/v1/Master/info", 
 				{{"uid", std::to_string(uid)}}, 
 				{
@@ -263,7 +263,7 @@ bool Bililive::Execute(const Mirai::GroupMessageEvent& gm, Bot::Group& group, Bo
 				return true;
 			}
 
-			auto result = cli.Get(
+			auto result = cli->Get(
 				"/live_user/v1/Master/info", 
 				{{"uid", std::to_string(uid)}}, 
 				{
@@ -1,4 +1,5 @@
 #include <GroupCommand/Bililive.hpp>
+#include <PluginUtils/RateGovernor.hpp>
 #include <PluginUtils/TypeList.hpp>
 #include <Trigger/BililiveTrigger.hpp>
 
@@ -12,7 +13,12 @@ using TriggerList = Utils::TypeList< Trigger::BililiveTrigger >;
 extern "C"
 {
 
-	void InitPlugin() {}
+	void InitPlugin(const Utils::BotConfig& /*config*/)
+	{
+		// Shared by the live trigger and the bililive command of every group
+		// NOLINTNEXTLINE(*-avoid-magic-numbers)
+		Utils::RateGovernor::GetInstance().SetLimits("https://api.live.bilibili.com", {.RequestsPerSecond = 2, .burst = 4});
+	}
 
 
 	const char* GetPluginName()
@@ -76,11 +76,11 @@ void BililiveTrigger::Action(Bot::GroupList& groups, Bot::Client& client, Utils:
 	auto stream = std::move(this->_streams.front());
 	this->_streams.pop();
 
-	httplib::Client cli("https://api.live.bilibili.com");
-	SetClientOptions(cli);
+	auto cli = Utils::GetHttpClient("https://api.live.bilibili.com");
+	SetClientOptions(*cli);
 
 	// Room info
-	auto result = cli.Get(
+	auto result = cli->Get(
 		"/room/v1/Room/get_info", 
 		{{"id", std::to_string(stream.RoomId)}},
 		{
@@ -134,7 +134,7 @@ void BililiveTrigger::Action(Bot::GroupList& groups, Bot::Client& client, Utils:
 		string title = content["data"]["title"].get<string>();
 		string cover = content["data"]["user_cover"].get<string>();
 		string area = content["data"]["area_name"].get<string>();
-		result = cli.Get(
+		result = cli->Get(
 			"/live_user/v1/Master/info", 
 			{{"uid", std::to_string(stream.uid)}},
 			{
@@ -42,7 +42,8 @@ bool AtBot::Execute(const Mirai::GroupMessageEvent& gm, Bot::Group& group, Bot::
 	constexpr std::array words = {"干嘛", "？"};
 	constexpr size_t words_count = words.size();
 
-	const std::filesystem::path filepath = config.Get("/path/MediaFiles", "MediaFiles") / std::filesystem::path("images/at");
+	static const Utils::ConfigKey MEDIA_KEY("/path/MediaFiles");
+	const std::filesystem::path filepath = config.Get(MEDIA_KEY, "MediaFiles") / std::filesystem::path("images/at");
 	vector<string> image;
 	for (const auto& entry : std::filesystem::directory_iterator(filepath))
 	{
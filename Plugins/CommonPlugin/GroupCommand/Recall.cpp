@@ -26,11 +26,11 @@ bool Recall::Execute(const Mirai::GroupMessageEvent& gm, Bot::Group& group, Bot:
 	string str = Utils::ReplaceMark(Utils::GetText(gm.GetMessage()));
 	if (!Utils::trim(str).empty() && Utils::trim(str)[0] != '#') return false;
 
-	vector<string> tokens;
-	if (Utils::Tokenize(str, tokens) < 1) return false;
+	Utils::TokenList<1> head(str);
+	if (head.empty() || !(Utils::iequals(head[0], "#recall") || Utils::iequals(head[0], "#撤回"))) return false;
 
-	string command = Utils::toLower(tokens[0]);
-	if (command != "#recall" && command != "#撤回") return false;
+	vector<string> tokens;
+	Utils::Tokenize(str, tokens);
 
 
 	LOG_INFO(Utils::GetLogger(), "Calling Recall <Recall>" + Utils::GetDescription(gm.GetSender()));
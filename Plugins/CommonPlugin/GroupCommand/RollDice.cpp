@@ -28,9 +28,11 @@ bool RollDice::Execute(const Mirai::GroupMessageEvent& gm, Bot::Group& group, Bo
 	string str = Utils::ReplaceMark(Utils::GetText(gm.GetMessage()));
 	if (!Utils::trim(str).empty() && Utils::trim(str)[0] != '#') return false;
 
+	Utils::TokenList<1> head(str);
+	if (head.empty() || !Utils::iequals(head[0], "#roll")) return false;
+
 	vector<string> tokens;
-	if (Utils::Tokenize(str, tokens) < 1) return false;
-	if (Utils::toLower(tokens[0]) != "#roll") return false;
+	Utils::Tokenize(str, tokens);
 
 
 	LOG_INFO(Utils::GetLogger(), "Calling RollDice <RollDice>" + Utils::GetDescription(gm.GetSender()));
@@ -22,7 +22,7 @@ using TriggerList = Utils::TypeList< Trigger::MorningTrigger >;
 extern "C"
 {
 
-	void InitPlugin() {}
+	void InitPlugin(const Utils::BotConfig& /*config*/) {}
 
 
 	const char* GetPluginName()
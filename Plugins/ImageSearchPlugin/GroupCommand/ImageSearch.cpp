@@ -35,11 +35,11 @@ bool ImageSearch::Execute(const Mirai::GroupMessageEvent& gm, Bot::Group& group,
 	string str = Utils::ReplaceMark(Utils::GetText(gm.GetMessage()));
 	if (!Utils::trim(str).empty() && Utils::trim(str)[0] != '#') return false;
 
-	vector<string> tokens;
-	if (Utils::Tokenize(str, tokens) < 1) return false;
+	Utils::TokenList<1> head(str);
+	if (head.empty() || !(Utils::iequals(head[0], "#search") || Utils::iequals(head[0], "#搜图"))) return false;
 
-	string command = Utils::toLower(tokens[0]);
-	if (command != "#search" && command !=  "#搜图") return false;
+	vector<string> tokens;
+	Utils::Tokenize(str, tokens);
 
 
 	LOG_INFO(Utils::GetLogger(), "Calling ImageSearch <ImageSearch>" + Utils::GetDescription(gm.GetSender()));
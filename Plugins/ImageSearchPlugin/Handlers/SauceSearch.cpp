@@ -100,13 +100,13 @@ void SearchSauce(std::string url, const Mirai::GroupMessageEvent& gm, Bot::Group
 	try
 	{
 		Utils::UrlComponent comp = Utils::UrlComponent::ParseUrl(url);
-		httplib::Client cli(comp.GetOrigin());
-		cli.set_decompress(true);
-		cli.set_connection_timeout(300); // NOLINT(*-avoid-magic-numbers)
-		cli.set_read_timeout(300);       // NOLINT(*-avoid-magic-numbers)
-		cli.set_write_timeout(120);      // NOLINT(*-avoid-magic-numbers)
+		auto cli = Utils::GetHttpClient(comp.GetOrigin());
+		cli->set_decompress(true);
+		cli->set_connection_timeout(300); // NOLINT(*-avoid-magic-numbers)
+		cli->set_read_timeout(300);       // NOLINT(*-avoid-magic-numbers)
+		cli->set_write_timeout(120);      // NOLINT(*-avoid-magic-numbers)
 
-		auto result = cli.Get(
+		auto result = cli->Get(
 			comp.GetRelativeRef(),
 			{	
 				{"Accept", "*/*"},
@@ -134,13 +134,20 @@ void SearchSauce(std::string url, const Mirai::GroupMessageEvent& gm, Bot::Group
 
 	using namespace SauceNAO;
 
-	SauceClient cli = [&]()
+	static const Utils::ConfigKey PROXY_KEY("/saucenao/proxy");
+	static const Utils::ConfigKey TOKEN_KEY("/saucenao/token");
+	static const Utils::ConfigKey HOST_KEY("/saucenao/proxy/host");
+	static const Utils::ConfigKey PORT_KEY("/saucenao/proxy/port");
+	static const Utils::ConfigKey DEFAULT_HOST_KEY("/proxy/host");
+	static const Utils::ConfigKey DEFAULT_PORT_KEY("/proxy/port");
+
+	SauceClient cli = [view = config.View()]()
 	{
-		if (config.IsNull("/saucenao/proxy")) return SauceClient(config.Get("/saucenao/token", ""), {});
+		if (view.IsNull(PROXY_KEY)) return SauceClient(view.Get(TOKEN_KEY, ""), {});
 		else
-			return SauceClient(config.Get("/saucenao/token", ""), {},
-			                   config.Get("/saucenao/proxy/host", config.Get("/proxy/host", "")),
-			                   config.Get("/saucenao/proxy/port", config.Get("/proxy/port", -1)));
+			return SauceClient(view.Get(TOKEN_KEY, ""), {},
+			                   view.Get(HOST_KEY, view.Get(DEFAULT_HOST_KEY, "")),
+			                   view.Get(PORT_KEY, view.Get(DEFAULT_PORT_KEY, -1)));
 	}();
 
 	SauceNAOResult result;
@@ -212,13 +219,13 @@ void SearchSauce(std::string url, const Mirai::GroupMessageEvent& gm, Bot::Group
 	try
 	{
 		Utils::UrlComponent comp = Utils::UrlComponent::ParseUrl(best_sauce.header.thumbnail);
-		httplib::Client cli(comp.GetOrigin());
-		cli.set_decompress(true);
-		cli.set_connection_timeout(300); // NOLINT(*-avoid-magic-numbers)
-		cli.set_read_timeout(300);       // NOLINT(*-avoid-magic-numbers)
-		cli.set_write_timeout(120);      // NOLINT(*-avoid-magic-numbers)
+		auto cli = Utils::GetHttpClient(comp.GetOrigin());
+		cli->set_decompress(true);
+		cli->set_connection_timeout(300); // NOLINT(*-avoid-magic-numbers)
+		cli->set_read_timeout(300);       // NOLINT(*-avoid-magic-numbers)
+		cli->set_write_timeout(120);      // NOLINT(*-avoid-magic-numbers)
 
-		auto result = cli.Get(
+		auto result = cli->Get(
 			comp.GetRelativeRef(),
 			{{"Accept", "*/*"},
 		     {"Accept-Encoding", "gzip, deflate"},
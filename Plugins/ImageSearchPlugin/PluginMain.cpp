@@ -1,3 +1,4 @@
+#include <PluginUtils/RateGovernor.hpp>
 #include <PluginUtils/TypeList.hpp>
 #include <GroupCommand/ImageSearch.hpp>
 #include <utility>
@@ -12,12 +13,16 @@ using TriggerList = Utils::TypeList<>;
 extern "C"
 {
 
-	void InitPlugin() 
+	void InitPlugin(const Utils::BotConfig& /*config*/) 
 	{
 		VIPS_INIT("");		// NOLINT(*-vararg)
 
 		constexpr size_t MAX_MEM = 1024 * 1024 * 10;
 		vips_cache_set_max_mem(MAX_MEM);
+
+		// The free SauceNAO plan allows 4 searches per 30 seconds
+		// NOLINTNEXTLINE(*-avoid-magic-numbers)
+		Utils::RateGovernor::GetInstance().SetLimits("https://saucenao.com", {.RequestsPerSecond = 4.0 / 30, .burst = 4});
 	}
 
 
@@ -23,16 +23,14 @@ SauceClient::SauceClient(
 {
 }
 
-httplib::Client SauceClient::_GetClient() const
+Utils::HttpPool::Lease SauceClient::_GetClient() const
 {
-	httplib::Client cli(api_host.data());
-	if (!this->_ProxyHost.empty() && this->_ProxyPort > 0)
-		cli.set_proxy(this->_ProxyHost, this->_ProxyPort);
-
-	cli.set_connection_timeout(10); // NOLINT(*-avoid-magic-numbers)
-	cli.set_write_timeout(120); // NOLINT(*-avoid-magic-numbers)
-	cli.set_read_timeout(120); // NOLINT(*-avoid-magic-numbers)
-	cli.set_default_headers({
+	auto cli = Utils::GetHttpClient(api_host.data(), this->_ProxyHost, this->_ProxyPort);
+
+	cli->set_connection_timeout(10); // NOLINT(*-avoid-magic-numbers)
+	cli->set_write_timeout(120); // NOLINT(*-avoid-magic-numbers)
+	cli->set_read_timeout(120); // NOLINT(*-avoid-magic-numbers)
+	cli->set_default_headers({
 		{"Accept", "*/*"},
 		{"Accept-Encoding", "gzip, deflate"},
 		{"User-Agent", "Mozilla/5.0 (Windows NT 10.0; Win64; x64; rv:100.0) Gecko/20100101 Firefox/100.0"}
@@ -60,7 +58,7 @@ SauceNAOResult SauceClient::SearchFile(std::string content, std::string filename
 	httplib::MultipartFormDataItems payload;
 	payload.emplace_back(httplib::MultipartFormData{"file", std::move(content), std::move(filename), "application/octet-stream"});
 
-	auto result = this->_GetClient().Post(
+	auto result = this->_GetClient()->Post(
 		"/search.php?" + Utils::Params2Query(params),
 		payload
 	);
@@ -104,7 +102,7 @@ SauceNAOResult SauceClient::SearchUrl(std::string url)
 	else
 		params.emplace("dbmask", std::to_string(this->_opts.mask));
 	
-	auto result = this->_GetClient().Post(
+	auto result = this->_GetClient()->Post(
 		"/search.php",
 		params
 	);
@@ -5,14 +5,9 @@
 #include <string>
 #include <string_view>
 
-#include "Models.hpp"
-
-namespace httplib
-{
+#include <PluginUtils/NetworkUtils.hpp>
 
-class Client;
-
-}
+#include "Models.hpp"
 
 namespace SauceNAO
 {
@@ -48,7 +43,7 @@ protected:
 	const std::string _ProxyHost;
 	const int _ProxyPort;
 
-	httplib::Client _GetClient() const;
+	Utils::HttpPool::Lease _GetClient() const;
 
 public:
 	explicit SauceClient(
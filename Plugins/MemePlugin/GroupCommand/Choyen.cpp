@@ -1,12 +1,16 @@
 #include "Choyen.hpp"
 
+#include <chrono>
 #include <cstdlib>
 #include <filesystem>
+#include <map>
+#include <mutex>
 #include <string>
 #include <vector>
 
 #include <PluginUtils/Common.hpp>
 #include <PluginUtils/StringUtils.hpp>
+#include <PluginUtils/Subprocess.hpp>
 
 #include <libmirai/mirai.hpp>
 
@@ -24,17 +28,37 @@ using std::vector;
 namespace GroupCommand
 {
 
+namespace
+{
+
+// Keeps the python interpreter (and PIL, numpy, the fonts) loaded between calls
+Utils::WorkerPool& GetPool(const string& module)
+{
+	constexpr std::size_t POOL_SIZE = 2;
+	constexpr auto IDLE_TIMEOUT = std::chrono::minutes(10);
+
+	static std::mutex mtx;
+	static std::map<string, Utils::WorkerPool> pools;
+	std::lock_guard<std::mutex> lk(mtx);
+	auto it = pools.find(module);
+	if (it == pools.end())
+		it = pools.try_emplace(module, vector<string>{"python", "-m", module, "--serve"}, POOL_SIZE, IDLE_TIMEOUT).first;
+	return it->second;
+}
+
+}
+
 bool Choyen::Execute(const Mirai::GroupMessageEvent& gm, Bot::Group& group, Bot::Client& client,
                      Utils::BotConfig& config)
 {
 	string str = Utils::ReplaceMark(Utils::GetText(gm.GetMessage()));
 	if (!Utils::trim(str).empty() && Utils::trim(str)[0] != '#') return false;
 
-	vector<string> tokens;
-	if (Utils::Tokenize(str, tokens) < 2) return false;
+	Utils::TokenList<2> head(str);
+	if (head.size() < 2 || !(Utils::iequals(head[0], "#choyen") || Utils::iequals(head[0], "#红字白字"))) return false;
 
-	string command = Utils::toLower(tokens[0]);
-	if (command != "#choyen" && command != "#红字白字") return false;
+	vector<string> tokens;
+	Utils::Tokenize(str, tokens);
 
 
 	LOG_INFO(Utils::GetLogger(), "Calling Choyen <Choyen>" + Utils::GetDescription(gm.GetSender()));
@@ -87,31 +111,30 @@ bool Choyen::Execute(const Mirai::GroupMessageEvent& gm, Bot::Group& group, Bot:
 		+ tokens[1] + " \\ " + tokens[2]
 		+ " <Choyen>" + Utils::GetDescription(gm.GetSender(), false));
 
-	std::string module = config.Get("/path/pymodules", "pymodules") + ".5000choyen";
-	vector<string> cmd{
-		"python", "-m", module,
-		string(upper), string(lower) 
+	static const Utils::ConfigKey PYMODULES_KEY("/path/pymodules");
+	std::string module = config.Get(PYMODULES_KEY, "pymodules") + ".5000choyen";
+	json request{
+		{"upper", string(upper)},
+		{"lower", string(lower)},
+		{"rupper", UpperRainbow},
+		{"rlower", LowerRainbow}
 	};
-	if (UpperRainbow)
-		cmd.emplace_back("--rupper");
-	if (LowerRainbow)
-		cmd.emplace_back("--rlower");
-	
-	int status{};
-	std::string output = Utils::ExecCmd(std::move(cmd), status);
-	if (output.empty())
+
+	constexpr auto TIMEOUT = std::chrono::seconds(60);
+	std::string output;
+	try
 	{
-		LOG_WARN(Utils::GetLogger(), "Error occured when executing 5000choyen <Choyen>");
+		output = GetPool(module).call(request.dump(-1, ' ', false, json::error_handler_t::replace), TIMEOUT);
+	}
+	catch (const Utils::SubprocessError& e)
+	{
+		LOG_WARN(Utils::GetLogger(), "Error occured when executing 5000choyen <Choyen>: " + std::string(e.what()));
 		client.SendGroupMessage(group.gid, Mirai::MessageChain().Plain("该服务寄了捏，怎么会事捏"));
 		return true;
 	}
-	if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+	if (output.empty())
 	{
-		LOG_WARN(Utils::GetLogger(), 
-			"Error occured when executing 5000choyen <Choyen>:\n"
-			+ output
-			+ "\nEXIT STATUS: " + std::to_string(WEXITSTATUS(status))
-		);
+		LOG_WARN(Utils::GetLogger(), "Error occured when executing 5000choyen <Choyen>");
 		client.SendGroupMessage(group.gid, Mirai::MessageChain().Plain("该服务寄了捏，怎么会事捏"));
 		return true;
 	}
@@ -1,9 +1,11 @@
 #include "Petpet.hpp"
 
+#include <chrono>
 #include <cmath>
 #include <cstdlib>
 #include <exception>
 #include <filesystem>
+#include <memory>
 #include <string>
 #include <vector>
 #include <charconv>
@@ -17,6 +19,7 @@
 #include <Core/Client/Client.hpp>
 #include <Core/Utils/Common.hpp>
 #include <Core/Utils/Logger.hpp>
+#include <PluginUtils/HttpCache.hpp>
 #include <PluginUtils/NetworkUtils.hpp>
 
 #include <PluginUtils/Base64.hpp>
@@ -96,11 +99,11 @@ bool Petpet::Execute(const Mirai::GroupMessageEvent& gm, Bot::Group& group, Bot:
 	string str = Utils::ReplaceMark(Utils::GetText(gm.GetMessage()));
 	if (!Utils::trim(str).empty() && Utils::trim(str)[0] != '#') return false;
 
-	vector<string> tokens;
-	if (Utils::Tokenize(str, tokens) < 1) return false;
+	Utils::TokenList<1> head(str);
+	if (head.empty() || !(Utils::iequals(head[0], "#pet") || Utils::iequals(head[0], "#petpet") || Utils::iequals(head[0], "#摸摸"))) return false;
 
-	string command = Utils::toLower(tokens[0]);
-	if (command != "#pet" && command !=  "#petpet" && command != "#摸摸") return false;
+	vector<string> tokens;
+	Utils::Tokenize(str, tokens);
 
 
 	LOG_INFO(Utils::GetLogger(), "Calling Petpet <Petpet>" + Utils::GetDescription(gm.GetSender()));
@@ -154,29 +157,41 @@ bool Petpet::Execute(const Mirai::GroupMessageEvent& gm, Bot::Group& group, Bot:
 		return true;
 	}
 
-	httplib::Client cli("http://q1.qlogo.cn");
-	cli.set_compress(true);
-	cli.set_decompress(true);
-	cli.set_connection_timeout(10); // NOLINT(*-avoid-magic-numbers)
-	cli.set_read_timeout(300);       // NOLINT(*-avoid-magic-numbers)
-	cli.set_write_timeout(10);      // NOLINT(*-avoid-magic-numbers)
+	static const Utils::ConfigKey MEDIA_KEY("/path/MediaFiles");
+	const std::filesystem::path MediaDir = config.Get(MEDIA_KEY, "MediaFiles");
 
-	auto result = cli.Get("/g?b=qq&nk=" + target.to_string() + "&s=640");
-	if (!Utils::VerifyResponse(result))
+	string path = "/g?b=qq&nk=" + target.to_string() + "&s=640";
+	std::shared_ptr<const httplib::Response> avatar;
+	try
 	{
-		LOG_WARN(Utils::GetLogger(),"Error occured while downloading image <Petpet>: " + 
-			((result)? 
-			"Reason: " + result->reason + ", Body: " + result->body + " <" + std::to_string(result->status) + ">"
-			: "Reason: " + httplib::to_string(result.error()) + " <-1>")
-		);
+		// Avatars rarely change and are often requested several times in a row,
+		// qlogo does not say how long they stay valid
+		Utils::CachePolicy policy;
+		policy.DefaultTtl = std::chrono::hours(1);
+		avatar = Utils::FetchGet("http://q1.qlogo.cn" + path, {},
+		                         [&path](const httplib::Headers& headers)
+		                         {
+									 auto cli = Utils::GetHttpClient("http://q1.qlogo.cn");
+									 cli->set_compress(true);
+									 cli->set_decompress(true);
+									 cli->set_connection_timeout(10); // NOLINT(*-avoid-magic-numbers)
+									 cli->set_read_timeout(300);      // NOLINT(*-avoid-magic-numbers)
+									 cli->set_write_timeout(10);      // NOLINT(*-avoid-magic-numbers)
+									 return cli->Get(path, headers);
+								 },
+		                         policy);
+	}
+	catch (const Utils::NetworkException& e)
+	{
+		LOG_WARN(Utils::GetLogger(),"Error occured while downloading image <Petpet>: " + string(e.what()));
 		client.SendGroupMessage(group.gid, Mirai::MessageChain().Plain("该服务寄了捏，怎么会事捏"));
 		return true;
 	}
 
 	size_t len{};
 	auto out = GeneratePetpet(
-		result->body, 
-		config.Get("/path/MediaFiles", "MediaFiles") / std::filesystem::path("images/petpet"), 
+		avatar->body, 
+		MediaDir / "images/petpet", 
 		len
 	);
 	
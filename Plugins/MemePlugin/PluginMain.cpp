@@ -1,3 +1,4 @@
+#include <PluginUtils/HttpCache.hpp>
 #include <PluginUtils/TypeList.hpp>
 #include <GroupCommand/Choyen.hpp>
 #include <GroupCommand/Petpet.hpp>
@@ -15,12 +16,14 @@ using TriggerList = Utils::TypeList<>;
 extern "C"
 {
 
-	void InitPlugin() 
+	void InitPlugin(const Utils::BotConfig& config) 
 	{
 		VIPS_INIT("");		// NOLINT(*-vararg)
 
 		constexpr size_t MAX_MEM = 1024 * 1024 * 10;
 		vips_cache_set_max_mem(MAX_MEM);
+
+		Utils::HttpCache::GetInstance().WatchConfig(config);
 	}
 
 
@@ -14,6 +14,9 @@
 #include <Core/Utils/Logger.hpp>
 
 #include <Handlers/PixivId.hpp>
+#include <Handlers/PixivRank.hpp>
+#include <Handlers/PixivSearch.hpp>
+#include <Handlers/PixivTag.hpp>
 
 using json = nlohmann::json;
 using std::string;
@@ -28,11 +31,11 @@ bool PixivCommand::Execute(const Mirai::GroupMessageEvent& gm, Bot::Group& group
 	string str = Utils::ReplaceMark(Utils::GetText(gm.GetMessage()));
 	if (!Utils::trim(str).empty() && Utils::trim(str)[0] != '#') return false;
 
-	vector<string> tokens;
-	if (Utils::Tokenize(str, tokens) < 2) return false;
+	Utils::TokenList<2> head(str);
+	if (head.size() < 2 || !(Utils::iequals(head[0], "#pixiv") || Utils::iequals(head[0], "#p站"))) return false;
 
-	string command = Utils::toLower(tokens[0]);
-	if (command != "#pixiv" && command != "#p站") return false;
+	vector<string> tokens;
+	Utils::Tokenize(str, tokens);
 
 
 	LOG_INFO(Utils::GetLogger(), "Calling Pixiv <Pixiv>" + Utils::GetDescription(gm.GetSender()));
@@ -44,7 +47,7 @@ bool PixivCommand::Execute(const Mirai::GroupMessageEvent& gm, Bot::Group& group
 		return true;
 	}
 
-	command = Utils::toLower(tokens[1]);
+	string command = Utils::toLower(tokens[1]);
 	if (command == "help" || command == "h" || command == "帮助")
 	{
 		LOG_INFO(Utils::GetLogger(), "帮助文档 <Pixiv>" + Utils::GetDescription(gm.GetSender(), false));
@@ -52,12 +55,27 @@ bool PixivCommand::Execute(const Mirai::GroupMessageEvent& gm, Bot::Group& group
 					Mirai::MessageChain()
 					.Plain("usage:")
 					.Plain(Pixiv::PixivId::HELP_TEXT.data())
+					.Plain(Pixiv::PixivRank::HELP_TEXT.data())
+					.Plain(Pixiv::PixivSearch::HELP_TEXT.data())
+					.Plain(Pixiv::PixivTag::HELP_TEXT.data())
 					);
 	}
 	else if (command == Pixiv::PixivId::COMMAND_NAME)
 	{
 		Pixiv::PixivId::GetIllustById(tokens, gm, group, client, config);
 	}
+	else if (command == Pixiv::PixivRank::COMMAND_NAME)
+	{
+		Pixiv::PixivRank::GetRanking(tokens, gm, group, client, config);
+	}
+	else if (command == Pixiv::PixivSearch::COMMAND_NAME)
+	{
+		Pixiv::PixivSearch::SearchByTag(tokens, gm, group, client, config);
+	}
+	else if (command == Pixiv::PixivTag::COMMAND_NAME)
+	{
+		Pixiv::PixivTag::GetTrendingTags(tokens, gm, group, client, config);
+	}
 	else
 	{	
 		LOG_INFO(Utils::GetLogger(), "未知命令 <Pixiv>: " + command + Utils::GetDescription(gm.GetSender(), false));
@@ -1,22 +1,32 @@
 #include "PixivId.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <charconv>
+#include <chrono>
 #include <condition_variable>
 #include <cstdint>
 #include <exception>
 #include <filesystem>
-#include <fstream>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
 #include <mutex>
 #include <queue>
 #include <stdexcept>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include <PixivClient/Models.hpp>
 #include <PixivClient/Singleton.hpp>
 #include <PixivClient/PixivClient.hpp>
 #include <PluginUtils/Common.hpp>
+#include <PluginUtils/LruCache.hpp>
 #include <PluginUtils/StringUtils.hpp>
 #include <PluginUtils/NetworkUtils.hpp>
+#include <PluginUtils/ZipReader.hpp>
 #include <nlohmann/json.hpp>
 
 #include <libmirai/mirai.hpp>
@@ -30,6 +40,7 @@
 
 #include <stduuid/include/uuid.h>
 #include <Utils/ImageUtils.hpp>
+#include <Utils/Ugoira.hpp>
 
 using std::string;
 using json = nlohmann::json;
@@ -48,7 +59,7 @@ private:
 	const size_t _MaxPayload;
 	std::queue<T> _payloads;
 	bool _stop = false;
-	std::exception_ptr _ep;
+	bool _closed = false;
 
 	std::mutex _mtx;
 	std::condition_variable _cv;
@@ -70,16 +81,17 @@ public:
 		this->_cv.notify_all();
 	}
 
+	// Fails once the queue is stopped, or closed and drained
 	std::pair<T, bool> read()
 	{
 		std::unique_lock<std::mutex> lk(this->_mtx);
 		
 		this->_cv.wait(lk, 
 			[this]{ 
-				return !this->_payloads.empty() || this->_stop; 
+				return !this->_payloads.empty() || this->_stop || this->_closed; 
 			}
 		);
-		if (this->_stop)
+		if (this->_stop || this->_payloads.empty())
 		{
 			return {{}, false};
 		}
@@ -87,17 +99,15 @@ public:
 		auto payload = std::move(this->_payloads.front());
 		this->_payloads.pop();
 		this->_cv.notify_all();
-		return {payload, true};
+		return {std::move(payload), true};
 	}
 
-	void wait()
+	// No more writes, readers still get what is queued
+	void close()
 	{
 		std::unique_lock<std::mutex> lk(this->_mtx);
-		this->_cv.wait(lk, 
-			[this]{ 
-				return this->_payloads.empty() || this->_stop;
-			}
-		);
+		this->_closed = true;
+		this->_cv.notify_all();
 	}
 
 	void stop()
@@ -106,23 +116,281 @@ public:
 		this->_stop = true;
 		this->_cv.notify_all();
 	}
+};
+
+struct Page
+{
+	size_t index{};
+	std::string image;
+};
+
+// Pages go through download -> upload, each stage has its own threads and the stages are connected by a
+// bounded queue so only a few pages are held in memory at a time.
+// Uploaders take pages in any order, the index travels with the page
+class PagePipeline
+{
+public:
+	using DownloadFunc = std::function<std::string(size_t)>;
+	using UploadFunc = std::function<void(size_t, std::string)>;
 
-	void SetException(std::exception_ptr ep)
+	struct Options
 	{
-		std::unique_lock<std::mutex> lk(this->_mtx);
-		this->_ep = ep;
-		this->_stop = true;
-		this->_cv.notify_all();
+		size_t downloaders = 4;
+		size_t uploaders = 3;
+		size_t QueueSize = 4;
+	};
+
+protected:
+	const size_t _pages;
+	DownloadFunc _download;
+	UploadFunc _upload;
+
+	std::mutex _mtx;
+	std::exception_ptr _error;
+	std::atomic<bool> _failed = false;
+
+	template <typename Func>
+	void _spawn(std::vector<std::thread>& threads, size_t count, Func body, std::vector<TaskQueue<Page>*> queues,
+	            TaskQueue<Page>* output)
+	{
+		if (count == 0 && output)
+			output->close();
+		auto remaining = std::make_shared<std::atomic<size_t>>(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			threads.emplace_back([this, body, queues, output, remaining]{
+				try
+				{
+					body();
+				}
+				catch (...)
+				{
+					{
+						std::lock_guard<std::mutex> lk(this->_mtx);
+						if (!this->_error) this->_error = std::current_exception();
+					}
+					this->_failed = true;
+					for (auto* queue : queues)
+						queue->stop();
+				}
+				if (--(*remaining) == 0 && output)
+					output->close();
+			});
+		}
 	}
 
-	void CheckException()
+public:
+	PagePipeline(size_t pages, DownloadFunc download, UploadFunc upload) :
+	_pages(pages), _download(std::move(download)), _upload(std::move(upload))
 	{
-		std::unique_lock<std::mutex> lk(this->_mtx);
-		if (this->_ep)
-			std::rethrow_exception(this->_ep);
+	}
+
+	// Blocks until every page is uploaded, the first exception of any stage stops all of them and is rethrown
+	void run(const Options& opts)
+	{
+		TaskQueue<Page> downloaded(opts.QueueSize);
+		const std::vector<TaskQueue<Page>*> queues{&downloaded};
+
+		std::atomic<size_t> next = 0;
+		std::vector<std::thread> threads;
+		this->_spawn(threads, std::min(opts.downloaders, this->_pages),
+			[this, &next, &downloaded]{
+				for (size_t i = next++; i < this->_pages && !this->_failed; i = next++)
+				{
+					LOG_INFO(Utils::GetLogger(), "Downloading " + std::to_string(i + 1) + "/" + std::to_string(this->_pages));
+					downloaded.write(Page{i, this->_download(i)});
+				}
+			}, queues, &downloaded);
+
+		this->_spawn(threads, opts.uploaders,
+			[this, &downloaded]{
+				while (true)
+				{
+					auto [page, success] = downloaded.read();
+					if (!success) return;
+					this->_upload(page.index, std::move(page.image));
+				}
+			}, queues, nullptr);
+
+		for (auto& th : threads)
+			th.join();
+
+		if (this->_error)
+			std::rethrow_exception(this->_error);
 	}
 };
 
+const Utils::ConfigKey MEDIA_KEY("/path/MediaFiles");
+
+std::shared_ptr<ImageUtils::CoverImage> LoadCover(const Utils::BotConfig& config)
+{
+	return ImageUtils::CoverImage::Get(config.Get(MEDIA_KEY, "MediaFiles") / std::filesystem::path("images/forbidden.png"));
+}
+
+constexpr double CensorSigma(X_RESTRICT restrict)
+{
+	constexpr double R18_RATIO = 0.05, R18G_RATIO = 0.15;
+	return (restrict == X_RESTRICT::R18 ? R18_RATIO : R18G_RATIO) * ImageUtils::THUMBNAIL_SIZE;
+}
+
+// Censored pages are decoded while they download
+std::string DownloadCensored(PixivClient& pclient, const std::string& url, double sigma,
+                             const std::shared_ptr<ImageUtils::CoverImage>& cover)
+{
+	return ImageUtils::CensorStream(
+		[&](std::function<bool(const char*, size_t)> receiver) { pclient.DownloadIllust(url, std::move(receiver)); },
+		sigma, cover);
+}
+
+// Pages already sent are looked up by pid, page and x_restrict
+std::string PageKey(const Illust& illust, size_t page)
+{
+	return illust.id.to_string() + "_p" + std::to_string(page) + "_" + std::to_string(static_cast<int>(illust.x_restrict));
+}
+
+// Ids of uploaded images, a repeated request only sends a message. mirai only keeps uploaded images
+// resolvable for a while, so they expire well before that
+Utils::LruCache<std::string, Mirai::GroupImage>& UploadedPages()
+{
+	constexpr size_t CAPACITY = 4096;
+	constexpr auto TTL = std::chrono::hours(1);
+	static Utils::LruCache<std::string, Mirai::GroupImage> cache(CAPACITY, TTL);
+	return cache;
+}
+
+// Censored thumbnails by size, to upload them again once the id has expired.
+// Originals are in the image cache of the client already
+constexpr size_t CENSORED_CACHE_SIZE = size_t(64) << 20;
+constexpr auto CENSORED_CACHE_TTL = std::chrono::hours(6);
+
+Utils::LruCache<std::string, std::shared_ptr<const std::string>>& CensoredPages()
+{
+	static Utils::LruCache<std::string, std::shared_ptr<const std::string>> cache(CENSORED_CACHE_SIZE);
+	return cache;
+}
+
+// The image of page as it is uploaded
+std::string FetchPage(PixivClient& pclient, const Illust& illust, const std::string& url, size_t page,
+                      const Utils::BotConfig& config)
+{
+	if (illust.x_restrict == X_RESTRICT::SAFE)
+		return pclient.DownloadIllust(url);
+
+	const std::string key = PageKey(illust, page);
+	if (auto cached = CensoredPages().get(key))
+		return **cached;
+
+	auto image = std::make_shared<const std::string>(
+		DownloadCensored(pclient, url, CensorSigma(illust.x_restrict), LoadCover(config)));
+	CensoredPages().put(key, image, CENSORED_CACHE_TTL, image->size());
+	return *image;
+}
+
+Mirai::GroupImage UploadPage(Bot::Client& client, const Illust& illust, size_t page, std::string image)
+{
+	auto uploaded = client->UploadGroupImage(std::move(image));
+	UploadedPages().put(PageKey(illust, page), uploaded);
+	return uploaded;
+}
+
+// mirai may forget an uploaded image before the cache does. Sends msg built from the images under keys and
+// waits for the result, a failed send drops the keys so the caller uploads them again
+bool SendUploaded(Bot::Client& client, Mirai::GID_t gid, Mirai::MessageChain msg, const std::vector<std::string>& keys)
+{
+	constexpr auto SEND_TIMEOUT = std::chrono::seconds(30);
+	auto sent = client.SendGroupMessage(gid, std::move(msg));
+	try
+	{
+		// Still queued after the timeout, most likely the connection is down and uploading again won't help
+		if (sent.wait_for(SEND_TIMEOUT) == std::future_status::timeout) return true;
+		sent.get();
+		return true;
+	}
+	catch (const std::exception& e)
+	{
+		LOG_WARN(Utils::GetLogger(), "Failed to send uploaded images, uploading again <Pixiv Id>: " + string(e.what()));
+		for (const auto& key : keys)
+			UploadedPages().erase(key);
+		return false;
+	}
+}
+
+// QQ only animates gifs
+constexpr Ugoira::Format UGOIRA_FORMAT = Ugoira::Format::GIF;
+constexpr size_t UGOIRA_BUDGET = size_t(8) << 20;
+constexpr size_t UGOIRA_CACHE_SIZE = size_t(128) << 20;
+constexpr auto UGOIRA_CACHE_TTL = std::chrono::hours(6);
+
+Utils::LruCache<int64_t, std::shared_ptr<const std::string>>& UgoiraCache()
+{
+	static Utils::LruCache<int64_t, std::shared_ptr<const std::string>> cache(UGOIRA_CACHE_SIZE);
+	return cache;
+}
+
+std::string UgoiraKey(const Illust& illust)
+{
+	return PageKey(illust, 0) + "_ugoira";
+}
+
+// The animation of an ugoira, frames are decoded while the archive downloads
+std::string FetchUgoira(PixivClient& pclient, const Illust& illust)
+{
+	if (auto cached = UgoiraCache().get((int64_t)illust.id))
+		return **cached;
+
+	json msg = pclient.GetUgoiraMetadata(illust.id);
+	const json& metadata = msg.at("ugoira_metadata");
+	std::map<std::string, size_t> index;
+	std::vector<int> delays;
+	for (const auto& frame : metadata.at("frames"))
+	{
+		index.emplace(frame.at("file").get<std::string>(), delays.size());
+		delays.push_back(frame.at("delay").get<int>());
+	}
+
+	Ugoira::FrameDecoder decoder(delays.size());
+	Utils::ZipReader zip(
+		[&index, &decoder](std::string name, std::string data)
+		{
+			auto it = index.find(name);
+			if (it != index.end())
+				decoder.push(it->second, std::move(data));
+		});
+
+	// Errors of the archive take precedence over the cancelled download
+	std::exception_ptr error;
+	try
+	{
+		pclient.DownloadIllust(metadata.at("zip_urls").at("medium").get<std::string>(),
+			[&zip, &error](const char* data, size_t len)
+			{
+				try
+				{
+					zip.feed(data, len);
+					return true;
+				}
+				catch (...)
+				{
+					error = std::current_exception();
+					return false;
+				}
+			});
+	}
+	catch (...)
+	{
+		if (!error) throw;
+	}
+	if (error)
+		std::rethrow_exception(error);
+	if (!zip.done())
+		throw std::runtime_error("Truncated ugoira archive");
+
+	auto image = std::make_shared<const std::string>(
+		Ugoira::Encode(decoder.finish(), std::move(delays), UGOIRA_FORMAT, UGOIRA_BUDGET));
+	UgoiraCache().put((int64_t)illust.id, image, UGOIRA_CACHE_TTL, image->size());
+	return *image;
+}
+
 }
 
 void GetIllustById(const std::vector<string>& tokens, const Mirai::GroupMessageEvent& gm, Bot::Group& group,
@@ -175,7 +443,7 @@ void GetIllustById(const std::vector<string>& tokens, const Mirai::GroupMessageE
 
 	auto cooldown = group.GetState<State::CoolDown>();
 	std::chrono::seconds remaining;
-	auto tk = cooldown->GetRemaining("Pixiv", 20s, remaining);
+	auto tk = cooldown->GetRemaining("Pixiv", COOLDOWN, remaining);
 	if (!tk)
 	{
 		LOG_INFO(Utils::GetLogger(),
@@ -193,14 +461,10 @@ void GetIllustById(const std::vector<string>& tokens, const Mirai::GroupMessageE
 
 	auto pclient = Pixiv::GetClient(config);
 
-	Illust illust;
+	std::shared_ptr<const Illust> details;
 	try
 	{
-		json msg = pclient->GetIllustDetails(pid);
-		if (!msg.contains("illust"))
-			throw Utils::ParseError("Response does not contain 'illust' field", msg);
-		illust = pclient->GetIllustDetails(pid).at("illust").get<Illust>();
-
+		details = pclient->GetIllust(pid);
 	}
 	catch(const Utils::NetworkException& e)
 	{
@@ -230,6 +494,7 @@ void GetIllustById(const std::vector<string>& tokens, const Mirai::GroupMessageE
 		return;
 	}
 
+	const Illust& illust = *details;
 	auto urls = illust.GetImageUrls();
 	string message = "标题: " + illust.title + " (id: " + illust.id.to_string() + ")\n作者: " 
 		+ illust.user.name + " (id: " + illust.user.id.to_string() + ")\n标签:";
@@ -254,58 +519,84 @@ void GetIllustById(const std::vector<string>& tokens, const Mirai::GroupMessageE
 	// Download illust
 	//////////////////
 
-	if (page != 0)
+	// Animations are sent whole, censored ones stay a still of their first frame
+	if (illust.type == ContentType::UGOIRA && illust.x_restrict == X_RESTRICT::SAFE)
 	{
-		if (page > urls.size())
-			page = urls.size() - 1;
-		
-		std::string image;
+		const std::string key = UgoiraKey(illust);
+		auto build = [&message](const Mirai::GroupImage& image)
+		{
+			auto msg = Mirai::MessageChain().Plain(message);
+			msg += Mirai::ImageMessage(image);
+			return msg;
+		};
+
+		if (auto uploaded = UploadedPages().get(key))
+		{
+			if (SendUploaded(client, group.gid, build(*uploaded), {key}))
+			{
+				LOG_INFO(Utils::GetLogger(), "上传结果 <Pixiv Id>" + Utils::GetDescription(gm.GetSender(), false));
+				return;
+			}
+		}
+
+		Mirai::GroupImage uploaded;
 		try
 		{
-			image = pclient->DownloadIllust(urls.at(page - 1));
+			uploaded = client->UploadGroupImage(FetchUgoira(*pclient, illust));
+			UploadedPages().put(key, uploaded);
 		}
 		catch(const std::exception& e)
 		{
-			LOG_WARN(Utils::GetLogger(),"Error occured while downloading image <Pixiv Id>: " + string(e.what()));
+			LOG_WARN(Utils::GetLogger(),"Error occured while converting ugoira <Pixiv Id>: " + string(e.what()));
 			client.SendGroupMessage(group.gid, Mirai::MessageChain().Plain("该服务寄了捏，怎么会事捏"));
 			return;
 		}
 
+		LOG_INFO(Utils::GetLogger(), "上传结果 <Pixiv Id>" + Utils::GetDescription(gm.GetSender(), false));
+		client.SendGroupMessage(group.gid, build(uploaded));
+		return;
+	}
+
+	if (page != 0)
+	{
+		if (page > urls.size())
+			page = urls.size() - 1;
+
 		if (illust.PageCount > 1)
 		{
 			message += "\n页码: " + std::to_string(page) + "/" + std::to_string(illust.PageCount) + "\n";
 		}
 
-		auto msg = Mirai::MessageChain().Plain(std::move(message));
-		if (illust.x_restrict == X_RESTRICT::SAFE)
+		const std::string key = PageKey(illust, page - 1);
+		auto build = [&message](const Mirai::GroupImage& image)
 		{
-			msg += Mirai::ImageMessage(client->UploadGroupImage(std::move(image)));
-		}
-		else
+			auto msg = Mirai::MessageChain().Plain(message);
+			msg += Mirai::ImageMessage(image);
+			return msg;
+		};
+
+		if (auto uploaded = UploadedPages().get(key))
 		{
-			std::filesystem::path cover_path = config.Get("/path/MediaFiles", "MediaFiles")
-							/ std::filesystem::path("images/forbidden.png");
-			std::string cover;
+			if (SendUploaded(client, group.gid, build(*uploaded), {key}))
 			{
-				std::ifstream ifile(cover_path);
-
-				constexpr size_t BUFFER_SIZE = 4096;
-				char buffer[BUFFER_SIZE];	// NOLINT(*-avoid-c-arrays)
-				while (ifile.read(buffer, sizeof(buffer)))
-					cover.append(buffer, sizeof(buffer));
-				cover.append(buffer, ifile.gcount());
+				LOG_INFO(Utils::GetLogger(), "上传结果 <Pixiv Id>" + Utils::GetDescription(gm.GetSender(), false));
+				return;
 			}
-			
-			size_t len{};
-
-			constexpr double R18_RATIO = 0.05, R18G_RATIO = 0.15;
-			double sigma = (illust.x_restrict == X_RESTRICT::R18 ? R18_RATIO : R18G_RATIO) 
-					* ImageUtils::THUMBNAIL_SIZE;
-			image = ImageUtils::CropAndConvert(image);
+		}
 
-			auto out = ImageUtils::CensorImage(image, sigma, len, cover);
-			msg += Mirai::ImageMessage(client->UploadGroupImage({out.get(), len}));
+		std::string image;
+		try
+		{
+			image = FetchPage(*pclient, illust, urls.at(page - 1), page - 1, config);
 		}
+		catch(const std::exception& e)
+		{
+			LOG_WARN(Utils::GetLogger(),"Error occured while downloading image <Pixiv Id>: " + string(e.what()));
+			client.SendGroupMessage(group.gid, Mirai::MessageChain().Plain("该服务寄了捏，怎么会事捏"));
+			return;
+		}
+
+		auto msg = build(UploadPage(client, illust, page - 1, std::move(image)));
 		
 		LOG_INFO(Utils::GetLogger(), "上传结果 <Pixiv Id>" + Utils::GetDescription(gm.GetSender(), false));
 		client.SendGroupMessage(group.gid, msg);
@@ -317,111 +608,72 @@ void GetIllustById(const std::vector<string>& tokens, const Mirai::GroupMessageE
 
 		message += "\n总页数: " + std::to_string(illust.PageCount);
 
-		Mirai::ForwardMessage msg;
-
-		Mirai::ForwardMessage::Node node;
-		node.SetSenderId(client->GetBotQQ());
-		node.SetTimestamp(std::time(nullptr));
-		node.SetSenderName("pixiv");
-		node.SetMessageChain(Mirai::MessageChain().Plain(std::move(message)));
-		msg.emplace_back(node);
-
-		bool success = false;
-
-		constexpr size_t MAX_PAYLOAD = 5;
-		TaskQueue<std::string> task(MAX_PAYLOAD);
+		// The second round only happens when images from the cache could not be sent, and uploads them again
+		for (int round = 0; round < 2; round++)
+		{
+			Mirai::ForwardMessage msg;
+
+			Mirai::ForwardMessage::Node node;
+			node.SetSenderId(client->GetBotQQ());
+			node.SetTimestamp(std::time(nullptr));
+			node.SetSenderName("pixiv");
+			node.SetMessageChain(Mirai::MessageChain().Plain(message));
+			msg.emplace_back(node);
+
+			std::vector<Mirai::MessageChain> pages(urls.size());
+			std::vector<size_t> missing;
+			std::vector<std::string> cached;
+			for (size_t i = 0; i < urls.size(); i++)
+			{
+				if (auto uploaded = UploadedPages().get(PageKey(illust, i)))
+				{
+					pages[i] = Mirai::MessageChain().Image(*uploaded);
+					cached.push_back(PageKey(illust, i));
+				}
+				else
+					missing.push_back(i);
+			}
 
-		std::thread th([&node, &msg, &task, &client]{
 			try
 			{
-				while (true)
-				{
-					auto [image, success] = task.read();
-					if (!success) 
+				PagePipeline pipeline(
+					missing.size(),
+					[&pclient, &illust, &urls, &missing, &config](size_t k)
 					{
-						// task.SetException(std::make_exception_ptr(std::runtime_error("Failed to read task")));
-						return;
-					}
-					node.SetTimestamp(std::time(nullptr));
-					node.SetMessageChain(Mirai::MessageChain().Image(client->UploadGroupImage(std::move(image))));
-					msg.emplace_back(node);
-				}
+						return FetchPage(*pclient, illust, urls[missing[k]], missing[k], config);
+					},
+					[&pages, &client, &illust, &missing](size_t k, std::string image)
+					{
+						pages[missing[k]] = Mirai::MessageChain().Image(UploadPage(client, illust, missing[k], std::move(image)));
+					});
+				pipeline.run({});
 			}
-			catch (...)
+			catch(const std::exception& e)
 			{
-				task.SetException(std::current_exception());
+				LOG_WARN(Utils::GetLogger(),"Error occured while downloading image <Pixiv Id>: " + string(e.what()));
+				client.SendGroupMessage(group.gid, Mirai::MessageChain().Plain("该服务寄了捏，怎么会事捏"));
 				return;
 			}
-		});
 
-		try
-		{
-			Utils::RunAtExit guard([&task, &th]()
+			for (auto& page : pages)
 			{
-				task.stop();
-				if (th.joinable())
-					th.join();
-			});
+				node.SetTimestamp(std::time(nullptr));
+				node.SetMessageChain(std::move(page));
+				msg.emplace_back(node);
+			}
 
-			if (illust.x_restrict == X_RESTRICT::SAFE)
+			if (cached.empty() || round > 0)
 			{
-				for (size_t i = 0; i < urls.size(); i++)
-				{
-					const std::string& url = urls[i];
-					LOG_INFO(Utils::GetLogger(), "Downloading " + std::to_string(i + 1) + "/" + std::to_string(urls.size()));
-
-					task.write(pclient->DownloadIllust(url));
-					task.CheckException();
-				}
+				LOG_INFO(Utils::GetLogger(), "上传结果 <Pixiv Id>" + Utils::GetDescription(gm.GetSender(), false));
+				client.SendGroupMessage(group.gid, Mirai::MessageChain().Forward(std::move(msg)));
+				return;
 			}
-			else
+			if (SendUploaded(client, group.gid, Mirai::MessageChain().Forward(std::move(msg)), cached))
 			{
-				
-				std::filesystem::path cover_path = config.Get("/path/MediaFiles", "MediaFiles")
-								/ std::filesystem::path("images/forbidden.png");
-				std::string cover;
-				{
-					std::ifstream ifile(cover_path);
-
-					constexpr size_t BUFFER_SIZE = 4096;
-					char buffer[BUFFER_SIZE];	// NOLINT(*-avoid-c-arrays)
-					while (ifile.read(buffer, sizeof(buffer)))
-						cover.append(buffer, sizeof(buffer));
-					cover.append(buffer, ifile.gcount());
-				}
-
-				for (size_t i = 0; i < urls.size(); i++)
-				{
-					const std::string& url = urls[i];
-					LOG_INFO(Utils::GetLogger(), "Downloading " + std::to_string(i + 1) + "/" + std::to_string(urls.size()));
-
-					std::string image = pclient->DownloadIllust(url);
-
-					constexpr double R18_RATIO = 0.05, R18G_RATIO = 0.15;
-					double sigma = (illust.x_restrict == X_RESTRICT::R18 ? R18_RATIO : R18G_RATIO) 
-							* ImageUtils::THUMBNAIL_SIZE;
-					image = ImageUtils::CropAndConvert(image);
-
-					size_t len{};
-					auto out = ImageUtils::CensorImage(image, sigma, len, cover);
-					string{}.swap(image);
-
-					task.write(string{out.get(), len});
-					task.CheckException();
-				}
+				LOG_INFO(Utils::GetLogger(), "上传结果 <Pixiv Id>" + Utils::GetDescription(gm.GetSender(), false));
+				return;
 			}
-			task.wait();
-			task.CheckException();
 		}
-		catch(const std::exception& e)
-		{
-			LOG_WARN(Utils::GetLogger(),"Error occured while downloading image <Pixiv Id>: " + string(e.what()));
-			client.SendGroupMessage(group.gid, Mirai::MessageChain().Plain("该服务寄了捏，怎么会事捏"));
-			return;
-		}
-	
-		LOG_INFO(Utils::GetLogger(), "上传结果 <Pixiv Id>" + Utils::GetDescription(gm.GetSender(), false));
-		client.SendGroupMessage(group.gid, Mirai::MessageChain().Forward(std::move(msg)));
 	}
 }
 
@@ -1,6 +1,7 @@
 #ifndef _PIXIV_HANDLERS_PIXIVID_HPP_
 #define _PIXIV_HANDLERS_PIXIVID_HPP_
 
+#include <chrono>
 #include <string>
 #include <vector>
 
@@ -14,6 +15,7 @@ namespace Pixiv::PixivId
 {
 
 constexpr std::string_view COMMAND_NAME= "id";
+constexpr std::chrono::seconds COOLDOWN{20};	// Of "Pixiv"
 
 constexpr std::string_view HELP_TEXT = 
 "\n#pixiv id [pid] (page/all)";
@@ -0,0 +1,66 @@
+#include "PixivRank.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <PixivClient/Models.hpp>
+#include <PixivClient/Prefetched.hpp>
+#include <PluginUtils/Common.hpp>
+#include <PluginUtils/StringUtils.hpp>
+
+#include <libmirai/mirai.hpp>
+
+#include <Core/Utils/Common.hpp>
+#include <Core/Utils/Logger.hpp>
+
+#include "PixivId.hpp"
+
+using std::string;
+
+namespace Pixiv::PixivRank
+{
+
+void GetRanking(const std::vector<string>& tokens, const Mirai::GroupMessageEvent& gm, Bot::Group& group,
+                Bot::Client& client, Utils::BotConfig& config)
+{
+	// Only what PixivPrefetchTrigger has fetched, never calls the pixiv api itself
+	auto data = GetPrefetched();
+	if (!data || data->ranking.empty())
+	{
+		LOG_INFO(Utils::GetLogger(), "排行榜未加载 <Pixiv Rank>" + Utils::GetDescription(gm.GetSender(), false));
+		client.SendGroupMessage(group.gid, Mirai::MessageChain().Plain("排行榜还没准备好捏，等会再来吧"));
+		return;
+	}
+
+	if (tokens.size() < 3)
+	{
+		constexpr size_t LIST_SIZE = 10;
+		string message = "今日排行:";
+		for (size_t i = 0; i < data->ranking.size() && i < LIST_SIZE; i++)
+		{
+			const auto& illust = *data->ranking[i];
+			message += "\n" + std::to_string(i + 1) + ". " + illust.title + " - " + illust.user.name
+			           + " (id: " + illust.id.to_string() + ")";
+		}
+
+		LOG_INFO(Utils::GetLogger(), "发送排行 <Pixiv Rank>" + Utils::GetDescription(gm.GetSender(), false));
+		client.SendGroupMessage(group.gid, Mirai::MessageChain().Plain(std::move(message)));
+		return;
+	}
+
+	uint64_t rank{};
+	if (!Utils::Str2Num(tokens[2], rank) || rank < 1 || rank > data->ranking.size())
+	{
+		LOG_INFO(Utils::GetLogger(), "无效参数(n) <Pixiv Rank>: " + tokens[2] + Utils::GetDescription(gm.GetSender(), false));
+		client.SendGroupMessage(group.gid, Mirai::MessageChain().Plain(
+			"只有前" + std::to_string(data->ranking.size()) + "名捏"));
+		return;
+	}
+
+	// The illust and its first page are in the caches of the client already
+	const std::vector<string> args{tokens[0], string(PixivId::COMMAND_NAME), data->ranking[rank - 1]->id.to_string()};
+	PixivId::GetIllustById(args, gm, group, client, config);
+}
+
+} // namespace Pixiv::PixivRank
@@ -0,0 +1,116 @@
+#include "PixivSearch.hpp"
+
+#include <chrono>
+#include <exception>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <PixivClient/Cursor.hpp>
+#include <PixivClient/Models.hpp>
+#include <PixivClient/Singleton.hpp>
+#include <PluginUtils/Common.hpp>
+
+#include <libmirai/mirai.hpp>
+
+#include <Core/States/CoolDown.hpp>
+#include <Core/Utils/Common.hpp>
+#include <Core/Utils/Logger.hpp>
+
+#include "PixivId.hpp"
+
+using std::string;
+using namespace std::literals;
+
+namespace Pixiv::PixivSearch
+{
+
+namespace
+{
+
+// Newest works first, keep going until enough of them are popular
+constexpr CursorOptions SEARCH_OPTIONS{.depth = 2, .budget = 5};
+constexpr uint64_t MIN_BOOKMARKS = 100;
+constexpr size_t CANDIDATES = 30;
+
+// A random popular work, or a random one of all if none is popular. nullptr for no results
+std::shared_ptr<const Illust> PickIllust(IllustCursor& cursor)
+{
+	std::vector<std::shared_ptr<const Illust>> popular, all;
+	while (popular.size() < CANDIDATES)
+	{
+		auto page = cursor.next();
+		if (!page) break;
+		for (auto& illust : *page)
+		{
+			if (illust->TotalBookmarks >= MIN_BOOKMARKS)
+				popular.push_back(illust);
+			all.push_back(std::move(illust));
+		}
+	}
+
+	auto& candidates = popular.empty() ? all : popular;
+	if (candidates.empty()) return nullptr;
+	std::uniform_int_distribution<size_t> dist(0, candidates.size() - 1);
+	return candidates[dist(Utils::GetRngEngine())];
+}
+
+}
+
+void SearchByTag(const std::vector<string>& tokens, const Mirai::GroupMessageEvent& gm, Bot::Group& group,
+                 Bot::Client& client, Utils::BotConfig& config)
+{
+	if (tokens.size() < 3)
+	{
+		LOG_INFO(Utils::GetLogger(), "缺少参数[tag] <Pixiv Search>" + Utils::GetDescription(gm.GetSender(), false));
+		client.SendGroupMessage(group.gid, Mirai::MessageChain().Plain("搜什么捏"));
+		return;
+	}
+
+	std::shared_ptr<const Illust> illust;
+	{
+		auto cooldown = group.GetState<State::CoolDown>();
+		// The result is sent by #pixiv id, a search it would refuse is not worth the requests.
+		// Checked before taking the token, whose release would restart the search cooldown
+		std::chrono::seconds remaining = cooldown->PeekRemaining("Pixiv", PixivId::COOLDOWN);
+		std::unique_ptr<State::CoolDown::Token> tk;
+		if (remaining <= 0s) tk = cooldown->GetRemaining("PixivSearch", 20s, remaining);
+		if (!tk)
+		{
+			LOG_INFO(Utils::GetLogger(),
+			         "冷却剩余<Pixiv Search>: " + std::to_string(remaining.count())
+			             + Utils::GetDescription(gm.GetSender(), false));
+			client.SendGroupMessage(
+				group.gid,
+				Mirai::MessageChain().Plain("冷却中捏（剩余: " + std::to_string(remaining.count()) + "s）"));
+			return;
+		}
+
+		try
+		{
+			auto cursor = SearchIllusts(Pixiv::GetClient(config), tokens[2], SearchOption::TAGS_PARTIAL,
+			                            SortOrder::DATE_DESC, SEARCH_OPTIONS);
+			illust = PickIllust(cursor);
+		}
+		catch (const std::exception& e)
+		{
+			LOG_WARN(Utils::GetLogger(), "Error occured in pixiv api <Pixiv Search>: " + string(e.what()));
+			client.SendGroupMessage(group.gid, Mirai::MessageChain().Plain("该服务寄了捏，怎么会事捏"));
+			return;
+		}
+	}
+
+	if (!illust)
+	{
+		LOG_INFO(Utils::GetLogger(), "无搜索结果 <Pixiv Search>: " + tokens[2] + Utils::GetDescription(gm.GetSender(), false));
+		client.SendGroupMessage(group.gid, Mirai::MessageChain().Plain("没有找到" + tokens[2] + "捏"));
+		return;
+	}
+
+	// The cursor has put the illust into the cache of the client, only its image is downloaded
+	const std::vector<string> args{tokens[0], string(PixivId::COMMAND_NAME), illust->id.to_string()};
+	PixivId::GetIllustById(args, gm, group, client, config);
+}
+
+} // namespace Pixiv::PixivSearch
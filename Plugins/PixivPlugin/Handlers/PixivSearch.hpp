@@ -0,0 +1,26 @@
+#ifndef _PIXIV_HANDLERS_PIXIVSEARCH_HPP_
+#define _PIXIV_HANDLERS_PIXIVSEARCH_HPP_
+
+#include <string>
+#include <vector>
+
+#include <libmirai/mirai.hpp>
+
+#include <Core/Bot/Group.hpp>
+#include <Core/Client/Client.hpp>
+#include <Core/Utils/Common.hpp>
+
+namespace Pixiv::PixivSearch
+{
+
+constexpr std::string_view COMMAND_NAME= "search";
+
+constexpr std::string_view HELP_TEXT = 
+"\n#pixiv search [tag]";
+
+void SearchByTag(const std::vector<std::string>& tokens, const Mirai::GroupMessageEvent& gm, Bot::Group& group, Bot::Client& client,
+                 Utils::BotConfig& config);
+
+}
+
+#endif
@@ -0,0 +1,46 @@
+#include "PixivTag.hpp"
+
+#include <string>
+#include <vector>
+
+#include <PixivClient/Models.hpp>
+#include <PixivClient/Prefetched.hpp>
+#include <PluginUtils/Common.hpp>
+
+#include <libmirai/mirai.hpp>
+
+#include <Core/Utils/Common.hpp>
+#include <Core/Utils/Logger.hpp>
+
+using std::string;
+
+namespace Pixiv::PixivTag
+{
+
+void GetTrendingTags(const std::vector<string>& /*tokens*/, const Mirai::GroupMessageEvent& gm, Bot::Group& group,
+                     Bot::Client& client, Utils::BotConfig& /*config*/)
+{
+	// Only what PixivPrefetchTrigger has fetched, never calls the pixiv api itself
+	auto data = GetPrefetched();
+	if (!data || data->tags.empty())
+	{
+		LOG_INFO(Utils::GetLogger(), "标签未加载 <Pixiv Tag>" + Utils::GetDescription(gm.GetSender(), false));
+		client.SendGroupMessage(group.gid, Mirai::MessageChain().Plain("热门标签还没准备好捏，等会再来吧"));
+		return;
+	}
+
+	constexpr size_t LIST_SIZE = 20;
+	string message = "热门标签:";
+	for (size_t i = 0; i < data->tags.size() && i < LIST_SIZE; i++)
+	{
+		const auto& tag = data->tags[i];
+		message += "\n#" + tag.name + (tag.translate.empty() ? "" : " (" + tag.translate + ")");
+		if (tag.illust)
+			message += "  id: " + tag.illust->id.to_string();
+	}
+
+	LOG_INFO(Utils::GetLogger(), "发送热门标签 <Pixiv Tag>" + Utils::GetDescription(gm.GetSender(), false));
+	client.SendGroupMessage(group.gid, Mirai::MessageChain().Plain(std::move(message)));
+}
+
+} // namespace Pixiv::PixivTag
@@ -0,0 +1,26 @@
+#ifndef _PIXIV_HANDLERS_PIXIVTAG_HPP_
+#define _PIXIV_HANDLERS_PIXIVTAG_HPP_
+
+#include <string>
+#include <vector>
+
+#include <libmirai/mirai.hpp>
+
+#include <Core/Bot/Group.hpp>
+#include <Core/Client/Client.hpp>
+#include <Core/Utils/Common.hpp>
+
+namespace Pixiv::PixivTag
+{
+
+constexpr std::string_view COMMAND_NAME= "tag";
+
+constexpr std::string_view HELP_TEXT = 
+"\n#pixiv tag";
+
+void GetTrendingTags(const std::vector<std::string>& tokens, const Mirai::GroupMessageEvent& gm, Bot::Group& group, Bot::Client& client,
+                     Utils::BotConfig& config);
+
+}
+
+#endif
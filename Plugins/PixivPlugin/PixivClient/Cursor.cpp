@@ -0,0 +1,205 @@
+#include "Cursor.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include <PluginUtils/Common.hpp>
+
+#include "PixivClient.hpp"
+
+namespace Pixiv
+{
+
+namespace
+{
+
+constexpr auto CURSOR_CACHE_TTL = std::chrono::minutes(10);
+
+}
+
+struct IllustCursor::State
+{
+	const CursorOptions opts;
+
+	std::mutex mtx;
+	std::condition_variable cv;
+	std::deque<Page> pages;	// Fetched but not taken yet
+	size_t requested = 0;	// Calls to next()
+	size_t fetched = 0;
+	bool done = false;
+	bool stop = false;
+	bool exited = false;	// The worker is about to return, joining it won't block
+	std::exception_ptr error;
+
+	explicit State(CursorOptions o) : opts(o) {}
+};
+
+struct IllustCursor::RetiredWorker
+{
+	std::shared_ptr<State> state;
+	std::thread worker;
+};
+
+std::mutex IllustCursor::_RetiredMtx;
+std::vector<IllustCursor::RetiredWorker> IllustCursor::_retired;
+
+IllustCursor::IllustCursor(std::shared_ptr<PixivClient> client, FirstPage first, CursorOptions opts) :
+_state(std::make_shared<State>(opts))
+{
+	this->_worker = std::thread(&IllustCursor::_run, this->_state, std::move(client), std::move(first));
+}
+
+IllustCursor::~IllustCursor()
+{
+	if (!this->_worker.joinable()) return;
+	{
+		std::lock_guard<std::mutex> lk(this->_state->mtx);
+		this->_state->stop = true;
+	}
+	this->_state->cv.notify_all();
+
+	std::lock_guard<std::mutex> lk(IllustCursor::_RetiredMtx);
+	std::erase_if(IllustCursor::_retired,
+	              [](RetiredWorker& retired)
+	              {
+					  {
+						  std::lock_guard<std::mutex> state_lk(retired.state->mtx);
+						  if (!retired.state->exited) return false;
+					  }
+					  retired.worker.join();
+					  return true;
+				  });
+	IllustCursor::_retired.push_back({this->_state, std::move(this->_worker)});
+}
+
+void IllustCursor::JoinRetired()
+{
+	std::vector<RetiredWorker> retired;
+	{
+		std::lock_guard<std::mutex> lk(IllustCursor::_RetiredMtx);
+		retired.swap(IllustCursor::_retired);
+	}
+	for (auto& p : retired)
+		p.worker.join();
+}
+
+void IllustCursor::_run(std::shared_ptr<State> state, std::shared_ptr<PixivClient> client, FirstPage first)
+{
+	struct ExitGuard
+	{
+		State& state;
+		~ExitGuard()
+		{
+			std::lock_guard<std::mutex> lk(this->state.mtx);
+			this->state.exited = true;
+		}
+	} guard{*state};
+
+	try
+	{
+		std::string NextUrl;
+		while (true)
+		{
+			{
+				std::unique_lock<std::mutex> lk(state->mtx);
+				state->cv.wait(lk, [&state]{
+					return state->stop || state->fetched < state->requested + state->opts.depth;
+				});
+				if (state->stop) return;
+			}
+
+			auto msg = NextUrl.empty() ? first(*client) : client->NextPage(NextUrl);
+			Page page;
+			for (const auto& item : Utils::GetValue(msg, "illusts", nlohmann::json::array()))
+			{
+				auto illust = std::make_shared<const Illust>(item.get<Illust>());
+				client->CacheIllust(illust, CURSOR_CACHE_TTL);
+				page.push_back(std::move(illust));
+			}
+			NextUrl = Utils::GetValue(msg, "next_url", "");
+
+			std::lock_guard<std::mutex> lk(state->mtx);
+			state->pages.push_back(std::move(page));
+			state->fetched++;
+			if (NextUrl.empty() || state->fetched >= state->opts.budget)
+			{
+				state->done = true;
+				state->cv.notify_all();
+				return;
+			}
+			state->cv.notify_all();
+		}
+	}
+	catch (...)
+	{
+		std::lock_guard<std::mutex> lk(state->mtx);
+		state->error = std::current_exception();
+		state->done = true;
+		state->cv.notify_all();
+	}
+}
+
+std::optional<IllustCursor::Page> IllustCursor::next()
+{
+	std::unique_lock<std::mutex> lk(this->_state->mtx);
+	auto& state = *this->_state;
+	if (state.pages.empty() && state.done && !state.error) return std::nullopt;
+
+	state.requested++;
+	state.cv.notify_all();
+	state.cv.wait(lk, [&state]{ return !state.pages.empty() || state.done; });
+	if (state.pages.empty())
+	{
+		if (state.error)
+		{
+			auto error = std::exchange(state.error, nullptr);
+			std::rethrow_exception(error);
+		}
+		return std::nullopt;
+	}
+
+	auto page = std::move(state.pages.front());
+	state.pages.pop_front();
+	state.cv.notify_all();
+	return page;
+}
+
+IllustCursor SearchIllusts(std::shared_ptr<PixivClient> client, std::string keyword, SearchOption option,
+                           SortOrder sort, CursorOptions opts)
+{
+	return {std::move(client),
+	        [keyword = std::move(keyword), option, sort](PixivClient& pclient)
+	        { return pclient.SearchIllust(keyword, option, sort); },
+	        opts};
+}
+
+IllustCursor RankingIllusts(std::shared_ptr<PixivClient> client, RankingMode mode, std::string date,
+                            CursorOptions opts)
+{
+	return {std::move(client),
+	        [mode, date = std::move(date)](PixivClient& pclient) { return pclient.GetIllustRanking(mode, date); },
+	        opts};
+}
+
+IllustCursor UserIllusts(std::shared_ptr<PixivClient> client, PUID_t UserId, ContentType type, CursorOptions opts)
+{
+	return {std::move(client),
+	        [UserId, type](PixivClient& pclient) { return pclient.GetUserIllusts(UserId, type); },
+	        opts};
+}
+
+IllustCursor BookmarkedIllusts(std::shared_ptr<PixivClient> client, PUID_t UserId, RESTRICT restrict,
+                               std::string tag, CursorOptions opts)
+{
+	return {std::move(client),
+	        [UserId, restrict, tag = std::move(tag)](PixivClient& pclient)
+	        { return pclient.GetUserBookmarkedIllusts(UserId, restrict, 0_pid, tag); },
+	        opts};
+}
+
+}
@@ -0,0 +1,81 @@
+#ifndef _PIXIV_CURSOR_HPP_
+#define _PIXIV_CURSOR_HPP_
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "Models.hpp"
+
+namespace Pixiv
+{
+
+class PixivClient;
+
+struct CursorOptions
+{
+	size_t depth = 1;	// Pages fetched ahead of the one being consumed, 0 fetches on demand
+	size_t budget = 10;	// Pages fetched in total
+};
+
+// Pages through an endpoint returning "illusts" and "next_url" (search, ranking, user illusts, bookmarks).
+// A background thread keeps up to depth pages ahead of the caller, so next() rarely waits for the network.
+// Pages before a failure are still returned, next() rethrows the failure after them.
+// Illusts are put into the illust cache of the client on the way
+class IllustCursor
+{
+public:
+	using Page = std::vector<std::shared_ptr<const Illust>>;
+	using FirstPage = std::function<nlohmann::json(PixivClient&)>;
+
+protected:
+	struct State;
+	std::shared_ptr<State> _state;
+	std::thread _worker;
+
+	// Workers of destroyed cursors, joined once they are done
+	struct RetiredWorker;
+	static std::mutex _RetiredMtx;
+	static std::vector<RetiredWorker> _retired;
+
+	static void _run(std::shared_ptr<State> state, std::shared_ptr<PixivClient> client, FirstPage first);
+
+public:
+	IllustCursor(std::shared_ptr<PixivClient> client, FirstPage first, CursorOptions opts = {});
+	IllustCursor(const IllustCursor&) = delete;
+	IllustCursor& operator=(const IllustCursor&) = delete;
+	IllustCursor(IllustCursor&&) noexcept = default;
+	IllustCursor& operator=(IllustCursor&&) = delete;
+	// Does not wait for a request in flight, it finishes in the background and nothing further is fetched
+	~IllustCursor();
+
+	// Joins the workers of destroyed cursors, before the plugin is unloaded
+	static void JoinRetired();
+
+	// nullopt once there are no more pages or the budget is used up
+	std::optional<Page> next();
+};
+
+IllustCursor SearchIllusts(std::shared_ptr<PixivClient> client, std::string keyword,
+                           SearchOption option = SearchOption::TAGS_PARTIAL, SortOrder sort = SortOrder::DATE_DESC,
+                           CursorOptions opts = {});
+
+IllustCursor RankingIllusts(std::shared_ptr<PixivClient> client, RankingMode mode = RankingMode::DAY,
+                            std::string date = {}, CursorOptions opts = {});
+
+IllustCursor UserIllusts(std::shared_ptr<PixivClient> client, PUID_t UserId, ContentType type = ContentType::ILLUST,
+                         CursorOptions opts = {});
+
+IllustCursor BookmarkedIllusts(std::shared_ptr<PixivClient> client, PUID_t UserId,
+                               RESTRICT restrict = RESTRICT::PUBLIC, std::string tag = {}, CursorOptions opts = {});
+
+}
+
+#endif
@@ -208,7 +208,7 @@ struct Illust
 	std::optional<std::pair<uint64_t, std::string>> series; // id, title
 	std::optional<uint64_t> TotalComments;
 
-	std::vector<std::string> GetImageUrls()
+	std::vector<std::string> GetImageUrls() const
 	{
 		std::vector<std::string> urls;
 		for (const auto& p : this->PageUrls)
@@ -1,5 +1,8 @@
+#include <algorithm>
 #include <chrono>
 #include <ctime>
+#include <memory>
+#include <optional>
 
 #include <nlohmann/json.hpp>
 #include <regex>
@@ -8,7 +11,10 @@
 
 #include "PixivClient.hpp"
 
+#include <PluginUtils/AsyncHttp.hpp>
+#include <PluginUtils/JsonStream.hpp>
 #include <PluginUtils/NetworkUtils.hpp>
+#include <PluginUtils/SingleFlight.hpp>
 #include <PluginUtils/UrlComponents.hpp>
 #include <httplib.h>
 
@@ -85,19 +91,33 @@ httplib::Headers GetClientHashHeader()
 	};
 }
 
+// Images are kept in the image cache of the client instead of the http cache
+const Utils::CachePolicy IMAGE_FETCH_POLICY{.mode = Utils::CachePolicy::Mode::NO_STORE};
+
+Utils::Task<std::optional<string>> TryDownload(Utils::Task<string> task)
+{
+	try
+	{
+		co_return co_await task;
+	}
+	catch (const std::exception& e)
+	{
+		LOG_WARN(Utils::GetLogger(), "Failed to download illust. Error: " + string(e.what()));
+	}
+	co_return std::nullopt;
 }
 
-httplib::Client PixivClient::_GetOAuthClient() const
+}
+
+Utils::HttpPool::Lease PixivClient::_GetOAuthClient() const
 {
-	httplib::Client cli(oauth_hosts.data());
-	if (!this->_ProxyHost.empty() && this->_ProxyPort > 0)
-		cli.set_proxy(this->_ProxyHost, this->_ProxyPort);
+	auto cli = Utils::GetHttpClient(oauth_hosts.data(), this->_ProxyHost, this->_ProxyPort);
 
-	cli.set_connection_timeout(10);		// NOLINT(*-avoid-magic-numbers)
-	cli.set_write_timeout(10);		// NOLINT(*-avoid-magic-numbers)
-	cli.set_read_timeout(60);		// NOLINT(*-avoid-magic-numbers)
+	cli->set_connection_timeout(10);		// NOLINT(*-avoid-magic-numbers)
+	cli->set_write_timeout(10);		// NOLINT(*-avoid-magic-numbers)
+	cli->set_read_timeout(60);		// NOLINT(*-avoid-magic-numbers)
 
-	cli.set_default_headers({
+	cli->set_default_headers({
 		{"User-Agent", "PixivAndroidApp/5.0.234 (Android 11; Pixel 5)"},
 		{"App-Version", "5.0.234"},
 		{"App-OS-Version", "Android 11.0"},
@@ -108,17 +128,15 @@ httplib::Client PixivClient::_GetOAuthClient() const
 	return cli;
 }
 
-httplib::Client PixivClient::_GetApiClient() const
+Utils::HttpPool::Lease PixivClient::_GetApiClient() const
 {
-	httplib::Client cli(api_hosts.data());
-	if (!this->_ProxyHost.empty() && this->_ProxyPort > 0)
-		cli.set_proxy(this->_ProxyHost, this->_ProxyPort);
+	auto cli = Utils::GetHttpClient(api_hosts.data(), this->_ProxyHost, this->_ProxyPort);
 
-	cli.set_connection_timeout(10);		// NOLINT(*-avoid-magic-numbers)
-	cli.set_write_timeout(10);		// NOLINT(*-avoid-magic-numbers)
-	cli.set_read_timeout(60);		// NOLINT(*-avoid-magic-numbers)
+	cli->set_connection_timeout(10);		// NOLINT(*-avoid-magic-numbers)
+	cli->set_write_timeout(10);		// NOLINT(*-avoid-magic-numbers)
+	cli->set_read_timeout(60);		// NOLINT(*-avoid-magic-numbers)
 
-	cli.set_default_headers({
+	cli->set_default_headers({
 		{"User-Agent", "PixivAndroidApp/5.0.234 (Android 11; Pixel 5)"},
 		{"App-Version", "5.0.234"},
 		{"App-OS-Version", "Android 11.0"},
@@ -129,20 +147,18 @@ httplib::Client PixivClient::_GetApiClient() const
 	return cli;
 }
 
-httplib::Client PixivClient::_GetDownloadClient() const
+Utils::HttpPool::Lease PixivClient::_GetDownloadClient() const
 {
-	httplib::Client cli(download_hosts.data());
-	if (!this->_ProxyHost.empty() && this->_ProxyPort > 0)
-		cli.set_proxy(this->_ProxyHost, this->_ProxyPort);
+	auto cli = Utils::GetHttpClient(download_hosts.data(), this->_ProxyHost, this->_ProxyPort);
 
-	cli.set_connection_timeout(10);		// NOLINT(*-avoid-magic-numbers)
-	cli.set_write_timeout(10);		// NOLINT(*-avoid-magic-numbers)
-	cli.set_read_timeout(120);		// NOLINT(*-avoid-magic-numbers)
+	cli->set_connection_timeout(10);		// NOLINT(*-avoid-magic-numbers)
+	cli->set_write_timeout(10);		// NOLINT(*-avoid-magic-numbers)
+	cli->set_read_timeout(120);		// NOLINT(*-avoid-magic-numbers)
 
 	return cli;
 }
 
-void PixivClient::_login()
+std::shared_ptr<const PixivClient::AccessToken> PixivClient::_login()
 {
 	auto headers = GetClientHashHeader();
 
@@ -154,89 +170,222 @@ void PixivClient::_login()
 		{"refresh_token", this->_RefreshToken},
 		{"include_policy", "true"}
 	};
-	auto result = this->_GetOAuthClient().Post("/auth/token", headers, params);
+	auto result = this->_GetOAuthClient()->Post("/auth/token", headers, params);
 	
 	json resp = Utils::GetJsonResponse(result);
 
-	this->_AccessToken = resp.at("access_token").get<std::string>();
-	this->_ObtainedTime = std::chrono::system_clock::now();
+	auto token = std::make_shared<const AccessToken>(
+		AccessToken{resp.at("access_token").get<std::string>(), std::chrono::system_clock::now()});
+	this->_token.store(token);
 
-	LOG_INFO(Utils::GetLogger(), "Login successful, Access Token: " + this->_AccessToken);
+	LOG_INFO(Utils::GetLogger(), "Login successful, Access Token: " + token->token);
+	return token;
 }
 
 string PixivClient::_GetToken()
 {
-	std::lock_guard<std::mutex> lk(this->_mtx);
-	if (this->_AccessToken.empty() || 
-		std::chrono::system_clock::now() - this->_ObtainedTime > expire_timeout)
-	{
-		LOG_INFO(Utils::GetLogger(), "Token expired, relogging");
-		this->_login();
-	}
+	auto valid = [](const std::shared_ptr<const AccessToken>& token)
+	{ return token && std::chrono::system_clock::now() - token->ObtainedTime <= expire_timeout; };
 
-	return this->_AccessToken;
+	auto token = this->_token.load();
+	if (valid(token)) return token->token;
+
+	std::lock_guard<std::mutex> lk(this->_LoginMtx);
+	// Someone else may have logged in while we waited
+	token = this->_token.load();
+	if (valid(token)) return token->token;
+
+	LOG_INFO(Utils::GetLogger(), "Token expired, relogging");
+	return this->_login()->token;
 }
 
-string PixivClient::DownloadIllust(const string& url)
+void PixivClient::RefreshToken()
 {
-	Utils::UrlComponent component = Utils::UrlComponent::ParseUrl(url);
+	auto due = [](const std::shared_ptr<const AccessToken>& token)
+	{ return !token || std::chrono::system_clock::now() - token->ObtainedTime > refresh_ahead; };
 
-	auto result = this->_GetDownloadClient().Get(
-		component.path, 
-		httplib::Headers{
-			{"User-Agent", "PixivIOSApp/5.8.0"},
-			{"Referer", api_hosts.data()}
-		});
+	if (!due(this->_token.load())) return;
 
-	if (!Utils::VerifyResponse(result))
-		throw Utils::NetworkException(result);
+	std::lock_guard<std::mutex> lk(this->_LoginMtx);
+	if (!due(this->_token.load()) || std::chrono::steady_clock::now() < this->_RetryAfter) return;
 
-	return result->body;
+	try
+	{
+		this->_login();
+		this->_backoff = {};
+	}
+	catch (const std::exception& e)
+	{
+		this->_backoff = std::clamp<std::chrono::seconds>(this->_backoff * 2, min_refresh_backoff, max_refresh_backoff);
+		this->_RetryAfter = std::chrono::steady_clock::now() + this->_backoff;
+		LOG_WARN(Utils::GetLogger(), "Failed to refresh token, retrying in " + std::to_string(this->_backoff.count())
+		                                 + "s: " + e.what());
+	}
 }
 
-void PixivClient::DownloadIllust(const string& url, std::function<bool(const char*, size_t)> receiver)
+std::shared_ptr<Utils::DiskCache> PixivClient::_GetImageCache() const
+{
+	std::lock_guard<std::mutex> lk(this->_mtx);
+	return this->_ImageCache;
+}
+
+void PixivClient::SetImageCache(std::shared_ptr<Utils::DiskCache> cache)
+{
+	std::lock_guard<std::mutex> lk(this->_mtx);
+	this->_ImageCache = std::move(cache);
+}
+
+string PixivClient::DownloadIllust(const string& url)
 {
 	Utils::UrlComponent component = Utils::UrlComponent::ParseUrl(url);
+	const string target = string(download_hosts) + component.path;
+	auto cache = this->_GetImageCache();
+	if (cache)
+	{
+		if (auto image = cache->get(target)) return std::move(*image);
+	}
 
-	auto result = this->_GetDownloadClient().Get(
-		component.path, 
-		httplib::Headers{
-			{"User-Agent", "PixivIOSApp/5.8.0"},
-			{"Referer", api_hosts.data()}
-		},
-		std::move(receiver));
+	httplib::Headers headers{
+		{"User-Agent", "PixivIOSApp/5.8.0"},
+		{"Referer", api_hosts.data()}
+	};
 
-	if (!Utils::VerifyResponse(result))
-		throw Utils::NetworkException(result);
+	// Concurrent downloads of the same page are coalesced
+	auto response = Utils::FetchGet(
+		target, headers,
+		[&](const httplib::Headers& request) { return this->_GetDownloadClient()->Get(component.path, request); },
+		IMAGE_FETCH_POLICY);
+	if (cache) cache->put(target, response->body);
+	return response->body;
 }
 
-std::vector<string> PixivClient::BatchDownloadIllust(const std::vector<string>& urls)
+void PixivClient::DownloadIllust(const string& url, std::function<bool(const char*, size_t)> receiver)
 {
-	std::vector<string> results;
-	auto client = this->_GetDownloadClient();
-	client.set_keep_alive(true);
+	// The first caller streams the image, callers asking for it meanwhile get it in one piece afterwards.
+	// nullptr if the receiver of the first caller stopped the download
+	static Utils::SingleFlight<string, std::shared_ptr<const string>> flight;
 
-	for (const auto& url : urls)
+	Utils::UrlComponent component = Utils::UrlComponent::ParseUrl(url);
+	const string target = string(download_hosts) + component.path;
+	auto cache = this->_GetImageCache();
+	if (cache)
 	{
-		Utils::UrlComponent component = Utils::UrlComponent::ParseUrl(url);
+		if (auto image = cache->get(target))
+		{
+			receiver(image->data(), image->size());
+			return;
+		}
+	}
 
-		auto result = client.Get(
+	bool streamed = false;
+	std::optional<Utils::NetworkException> cancelled;
+	auto download = [&]() -> std::shared_ptr<const string>
+	{
+		streamed = true;
+		auto image = std::make_shared<string>();
+		bool complete = true;
+		bool success = true;
+		auto result = this->_GetDownloadClient()->Get(
 			component.path, 
 			httplib::Headers{
 				{"User-Agent", "PixivIOSApp/5.8.0"},
 				{"Referer", api_hosts.data()}
+			},
+			[&success](const httplib::Response& response)
+			{
+				success = response.status >= 200 && response.status <= 299;	// NOLINT(*-avoid-magic-numbers)
+				return true;
+			},
+			[&](const char* data, size_t len)
+			{
+				image->append(data, len);
+				// Error bodies never reach the receiver, they are kept for the exception
+				if (!success) return true;
+				complete = receiver(data, len);
+				return complete;
 			});
 
+		if (!complete)
+		{
+			cancelled.emplace(result);
+			return nullptr;
+		}
 		if (!Utils::VerifyResponse(result))
 		{
-			if (!result)
-				LOG_WARN(Utils::GetLogger(), "Failed to download illust. Error: " + httplib::to_string(result.error()));
-			else
-				LOG_WARN(Utils::GetLogger(), "Failed to download illust. Reason: " + result->reason + ", Body: " + result->body);
-			return results;
+			if (result) result->body = std::move(*image);
+			throw Utils::NetworkException(result);
+		}
+		if (cache) cache->put(target, *image);
+		return image;
+	};
+
+	auto image = flight.run(target, download);
+	if (!streamed)
+	{
+		if (image)
+		{
+			receiver(image->data(), image->size());
+			return;
 		}
+		// The first caller gave up early, download it for this one
+		image = download();
+	}
+	if (!image) throw *cancelled;
+}
+
+Utils::Task<string> PixivClient::DownloadIllustAsync(string url) const
+{
+	using namespace std::literals;
+
+	Utils::UrlComponent component = Utils::UrlComponent::ParseUrl(url);
+
+	Utils::AsyncHttpOptions opts;
+	opts.ConnectTimeout = 10s;
+	opts.WriteTimeout = 10s;
+	opts.ReadTimeout = 120s;
+	opts.ProxyHost = this->_ProxyHost;
+	opts.ProxyPort = this->_ProxyPort;
+	httplib::Headers headers{
+		{"User-Agent", "PixivIOSApp/5.8.0"},
+		{"Referer", api_hosts.data()}
+	};
+
+	string target = string(download_hosts) + component.path;
+	auto cache = this->_GetImageCache();
+	// Cache reads and writes block on the disk, keep them off the loop threads
+	auto& loop = Utils::EventLoop::GetInstance();
+	if (cache)
+	{
+		auto image = co_await loop.offload([&cache, &target] { return cache->get(target); });
+		if (image) co_return std::move(*image);
+	}
+
+	auto resp = co_await Utils::AsyncHttpClient::GetInstance().Get(target, std::move(headers), std::move(opts));
+	if (!resp.ok())
+		throw Utils::AsyncHttpError("Failed to download illust. Reason: " + resp.reason + ", Body: " + resp.body + " <"
+		                            + std::to_string(resp.status) + ">");
+
+	if (cache) co_await loop.offload([&cache, &target, &resp] { cache->put(target, resp.body); });
+	co_return std::move(resp.body);
+}
+
+std::vector<string> PixivClient::BatchDownloadIllust(const std::vector<string>& urls)
+{
+	// Keep the number of simultaneous connections to i.pximg.net reasonable for large albums
+	constexpr size_t MAX_CONCURRENT = 8;
+
+	std::vector<string> results;
+	for (size_t i = 0; i < urls.size(); i += MAX_CONCURRENT)
+	{
+		std::vector<Utils::Task<std::optional<string>>> tasks;
+		for (size_t j = i; j < std::min(i + MAX_CONCURRENT, urls.size()); j++)
+			tasks.push_back(TryDownload(this->DownloadIllustAsync(urls[j])));
 
-		results.emplace_back(std::move(result->body));
+		for (auto& image : Utils::SyncWait(Utils::WhenAll(std::move(tasks))))
+		{
+			if (!image) return results;
+			results.emplace_back(std::move(*image));
+		}
 	}
 	return results;
 }
@@ -244,13 +393,22 @@ std::vector<string> PixivClient::BatchDownloadIllust(const std::vector<string>&
 void PixivClient::BatchDownloadIllust(const std::vector<string>& urls, std::function<bool(string, size_t)> receiver)
 {
 	auto client = this->_GetDownloadClient();
-	client.set_keep_alive(true);
+	auto cache = this->_GetImageCache();
 
 	for (size_t i = 0; i < urls.size(); i++)
 	{
 		Utils::UrlComponent component = Utils::UrlComponent::ParseUrl(urls[i]);
+		const string target = string(download_hosts) + component.path;
+		if (cache)
+		{
+			if (auto image = cache->get(target))
+			{
+				receiver(std::move(*image), i);
+				continue;
+			}
+		}
 
-		auto result = client.Get(
+		auto result = client->Get(
 			component.path, 
 			httplib::Headers{
 				{"User-Agent", "PixivIOSApp/5.8.0"},
@@ -266,6 +424,7 @@ void PixivClient::BatchDownloadIllust(const std::vector<string>& urls, std::func
 			break;
 		}
 
+		if (cache) cache->put(target, result->body);
 		receiver(std::move(result->body), i);
 	}
 }
@@ -281,7 +440,7 @@ json PixivClient::GetUserDetails(PUID_t UserId)
 		{"filter", "for_android"}
 	};
 
-	return Utils::GetJsonResponse(this->_GetApiClient().Get("/v1/user/detail", params, headers));
+	return Utils::GetJsonResponse(this->_GetApiClient()->Get("/v1/user/detail", params, headers));
 }
 
 json PixivClient::SearchUser(string name, uint64_t offset)
@@ -297,7 +456,7 @@ json PixivClient::SearchUser(string name, uint64_t offset)
 	if (offset > 0)
 		params.emplace("offset", std::to_string(offset));
 
-	return Utils::GetJsonResponse(this->_GetApiClient().Get("/v1/search/user", params, headers));
+	return Utils::GetJsonResponse(this->_GetApiClient()->Get("/v1/search/user", params, headers));
 }
 
 json PixivClient::FollowUser(PUID_t UserId, RESTRICT restrict)
@@ -311,7 +470,7 @@ json PixivClient::FollowUser(PUID_t UserId, RESTRICT restrict)
 		{"restrict", to_string(restrict)}
 	};
 
-	return Utils::GetJsonResponse(this->_GetApiClient().Post("/v1/user/follow/add", headers, params));
+	return Utils::GetJsonResponse(this->_GetApiClient()->Post("/v1/user/follow/add", headers, params));
 }
 
 json PixivClient::UnfollowUser(PUID_t UserId)
@@ -324,7 +483,7 @@ json PixivClient::UnfollowUser(PUID_t UserId)
 		{"user_id", UserId.to_string()}
 	};
 
-	return Utils::GetJsonResponse(this->_GetApiClient().Post("/v1/user/follow/delete", headers, params));
+	return Utils::GetJsonResponse(this->_GetApiClient()->Post("/v1/user/follow/delete", headers, params));
 }
 
 json PixivClient::GetUserBookmarkTags(PUID_t UserId, RESTRICT restrict, uint64_t offset)
@@ -341,7 +500,7 @@ json PixivClient::GetUserBookmarkTags(PUID_t UserId, RESTRICT restrict, uint64_t
 	if (offset > 0)
 		params.emplace("offset", std::to_string(offset));
 
-	return Utils::GetJsonResponse(this->_GetApiClient().Get("/v1/user/bookmark-tags/illust", params, headers));
+	return Utils::GetJsonResponse(this->_GetApiClient()->Get("/v1/user/bookmark-tags/illust", params, headers));
 }
 
 json PixivClient::GetUserIllusts(PUID_t UserId, ContentType type, uint64_t offset)
@@ -358,7 +517,7 @@ json PixivClient::GetUserIllusts(PUID_t UserId, ContentType type, uint64_t offse
 	if (offset > 0)
 		params.emplace("offset", std::to_string(offset));
 
-	return Utils::GetJsonResponse(this->_GetApiClient().Get("/v1/user/illusts", params, headers));
+	return Utils::GetJsonResponse(this->_GetApiClient()->Get("/v1/user/illusts", params, headers));
 }
 
 json PixivClient::GetUserNovels(PUID_t UserId, uint64_t offset)
@@ -374,7 +533,7 @@ json PixivClient::GetUserNovels(PUID_t UserId, uint64_t offset)
 	if (offset > 0)
 		params.emplace("offset", std::to_string(offset));
 
-	return Utils::GetJsonResponse(this->_GetApiClient().Get("/v1/user/novels", params, headers));
+	return Utils::GetJsonResponse(this->_GetApiClient()->Get("/v1/user/novels", params, headers));
 }
 
 json PixivClient::GetUserFollowing(PUID_t UserId, RESTRICT restrict, uint64_t offset)
@@ -392,7 +551,7 @@ json PixivClient::GetUserFollowing(PUID_t UserId, RESTRICT restrict, uint64_t of
 	if (offset > 0)
 		params.emplace("offset", std::to_string(offset));
 
-	return Utils::GetJsonResponse(this->_GetApiClient().Get("/v1/user/following", params, headers));
+	return Utils::GetJsonResponse(this->_GetApiClient()->Get("/v1/user/following", params, headers));
 }
 
 json PixivClient::GetUserFollower(PUID_t UserId, RESTRICT restrict, uint64_t offset)
@@ -410,7 +569,7 @@ json PixivClient::GetUserFollower(PUID_t UserId, RESTRICT restrict, uint64_t off
 	if (offset > 0)
 		params.emplace("offset", std::to_string(offset));
 
-	return Utils::GetJsonResponse(this->_GetApiClient().Get("/v1/user/follower", params, headers));
+	return Utils::GetJsonResponse(this->_GetApiClient()->Get("/v1/user/follower", params, headers));
 }
 
 json PixivClient::GetUserMyPixiv(PUID_t UserId, uint64_t offset)
@@ -427,7 +586,7 @@ json PixivClient::GetUserMyPixiv(PUID_t UserId, uint64_t offset)
 	if (offset > 0)
 		params.emplace("offset", std::to_string(offset));
 
-	return Utils::GetJsonResponse(this->_GetApiClient().Get("/v1/user/mypixiv", params, headers));
+	return Utils::GetJsonResponse(this->_GetApiClient()->Get("/v1/user/mypixiv", params, headers));
 }
 
 json PixivClient::GetUserBlacklist(PUID_t UserId, uint64_t offset)
@@ -444,7 +603,7 @@ json PixivClient::GetUserBlacklist(PUID_t UserId, uint64_t offset)
 	if (offset > 0)
 		params.emplace("offset", std::to_string(offset));
 
-	return Utils::GetJsonResponse(this->_GetApiClient().Get("/v2/user/list", params, headers));
+	return Utils::GetJsonResponse(this->_GetApiClient()->Get("/v2/user/list", params, headers));
 }
 
 json PixivClient::GetUserBookmarkedIllusts(PUID_t UserId, RESTRICT restrict, 
@@ -464,7 +623,7 @@ json PixivClient::GetUserBookmarkedIllusts(PUID_t UserId, RESTRICT restrict,
 	if (!tag.empty())
 		params.emplace("tag", std::move(tag));
 
-	return Utils::GetJsonResponse(this->_GetApiClient().Get("/v1/user/bookmarks/illust", params, headers));
+	return Utils::GetJsonResponse(this->_GetApiClient()->Get("/v1/user/bookmarks/illust", params, headers));
 }
 
 json PixivClient::GetRelatedUsers(PUID_t UserId, uint64_t offset)
@@ -477,7 +636,7 @@ json PixivClient::GetRelatedUsers(PUID_t UserId, uint64_t offset)
 	if (offset > 0)
 		params.emplace("offset", std::to_string(offset));
 
-	return Utils::GetJsonResponse(this->_GetApiClient().Get("/v1/user/related", params, headers));
+	return Utils::GetJsonResponse(this->_GetApiClient()->Get("/v1/user/related", params, headers));
 }
 
 json PixivClient::GetRecommendedUser(uint64_t offset)
@@ -490,7 +649,7 @@ json PixivClient::GetRecommendedUser(uint64_t offset)
 	if (offset > 0)
 		params.emplace("offset", std::to_string(offset));
 
-	return Utils::GetJsonResponse(this->_GetApiClient().Get("/v1/user/recommended", params, headers));
+	return Utils::GetJsonResponse(this->_GetApiClient()->Get("/v1/user/recommended", params, headers));
 }
 
 json PixivClient::GetFollowedIllust(RESTRICT restrict, uint64_t offset)
@@ -503,7 +662,7 @@ json PixivClient::GetFollowedIllust(RESTRICT restrict, uint64_t offset)
 	if (offset > 0)
 		params.emplace("offset", std::to_string(offset));
 
-	return Utils::GetJsonResponse(this->_GetApiClient().Get("/v2/illust/follow", params, headers));
+	return Utils::GetJsonResponse(this->_GetApiClient()->Get("/v2/illust/follow", params, headers));
 }
 
 json PixivClient::GetIllustDetails(PID_t pid)
@@ -514,7 +673,45 @@ json PixivClient::GetIllustDetails(PID_t pid)
 	
 	httplib::Params params{{"illust_id", pid.to_string()}};
 
-	return Utils::GetJsonResponse(this->_GetApiClient().Get("/v1/illust/detail", params, headers));
+	// The same illust is often requested from several groups at once
+	auto response = Utils::FetchGet(string(api_hosts) + "/v1/illust/detail?" + Utils::Params2Query(params), headers,
+	                                [&](const httplib::Headers& request)
+	                                { return this->_GetApiClient()->Get("/v1/illust/detail", params, request); });
+	return Utils::ParseJson(response->body);
+}
+
+std::shared_ptr<const Illust> PixivClient::GetIllust(PID_t pid)
+{
+	auto cached = this->_IllustCache.get((int64_t)pid);
+	if (cached)
+	{
+		if (cached->error) std::rethrow_exception(cached->error);
+		return cached->illust;
+	}
+
+	json msg;
+	try
+	{
+		msg = this->GetIllustDetails(pid);
+	}
+	catch (const Utils::NetworkException& e)
+	{
+		if (e._code == 404)	// NOLINT(*-avoid-magic-numbers)
+			this->_IllustCache.put((int64_t)pid, {nullptr, std::current_exception()}, illust_missing_ttl);
+		throw;
+	}
+	if (!msg.contains("illust"))
+		throw Utils::ParseError("Response does not contain 'illust' field", msg.dump());
+
+	auto illust = std::make_shared<const Illust>(msg.at("illust").get<Illust>());
+	this->_IllustCache.put((int64_t)pid, {illust, nullptr}, illust_cache_ttl);
+	return illust;
+}
+
+void PixivClient::CacheIllust(std::shared_ptr<const Illust> illust, std::chrono::seconds ttl)
+{
+	const auto pid = (int64_t)illust->id;
+	this->_IllustCache.put(pid, {std::move(illust), nullptr}, ttl);
 }
 
 json PixivClient::GetIllustComments(PID_t pid, uint64_t offset, bool IncludeTotalComments)
@@ -529,7 +726,7 @@ json PixivClient::GetIllustComments(PID_t pid, uint64_t offset, bool IncludeTota
 	if (IncludeTotalComments)
 		params.emplace("include_total_comments", "true");
 
-	return Utils::GetJsonResponse(this->_GetApiClient().Get("/v1/illust/comments", params, headers));
+	return Utils::GetJsonResponse(this->_GetApiClient()->Get("/v1/illust/comments", params, headers));
 }
 
 json PixivClient::GetRelatedIllusts(PID_t pid, uint64_t offset, const std::vector<PID_t>& seeds)
@@ -547,7 +744,7 @@ json PixivClient::GetRelatedIllusts(PID_t pid, uint64_t offset, const std::vecto
 			params.emplace("seed_illust_ids[]", id.to_string());
 	}
 
-	return Utils::GetJsonResponse(this->_GetApiClient().Get("/v2/illust/related", params, headers));
+	return Utils::GetJsonResponse(this->_GetApiClient()->Get("/v2/illust/related", params, headers));
 }
 
 json PixivClient::GetRecommendedIllusts(ContentType type, 
@@ -588,7 +785,7 @@ json PixivClient::GetRecommendedIllusts(ContentType type,
 	if (include_privacy_policy)
 		params.emplace("include_privacy_policy", "true");
 
-	return Utils::GetJsonResponse(this->_GetApiClient().Get("/v1/illust/recommended", params, headers));
+	return Utils::GetJsonResponse(this->_GetApiClient()->Get("/v1/illust/recommended", params, headers));
 }
 
 json PixivClient::GetIllustRanking(RankingMode option, std::string date, uint64_t offset)
@@ -603,7 +800,10 @@ json PixivClient::GetIllustRanking(RankingMode option, std::string date, uint64_
 	if (offset > 0)
 		params.emplace("offset", std::to_string(offset));
 
-	return Utils::GetJsonResponse(this->_GetApiClient().Get("/v1/illust/ranking", params, headers));
+	// Ranking and search pages are large, parse them while they arrive
+	return Utils::GetJsonStreaming(
+		[&](auto handler, auto receiver)
+		{ return this->_GetApiClient()->Get("/v1/illust/ranking", params, headers, handler, receiver); });
 }
 
 json PixivClient::GetTrendingTagsIllust()
@@ -614,7 +814,7 @@ json PixivClient::GetTrendingTagsIllust()
 	
 	httplib::Params params{{"filter", "for_android"}};
 
-	return Utils::GetJsonResponse(this->_GetApiClient().Get("/v1/trending-tags/illust", params, headers));
+	return Utils::GetJsonResponse(this->_GetApiClient()->Get("/v1/trending-tags/illust", params, headers));
 }
 
 json PixivClient::GetTrendingTagsNovel()
@@ -625,7 +825,7 @@ json PixivClient::GetTrendingTagsNovel()
 	
 	httplib::Params params{{"filter", "for_android"}};
 
-	return Utils::GetJsonResponse(this->_GetApiClient().Get("/v1/trending-tags/novel", params, headers));
+	return Utils::GetJsonResponse(this->_GetApiClient()->Get("/v1/trending-tags/novel", params, headers));
 }
 
 json PixivClient::SearchIllust(std::string keyword, SearchOption option, SortOrder sort,
@@ -653,7 +853,9 @@ json PixivClient::SearchIllust(std::string keyword, SearchOption option, SortOrd
 	if (offset > 0)
 		params.emplace("offset", std::to_string(offset));
 
-	return Utils::GetJsonResponse(this->_GetApiClient().Get("/v1/search/illust", params, headers));
+	return Utils::GetJsonStreaming(
+		[&](auto handler, auto receiver)
+		{ return this->_GetApiClient()->Get("/v1/search/illust", params, headers, handler, receiver); });
 }
 
 json PixivClient::GetIllustBookmarkDetails(PID_t pid)
@@ -664,7 +866,7 @@ json PixivClient::GetIllustBookmarkDetails(PID_t pid)
 	
 	httplib::Params params{{"illust_id", pid.to_string()}};
 
-	return Utils::GetJsonResponse(this->_GetApiClient().Get("/v2/illust/bookmark/detail", params, headers));
+	return Utils::GetJsonResponse(this->_GetApiClient()->Get("/v2/illust/bookmark/detail", params, headers));
 }
 
 json PixivClient::AddBookmark(PID_t pid, RESTRICT restrict, const std::vector<std::string>& tags)
@@ -685,7 +887,7 @@ json PixivClient::AddBookmark(PID_t pid, RESTRICT restrict, const std::vector<st
 		params.emplace("tags[]", str);
 	}
 
-	return Utils::GetJsonResponse(this->_GetApiClient().Post("/v2/illust/bookmark/add", headers, params));
+	return Utils::GetJsonResponse(this->_GetApiClient()->Post("/v2/illust/bookmark/add", headers, params));
 }
 
 json PixivClient::DeleteBookmark(PID_t pid)
@@ -698,7 +900,7 @@ json PixivClient::DeleteBookmark(PID_t pid)
 		{"illust_id", pid.to_string()}
 	};
 
-	return Utils::GetJsonResponse(this->_GetApiClient().Post("/v2/illust/bookmark/delete", headers, params));
+	return Utils::GetJsonResponse(this->_GetApiClient()->Post("/v2/illust/bookmark/delete", headers, params));
 }
 
 json PixivClient::GetUgoiraMetadata(PID_t pid)
@@ -711,7 +913,7 @@ json PixivClient::GetUgoiraMetadata(PID_t pid)
 		{"illust_id", pid.to_string()}
 	};
 
-	return Utils::GetJsonResponse(this->_GetApiClient().Get("/v1/ugoira/metadata", params, headers));
+	return Utils::GetJsonResponse(this->_GetApiClient()->Get("/v1/ugoira/metadata", params, headers));
 }
 
 json PixivClient::GetNovelSeries(uint64_t SeriesId, std::string LastOrder)
@@ -728,7 +930,7 @@ json PixivClient::GetNovelSeries(uint64_t SeriesId, std::string LastOrder)
 	if (!LastOrder.empty())
 		params.emplace("last_order", std::move(LastOrder));
 
-	return Utils::GetJsonResponse(this->_GetApiClient().Get("/v2/novel/series", params, headers));
+	return Utils::GetJsonResponse(this->_GetApiClient()->Get("/v2/novel/series", params, headers));
 }
 
 json PixivClient::GetNovelDetails(PNID_t pnid)
@@ -741,7 +943,7 @@ json PixivClient::GetNovelDetails(PNID_t pnid)
 		{"novel_id", pnid.to_string()}
 	};
 
-	return Utils::GetJsonResponse(this->_GetApiClient().Get("/v2/novel/detail", params, headers));
+	return Utils::GetJsonResponse(this->_GetApiClient()->Get("/v2/novel/detail", params, headers));
 }
 
 json PixivClient::GetNovelComments(PNID_t pnid, uint64_t offset, bool IncludeTotalComments)
@@ -758,7 +960,7 @@ json PixivClient::GetNovelComments(PNID_t pnid, uint64_t offset, bool IncludeTot
 	if (IncludeTotalComments)
 		params.emplace("include_total_comments", "true");
 	
-	return Utils::GetJsonResponse(this->_GetApiClient().Get("/v1/novel/comments", params, headers));
+	return Utils::GetJsonResponse(this->_GetApiClient()->Get("/v1/novel/comments", params, headers));
 }
 
 json PixivClient::GetNovelText(PNID_t pnid)
@@ -771,7 +973,7 @@ json PixivClient::GetNovelText(PNID_t pnid)
 		{"novel_id", pnid.to_string()}
 	};
 
-	return Utils::GetJsonResponse(this->_GetApiClient().Get("/v1/novel/text", params, headers));
+	return Utils::GetJsonResponse(this->_GetApiClient()->Get("/v1/novel/text", params, headers));
 }
 
 json PixivClient::SearchNovel(std::string keyword, SearchOption option, SortOrder sort,
@@ -800,7 +1002,7 @@ json PixivClient::SearchNovel(std::string keyword, SearchOption option, SortOrde
 	if (offset > 0)
 		params.emplace("offset", std::to_string(offset));
 
-	return Utils::GetJsonResponse(this->_GetApiClient().Get("/v1/search/novel", params, headers));
+	return Utils::GetJsonResponse(this->_GetApiClient()->Get("/v1/search/novel", params, headers));
 }
 
 json PixivClient::GetRecommendedNovels(
@@ -833,7 +1035,7 @@ json PixivClient::GetRecommendedNovels(
 	if (include_privacy_policy)
 		params.emplace("include_privacy_policy", "true");
 
-	return Utils::GetJsonResponse(this->_GetApiClient().Get("/v1/novel/recommended", params, headers));
+	return Utils::GetJsonResponse(this->_GetApiClient()->Get("/v1/novel/recommended", params, headers));
 }
 
 json PixivClient::AutoComplete(string keyword, bool MergePlainKeywordResult)
@@ -847,7 +1049,7 @@ json PixivClient::AutoComplete(string keyword, bool MergePlainKeywordResult)
 	if (MergePlainKeywordResult)
 		params.emplace("merge_plain_keyword_results", "true");
 
-	return Utils::GetJsonResponse(this->_GetApiClient().Get("/v2/search/autocomplete", params, headers));
+	return Utils::GetJsonResponse(this->_GetApiClient()->Get("/v2/search/autocomplete", params, headers));
 }
 
 json PixivClient::NextPage(const std::string& NextUrl)
@@ -858,7 +1060,9 @@ json PixivClient::NextPage(const std::string& NextUrl)
 	
 	Utils::UrlComponent component = Utils::UrlComponent::ParseUrl(NextUrl);
 
-	return Utils::GetJsonResponse(this->_GetApiClient().Get(component.GetRelativeRef(), {}, headers));
+	return Utils::GetJsonStreaming(
+		[&](auto handler, auto receiver)
+		{ return this->_GetApiClient()->Get(component.GetRelativeRef(), headers, handler, receiver); });
 }
 
 }
\ No newline at end of file
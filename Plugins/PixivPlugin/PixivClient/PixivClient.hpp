@@ -1,22 +1,23 @@
 #ifndef _PIXIV_CLIENT_HPP_
 #define _PIXIV_CLIENT_HPP_
 
+#include <atomic>
 #include <chrono>
 #include <cstdint>
+#include <exception>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <utility>
 #include <vector>
 
-#include "Models.hpp"
-
-namespace httplib
-{
-
-class Client;
+#include <PluginUtils/AsyncHttp.hpp>
+#include <PluginUtils/DiskCache.hpp>
+#include <PluginUtils/LruCache.hpp>
+#include <PluginUtils/NetworkUtils.hpp>
 
-}
+#include "Models.hpp"
 
 namespace Pixiv
 {
@@ -31,20 +32,47 @@ class PixivClient
 	static constexpr std::string_view download_hosts = "https://i.pximg.net";
 
 	static constexpr auto expire_timeout = std::chrono::seconds(3600) * 0.95;
+	// RefreshToken() renews the token once it is this old, well before requests have to
+	static constexpr auto refresh_ahead = std::chrono::seconds(3600) * 0.75;
+	static constexpr auto min_refresh_backoff = std::chrono::seconds(30);
+	static constexpr auto max_refresh_backoff = std::chrono::minutes(10);
+
+	static constexpr std::size_t ILLUST_CACHE_SIZE = 512;
+	static constexpr auto illust_cache_ttl = std::chrono::minutes(10);
+	static constexpr auto illust_missing_ttl = std::chrono::minutes(5);
 
 protected:
 	const std::string _RefreshToken;
 	const std::string _ProxyHost;
 	const int _ProxyPort;
 
-	std::string _AccessToken;
-	std::chrono::system_clock::time_point _ObtainedTime;
+	struct AccessToken
+	{
+		std::string token;
+		std::chrono::system_clock::time_point ObtainedTime;
+	};
+	// Swapped as a whole, readers never wait for a login in progress unless the token has expired
+	std::atomic<std::shared_ptr<const AccessToken>> _token;
 
-	void _login();
+	std::mutex _LoginMtx;	// Serializes logins
+	std::chrono::steady_clock::time_point _RetryAfter;
+	std::chrono::seconds _backoff{};
+
+	std::shared_ptr<Utils::DiskCache> _ImageCache;
+
+	std::shared_ptr<const AccessToken> _login();
 	std::string _GetToken();
 
 	mutable std::mutex _mtx;
 
+	// Either the illust or the error (404) it failed with
+	struct CachedIllust
+	{
+		std::shared_ptr<const Illust> illust;
+		std::exception_ptr error;
+	};
+	Utils::LruCache<int64_t, CachedIllust> _IllustCache{ILLUST_CACHE_SIZE};
+
 	// void _InitClients()
 	// {
 	// 	if (!this->_ProxyHost.empty() && this->_ProxyPort > 0)
@@ -71,9 +99,10 @@ protected:
 	// 	this->_DownloadCli.set_read_timeout(120); // NOLINT(*-avoid-magic-numbers)
 	// }
 
-	httplib::Client _GetOAuthClient() const;
-	httplib::Client _GetApiClient() const;
-	httplib::Client _GetDownloadClient() const;
+	Utils::HttpPool::Lease _GetOAuthClient() const;
+	Utils::HttpPool::Lease _GetApiClient() const;
+	Utils::HttpPool::Lease _GetDownloadClient() const;
+	std::shared_ptr<Utils::DiskCache> _GetImageCache() const;
 
 public:
 	explicit PixivClient(std::string token, std::string ProxyHost = {}, int ProxyPort = -1) : 
@@ -82,25 +111,23 @@ public:
 	}
 
 	PixivClient(const PixivClient& rhs) :
-	_RefreshToken(rhs._RefreshToken), _ProxyHost(rhs._ProxyHost), _ProxyPort(rhs._ProxyPort)
+	_RefreshToken(rhs._RefreshToken), _ProxyHost(rhs._ProxyHost), _ProxyPort(rhs._ProxyPort), _token(rhs._token.load())
 	{
 		{
 		
 		std::lock_guard<std::mutex> lk(rhs._mtx);
-		this->_AccessToken = rhs._AccessToken;
-		this->_ObtainedTime = rhs._ObtainedTime;
+		this->_ImageCache = rhs._ImageCache;
 	
 		}
 	}
 	
 	PixivClient(PixivClient&& rhs) :
-	_RefreshToken(rhs._RefreshToken), _ProxyHost(rhs._ProxyHost), _ProxyPort(rhs._ProxyPort)
+	_RefreshToken(rhs._RefreshToken), _ProxyHost(rhs._ProxyHost), _ProxyPort(rhs._ProxyPort), _token(rhs._token.exchange(nullptr))
 	{
 		{
 
 		std::lock_guard<std::mutex> lk(rhs._mtx);
-		this->_AccessToken = std::move(rhs._AccessToken);
-		this->_ObtainedTime = std::move(rhs._ObtainedTime);
+		this->_ImageCache = std::move(rhs._ImageCache);
 		
 		}
 	}
@@ -109,9 +136,19 @@ public:
 	PixivClient& operator=(PixivClient&&) = delete;
 	~PixivClient() = default;
 
+	// Renews the access token ahead of its expiry, meant to be called periodically. Failures are logged and
+	// retried with a growing backoff, requests keep using the current token until it expires
+	void RefreshToken();
+
+	// Downloads read through cache when set, image urls never change their content
+	void SetImageCache(std::shared_ptr<Utils::DiskCache> cache);
+
 	// 下载图片
 	std::string DownloadIllust(const std::string& url);
 	void DownloadIllust(const std::string& url, std::function<bool(const char*, size_t)> receiver);
+	// The client must outlive the returned task
+	Utils::Task<std::string> DownloadIllustAsync(std::string url) const;
+	// Downloads concurrently, stops at the first failure and returns the images before it
 	std::vector<std::string> BatchDownloadIllust(const std::vector<std::string>& urls);
 	void BatchDownloadIllust(const std::vector<std::string>& urls, std::function<bool(std::string, size_t)> receiver);
 
@@ -166,6 +203,12 @@ public:
 	// 作品详情
 	json GetIllustDetails(PID_t pid);
 
+	// 作品详情, parsed and cached for all groups. Works that do not exist are cached for a while as well,
+	// the cached NetworkException is rethrown for them
+	std::shared_ptr<const Illust> GetIllust(PID_t pid);
+	// Seeds the cache of GetIllust, e.g. with the illusts of a ranking page
+	void CacheIllust(std::shared_ptr<const Illust> illust, std::chrono::seconds ttl);
+
 	// 作品评论
 	json GetIllustComments(PID_t pid, uint64_t offset = 0, bool IncludeTotalComments = true);
 
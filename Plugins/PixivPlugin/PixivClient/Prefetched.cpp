@@ -0,0 +1,31 @@
+#include "Prefetched.hpp"
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+namespace Pixiv
+{
+
+namespace
+{
+
+std::atomic<std::shared_ptr<const Prefetched>>& Storage()
+{
+	static std::atomic<std::shared_ptr<const Prefetched>> data;
+	return data;
+}
+
+}
+
+std::shared_ptr<const Prefetched> GetPrefetched()
+{
+	return Storage().load();
+}
+
+void SetPrefetched(std::shared_ptr<const Prefetched> data)
+{
+	Storage().store(std::move(data));
+}
+
+}
@@ -0,0 +1,35 @@
+#ifndef _PIXIV_PREFETCHED_HPP_
+#define _PIXIV_PREFETCHED_HPP_
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Models.hpp"
+
+namespace Pixiv
+{
+
+struct TrendingTag
+{
+	std::string name;
+	std::string translate;
+	std::shared_ptr<const Illust> illust;	// Representative work of the tag
+};
+
+// Results of the last PixivPrefetchTrigger run, the commands reading them never call the pixiv api
+struct Prefetched
+{
+	std::vector<std::shared_ptr<const Illust>> ranking;	// Daily ranking, first place first
+	std::vector<TrendingTag> tags;
+	std::chrono::system_clock::time_point time;
+};
+
+// nullptr before the first successful run
+std::shared_ptr<const Prefetched> GetPrefetched();
+void SetPrefetched(std::shared_ptr<const Prefetched> data);
+
+}
+
+#endif
@@ -1,3 +1,5 @@
+#include <atomic>
+#include <filesystem>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -6,6 +8,7 @@
 #include "PixivClient.hpp"
 #include "Singleton.hpp"
 #include <Core/Utils/Logger.hpp>
+#include <PluginUtils/DiskCache.hpp>
 
 namespace Pixiv
 {
@@ -26,4 +29,57 @@ std::shared_ptr<PixivClient> GetClient(std::string token, std::string ProxyHost,
 	return client;
 }
 
+std::shared_ptr<PixivClient> GetClient(const Utils::BotConfig& config)
+{
+	static const Utils::ConfigKey PIXIV_KEY("/pixiv");
+	static const Utils::ConfigKey PROXY_KEY("/pixiv/proxy");
+	static const Utils::ConfigKey TOKEN_KEY("/pixiv/token");
+	static const Utils::ConfigKey HOST_KEY("/pixiv/proxy/host");
+	static const Utils::ConfigKey PORT_KEY("/pixiv/proxy/port");
+	static const Utils::ConfigKey DEFAULT_PROXY_KEY("/proxy");
+	static const Utils::ConfigKey DEFAULT_HOST_KEY("/proxy/host");
+	static const Utils::ConfigKey DEFAULT_PORT_KEY("/proxy/port");
+	static const Utils::ConfigKey MEDIA_KEY("/path/MediaFiles");
+
+	static std::mutex mtx;
+	static std::atomic<bool> dirty = true;
+	static const Utils::BotConfig* source = nullptr;
+	static std::shared_ptr<PixivClient> client;
+	static Utils::BotConfig::Subscription PixivSubscription;
+	static Utils::BotConfig::Subscription ProxySubscription;
+	static Utils::BotConfig::Subscription MediaSubscription;
+	static std::shared_ptr<Utils::DiskCache> ImageCache;
+
+	std::lock_guard<std::mutex> lk(mtx);
+	if (source != &config)
+	{
+		source = &config;
+		dirty = true;
+		PixivSubscription = config.Subscribe(PIXIV_KEY, [] { dirty = true; });
+		ProxySubscription = config.Subscribe(DEFAULT_PROXY_KEY, [] { dirty = true; });
+		MediaSubscription = config.Subscribe(MEDIA_KEY, [] { dirty = true; });
+	}
+	if (client && !dirty) return client;
+
+	dirty = false;
+	// The token, the proxy and the media path all from the same snapshot
+	const auto view = config.View();
+	if (view.IsNull(PROXY_KEY))
+		client = GetClient(view.Get(TOKEN_KEY, ""));
+	else
+		client = GetClient(
+			view.Get(TOKEN_KEY, ""), 
+			view.Get(HOST_KEY, view.Get(DEFAULT_HOST_KEY, "")), 
+			view.Get(PORT_KEY, view.Get(DEFAULT_PORT_KEY, -1))
+		);
+
+	// The index is rebuilt from the directory, only do that when the path changes
+	const std::filesystem::path MediaDir = view.Get(MEDIA_KEY, "MediaFiles");
+	const std::filesystem::path CacheDir = MediaDir / "cache/pixiv";
+	if (!ImageCache || ImageCache->directory() != CacheDir)
+		ImageCache = std::make_shared<Utils::DiskCache>(CacheDir);
+	client->SetImageCache(ImageCache);
+	return client;
+}
+
 }
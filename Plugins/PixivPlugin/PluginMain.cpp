@@ -1,5 +1,10 @@
+#include <PluginUtils/HttpCache.hpp>
+#include <PluginUtils/RateGovernor.hpp>
 #include <PluginUtils/TypeList.hpp>
 #include <GroupCommand/PixivCommand.hpp>
+#include <PixivClient/Cursor.hpp>
+#include <Trigger/PixivPrefetchTrigger.hpp>
+#include <Trigger/PixivTokenTrigger.hpp>
 
 #include <vips/vips8>
 
@@ -7,17 +12,27 @@
 #include <Core/Interface/PluginEntry.hpp>
 
 using GroupCommandList = Utils::TypeList< GroupCommand::PixivCommand >;
-using TriggerList = Utils::TypeList<>;
+using TriggerList = Utils::TypeList< Trigger::PixivTokenTrigger, Trigger::PixivPrefetchTrigger >;
 
 extern "C"
 {
 
-	void InitPlugin() 
+	void InitPlugin(const Utils::BotConfig& config) 
 	{
 		VIPS_INIT("");		// NOLINT(*-vararg)
 
 		constexpr size_t MAX_MEM = 1024 * 1024 * 10;
 		vips_cache_set_max_mem(MAX_MEM);
+
+		// NOLINTBEGIN(*-avoid-magic-numbers)
+		Utils::RateGovernor::GetInstance().SetLimits("https://app-api.pixiv.net",
+		                                             {.RequestsPerSecond = 2, .burst = 5, .MaxConcurrent = 4});
+		Utils::RateGovernor::GetInstance().SetLimits("https://oauth.secure.pixiv.net",
+		                                             {.RequestsPerSecond = 0.2, .burst = 2, .MaxConcurrent = 1});
+		Utils::RateGovernor::GetInstance().SetLimits("https://i.pximg.net", {.MaxConcurrent = 16});
+		// NOLINTEND(*-avoid-magic-numbers)
+
+		Utils::HttpCache::GetInstance().WatchConfig(config);
 	}
 
 
@@ -102,5 +117,8 @@ extern "C"
 	}
 
 
-	void ClosePlugin() {}
+	void ClosePlugin()
+	{
+		Pixiv::IllustCursor::JoinRetired();
+	}
 }
\ No newline at end of file
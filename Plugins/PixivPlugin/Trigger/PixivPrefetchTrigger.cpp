@@ -0,0 +1,135 @@
+#include "PixivPrefetchTrigger.hpp"
+
+#include <chrono>
+#include <ctime>
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <PixivClient/Models.hpp>
+#include <PixivClient/PixivClient.hpp>
+#include <PixivClient/Prefetched.hpp>
+#include <PixivClient/Singleton.hpp>
+#include <PluginUtils/Common.hpp>
+#include <nlohmann/json.hpp>
+
+#include <Core/Utils/Common.hpp>
+#include <Core/Utils/Logger.hpp>
+
+namespace Trigger
+{
+
+namespace
+{
+
+// One ranking page, every work on it gets its first page downloaded
+constexpr size_t RANKING_SIZE = 30;
+constexpr time_t INTERVAL = 3600;
+// Until well after the next run, so a failed run does not leave the commands without images
+constexpr auto CACHE_TTL = std::chrono::seconds(INTERVAL * 3);
+
+std::vector<std::shared_ptr<const Pixiv::Illust>> FetchRanking(Pixiv::PixivClient& pclient)
+{
+	auto msg = pclient.GetIllustRanking(Pixiv::RankingMode::DAY);
+	std::vector<std::shared_ptr<const Pixiv::Illust>> ranking;
+	for (const auto& item : msg.at("illusts"))
+	{
+		if (ranking.size() >= RANKING_SIZE) break;
+		auto illust = std::make_shared<const Pixiv::Illust>(item.get<Pixiv::Illust>());
+		pclient.CacheIllust(illust, CACHE_TTL);
+		ranking.push_back(std::move(illust));
+	}
+	return ranking;
+}
+
+std::vector<Pixiv::TrendingTag> FetchTags(Pixiv::PixivClient& pclient)
+{
+	auto msg = pclient.GetTrendingTagsIllust();
+	std::vector<Pixiv::TrendingTag> tags;
+	for (const auto& item : msg.at("trend_tags"))
+	{
+		Pixiv::TrendingTag tag;
+		tag.name = Utils::GetValue(item, "tag", "");
+		tag.translate = Utils::GetValue(item, "translated_name", "");
+		if (Utils::HasValue(item, "illust"))
+		{
+			tag.illust = std::make_shared<const Pixiv::Illust>(item.at("illust").get<Pixiv::Illust>());
+			pclient.CacheIllust(tag.illust, CACHE_TTL);
+		}
+		tags.push_back(std::move(tag));
+	}
+	return tags;
+}
+
+} // namespace
+
+void PixivPrefetchTrigger::Action(Bot::GroupList& /*groups*/, Bot::Client& /*client*/, Utils::BotConfig& config)
+{
+	static const Utils::ConfigKey TOKEN_KEY("/pixiv/token");
+	if (config.Get(TOKEN_KEY, "").empty()) return;
+
+	auto pclient = Pixiv::GetClient(config);
+	auto old = Pixiv::GetPrefetched();
+	auto data = std::make_shared<Pixiv::Prefetched>();
+	data->time = std::chrono::system_clock::now();
+
+	// Either part is kept from the last run if it fails, or left empty if there is none.
+	// The commands check each part on their own
+	bool fetched = false;
+	try
+	{
+		data->ranking = FetchRanking(*pclient);
+		fetched = true;
+	}
+	catch (const std::exception& e)
+	{
+		LOG_WARN(Utils::GetLogger(), "Failed to fetch pixiv ranking <PixivPrefetch>: " + std::string(e.what()));
+		if (old) data->ranking = old->ranking;
+	}
+	try
+	{
+		data->tags = FetchTags(*pclient);
+		fetched = true;
+	}
+	catch (const std::exception& e)
+	{
+		LOG_WARN(Utils::GetLogger(), "Failed to fetch pixiv trending tags <PixivPrefetch>: " + std::string(e.what()));
+		if (old) data->tags = old->tags;
+	}
+	if (!fetched) return;
+
+	// Images first, the commands should not find a ranking whose images are not there yet.
+	// Downloads go through the image cache of the client, works already in it cost nothing
+	size_t failed = 0;
+	for (const auto& illust : data->ranking)
+	{
+		auto urls = illust->GetImageUrls();
+		if (urls.empty()) continue;
+		try
+		{
+			pclient->DownloadIllust(urls.front());
+		}
+		catch (const std::exception& e)
+		{
+			LOG_WARN(Utils::GetLogger(), "Failed to prefetch " + urls.front() + " <PixivPrefetch>: " + e.what());
+			failed++;
+		}
+	}
+
+	LOG_INFO(Utils::GetLogger(), "Prefetched " + std::to_string(data->ranking.size()) + " ranked works ("
+	                                 + std::to_string(failed) + " failed) and " + std::to_string(data->tags.size())
+	                                 + " tags <PixivPrefetch>");
+	Pixiv::SetPrefetched(std::move(data));
+}
+
+time_t PixivPrefetchTrigger::GetNext()
+{
+	// Shortly after startup, then hourly. The daily ranking changes once a day but the trending tags do not
+	constexpr time_t STARTUP_DELAY = 60;
+	const time_t next = std::time(nullptr) + (this->_started ? INTERVAL : STARTUP_DELAY);
+	this->_started = true;
+	return next;
+}
+
+} // namespace Trigger
@@ -0,0 +1,29 @@
+#ifndef _PIXIV_PREFETCH_TRIGGER_HPP_
+#define _PIXIV_PREFETCH_TRIGGER_HPP_
+
+#include <string_view>
+
+#include <Core/Interface/ITrigger.hpp>
+
+namespace Trigger
+{
+
+// Fetches the daily ranking and the trending tags for #pixiv rank and #pixiv tag, and warms the illust and
+// image caches of the client with them. Global, so it is not listed in #trig
+class PixivPrefetchTrigger : public ITrigger
+{
+protected:
+	bool _started = false;
+
+public:
+	void Action(Bot::GroupList& groups, Bot::Client& client, Utils::BotConfig& config) override;
+	time_t GetNext() override;
+	bool isDefaultOn() const override { return false; }
+	bool isGlobal() const override { return true; }
+
+	static constexpr std::string_view _NAME_ = "PixivPrefetch";
+};
+
+} // namespace Trigger
+
+#endif
@@ -0,0 +1,38 @@
+#include "PixivTokenTrigger.hpp"
+
+#include <ctime>
+#include <exception>
+#include <string>
+
+#include <PixivClient/PixivClient.hpp>
+#include <PixivClient/Singleton.hpp>
+
+#include <Core/Utils/Common.hpp>
+#include <Core/Utils/Logger.hpp>
+
+namespace Trigger
+{
+
+void PixivTokenTrigger::Action(Bot::GroupList& /*groups*/, Bot::Client& /*client*/, Utils::BotConfig& config)
+{
+	static const Utils::ConfigKey TOKEN_KEY("/pixiv/token");
+	if (config.Get(TOKEN_KEY, "").empty()) return;
+
+	try
+	{
+		Pixiv::GetClient(config)->RefreshToken();
+	}
+	catch (const std::exception& e)
+	{
+		LOG_WARN(Utils::GetLogger(), "Failed to refresh pixiv token <PixivToken>: " + std::string(e.what()));
+	}
+}
+
+time_t PixivTokenTrigger::GetNext()
+{
+	// The token is renewed a quarter of its lifetime ahead, checking once a minute is plenty
+	constexpr time_t INTERVAL = 60;
+	return std::time(nullptr) + INTERVAL;
+}
+
+} // namespace Trigger
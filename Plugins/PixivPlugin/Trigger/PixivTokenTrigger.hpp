@@ -0,0 +1,26 @@
+#ifndef _PIXIV_TOKEN_TRIGGER_HPP_
+#define _PIXIV_TOKEN_TRIGGER_HPP_
+
+#include <string_view>
+
+#include <Core/Interface/ITrigger.hpp>
+
+namespace Trigger
+{
+
+// Keeps the pixiv access token fresh so requests never wait for a login.
+// Global, so it is not listed in #trig
+class PixivTokenTrigger : public ITrigger
+{
+public:
+	void Action(Bot::GroupList& groups, Bot::Client& client, Utils::BotConfig& config) override;
+	time_t GetNext() override;
+	bool isDefaultOn() const override { return false; }
+	bool isGlobal() const override { return true; }
+
+	static constexpr std::string_view _NAME_ = "PixivToken";
+};
+
+} // namespace Trigger
+
+#endif
@@ -1,47 +1,193 @@
 #ifndef _PIXIV_FUNCTIONS_IMAGE_UTILS_HPP_
 #define _PIXIV_FUNCTIONS_IMAGE_UTILS_HPP_
 
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <filesystem>
 #include <functional>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <system_error>
+#include <utility>
 #include <string>
+#include <thread>
 #include <vips/vips8>
 
 namespace Pixiv::ImageUtils
 {
 
-inline auto CensorImage(const std::string& image, double sigma, size_t& len, const std::string& cover = {})
+constexpr size_t THUMBNAIL_SIZE = 960;
+
+// Cover put on censored images. It is decoded once and kept in memory along with the sizes it was scaled to,
+// widths are rounded down to buckets so only a handful of variants exist for thumbnails up to THUMBNAIL_SIZE
+class CoverImage
 {
-	using namespace vips;
-	VImage in = VImage::new_from_buffer(image.data(), image.size(), nullptr);
-	in = in.gaussblur(sigma);
-	if (!cover.empty())
+protected:
+	static constexpr int BUCKET = 32;
+	static constexpr double TOP_RATIO = 0.7;
+
+	const vips::VImage _image;
+	std::mutex _mtx;
+	std::map<int, vips::VImage> _variants;	// Keyed by width
+
+public:
+	explicit CoverImage(const std::filesystem::path& path) :
+	_image(vips::VImage::new_from_file(path.c_str()).copy_memory())
 	{
-		VImage top = VImage::new_from_buffer(cover.data(), cover.size(), nullptr);
-		constexpr double TOP_RATIO = 0.7;
-		double scale = TOP_RATIO * std::min(in.width() / (double)top.width(), in.height() / (double)top.height());
-		top = top.resize(scale);
-		in = in.cast(top.format());
-		in = in.composite2(
-			top, VIPS_BLEND_MODE_OVER,
-			VImage::option()->set("x", (in.width() - top.width()) / 2)->set("y", (in.height() - top.height()) / 2));
 	}
 
-	char* buffer = nullptr;
-	// NOLINTNEXTLINE(*-reinterpret-cast)
-	in.write_to_buffer(".jpg", reinterpret_cast<void**>(&buffer), &len);
-	return std::unique_ptr<char, std::function<void(char*)>>(buffer, [](auto* p) { VIPS_FREE(p); });
-}
+	// Shared by every caller until the file changes, nullptr if it does not exist
+	static std::shared_ptr<CoverImage> Get(const std::filesystem::path& path)
+	{
+		static std::mutex mtx;
+		static std::map<std::filesystem::path, std::pair<std::filesystem::file_time_type, std::shared_ptr<CoverImage>>> covers;
 
-constexpr size_t THUMBNAIL_SIZE = 960;
+		std::error_code ec;
+		auto time = std::filesystem::last_write_time(path, ec);
+		if (ec) return nullptr;
 
-std::string CropAndConvert(const std::string& image)
+		std::lock_guard<std::mutex> lk(mtx);
+		auto& [loaded, cover] = covers[path];
+		if (!cover || loaded != time)
+		{
+			cover = std::make_shared<CoverImage>(path);
+			loaded = time;
+		}
+		return cover;
+	}
+
+	// Cover scaled to TOP_RATIO of a width x height image
+	vips::VImage fit(int width, int height)
+	{
+		const double scale = TOP_RATIO * std::min(width / (double)this->_image.width(), height / (double)this->_image.height());
+		const int target = static_cast<int>(scale * this->_image.width()) / BUCKET * BUCKET;
+		if (target == 0) return this->_image.resize(scale);
+
+		std::lock_guard<std::mutex> lk(this->_mtx);
+		auto it = this->_variants.find(target);
+		if (it == this->_variants.end())
+			it = this->_variants.emplace(target, this->_image.resize(target / (double)this->_image.width()).copy_memory()).first;
+		return it->second;
+	}
+};
+
+// Chunks handed from a download to libvips, which pulls them through a custom source on another thread.
+// push blocks while too much is buffered
+class ChunkSource
+{
+protected:
+	static constexpr size_t MAX_CHUNKS = 64;
+
+	std::mutex _mtx;
+	std::condition_variable _cv;
+	std::deque<std::string> _chunks;
+	std::string _current;
+	size_t _offset = 0;
+	bool _closed = false;
+	bool _aborted = false;
+	bool _discard = false;
+
+	static gint64 _read(VipsSourceCustom* /*unused*/, void* buffer, gint64 length, void* user)
+	{
+		auto* self = static_cast<std::shared_ptr<ChunkSource>*>(user)->get();
+		if (self->_offset == self->_current.size())
+		{
+			std::unique_lock<std::mutex> lk(self->_mtx);
+			self->_cv.wait(lk, [self] { return !self->_chunks.empty() || self->_closed || self->_aborted; });
+			if (self->_chunks.empty()) return 0;
+
+			self->_current = std::move(self->_chunks.front());
+			self->_chunks.pop_front();
+			self->_offset = 0;
+			lk.unlock();
+			self->_cv.notify_all();
+		}
+
+		size_t len = std::min(static_cast<size_t>(length), self->_current.size() - self->_offset);
+		std::memcpy(buffer, self->_current.data() + self->_offset, len);
+		self->_offset += len;
+		return static_cast<gint64>(len);
+	}
+
+public:
+	// Returns false once the reader has failed
+	bool push(const char* data, size_t len)
+	{
+		if (len == 0) return true;
+		std::unique_lock<std::mutex> lk(this->_mtx);
+		this->_cv.wait(lk, [this] { return this->_chunks.size() < MAX_CHUNKS || this->_aborted || this->_discard; });
+		if (this->_aborted) return false;
+		if (!this->_discard) this->_chunks.emplace_back(data, len);
+		lk.unlock();
+		this->_cv.notify_all();
+		return true;
+	}
+
+	// No more data, the reader sees eof
+	void close()
+	{
+		{
+			std::lock_guard<std::mutex> lk(this->_mtx);
+			this->_closed = true;
+		}
+		this->_cv.notify_all();
+	}
+
+	// The reader failed, further pushes fail
+	void abort()
+	{
+		{
+			std::lock_guard<std::mutex> lk(this->_mtx);
+			this->_aborted = true;
+			this->_chunks.clear();
+		}
+		this->_cv.notify_all();
+	}
+
+	// The reader is done, the rest of the data is accepted and dropped
+	void discard()
+	{
+		{
+			std::lock_guard<std::mutex> lk(this->_mtx);
+			this->_discard = true;
+			this->_chunks.clear();
+		}
+		this->_cv.notify_all();
+	}
+
+	// The source keeps self alive, vips may hold on to it in its operation cache
+	static vips::VSource NewSource(std::shared_ptr<ChunkSource> self)
+	{
+		VipsSourceCustom* source = vips_source_custom_new();
+		g_signal_connect_data(
+			source, "read", G_CALLBACK(&ChunkSource::_read), new std::shared_ptr<ChunkSource>(std::move(self)),
+			[](gpointer data, GClosure* /*unused*/) { delete static_cast<std::shared_ptr<ChunkSource>*>(data); },
+			static_cast<GConnectFlags>(0));
+		return vips::VSource(VIPS_SOURCE(source));
+	}
+};
+
+// Shrinks image to a thumbnail on load, blurs it and puts cover in the middle, encoded once as jpeg
+inline std::string CensorThumbnail(vips::VSource source, double sigma, const std::shared_ptr<CoverImage>& cover = nullptr)
 {
 	using namespace vips;
-	VImage in = VImage::thumbnail_buffer(vips_blob_new(nullptr, image.data(), image.size()), THUMBNAIL_SIZE, 
+	VImage in = VImage::thumbnail_source(source, THUMBNAIL_SIZE,
 		VImage::option()
 		->set("size", VipsSize::VIPS_SIZE_DOWN)
 		->set("no_rotate", true)
 	);
+	in = in.gaussblur(sigma);
+	if (cover)
+	{
+		VImage top = cover->fit(in.width(), in.height());
+		in = in.cast(top.format());
+		in = in.composite2(
+			top, VIPS_BLEND_MODE_OVER,
+			VImage::option()->set("x", (in.width() - top.width()) / 2)->set("y", (in.height() - top.height()) / 2));
+	}
 
 	char* buffer = nullptr;
 	size_t len{};
@@ -52,6 +198,50 @@ std::string CropAndConvert(const std::string& image)
 	return {p.get(), len};
 }
 
+// Runs CensorThumbnail while the image is still downloading, download must pass the data to the receiver
+// and stop when it returns false. If vips fails first its error is thrown instead of the one from download
+inline std::string CensorStream(const std::function<void(std::function<bool(const char*, size_t)>)>& download,
+                                double sigma, const std::shared_ptr<CoverImage>& cover = nullptr)
+{
+	auto chunks = std::make_shared<ChunkSource>();
+	std::string result;
+	std::exception_ptr error;
+	std::thread decoder([&]{
+		try
+		{
+			result = CensorThumbnail(ChunkSource::NewSource(chunks), sigma, cover);
+			chunks->discard();
+		}
+		catch (...)
+		{
+			error = std::current_exception();
+			chunks->abort();
+		}
+	});
+
+	bool cancelled = false;
+	try
+	{
+		download([&chunks, &cancelled](const char* data, size_t len)
+		{
+			cancelled = !chunks->push(data, len);
+			return !cancelled;
+		});
+	}
+	catch (...)
+	{
+		chunks->close();
+		decoder.join();
+		if (cancelled && error) std::rethrow_exception(error);
+		throw;
+	}
+	chunks->close();
+	decoder.join();
+
+	if (error) std::rethrow_exception(error);
+	return result;
+}
+
 } // namespace Pixiv::ImageUtils
 
 #endif
\ No newline at end of file
@@ -0,0 +1,163 @@
+#ifndef _PIXIV_FUNCTIONS_UGOIRA_HPP_
+#define _PIXIV_FUNCTIONS_UGOIRA_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <vips/vips8>
+
+namespace Pixiv::Ugoira
+{
+
+// Decodes frames on a few threads while the rest of the archive is downloading.
+// Frames are kept decoded in memory, the encoder needs all of them at once anyway
+class FrameDecoder
+{
+protected:
+	std::mutex _mtx;
+	std::condition_variable _cv;
+	std::deque<std::pair<size_t, std::string>> _queue;
+	std::vector<vips::VImage> _frames;
+	std::vector<bool> _decoded;
+	bool _closed = false;
+	std::exception_ptr _error;
+	std::vector<std::thread> _workers;
+
+	void _work()
+	{
+		while (true)
+		{
+			std::pair<size_t, std::string> item;
+			{
+				std::unique_lock<std::mutex> lk(this->_mtx);
+				this->_cv.wait(lk, [this] { return !this->_queue.empty() || this->_closed; });
+				if (this->_queue.empty() || this->_error) return;
+				item = std::move(this->_queue.front());
+				this->_queue.pop_front();
+			}
+
+			try
+			{
+				auto frame = vips::VImage::new_from_buffer(item.second.data(), item.second.size(), "").copy_memory();
+				std::lock_guard<std::mutex> lk(this->_mtx);
+				this->_frames[item.first] = std::move(frame);
+				this->_decoded[item.first] = true;
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lk(this->_mtx);
+				if (!this->_error) this->_error = std::current_exception();
+				this->_queue.clear();
+				return;
+			}
+		}
+	}
+
+	void _join()
+	{
+		{
+			std::lock_guard<std::mutex> lk(this->_mtx);
+			this->_closed = true;
+		}
+		this->_cv.notify_all();
+		for (auto& worker : this->_workers)
+			worker.join();
+		this->_workers.clear();
+	}
+
+public:
+	explicit FrameDecoder(size_t frames, size_t threads = std::clamp<size_t>(std::thread::hardware_concurrency(), 1, 4)) :
+	_frames(frames), _decoded(frames)
+	{
+		for (size_t i = 0; i < threads; i++)
+			this->_workers.emplace_back(&FrameDecoder::_work, this);
+	}
+	FrameDecoder(const FrameDecoder&) = delete;
+	FrameDecoder& operator=(const FrameDecoder&) = delete;
+	FrameDecoder(FrameDecoder&&) = delete;
+	FrameDecoder& operator=(FrameDecoder&&) = delete;
+	~FrameDecoder() { this->_join(); }
+
+	// Rethrows the first decoding error
+	void push(size_t index, std::string data)
+	{
+		{
+			std::lock_guard<std::mutex> lk(this->_mtx);
+			if (this->_error) std::rethrow_exception(this->_error);
+			if (index >= this->_frames.size())
+				throw std::out_of_range("Frame " + std::to_string(index) + " out of range");
+			this->_queue.emplace_back(index, std::move(data));
+		}
+		this->_cv.notify_one();
+	}
+
+	// Waits for the frames pushed so far, throws if any of them failed or is missing
+	std::vector<vips::VImage> finish()
+	{
+		this->_join();
+		if (this->_error) std::rethrow_exception(this->_error);
+		if (std::find(this->_decoded.begin(), this->_decoded.end(), false) != this->_decoded.end())
+			throw std::runtime_error("Ugoira archive is missing frames");
+		return std::move(this->_frames);
+	}
+};
+
+enum class Format
+{
+	GIF,
+	WEBP
+};
+
+// Animated image of frames with delays in milliseconds. Frames are scaled down until the result fits in budget,
+// throws if it still does not after a few attempts
+inline std::string Encode(const std::vector<vips::VImage>& frames, std::vector<int> delays, Format format, size_t budget)
+{
+	using namespace vips;
+	constexpr int MAX_ATTEMPTS = 4;
+	constexpr double SHRINK_MARGIN = 0.9;
+
+	if (frames.empty() || frames.size() != delays.size())
+		throw std::invalid_argument("Frames and delays do not match");
+
+	double scale = 1;
+	for (int attempt = 1;; attempt++)
+	{
+		std::vector<VImage> scaled;
+		scaled.reserve(frames.size());
+		for (const auto& frame : frames)
+			scaled.push_back(scale < 1 ? frame.resize(scale) : frame);
+
+		// Animations are a vertical strip of frames, tagged with the height of one
+		VImage strip = VImage::arrayjoin(scaled, VImage::option()->set("across", 1)).copy();
+		strip.set("page-height", scaled.front().height());
+		strip.set("delay", delays.data(), static_cast<int>(delays.size()));
+		strip.set("loop", 0);
+
+		char* buffer = nullptr;
+		size_t len{};
+		// NOLINTNEXTLINE(*-reinterpret-cast)
+		strip.write_to_buffer(format == Format::GIF ? ".gif" : ".webp", reinterpret_cast<void**>(&buffer), &len);
+		auto p = std::unique_ptr<char, std::function<void(char*)>>
+			(buffer, [](auto* p) { VIPS_FREE(p); });
+		if (len <= budget) return {p.get(), len};
+
+		if (attempt >= MAX_ATTEMPTS)
+			throw std::runtime_error("Ugoira does not fit in " + std::to_string(budget) + " bytes");
+		// Size goes roughly with the area
+		scale *= std::sqrt(budget / static_cast<double>(len)) * SHRINK_MARGIN;
+	}
+}
+
+} // namespace Pixiv::Ugoira
+
+#endif
@@ -13,7 +13,7 @@ using TriggerList = Utils::TypeList< Trigger::SekaiUpdateTrigger >;
 extern "C"
 {
 
-	void InitPlugin() 
+	void InitPlugin(const Utils::BotConfig& /*config*/) 
 	{
 		VIPS_INIT("");		// NOLINT(*-vararg)
 
@@ -3,6 +3,7 @@
 #include <SekaiNetworkClient/SekaiNetworkClient.hpp>
 
 #include <PluginUtils/Common.hpp>
+#include <PluginUtils/JsonStream.hpp>
 
 #include <models/BasicTypes.hpp>
 #include <models/Exceptions.hpp>
@@ -51,7 +52,8 @@ SekaiClient::SekaiClient(
   _ApiUrl(std::move(ApiUrl)),
   /*_HCAKey(HCAKey),*/ _PoolSize(PoolSize), 
   _PyModule(std::move(PythonModule)),
-  _AssetFilter(std::move(filter))
+  _AssetFilter(std::move(filter)),
+  _AssetPatterns(this->_AssetFilter.begin(), this->_AssetFilter.end())
 {
 	// Create directories
 	filesystem::create_directories(this->_AssetFolder / "database");
@@ -391,15 +393,16 @@ std::vector<string> SekaiClient::UpdateContents() const
 					return {};
 				}
 
-				AssetBundles = json::parse(ifile).at("bundles");
+				// Only the bundle list is needed from the (large) asset list
+				AssetBundles = std::move(Utils::ParseJsonSelected(ifile, {"/bundles"}).at("bundles"));
 			}
 			for (const auto& item : AssetBundles.items())
 			{
 				string key = item.key();
 				bool skip = false;
-				for (const auto& reg : this->_AssetFilter)
+				for (const auto& pattern : this->_AssetPatterns)
 				{
-					if (std::regex_match(key, std::regex(reg, std::regex::ECMAScript)))
+					if (pattern.match(key))
 					{
 						skip = true;
 						break;
@@ -10,6 +10,8 @@
 
 #include <nlohmann/json_fwd.hpp>
 
+#include <PluginUtils/SimplePattern.hpp>
+
 namespace Sekai
 {
 
@@ -29,6 +31,7 @@ protected:
 	const std::string _PyModule;
 	const std::string _ApiUrl;
 	const std::vector<std::string> _AssetFilter;
+	const std::vector<Utils::SimplePattern> _AssetPatterns;
 
 	mutable std::shared_mutex _mtx;
 
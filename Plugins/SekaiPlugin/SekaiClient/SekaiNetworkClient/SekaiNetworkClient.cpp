@@ -163,19 +163,15 @@ SekaiNetworkClient::SekaiNetworkClient(
 {
 }
 
-httplib::Client SekaiNetworkClient::_GetClient() const
+Utils::HttpPool::Lease SekaiNetworkClient::_GetClient() const
 {
-	httplib::Client cli(this->_ApiUrl);
-	if (!this->_ProxyHost.empty() && this->_ProxyPort > 0)
-	{
-		cli.set_proxy(this->_ProxyHost, this->_ProxyPort);
-	}
+	auto cli = Utils::GetHttpClient(this->_ApiUrl, this->_ProxyHost, this->_ProxyPort);
 
-	cli.set_connection_timeout(10); // NOLINT(*-avoid-magic-numbers)
-	cli.set_write_timeout(10); // NOLINT(*-avoid-magic-numbers)
-	cli.set_read_timeout(120); // NOLINT(*-avoid-magic-numbers)
+	cli->set_connection_timeout(10); // NOLINT(*-avoid-magic-numbers)
+	cli->set_write_timeout(10); // NOLINT(*-avoid-magic-numbers)
+	cli->set_read_timeout(120); // NOLINT(*-avoid-magic-numbers)
 
-	cli.set_default_headers({
+	cli->set_default_headers({
 		{"Accept-Encoding", "deflate, gzip"},
 		{"Accept-Language", "en-US,en;q=0.9"},
 		{"User-Agent", "ProductName/94 CFNetwork/1335.0.3 Darwin/21.6.0"},
@@ -418,7 +414,7 @@ string SekaiNetworkClient::_GetCookie()
 
 	LOG_DEBUG(Utils::GetLogger(), "Cookie expired, applying for a new one");
 
-	auto result = this->_GetClient().Post(
+	auto result = this->_GetClient()->Post(
 		"/issue/api/signature", 
 		httplib::Headers{{"Accept", "*/*"}}, 
 		httplib::Params{}
@@ -448,7 +444,7 @@ string SekaiNetworkClient::_GetCookie()
 
 json SekaiNetworkClient::GetVersionInfo()
 {
-	auto result = this->_GetClient().Get("/production-game-api/api/system", this->_GetHeader());
+	auto result = this->_GetClient()->Get("/production-game-api/api/system", this->_GetHeader());
 	this->_VerifyAndThrow(result);
 	json versions = json::from_msgpack(DecodeAES(result->body, this->_AESKey, this->_AESIV));
 
@@ -483,7 +479,7 @@ json SekaiNetworkClient::GetGameVersionInfo()
 		DataVersion = this->_DataVersion;
 	}
 
-	auto result = this->_GetClient().Get("/game-version/" + AppVersion + "/" + AppHash, {
+	auto result = this->_GetClient()->Get("/game-version/" + AppVersion + "/" + AppHash, {
 		{"X-App-Version", AppVersion},
 		{"X-Asset-Version", AssetVersion},
 		{"X-Data-Version", DataVersion},
@@ -507,7 +503,7 @@ json SekaiNetworkClient::Login(const Account& user)
 	auto data = json::to_msgpack({
 		{"credential", user.credential}
 	});
-	auto result = this->_GetClient().Put(
+	auto result = this->_GetClient()->Put(
 		"/production-game-api/api/user/" 
 		+ user.id.to_string() 
 		+ "/auth?refreshUpdatedResources=False", 
@@ -527,7 +523,7 @@ json SekaiNetworkClient::Register()
 		{"deviceModel", X_DEVICE_MODEL},
 		{"operatingSystem", X_OPERATING_SYSTEM}
 	});
-	auto result = this->_GetClient().Post(
+	auto result = this->_GetClient()->Post(
 		"/production-game-api/api/user", 
 		this->_GetHeader(),
 		EncodeAES({data.begin(), data.end()}, this->_AESKey, this->_AESIV), 
@@ -545,7 +541,7 @@ json SekaiNetworkClient::GetUserProfile(UID_t UserId)
 	auto header = this->_GetHeader();
 	header.emplace("X-Session-Token", std::move(token));
 
-	auto result = this->_GetClient().Get("/production-game-api/api/user/" + UserId.to_string() + "/profile", std::move(header));
+	auto result = this->_GetClient()->Get("/production-game-api/api/user/" + UserId.to_string() + "/profile", std::move(header));
 
 	if (result && result->has_header("X-Session-Token"))
 		this->_RefreshToken(id, result->get_header_value("X-Session-Token"));
@@ -562,7 +558,7 @@ json SekaiNetworkClient::GetUserEventRanking(UID_t UserId, uint64_t EventId)
 	auto header = this->_GetHeader();
 	header.emplace("X-Session-Token", std::move(token));
 
-	auto result = this->_GetClient().Get(
+	auto result = this->_GetClient()->Get(
 		"/production-game-api/api/user/" + id.to_string() + 
 		"/event/" + std::to_string(EventId) + 
 		"/ranking?targetUserId=" + UserId.to_string(), 
@@ -590,7 +586,7 @@ json SekaiNetworkClient::GetEventRankingUser(uint64_t TargetRank, uint64_t Event
 	if (LowerLimit > 1)
 		url += "&lowerLimit=" + std::to_string(LowerLimit);
 
-	auto result = this->_GetClient().Get(url, std::move(header));
+	auto result = this->_GetClient()->Get(url, std::move(header));
 	
 	if (result && result->has_header("X-Session-Token"))
 		this->_RefreshToken(id, result->get_header_value("X-Session-Token"));
@@ -716,7 +712,7 @@ json SekaiNetworkClient::GetAssetList()
 
 	AESContentReceiver receiver(this->_AESKey, this->_AESIV);
 	
-	auto result = this->_GetClient().Get(
+	auto result = this->_GetClient()->Get(
 		"/assetbundle-info/" + AssetBundleHostHash + "/api/version/" + AssetVersion + "/os/ios?t=" + string(timestamp),
 		{
 			{"Accept", "*/*"},
@@ -739,7 +735,7 @@ string SekaiNetworkClient::GetMasterSuiteInfo()
 
 	AESContentReceiver receiver(this->_AESKey, this->_AESIV);
 
-	auto result = this->_GetClient().Get(
+	auto result = this->_GetClient()->Get(
 		"/production-game-api/api/suite/master", std::move(header),
 		[&receiver](auto* data, auto n) { return receiver.Receiver(data, n); }
 	);
@@ -10,6 +10,7 @@
 #include <utility>
 #include <vector>
 
+#include <PluginUtils/NetworkUtils.hpp>
 #include <httplib.h>
 #include <nlohmann/json_fwd.hpp>
 
@@ -39,7 +40,7 @@ protected:
 
 	mutable std::mutex _mtx;
 
-	httplib::Client _GetClient() const;
+	Utils::HttpPool::Lease _GetClient() const;
 
 	/* Utilities */
 
@@ -1,3 +1,4 @@
+#include <atomic>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -72,4 +73,72 @@ std::shared_ptr<SekaiClient> GetClient(
 	return client;
 }
 
+std::shared_ptr<SekaiClient> GetClient(const Utils::BotConfig& config)
+{
+	static const Utils::ConfigKey PROXY_KEY("/sekai/proxy");
+	static const Utils::ConfigKey MEDIA_KEY("/path/MediaFiles");
+	static const Utils::ConfigKey UPDATER_KEY("/sekai/UpdaterPath");
+	static const Utils::ConfigKey PYMODULES_KEY("/path/pymodules");
+	static const Utils::ConfigKey FILTER_KEY("/sekai/filter");
+	static const Utils::ConfigKey AES_KEY_KEY("/sekai/AESKey");
+	static const Utils::ConfigKey AES_IV_KEY("/sekai/AESIV");
+	static const Utils::ConfigKey API_KEY("/sekai/api");
+	static const Utils::ConfigKey POOL_SIZE_KEY("/sekai/PoolSize");
+	static const Utils::ConfigKey HOST_KEY("/sekai/proxy/host");
+	static const Utils::ConfigKey PORT_KEY("/sekai/proxy/port");
+	static const Utils::ConfigKey DEFAULT_HOST_KEY("/sekai/host");
+	static const Utils::ConfigKey DEFAULT_PORT_KEY("/sekai/port");
+	static const Utils::ConfigKey SEKAI_KEY("/sekai");
+	static const Utils::ConfigKey PATH_KEY("/path");
+
+	static std::mutex mtx;
+	static std::atomic<bool> dirty = true;
+	static const Utils::BotConfig* source = nullptr;
+	static std::shared_ptr<SekaiClient> client;
+	static Utils::BotConfig::Subscription SekaiSubscription;
+	static Utils::BotConfig::Subscription PathSubscription;
+
+	std::lock_guard<std::mutex> lk(mtx);
+	if (source != &config)
+	{
+		source = &config;
+		dirty = true;
+		SekaiSubscription = config.Subscribe(SEKAI_KEY, [] { dirty = true; });
+		PathSubscription = config.Subscribe(PATH_KEY, [] { dirty = true; });
+	}
+	if (client && !dirty) return client;
+
+	dirty = false;
+	// All settings of one client from the same snapshot
+	const auto view = config.View();
+	const std::filesystem::path MediaFiles = view.Get(MEDIA_KEY, "MediaFiles");
+	if (view.IsNull(PROXY_KEY))
+		client = GetClient(
+			MediaFiles / std::filesystem::path("pjsk"), 
+			MediaFiles / std::filesystem::path("tmp"), 
+			view.Get(UPDATER_KEY, "SekaiUpdater"), 
+			view.Get(PYMODULES_KEY, "pymodules") + ".sekai-extract", 
+			view.Get(FILTER_KEY, std::vector<std::string>{}), 
+			view.Get(AES_KEY_KEY, ""), 
+			view.Get(AES_IV_KEY, ""),
+			view.Get(API_KEY, ""),
+			view.Get(POOL_SIZE_KEY, 4)
+		);
+	else
+		client = GetClient(
+			MediaFiles / std::filesystem::path("pjsk"), 
+			MediaFiles / std::filesystem::path("tmp"), 
+			view.Get(UPDATER_KEY, "SekaiUpdater"), 
+			view.Get(PYMODULES_KEY, "pymodules") + ".sekai-extract", 
+			view.Get(FILTER_KEY, std::vector<std::string>{}), 
+			view.Get(AES_KEY_KEY, ""), 
+			view.Get(AES_IV_KEY, ""),
+			view.Get(API_KEY, ""),
+			view.Get(POOL_SIZE_KEY, 4),
+			view.Get(HOST_KEY, view.Get(DEFAULT_HOST_KEY, "")), 
+			view.Get(PORT_KEY, view.Get(DEFAULT_PORT_KEY, -1))
+		);
+	return client;
+}
+
 }
@@ -24,35 +24,8 @@ std::shared_ptr<SekaiClient> GetClient(
 	std::string ProxyHost = {}, int ProxyPort = -1
 );
 
-inline std::shared_ptr<SekaiClient> GetClient(const Utils::BotConfig& config)
-{
-	if (config.IsNull("/sekai/proxy"))
-		return GetClient(
-			config.Get("/path/MediaFiles", "MediaFiles") / std::filesystem::path("pjsk"), 
-			config.Get("/path/MediaFiles", "MediaFiles") / std::filesystem::path("tmp"), 
-			config.Get("/sekai/UpdaterPath", "SekaiUpdater"), 
-			config.Get("/path/pymodules", "pymodules") + ".sekai-extract", 
-			config.Get("/sekai/filter", std::vector<std::string>{}), 
-			config.Get("/sekai/AESKey", ""), 
-			config.Get("/sekai/AESIV", ""),
-			config.Get("/sekai/api", ""),
-			config.Get("/sekai/PoolSize", 4)
-		);
-	else
-		return GetClient(
-			config.Get("/path/MediaFiles", "MediaFiles") / std::filesystem::path("pjsk"), 
-			config.Get("/path/MediaFiles", "MediaFiles") / std::filesystem::path("tmp"), 
-			config.Get("/sekai/UpdaterPath", "SekaiUpdater"), 
-			config.Get("/path/pymodules", "pymodules") + ".sekai-extract", 
-			config.Get("/sekai/filter", std::vector<std::string>{}), 
-			config.Get("/sekai/AESKey", ""), 
-			config.Get("/sekai/AESIV", ""),
-			config.Get("/sekai/api", ""),
-			config.Get("/sekai/PoolSize", 4),
-			config.Get("/sekai/proxy/host", config.Get("/sekai/host", "")), 
-			config.Get("/sekai/proxy/port", config.Get("/sekai/port", -1))
-		);
-}
+// Cached until the /sekai or /path section of config changes. The proxy is read from /sekai only
+std::shared_ptr<SekaiClient> GetClient(const Utils::BotConfig& config);
 
 }
 
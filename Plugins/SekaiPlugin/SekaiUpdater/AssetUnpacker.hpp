@@ -5,8 +5,11 @@
 #include <filesystem>
 #include <mutex>
 #include <queue>
+#include <thread>
 #include <vector>
 
+#include <PluginUtils/Subprocess.hpp>
+
 namespace AssetUpdater
 {
 
@@ -21,8 +24,8 @@ protected:
 	std::vector<std::thread> _workers;
 	std::queue<std::string> _workloads;
 
-	const std::string _pymodule;
 	const std::filesystem::path _PathPrefix;
+	Utils::WorkerPool _pool;
 
 	bool _stop = false;
 
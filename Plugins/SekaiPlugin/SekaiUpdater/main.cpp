@@ -6,7 +6,6 @@
 #include <fstream>
 #include <iostream>
 #include <mutex>
-#include <regex>
 #include <stdexcept>
 #include <filesystem>
 #include <string>
@@ -18,6 +17,7 @@
 
 #include <PluginUtils/StringUtils.hpp>
 #include <PluginUtils/NetworkUtils.hpp>
+#include <PluginUtils/SimplePattern.hpp>
 
 #include "TaskDispatcher.hpp"
 #include "utils.hpp"
@@ -73,12 +73,12 @@ try
 		return 1;
 	}
 
-	std::vector<std::regex> filter;
+	std::vector<Utils::SimplePattern> filter;
 	if (argc > 5)
 	{
 		filter.reserve(argc - 5);
 		for (int i = 5; i < argc; i++)
-			filter.emplace_back(argv[i], std::regex_constants::ECMAScript);
+			filter.emplace_back(argv[i]);
 	}
 
 	LOGGING("Reading neccessary infomations from file...");
@@ -247,7 +247,7 @@ try
 		bool skip = false;
 		for (const auto& reg : filter)
 		{
-			if (std::regex_match(key, reg))
+			if (reg.match(key))
 			{
 				skip = true;
 				break;
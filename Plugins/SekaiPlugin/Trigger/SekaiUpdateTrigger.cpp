@@ -2,9 +2,9 @@
 
 #include <chrono>
 #include <exception>
-#include <regex>
 #include <vector>
 #include <croncpp.h>
+#include <PluginUtils/SimplePattern.hpp>
 
 #include <SekaiClient/SekaiClient.hpp>
 #include <SekaiClient/Singleton.hpp>
@@ -56,7 +56,7 @@ Mirai::MessageChain GetUpdatedVersions(Sekai::SekaiClient& SekaiCli, Bot::Client
 
 Mirai::MessageChain GetUpdatedCards(Sekai::SekaiClient& SekaiCli, Bot::Client& client, const std::vector<string>& UpdatedContents)
 {
-	const static std::regex reg(R"(^character/member/res\d+_no\d+$)", std::regex_constants::ECMAScript);
+	const static Utils::SimplePattern CardPattern(R"(^character/member/res\d+_no\d+$)");
 
 	Mirai::ForwardMessage msg;
 	Mirai::ForwardMessage::Node node;
@@ -65,7 +65,7 @@ Mirai::MessageChain GetUpdatedCards(Sekai::SekaiClient& SekaiCli, Bot::Client& c
 
 	for (const auto& key : UpdatedContents)
 	{
-		if (!std::regex_match(key, reg))
+		if (!CardPattern.match(key))
 			continue;
 
 		auto contents = SekaiCli.GetAssetContents(key);
@@ -0,0 +1,449 @@
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include <zlib.h>
+
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <PluginUtils/AsyncHttp.hpp>
+
+// NOLINTBEGIN
+
+namespace
+{
+
+using Utils::AsyncHttpClient;
+using Utils::AsyncHttpError;
+using Utils::AsyncHttpOptions;
+using Utils::AsyncHttpResponse;
+using Utils::EventLoop;
+using Utils::SyncWait;
+using Utils::Task;
+using std::chrono::milliseconds;
+
+// Accepts connections on 127.0.0.1 one after another and hands each to handler with its index
+class LoopbackServer
+{
+protected:
+	int _fd = -1;
+	int _port = 0;
+	std::atomic<int> _accepted = 0;
+	std::thread _thread;
+
+public:
+	explicit LoopbackServer(std::function<void(int fd, int index)> handler)
+	{
+		this->_fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+		sockaddr_in addr{};
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		socklen_t len = sizeof(addr);
+		if (bind(this->_fd, reinterpret_cast<sockaddr*>(&addr), len) < 0 || listen(this->_fd, 16) < 0
+		    || getsockname(this->_fd, reinterpret_cast<sockaddr*>(&addr), &len) < 0)
+			throw std::runtime_error("Failed to listen on loopback");
+		this->_port = ntohs(addr.sin_port);
+
+		this->_thread = std::thread(
+			[this, handler = std::move(handler)]
+			{
+				while (true)
+				{
+					int conn = accept(this->_fd, nullptr, nullptr);
+					if (conn < 0) return;
+					handler(conn, this->_accepted++);
+					close(conn);
+				}
+			});
+	}
+	LoopbackServer(const LoopbackServer&) = delete;
+	LoopbackServer& operator=(const LoopbackServer&) = delete;
+	~LoopbackServer()
+	{
+		shutdown(this->_fd, SHUT_RDWR);
+		this->_thread.join();
+		close(this->_fd);
+	}
+
+	int port() const { return this->_port; }
+	int accepted() const { return this->_accepted; }
+	std::string url(const std::string& path) const { return "http://127.0.0.1:" + std::to_string(this->_port) + path; }
+};
+
+// Request head up to the blank line, empty once the client closed the connection
+std::string ReadHead(int fd)
+{
+	std::string head;
+	char c{};
+	while (head.size() < 4 || head.compare(head.size() - 4, 4, "\r\n\r\n") != 0)
+	{
+		if (recv(fd, &c, 1, 0) <= 0) return {};
+		head += c;
+	}
+	return head;
+}
+
+void Send(int fd, const std::string& data)
+{
+	std::size_t sent = 0;
+	while (sent < data.size())
+	{
+		auto n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+		if (n <= 0) return;
+		sent += n;
+	}
+}
+
+// Waits until the client hangs up
+void Drain(int fd)
+{
+	char c{};
+	while (recv(fd, &c, 1, 0) > 0) {}
+}
+
+std::string Response(const std::string& body, const std::string& headers = {})
+{
+	return "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(body.size()) + "\r\n" + headers + "\r\n" + body;
+}
+
+// windowBits picks the format, 15 + 16 for gzip, 15 for zlib and -15 for raw deflate
+std::string Compress(const std::string& data, int bits)
+{
+	z_stream strm{};
+	EXPECT_EQ(deflateInit2(&strm, Z_BEST_COMPRESSION, Z_DEFLATED, bits, 8, Z_DEFAULT_STRATEGY), Z_OK);
+	std::string out(deflateBound(&strm, data.size()) + 32, '\0');
+	strm.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+	strm.avail_in = data.size();
+	strm.next_out = reinterpret_cast<Bytef*>(out.data());
+	strm.avail_out = out.size();
+	EXPECT_EQ(deflate(&strm, Z_FINISH), Z_STREAM_END);
+	out.resize(strm.total_out);
+	deflateEnd(&strm);
+	return out;
+}
+
+struct Fixture
+{
+	EventLoop loop{1, 1};
+	AsyncHttpClient client{loop};
+
+	AsyncHttpResponse Get(const std::string& url, AsyncHttpOptions opts = {})
+	{
+		return SyncWait(this->client.Get(url, {}, std::move(opts)));
+	}
+};
+
+Task<bool> Sleep(EventLoop& loop, milliseconds duration)
+{
+	bool woken = co_await loop.sleep(EventLoop::clock::now() + duration);
+	co_return woken;
+}
+
+Task<bool> WaitReadable(EventLoop& loop, int fd, milliseconds timeout)
+{
+	bool ready = co_await loop.wait(fd, EPOLLIN, EventLoop::clock::now() + timeout);
+	co_return ready;
+}
+
+Task<std::thread::id> Offload(EventLoop& loop, bool fail)
+{
+	auto job = [fail]
+	{
+		if (fail) throw std::runtime_error("offload");
+		return std::this_thread::get_id();
+	};
+	auto id = co_await loop.offload(std::move(job));
+	co_return id;
+}
+
+} // namespace
+
+TEST(EventLoopTest, SleepResumesAfterDeadline)
+{
+	EventLoop loop(1, 1);
+	const auto start = EventLoop::clock::now();
+	EXPECT_FALSE(SyncWait(Sleep(loop, milliseconds(50))));
+	EXPECT_GE(EventLoop::clock::now() - start, milliseconds(50));
+
+	// Sleeps run concurrently on a single loop thread
+	std::vector<Task<bool>> tasks;
+	for (int i = 0; i < 20; i++)
+		tasks.push_back(Sleep(loop, milliseconds(100)));
+	const auto before = EventLoop::clock::now();
+	EXPECT_EQ(SyncWait(Utils::WhenAll(std::move(tasks))).size(), 20);
+	EXPECT_LT(EventLoop::clock::now() - before, std::chrono::seconds(1));
+}
+
+TEST(EventLoopTest, WaitResumesOnReadiness)
+{
+	EventLoop loop(1, 1);
+	int fds[2];
+	ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+
+	std::thread writer(
+		[fd = fds[1]]
+		{
+			std::this_thread::sleep_for(milliseconds(20));
+			Send(fd, "x");
+		});
+	EXPECT_TRUE(SyncWait(WaitReadable(loop, fds[0], std::chrono::seconds(5))));
+	writer.join();
+
+	char c{};
+	ASSERT_EQ(recv(fds[0], &c, 1, 0), 1);
+	EXPECT_FALSE(SyncWait(WaitReadable(loop, fds[0], milliseconds(50))));
+
+	close(fds[0]);
+	close(fds[1]);
+}
+
+TEST(EventLoopTest, OffloadRunsOnWorker)
+{
+	EventLoop loop(1, 1);
+	EXPECT_NE(SyncWait(Offload(loop, false)), std::this_thread::get_id());
+	EXPECT_THROW(SyncWait(Offload(loop, true)), std::runtime_error);
+}
+
+TEST(AsyncHttpTest, ContentLengthBody)
+{
+	std::string head;
+	LoopbackServer server(
+		[&head](int fd, int)
+		{
+			head = ReadHead(fd);
+			Send(fd, "HTTP/1.1 100 Continue\r\n\r\n");
+			Send(fd, Response("hello", "X-Test: a\r\n"));
+			Drain(fd);
+		});
+
+	Fixture f;
+	auto resp = f.Get(server.url("/path?x=1"));
+	EXPECT_EQ(resp.status, 200);
+	EXPECT_EQ(resp.reason, "OK");
+	EXPECT_EQ(resp.body, "hello");
+	EXPECT_EQ(resp.get_header_value("X-Test"), "a");
+	EXPECT_EQ(head.substr(0, head.find("\r\n")), "GET /path?x=1 HTTP/1.1");
+	EXPECT_NE(head.find("Host: 127.0.0.1:" + std::to_string(server.port()) + "\r\n"), std::string::npos);
+}
+
+TEST(AsyncHttpTest, ChunkedBody)
+{
+	LoopbackServer server(
+		[](int fd, int)
+		{
+			ReadHead(fd);
+			Send(fd, "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n");
+			// Split across writes so the client has to wait for the rest
+			Send(fd, "5;ext=1\r\nhel");
+			std::this_thread::sleep_for(milliseconds(20));
+			Send(fd, "lo\r\n1A\r\n");
+			Send(fd, std::string(26, 'z') + "\r\n0\r\nX-Trailer: t\r\n\r\n");
+			ReadHead(fd);
+			Send(fd, Response("again"));
+			Drain(fd);
+		});
+
+	Fixture f;
+	EXPECT_EQ(f.Get(server.url("/")).body, "hello" + std::string(26, 'z'));
+	// The trailers were consumed, so the connection is reused for the next request
+	EXPECT_EQ(f.Get(server.url("/")).body, "again");
+	EXPECT_EQ(server.accepted(), 1);
+}
+
+TEST(AsyncHttpTest, BodyUntilEof)
+{
+	LoopbackServer server(
+		[](int fd, int)
+		{
+			ReadHead(fd);
+			Send(fd, "HTTP/1.1 200 OK\r\nX-Test: eof\r\n\r\nuntil ");
+			Send(fd, "closed");
+		});
+
+	Fixture f;
+	EXPECT_EQ(f.Get(server.url("/")).body, "until closed");
+	EXPECT_EQ(f.Get(server.url("/")).body, "until closed");
+	// The end of the body is the end of the connection
+	EXPECT_EQ(server.accepted(), 2);
+}
+
+TEST(AsyncHttpTest, KeepAliveConnectionIsReused)
+{
+	LoopbackServer server(
+		[](int fd, int)
+		{
+			for (int i = 0; !ReadHead(fd).empty(); i++)
+				Send(fd, Response(std::to_string(i)));
+		});
+
+	Fixture f;
+	for (int i = 0; i < 3; i++)
+		EXPECT_EQ(f.Get(server.url("/")).body, std::to_string(i));
+	EXPECT_EQ(server.accepted(), 1);
+}
+
+TEST(AsyncHttpTest, StaleKeepAliveConnectionIsRetried)
+{
+	LoopbackServer server(
+		[](int fd, int index)
+		{
+			ReadHead(fd);
+			if (index == 0)
+			{
+				Send(fd, Response("first"));
+				// Gives up on the connection only once the next request arrived
+				ReadHead(fd);
+				return;
+			}
+			Send(fd, Response("retried"));
+			Drain(fd);
+		});
+
+	Fixture f;
+	EXPECT_EQ(f.Get(server.url("/")).body, "first");
+	EXPECT_EQ(f.Get(server.url("/")).body, "retried");
+	EXPECT_EQ(server.accepted(), 2);
+}
+
+TEST(AsyncHttpTest, FreshConnectionIsNotRetried)
+{
+	LoopbackServer server([](int fd, int) { ReadHead(fd); });
+
+	Fixture f;
+	EXPECT_THROW(f.Get(server.url("/")), AsyncHttpError);
+	EXPECT_EQ(server.accepted(), 1);
+}
+
+TEST(AsyncHttpTest, ReadTimesOut)
+{
+	LoopbackServer server(
+		[](int fd, int)
+		{
+			ReadHead(fd);
+			Drain(fd);
+		});
+
+	Fixture f;
+	AsyncHttpOptions opts;
+	opts.ReadTimeout = milliseconds(100);
+	EXPECT_THROW(f.Get(server.url("/"), opts), AsyncHttpError);
+}
+
+TEST(AsyncHttpTest, DecompressesBodies)
+{
+	std::string body;
+	for (int i = 0; i < 1000; i++)
+		body += "line " + std::to_string(i % 7) + "\n";
+	const std::vector<std::pair<std::string, std::string>> encoded = {
+		{"gzip", Compress(body, 15 + 16)},
+		{"deflate", Compress(body, 15)},
+		// Raw deflate without the zlib header, as sent by some servers
+		{"deflate", Compress(body, -15)},
+	};
+
+	std::string head;
+	LoopbackServer server(
+		[&encoded, &head](int fd, int)
+		{
+			for (std::size_t i = 0; !(head = ReadHead(fd)).empty(); i++)
+			{
+				const auto& [encoding, data] = encoded[i % encoded.size()];
+				Send(fd, Response(data, "Content-Encoding: " + encoding + "\r\n"));
+			}
+		});
+
+	Fixture f;
+	for (std::size_t i = 0; i < encoded.size(); i++)
+		EXPECT_EQ(f.Get(server.url("/")).body, body) << "response " << i;
+	EXPECT_NE(head.find("Accept-Encoding: gzip, deflate\r\n"), std::string::npos);
+
+	// Left alone when asked to
+	AsyncHttpOptions opts;
+	opts.decompress = false;
+	EXPECT_EQ(f.Get(server.url("/"), opts).body, encoded[0].second);
+	EXPECT_EQ(head.find("Accept-Encoding"), std::string::npos);
+
+	opts.decompress = true;
+	opts.MaxBodySize = body.size() - 1;
+	EXPECT_THROW(f.Get(server.url("/"), opts), AsyncHttpError);
+}
+
+TEST(AsyncHttpTest, ProxyGetsAbsoluteUrlForHttp)
+{
+	std::string head;
+	LoopbackServer proxy(
+		[&head](int fd, int)
+		{
+			head = ReadHead(fd);
+			Send(fd, Response("proxied"));
+			Drain(fd);
+		});
+
+	Fixture f;
+	AsyncHttpOptions opts;
+	opts.ProxyHost = "127.0.0.1";
+	opts.ProxyPort = proxy.port();
+	// Only the proxy is resolved
+	EXPECT_EQ(f.Get("http://elanor.invalid/a?b=c", opts).body, "proxied");
+	EXPECT_EQ(head.substr(0, head.find("\r\n")), "GET http://elanor.invalid/a?b=c HTTP/1.1");
+	EXPECT_NE(head.find("Host: elanor.invalid\r\n"), std::string::npos);
+}
+
+TEST(AsyncHttpTest, ProxyConnectTunnel)
+{
+	std::mutex mtx;
+	std::vector<std::string> heads;
+	bool hello = false;
+	LoopbackServer proxy(
+		[&](int fd, int index)
+		{
+			auto head = ReadHead(fd);
+			{
+				std::lock_guard<std::mutex> lk(mtx);
+				heads.push_back(head);
+			}
+			if (index == 0)
+			{
+				Send(fd, "HTTP/1.1 403 Forbidden\r\nContent-Length: 0\r\n\r\n");
+				Drain(fd);
+				return;
+			}
+			Send(fd, "HTTP/1.1 200 Connection established\r\nX-Proxy: 1\r\n\r\n");
+			// The TLS handshake starts right after, there is no server behind this proxy though
+			unsigned char c{};
+			bool received = recv(fd, &c, 1, 0) == 1 && c == 0x16;
+			std::lock_guard<std::mutex> lk(mtx);
+			hello = received;
+		});
+
+	Fixture f;
+	AsyncHttpOptions opts;
+	opts.ProxyHost = "127.0.0.1";
+	opts.ProxyPort = proxy.port();
+	try
+	{
+		f.Get("https://elanor.invalid/", opts);
+		ADD_FAILURE() << "Tunnel was not refused";
+	}
+	catch (const AsyncHttpError& e)
+	{
+		EXPECT_NE(std::string(e.what()).find("Proxy refused"), std::string::npos) << e.what();
+	}
+	EXPECT_THROW(f.Get("https://elanor.invalid/", opts), AsyncHttpError);
+
+	std::lock_guard<std::mutex> lk(mtx);
+	ASSERT_EQ(heads.size(), 2);
+	for (const auto& head : heads)
+		EXPECT_EQ(head, "CONNECT elanor.invalid:443 HTTP/1.1\r\nHost: elanor.invalid:443\r\n\r\n");
+	EXPECT_TRUE(hello);
+}
+
+// NOLINTEND
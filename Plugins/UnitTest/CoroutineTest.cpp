@@ -0,0 +1,126 @@
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include <PluginUtils/Coroutine.hpp>
+
+// NOLINTBEGIN
+
+namespace
+{
+
+using Utils::SyncWait;
+using Utils::Task;
+using Utils::WhenAll;
+
+Task<int> Value(int v, int& started)
+{
+	started++;
+	co_return v;
+}
+
+Task<int> Fail(std::string msg)
+{
+	throw std::runtime_error(msg);
+	co_return 0;
+}
+
+Task<int> Sum(int a, int b, int& started)
+{
+	int x = co_await Value(a, started);
+	int y = co_await Value(b, started);
+	co_return x + y;
+}
+
+Task<void> Nothing(int& started)
+{
+	started++;
+	co_return;
+}
+
+Task<std::string> Caught()
+{
+	try
+	{
+		co_await Fail("inner");
+	}
+	catch (const std::runtime_error& e)
+	{
+		co_return std::string("caught ") + e.what();
+	}
+	co_return "";
+}
+
+} // namespace
+
+TEST(CoroutineTest, TaskIsLazy)
+{
+	int started = 0;
+	{
+		auto task = Value(1, started);
+		EXPECT_TRUE(task.valid());
+		EXPECT_EQ(started, 0);
+	}
+	// Destroyed without ever running
+	EXPECT_EQ(started, 0);
+
+	EXPECT_EQ(SyncWait(Value(1, started)), 1);
+	EXPECT_EQ(started, 1);
+}
+
+TEST(CoroutineTest, AwaitsNestedTasks)
+{
+	int started = 0;
+	EXPECT_EQ(SyncWait(Sum(2, 3, started)), 5);
+	EXPECT_EQ(started, 2);
+
+	SyncWait(Nothing(started));
+	EXPECT_EQ(started, 3);
+}
+
+TEST(CoroutineTest, ExceptionsPropagateToTheAwaiter)
+{
+	EXPECT_THROW(SyncWait(Fail("outer")), std::runtime_error);
+	EXPECT_EQ(SyncWait(Caught()), "caught inner");
+}
+
+TEST(CoroutineTest, WhenAllKeepsOrder)
+{
+	int started = 0;
+	std::vector<Task<int>> tasks;
+	for (int i = 0; i < 10; i++)
+		tasks.push_back(Value(i, started));
+	EXPECT_EQ(started, 0);
+
+	auto result = SyncWait(WhenAll(std::move(tasks)));
+	EXPECT_EQ(started, 10);
+	ASSERT_EQ(result.size(), 10);
+	for (int i = 0; i < 10; i++)
+		EXPECT_EQ(result[i], i);
+
+	EXPECT_TRUE(SyncWait(WhenAll(std::vector<Task<int>>{})).empty());
+}
+
+TEST(CoroutineTest, WhenAllRethrowsFirstFailureByIndex)
+{
+	int started = 0;
+	std::vector<Task<int>> tasks;
+	tasks.push_back(Value(0, started));
+	tasks.push_back(Fail("first"));
+	tasks.push_back(Fail("second"));
+	tasks.push_back(Value(3, started));
+	try
+	{
+		SyncWait(WhenAll(std::move(tasks)));
+		ADD_FAILURE() << "WhenAll did not throw";
+	}
+	catch (const std::runtime_error& e)
+	{
+		EXPECT_STREQ(e.what(), "first");
+	}
+	// Every task ran to completion regardless
+	EXPECT_EQ(started, 2);
+}
+
+// NOLINTEND
@@ -0,0 +1,198 @@
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include <PluginUtils/DiskCache.hpp>
+
+// NOLINTBEGIN
+
+namespace
+{
+
+namespace fs = std::filesystem;
+
+class DiskCacheTest : public ::testing::Test
+{
+protected:
+	fs::path dir;
+
+	void SetUp() override
+	{
+		dir = fs::temp_directory_path() / ("elanor-disk-cache-" + std::to_string(std::random_device{}()));
+		fs::remove_all(dir);
+	}
+
+	void TearDown() override { fs::remove_all(dir); }
+
+	fs::path PathOf(const std::string& key) const
+	{
+		const auto hash = Utils::Sha256(key);
+		return dir / hash.substr(0, 2) / hash;
+	}
+
+	// Modification times decide the order after a restart
+	void SetAge(const std::string& key, std::chrono::hours age) const
+	{
+		fs::last_write_time(PathOf(key), fs::file_time_type::clock::now() - age);
+	}
+
+	static void Touch(const fs::path& path, const std::string& content = "x")
+	{
+		fs::create_directories(path.parent_path());
+		std::ofstream(path, std::ios::binary) << content;
+	}
+};
+
+} // namespace
+
+TEST(Sha256Test, KnownDigests)
+{
+	EXPECT_EQ(Utils::Sha256(""), "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+	EXPECT_EQ(Utils::Sha256("abc"), "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+}
+
+TEST_F(DiskCacheTest, PutGetErase)
+{
+	Utils::DiskCache cache(dir, 100);
+	EXPECT_FALSE(cache.get("a"));
+
+	cache.put("a", std::string("bin\0ary", 7));
+	EXPECT_EQ(cache.get("a"), std::string("bin\0ary", 7));
+	EXPECT_TRUE(fs::exists(PathOf("a")));
+	EXPECT_EQ(cache.bytes(), 7);
+
+	// Replacing counts the new size only
+	cache.put("a", "abc");
+	EXPECT_EQ(cache.get("a"), "abc");
+	EXPECT_EQ(cache.bytes(), 3);
+	EXPECT_EQ(cache.count(), 1);
+
+	cache.erase("a");
+	EXPECT_FALSE(cache.get("a"));
+	EXPECT_FALSE(fs::exists(PathOf("a")));
+	EXPECT_EQ(cache.bytes(), 0);
+}
+
+TEST_F(DiskCacheTest, ValuesOverLimitAreNotStored)
+{
+	Utils::DiskCache cache(dir, 10);
+	cache.put("a", "12345");
+	cache.put("big", std::string(11, 'x'));
+	EXPECT_FALSE(cache.get("big"));
+	EXPECT_EQ(cache.get("a"), "12345");
+}
+
+TEST_F(DiskCacheTest, EvictsLeastRecentlyUsed)
+{
+	Utils::DiskCache cache(dir, 30);
+	cache.put("a", std::string(10, 'a'));
+	cache.put("b", std::string(10, 'b'));
+	cache.put("c", std::string(10, 'c'));
+
+	// Reading a makes b the oldest
+	EXPECT_TRUE(cache.get("a"));
+	cache.put("d", std::string(10, 'd'));
+	EXPECT_FALSE(cache.get("b"));
+	EXPECT_FALSE(fs::exists(PathOf("b")));
+	EXPECT_TRUE(cache.get("a"));
+	EXPECT_TRUE(cache.get("c"));
+	EXPECT_TRUE(cache.get("d"));
+	EXPECT_EQ(cache.bytes(), 30);
+
+	// A large value evicts several
+	cache.put("e", std::string(25, 'e'));
+	EXPECT_EQ(cache.count(), 1);
+	EXPECT_TRUE(cache.get("e"));
+}
+
+TEST_F(DiskCacheTest, RestartRebuildsIndexFromDisk)
+{
+	{
+		Utils::DiskCache cache(dir, 30);
+		cache.put("a", std::string(10, 'a'));
+		cache.put("b", std::string(10, 'b'));
+		cache.put("c", std::string(10, 'c'));
+	}
+	SetAge("a", std::chrono::hours(3));
+	SetAge("b", std::chrono::hours(2));
+	SetAge("c", std::chrono::hours(1));
+
+	{
+		Utils::DiskCache cache(dir, 30);
+		EXPECT_EQ(cache.count(), 3);
+		EXPECT_EQ(cache.bytes(), 30);
+		// Reads touch the file, so a is the newest after the next restart
+		EXPECT_EQ(cache.get("a"), std::string(10, 'a'));
+	}
+
+	// A smaller limit evicts the oldest on startup
+	Utils::DiskCache cache(dir, 20);
+	EXPECT_EQ(cache.count(), 2);
+	EXPECT_FALSE(cache.get("b"));
+	EXPECT_FALSE(fs::exists(PathOf("b")));
+	EXPECT_TRUE(cache.get("a"));
+	EXPECT_TRUE(cache.get("c"));
+}
+
+TEST_F(DiskCacheTest, StartupRemovesTemporaryFiles)
+{
+	const auto hash = Utils::Sha256("a");
+	const auto temp = dir / hash.substr(0, 2) / (hash + ".tmp.3");
+	Touch(temp, "partial");
+	// Unrelated files are neither indexed nor removed
+	const auto other = dir / "README";
+	Touch(other);
+	const auto misplaced = dir / "00" / hash;
+	Touch(misplaced);
+
+	Utils::DiskCache cache(dir, 100);
+	EXPECT_FALSE(fs::exists(temp));
+	EXPECT_TRUE(fs::exists(other));
+	EXPECT_TRUE(fs::exists(misplaced));
+	EXPECT_EQ(cache.count(), 0);
+	EXPECT_FALSE(cache.get("a"));
+
+	// No temporary file is left behind by a write
+	cache.put("a", "done");
+	for (const auto& file : fs::recursive_directory_iterator(dir))
+		EXPECT_EQ(file.path().filename().string().find(".tmp"), std::string::npos) << file.path();
+}
+
+TEST_F(DiskCacheTest, FilesRemovedFromOutsideAreMisses)
+{
+	Utils::DiskCache cache(dir, 100);
+	cache.put("a", "abc");
+	fs::remove(PathOf("a"));
+	EXPECT_FALSE(cache.get("a"));
+	EXPECT_EQ(cache.count(), 0);
+	EXPECT_EQ(cache.bytes(), 0);
+}
+
+TEST_F(DiskCacheTest, ConcurrentWritersOfOneKey)
+{
+	Utils::DiskCache cache(dir, 1 << 20);
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; t++)
+		threads.emplace_back(
+			[&cache, t]
+			{
+				for (int i = 0; i < 20; i++)
+					cache.put("a", std::string(1000, static_cast<char>('a' + t)));
+			});
+	for (auto& thread : threads)
+		thread.join();
+
+	// Whoever won, the file is one complete value
+	const auto value = cache.get("a");
+	ASSERT_TRUE(value);
+	EXPECT_EQ(*value, std::string(1000, value->front()));
+	EXPECT_EQ(cache.count(), 1);
+	EXPECT_EQ(cache.bytes(), 1000);
+}
+
+// NOLINTEND
@@ -0,0 +1,314 @@
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include <gtest/gtest.h>
+#include <nlohmann/json.hpp>
+
+#include <Core/Utils/Common.hpp>
+#include <PluginUtils/DiskCache.hpp>
+#include <PluginUtils/HttpCache.hpp>
+
+// NOLINTBEGIN
+
+namespace
+{
+
+namespace fs = std::filesystem;
+using Utils::CachePolicy;
+using Utils::HttpCache;
+using std::chrono::hours;
+using std::chrono::seconds;
+
+constexpr auto SLACK = seconds(5);
+
+std::shared_ptr<httplib::Response> Response(std::vector<std::pair<std::string, std::string>> headers,
+                                            std::string body = "body", int status = 200)
+{
+	auto response = std::make_shared<httplib::Response>();
+	response->status = status;
+	response->reason = "OK";
+	response->body = std::move(body);
+	for (auto& [name, value] : headers)
+		response->headers.emplace(std::move(name), std::move(value));
+	return response;
+}
+
+// Lifetime of entry from now
+HttpCache::clock::duration Ttl(const HttpCache::Entry& entry)
+{
+	return entry.expires - HttpCache::clock::now();
+}
+
+std::size_t FileCount(const fs::path& dir)
+{
+	std::size_t count = 0;
+	std::error_code ec;
+	for (fs::recursive_directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec))
+		if (it->is_regular_file()) count++;
+	return count;
+}
+
+class HttpCacheTest : public ::testing::Test
+{
+protected:
+	fs::path dir;
+
+	void SetUp() override
+	{
+		dir = fs::temp_directory_path() / ("elanor-http-cache-" + std::to_string(std::random_device{}()));
+		fs::remove_all(dir);
+	}
+
+	void TearDown() override { fs::remove_all(dir); }
+};
+
+} // namespace
+
+TEST_F(HttpCacheTest, ExpiryFromCacheControl)
+{
+	HttpCache cache;
+	auto entry = cache.store("a", Response({{"Cache-Control", "public, max-age=100"}}));
+	ASSERT_NE(entry, nullptr);
+	EXPECT_NEAR(std::chrono::duration<double>(Ttl(*entry)).count(), 100, SLACK.count());
+	EXPECT_TRUE(entry->fresh({}));
+
+	// Age counts against max-age
+	entry = cache.store("b", Response({{"Cache-Control", "max-age=100"}, {"Age", "40"}}));
+	ASSERT_NE(entry, nullptr);
+	EXPECT_NEAR(std::chrono::duration<double>(Ttl(*entry)).count(), 60, SLACK.count());
+
+	// Already stale on arrival, only kept because it can be revalidated
+	entry = cache.store("c", Response({{"Cache-Control", "max-age=10"}, {"Age", "20"}, {"ETag", "\"c\""}}));
+	ASSERT_NE(entry, nullptr);
+	EXPECT_FALSE(entry->fresh({}));
+	EXPECT_EQ(cache.store("d", Response({{"Cache-Control", "max-age=10"}, {"Age", "20"}})), nullptr);
+
+	// max-age wins over Expires
+	entry = cache.store("e", Response({{"Cache-Control", "max-age=100"},
+	                                   {"Date", "Wed, 21 Oct 2015 07:28:00 GMT"},
+	                                   {"Expires", "Wed, 21 Oct 2015 17:28:00 GMT"}}));
+	ASSERT_NE(entry, nullptr);
+	EXPECT_NEAR(std::chrono::duration<double>(Ttl(*entry)).count(), 100, SLACK.count());
+}
+
+TEST_F(HttpCacheTest, ExpiryFromExpires)
+{
+	HttpCache cache;
+	// Relative to Date, so a skewed server clock does not matter
+	auto entry = cache.store("a", Response({{"Date", "Wed, 21 Oct 2015 07:28:00 GMT"},
+	                                        {"Expires", "Wed, 21 Oct 2015 08:28:00 GMT"}}));
+	ASSERT_NE(entry, nullptr);
+	EXPECT_NEAR(std::chrono::duration<double>(Ttl(*entry)).count(), 3600, SLACK.count());
+
+	EXPECT_EQ(cache.store("b", Response({{"Date", "Wed, 21 Oct 2015 07:28:00 GMT"},
+	                                     {"Expires", "Wed, 21 Oct 2015 07:00:00 GMT"}})),
+	          nullptr);
+}
+
+TEST_F(HttpCacheTest, ExpiryWithoutServerLifetime)
+{
+	HttpCache cache;
+	// Nothing to go by and nothing to revalidate with
+	EXPECT_EQ(cache.store("a", Response({})), nullptr);
+
+	CachePolicy policy;
+	policy.DefaultTtl = hours(1);
+	auto entry = cache.store("a", Response({}), policy);
+	ASSERT_NE(entry, nullptr);
+	EXPECT_NEAR(std::chrono::duration<double>(Ttl(*entry)).count(), 3600, SLACK.count());
+
+	// A tenth of the time since the last modification, at most a day
+	entry = cache.store("b", Response({{"Date", "Wed, 21 Oct 2015 07:28:00 GMT"},
+	                                   {"Last-Modified", "Wed, 21 Oct 2015 05:28:00 GMT"}}));
+	ASSERT_NE(entry, nullptr);
+	EXPECT_NEAR(std::chrono::duration<double>(Ttl(*entry)).count(), 720, SLACK.count());
+	EXPECT_EQ(entry->LastModified, "Wed, 21 Oct 2015 05:28:00 GMT");
+
+	entry = cache.store("c", Response({{"Date", "Wed, 21 Oct 2015 07:28:00 GMT"},
+	                                   {"Last-Modified", "Wed, 21 Oct 2009 07:28:00 GMT"}}));
+	ASSERT_NE(entry, nullptr);
+	EXPECT_NEAR(std::chrono::duration<double>(Ttl(*entry)).count(), 86400, SLACK.count());
+}
+
+TEST_F(HttpCacheTest, NotStored)
+{
+	HttpCache cache;
+	const std::vector<std::pair<std::string, std::string>> lasting = {{"Cache-Control", "max-age=100"}};
+
+	CachePolicy NoStore;
+	NoStore.mode = CachePolicy::Mode::NO_STORE;
+	EXPECT_EQ(cache.store("a", Response(lasting), NoStore), nullptr);
+	EXPECT_EQ(cache.store("a", Response({{"Cache-Control", "no-store, max-age=100"}})), nullptr);
+	EXPECT_EQ(cache.store("a", Response({{"Cache-Control", "max-age=100"}, {"Vary", "*"}})), nullptr);
+	EXPECT_EQ(cache.store("a", Response(lasting, "missing", 404)), nullptr);
+	EXPECT_EQ(cache.find("a"), nullptr);
+
+	// Stored entries are never fresh under NO_STORE
+	auto entry = cache.store("a", Response(lasting));
+	ASSERT_NE(entry, nullptr);
+	EXPECT_FALSE(entry->fresh(NoStore));
+}
+
+TEST_F(HttpCacheTest, PolicyModes)
+{
+	HttpCache cache;
+	CachePolicy immutable;
+	immutable.mode = CachePolicy::Mode::IMMUTABLE;
+	// Overrides whatever the server says
+	auto entry = cache.store("a", Response({{"Cache-Control", "no-store"}}), immutable);
+	ASSERT_NE(entry, nullptr);
+	EXPECT_TRUE(entry->fresh(immutable));
+
+	CachePolicy NoCache;
+	NoCache.mode = CachePolicy::Mode::NO_CACHE;
+	entry = cache.store("b", Response({}), NoCache);
+	ASSERT_NE(entry, nullptr);
+	EXPECT_FALSE(entry->fresh(NoCache));
+
+	// no-cache from the server stores a stale entry
+	entry = cache.store("c", Response({{"Cache-Control", "no-cache"}, {"ETag", "\"c\""}}));
+	ASSERT_NE(entry, nullptr);
+	EXPECT_FALSE(entry->fresh({}));
+}
+
+TEST_F(HttpCacheTest, RevalidationRefreshesEntry)
+{
+	HttpCache cache;
+	auto stale = cache.store("a", Response({{"Cache-Control", "no-cache"},
+	                                        {"ETag", "\"v1\""},
+	                                        {"Content-Type", "image/png"},
+	                                        {"X-Kept", "1"}},
+	                                       "png"));
+	ASSERT_NE(stale, nullptr);
+	EXPECT_FALSE(stale->fresh({}));
+
+	auto NotModified = Response({{"Cache-Control", "max-age=100"}, {"ETag", "\"v2\""}, {"Connection", "close"}}, "", 304);
+	auto entry = cache.refresh("a", *stale, *NotModified);
+	ASSERT_NE(entry, nullptr);
+	EXPECT_TRUE(entry->fresh({}));
+	EXPECT_NEAR(std::chrono::duration<double>(Ttl(*entry)).count(), 100, SLACK.count());
+	EXPECT_EQ(entry->ETag, "\"v2\"");
+	EXPECT_EQ(entry->ObjectId, stale->ObjectId);
+
+	// Headers of the 304 replace the stored ones, the body and the rest stay
+	EXPECT_EQ(entry->response->status, 200);
+	EXPECT_EQ(entry->response->body, "png");
+	EXPECT_EQ(entry->response->get_header_value("Content-Type"), "image/png");
+	EXPECT_EQ(entry->response->get_header_value("X-Kept"), "1");
+	EXPECT_EQ(entry->response->get_header_value("Cache-Control"), "max-age=100");
+	EXPECT_EQ(entry->response->headers.count("ETag"), 1);
+	EXPECT_FALSE(entry->response->has_header("Connection"));
+
+	EXPECT_EQ(cache.find("a"), entry);
+	// The entry handed out before is not touched
+	EXPECT_EQ(stale->ETag, "\"v1\"");
+}
+
+TEST_F(HttpCacheTest, DiskTierSurvivesRestart)
+{
+	const auto headers = std::vector<std::pair<std::string, std::string>>{
+		{"Cache-Control", "max-age=100"}, {"ETag", "\"v1\""}, {"Content-Type", "text/plain"}, {"Connection", "keep-alive"}};
+	std::shared_ptr<const HttpCache::Entry> stored;
+	{
+		HttpCache cache;
+		cache.SetDirectory(dir);
+		stored = cache.store("a", Response(headers, "shared body"));
+		ASSERT_NE(stored, nullptr);
+		// Bodies are content addressed, the same body is only written once
+		ASSERT_NE(cache.store("b", Response(headers, "shared body")), nullptr);
+		EXPECT_EQ(FileCount(dir / "objects"), 1);
+		EXPECT_EQ(FileCount(dir / "meta"), 2);
+	}
+
+	HttpCache cache;
+	EXPECT_EQ(cache.find("a"), nullptr);
+	cache.SetDirectory(dir);
+	auto entry = cache.find("a");
+	ASSERT_NE(entry, nullptr);
+	EXPECT_EQ(entry->response->status, 200);
+	EXPECT_EQ(entry->response->body, "shared body");
+	EXPECT_EQ(entry->response->get_header_value("Content-Type"), "text/plain");
+	EXPECT_FALSE(entry->response->has_header("Connection"));
+	EXPECT_EQ(entry->ETag, "\"v1\"");
+	EXPECT_EQ(entry->ObjectId, Utils::Sha256("shared body"));
+	EXPECT_LE(std::chrono::abs(entry->expires - stored->expires), seconds(1));
+	EXPECT_TRUE(entry->fresh({}));
+
+	cache.erase("a");
+	EXPECT_EQ(cache.find("a"), nullptr);
+	EXPECT_NE(cache.find("b"), nullptr);
+
+	// Entries whose body went missing are dropped
+	fs::remove_all(dir / "objects");
+	cache.clear();
+	EXPECT_EQ(cache.find("b"), nullptr);
+	EXPECT_EQ(FileCount(dir / "meta"), 0);
+}
+
+TEST_F(HttpCacheTest, DiskTierIsPruned)
+{
+	HttpCache cache;
+	cache.SetDirectory(dir);
+	cache.SetLimits(HttpCache::MEMORY_LIMIT, 1000);
+	for (int i = 0; i < 10; i++)
+		ASSERT_NE(cache.store(std::to_string(i), Response({{"Cache-Control", "max-age=100"}},
+		                                                  std::string(300, 'a' + i))),
+		          nullptr);
+	EXPECT_LE(FileCount(dir / "objects"), 3);
+
+	// The newest entry stays, pruned ones are gone from the disk tier as well
+	HttpCache restarted;
+	restarted.SetDirectory(dir);
+	EXPECT_NE(restarted.find("9"), nullptr);
+	EXPECT_EQ(restarted.find("0"), nullptr);
+	EXPECT_EQ(FileCount(dir / "meta"), FileCount(dir / "objects"));
+}
+
+TEST_F(HttpCacheTest, LargeBodiesSkipMemory)
+{
+	HttpCache cache;
+	cache.SetLimits(10, HttpCache::DISK_LIMIT);
+	const auto lasting = std::vector<std::pair<std::string, std::string>>{{"Cache-Control", "max-age=100"}};
+	ASSERT_NE(cache.store("small", Response(lasting, "12345")), nullptr);
+	ASSERT_NE(cache.store("large", Response(lasting, std::string(11, 'x'))), nullptr);
+	EXPECT_NE(cache.find("small"), nullptr);
+	// Without a disk tier it is not kept anywhere
+	EXPECT_EQ(cache.find("large"), nullptr);
+
+	// The least recently used entry makes room
+	ASSERT_NE(cache.store("other", Response(lasting, "abcdefgh")), nullptr);
+	EXPECT_EQ(cache.find("small"), nullptr);
+	EXPECT_NE(cache.find("other"), nullptr);
+}
+
+TEST_F(HttpCacheTest, WatchConfigFollowsMediaPath)
+{
+	const auto ConfigPath = dir / "config.json";
+	fs::create_directories(dir);
+	Utils::BotConfig config(nlohmann::json{{"path", {{"MediaFiles", (dir / "first").string()}}}});
+
+	HttpCache cache;
+	cache.WatchConfig(config);
+	ASSERT_NE(cache.store("a", Response({{"Cache-Control", "max-age=100"}})), nullptr);
+	EXPECT_EQ(FileCount(dir / "first/cache/http/meta"), 1);
+
+	std::ofstream(ConfigPath) << nlohmann::json{{"path", {{"MediaFiles", (dir / "second").string()}}}}.dump();
+	ASSERT_TRUE(config.FromFile(ConfigPath.string()));
+	ASSERT_NE(cache.store("b", Response({{"Cache-Control", "max-age=100"}})), nullptr);
+	EXPECT_EQ(FileCount(dir / "second/cache/http/meta"), 1);
+	EXPECT_EQ(FileCount(dir / "first/cache/http/meta"), 1);
+
+	// Only the first call subscribes
+	Utils::BotConfig other(nlohmann::json{{"path", {{"MediaFiles", (dir / "third").string()}}}});
+	cache.WatchConfig(other);
+	ASSERT_NE(cache.store("c", Response({{"Cache-Control", "max-age=100"}})), nullptr);
+	EXPECT_FALSE(fs::exists(dir / "third"));
+	EXPECT_EQ(FileCount(dir / "second/cache/http/meta"), 2);
+}
+
+// NOLINTEND
@@ -0,0 +1,184 @@
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <PluginUtils/NetworkUtils.hpp>
+#include <PluginUtils/RateGovernor.hpp>
+
+// NOLINTBEGIN
+
+namespace
+{
+
+using Utils::HttpPool;
+using std::chrono::milliseconds;
+
+// Nothing is sent, so the origins never have to resolve
+std::string Origin(int i)
+{
+	return "http://host" + std::to_string(i) + ".elanor.invalid";
+}
+
+// Answers a single request on 127.0.0.1 with response, returns the origin to send it to
+std::string ServeOnce(std::thread& server, std::string response)
+{
+	int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	sockaddr_in addr{};
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	socklen_t len = sizeof(addr);
+	if (bind(fd, reinterpret_cast<sockaddr*>(&addr), len) < 0 || listen(fd, 1) < 0
+	    || getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) < 0)
+		throw std::runtime_error("Failed to listen on loopback");
+
+	server = std::thread(
+		[fd, response = std::move(response)]
+		{
+			int conn = accept(fd, nullptr, nullptr);
+			close(fd);
+			if (conn < 0) return;
+			std::string head;
+			char c{};
+			while (head.find("\r\n\r\n") == std::string::npos && recv(conn, &c, 1, 0) == 1)
+				head += c;
+			send(conn, response.data(), response.size(), MSG_NOSIGNAL);
+			close(conn);
+		});
+	return "http://127.0.0.1:" + std::to_string(ntohs(addr.sin_port));
+}
+
+} // namespace
+
+TEST(HttpPoolTest, ReleasedConnectionIsReused)
+{
+	HttpPool pool;
+	const httplib::Client* first = nullptr;
+	{
+		auto lease = pool.acquire(Origin(0));
+		first = &*lease;
+	}
+	auto lease = pool.acquire(Origin(0));
+	EXPECT_EQ(&*lease, first);
+
+	// A second lease of the same host gets its own connection
+	auto other = pool.acquire(Origin(0));
+	EXPECT_NE(&*other, first);
+}
+
+TEST(HttpPoolTest, AcquireTimesOutWhenAllConnectionsAreLeased)
+{
+	HttpPool pool;
+	pool.SetHostOptions(Origin(0), {.MaxConnections = 1, .AcquireTimeout = milliseconds(100)});
+
+	auto lease = pool.acquire(Origin(0));
+	const auto start = std::chrono::steady_clock::now();
+	EXPECT_THROW(pool.acquire(Origin(0)), std::runtime_error);
+	EXPECT_GE(std::chrono::steady_clock::now() - start, milliseconds(100));
+	EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(2));
+
+	// Other hosts are not affected
+	EXPECT_NO_THROW(pool.acquire(Origin(1)));
+
+	lease.release();
+	EXPECT_NO_THROW(pool.acquire(Origin(0)));
+}
+
+TEST(HttpPoolTest, WaiterGetsReleasedConnection)
+{
+	HttpPool pool;
+	pool.SetHostOptions(Origin(0), {.MaxConnections = 1});
+
+	auto lease = pool.acquire(Origin(0));
+	const httplib::Client* first = &*lease;
+	std::thread releaser(
+		[&lease]
+		{
+			std::this_thread::sleep_for(milliseconds(50));
+			lease.release();
+		});
+	auto next = pool.acquire(Origin(0));
+	releaser.join();
+	EXPECT_EQ(&*next, first);
+}
+
+TEST(HttpPoolTest, HostsWithoutConnectionsAreForgotten)
+{
+	HttpPool pool;
+	pool.SetHostOptions(Origin(0), {.IdleTimeout = std::chrono::seconds(0)});
+
+	pool.acquire(Origin(1));
+	pool.acquire(Origin(0));
+	EXPECT_EQ(pool.size(), 2);
+
+	// The idle connection of host 0 expires at once, so the next acquire forgets the host.
+	// Host 1 keeps its connection
+	pool.acquire(Origin(2));
+	EXPECT_EQ(pool.size(), 2);
+
+	// Leased hosts are kept no matter what
+	auto lease = pool.acquire(Origin(0));
+	pool.clear();
+	pool.acquire(Origin(3));
+	EXPECT_EQ(pool.size(), 2);
+}
+
+TEST(HttpPoolTest, NumberOfHostsIsCapped)
+{
+	HttpPool pool;
+	auto lease = pool.acquire(Origin(0));
+	const httplib::Client* first = &*lease;
+	for (int i = 1; i < static_cast<int>(HttpPool::MAX_HOSTS) * 2; i++)
+		pool.acquire(Origin(i));
+	EXPECT_LE(pool.size(), HttpPool::MAX_HOSTS);
+
+	// The least recently used hosts went first, the newest ones still have their connection
+	const auto last = Origin(static_cast<int>(HttpPool::MAX_HOSTS) * 2 - 1);
+	const httplib::Client* newest = nullptr;
+	{
+		auto again = pool.acquire(last);
+		newest = &*again;
+	}
+	EXPECT_EQ(&*pool.acquire(last), newest);
+
+	lease.release();
+	EXPECT_EQ(&*pool.acquire(Origin(0)), first);
+}
+
+TEST(HttpPoolTest, CallerLoggerRunsAlongRateReporting)
+{
+	std::thread server;
+	const auto origin = ServeOnce(
+		server, "HTTP/1.1 429 Too Many Requests\r\nRetry-After: 0\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+
+	HttpPool pool;
+	{
+		auto lease = pool.acquire(origin);
+		int logged = 0;
+		lease.set_logger([&logged](const httplib::Request&, const httplib::Response& res) { logged += res.status; });
+		auto result = lease->Get("/");
+		server.join();
+		ASSERT_TRUE(result);
+		EXPECT_EQ(result->status, 429);
+		EXPECT_EQ(logged, 429);
+	}
+
+	// The response still reached RateGovernor
+	bool found = false;
+	for (const auto& stats : Utils::RateGovernor::GetInstance().GetStats())
+	{
+		if (stats.origin != origin) continue;
+		found = true;
+		EXPECT_EQ(stats.throttled, 1);
+		EXPECT_DOUBLE_EQ(stats.rate, Utils::RateGovernor::THROTTLED_RATE / 2);
+	}
+	EXPECT_TRUE(found);
+}
+
+// NOLINTEND
@@ -0,0 +1,222 @@
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include <httplib.h>
+#include <nlohmann/json.hpp>
+
+#include <PluginUtils/JsonStream.hpp>
+#include <PluginUtils/NetworkUtils.hpp>
+
+// NOLINTBEGIN
+
+namespace
+{
+
+using json = nlohmann::json;
+
+const std::string DOCUMENT = R"({
+	"illusts": [
+		{"id": 1, "title": "a\"b", "tags": [{"name": "\u6771\u65b9"}], "ratio": 1.5e0},
+		{"id": 18446744073709551615, "title": "", "tags": [], "ratio": -0.25}
+	],
+	"next_url": null,
+	"a/b": {"c~d": [true, false]},
+	"nested": {"deep": {"value": [1, [2, [3]]]}}
+})";
+
+// Answers like httplib: the handler sees the status, then the body arrives in chunks of chunk bytes,
+// a receiver returning false cancels the request
+Utils::StreamingRequest Serve(std::string body, std::size_t chunk, int status = 200)
+{
+	return [body = std::move(body), chunk, status](httplib::ResponseHandler handler, httplib::ContentReceiver receiver)
+	{
+		auto response = std::make_unique<httplib::Response>();
+		response->status = status;
+		handler(*response);
+		for (std::size_t i = 0; i < body.size(); i += chunk)
+			if (!receiver(body.data() + i, std::min(chunk, body.size() - i)))
+				return httplib::Result(nullptr, httplib::Error::Canceled);
+		return httplib::Result(std::move(response), httplib::Error::Success);
+	};
+}
+
+json Selected(const std::string& body, std::vector<std::string> pointers = {})
+{
+	std::istringstream in(body);
+	return Utils::ParseJsonSelected(in, std::move(pointers));
+}
+
+json RandomValue(std::mt19937& gen, int depth)
+{
+	const std::vector<std::string> strings = {"", "plain", "quote\"", "back\\slash", "tab\t", "new\nline",
+	                                          "\xe4\xb8\xad\xe6\x96\x87", "\xf0\x9f\x98\x80", "/slash", "~tilde"};
+	switch (std::uniform_int_distribution<int>(0, depth > 3 ? 5 : 7)(gen))
+	{
+	case 0:
+		return nullptr;
+	case 1:
+		return std::bernoulli_distribution()(gen);
+	case 2:
+		return std::uniform_int_distribution<long long>(-1'000'000'000'000LL, 1'000'000'000'000LL)(gen);
+	case 3:
+		return std::uniform_int_distribution<unsigned long long>()(gen);
+	case 4:
+		return std::uniform_real_distribution<double>(-1e6, 1e6)(gen);
+	case 5:
+		return strings[std::uniform_int_distribution<std::size_t>(0, strings.size() - 1)(gen)];
+	case 6:
+	{
+		json array = json::array();
+		for (int i = std::uniform_int_distribution<int>(0, 4)(gen); i > 0; i--)
+			array.push_back(RandomValue(gen, depth + 1));
+		return array;
+	}
+	default:
+	{
+		json object = json::object();
+		for (int i = std::uniform_int_distribution<int>(0, 4)(gen); i > 0; i--)
+			object[strings[std::uniform_int_distribution<std::size_t>(0, strings.size() - 1)(gen)] + std::to_string(i)] =
+				RandomValue(gen, depth + 1);
+		return object;
+	}
+	}
+}
+
+} // namespace
+
+TEST(JsonStreamTest, SelectorKeepsWholeDocumentWithoutPointers)
+{
+	EXPECT_EQ(Selected(DOCUMENT), json::parse(DOCUMENT));
+}
+
+TEST(JsonStreamTest, SelectorKeepsOnlySelectedValues)
+{
+	const auto full = json::parse(DOCUMENT);
+	const auto result = Selected(DOCUMENT, {"/illusts", "/next_url"});
+	EXPECT_EQ(result, (json{{"illusts", full["illusts"]}, {"next_url", nullptr}}));
+}
+
+TEST(JsonStreamTest, SelectorKeepsLayoutOfNestedPointers)
+{
+	const auto result = Selected(DOCUMENT, {"/nested/deep/value/1", "/illusts/0/tags"});
+	EXPECT_EQ(result.at(json::json_pointer("/nested/deep/value/1")), json::parse("[2, [3]]"));
+	EXPECT_EQ(result.at(json::json_pointer("/illusts/0/tags/0/name")), "\xe6\x9d\xb1\xe6\x96\xb9");
+	// Earlier array elements are padded with null so the index stays the same
+	EXPECT_TRUE(result.at(json::json_pointer("/nested/deep/value/0")).is_null());
+	EXPECT_FALSE(result["illusts"][0].contains("id"));
+}
+
+TEST(JsonStreamTest, SelectorUnescapesPointerTokens)
+{
+	const auto result = Selected(DOCUMENT, {"/a~1b/c~0d"});
+	EXPECT_EQ(result, json::parse(R"({"a/b": {"c~d": [true, false]}})"));
+}
+
+TEST(JsonStreamTest, SelectorIgnoresMissingPointers)
+{
+	EXPECT_TRUE(Selected(DOCUMENT, {"/missing", "/illusts/5"}).is_null());
+}
+
+TEST(JsonStreamTest, SelectorKeepsNumberTypes)
+{
+	const auto result = Selected(DOCUMENT, {"/illusts"});
+	EXPECT_TRUE(result["illusts"][0]["id"].is_number_unsigned());
+	EXPECT_EQ(result["illusts"][1]["id"].get<unsigned long long>(), 18446744073709551615ULL);
+	EXPECT_DOUBLE_EQ(result["illusts"][1]["ratio"].get<double>(), -0.25);
+}
+
+TEST(JsonStreamTest, SelectorThrowsOnMalformedInput)
+{
+	EXPECT_THROW(Selected(R"({"a": [1, 2})"), Utils::ParseError);
+	EXPECT_THROW(Selected(R"({"a" 1})"), Utils::ParseError);
+}
+
+TEST(JsonStreamTest, StreamingMatchesSelectorForEveryChunkSize)
+{
+	const std::vector<std::string> pointers = {"/illusts", "/a~1b", "/nested/deep/value/1"};
+	const auto expected = Selected(DOCUMENT, pointers);
+	for (std::size_t chunk = 1; chunk <= DOCUMENT.size(); chunk++)
+		ASSERT_EQ(Utils::GetJsonStreaming(Serve(DOCUMENT, chunk), pointers), expected) << "chunk " << chunk;
+}
+
+TEST(JsonStreamTest, StreamingMatchesJsonParse)
+{
+	std::mt19937 gen(42);
+	for (int i = 0; i < 500; i++)
+	{
+		const auto value = RandomValue(gen, 0);
+		const auto text = value.dump(i % 2 ? 1 : -1);
+		const std::size_t chunk = std::uniform_int_distribution<std::size_t>(1, 16)(gen);
+		ASSERT_EQ(Utils::GetJsonStreaming(Serve(text, chunk)), json::parse(text)) << text;
+	}
+}
+
+TEST(JsonStreamTest, StreamingTopLevelScalars)
+{
+	EXPECT_EQ(Utils::GetJsonStreaming(Serve("42", 1)), 42);
+	EXPECT_EQ(Utils::GetJsonStreaming(Serve(" -1.5e3 ", 2)), -1500.0);
+	EXPECT_EQ(Utils::GetJsonStreaming(Serve("\"s\"", 1)), "s");
+	EXPECT_EQ(Utils::GetJsonStreaming(Serve("true", 3)), true);
+}
+
+TEST(JsonStreamTest, StreamingRejectsMalformedBodies)
+{
+	const std::vector<std::string> bodies = {
+		"",       "{",           "[1, 2",       R"({"a": 1,})", "[1 2]",      R"({"a" 1})", R"({1: 2})", "[1]]",
+		"[1] x",  "tru",         "nul",         "01",           "-",          "1.",         "[\"a]",     "{\"a\":}",
+		"[,1]",   R"({"a":1}})", "\"\\x\"",     "[}",           R"({"a"])",   "truex",
+	};
+	for (const auto& body : bodies)
+		for (std::size_t chunk : {std::size_t(1), std::size_t(64)})
+			EXPECT_THROW(Utils::GetJsonStreaming(Serve(body, chunk)), Utils::ParseError) << body << " chunk " << chunk;
+}
+
+TEST(JsonStreamTest, StreamingStopsReceivingAfterParseError)
+{
+	std::size_t received = 0;
+	const std::string body = "[1, x" + std::string(1000, ' ') + "]";
+	auto request = [&](httplib::ResponseHandler handler, httplib::ContentReceiver receiver)
+	{
+		httplib::Response response;
+		response.status = 200;
+		handler(response);
+		for (std::size_t i = 0; i < body.size(); i++)
+		{
+			received++;
+			if (!receiver(body.data() + i, 1)) return httplib::Result(nullptr, httplib::Error::Canceled);
+		}
+		return httplib::Result(std::make_unique<httplib::Response>(response), httplib::Error::Success);
+	};
+	EXPECT_THROW(Utils::GetJsonStreaming(request), Utils::ParseError);
+	EXPECT_EQ(received, 5);
+}
+
+TEST(JsonStreamTest, StreamingKeepsErrorBody)
+{
+	try
+	{
+		Utils::GetJsonStreaming(Serve(R"({"error": "rate limited"})", 4, 403));
+		FAIL() << "Expected NetworkException";
+	}
+	catch (const Utils::NetworkException& e)
+	{
+		EXPECT_EQ(e._code, 403);
+		EXPECT_EQ(e._body, R"({"error": "rate limited"})");
+	}
+}
+
+TEST(JsonStreamTest, StreamingReportsConnectionErrors)
+{
+	auto request = [](httplib::ResponseHandler, httplib::ContentReceiver receiver)
+	{
+		receiver("[1, ", 4);
+		return httplib::Result(nullptr, httplib::Error::Connection);
+	};
+	EXPECT_THROW(Utils::GetJsonStreaming(request), Utils::NetworkException);
+}
+
+// NOLINTEND
@@ -0,0 +1,185 @@
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include <PluginUtils/LruCache.hpp>
+
+// NOLINTBEGIN
+
+namespace
+{
+
+using Cache = Utils::LruCache<std::string, int>;
+using std::chrono::milliseconds;
+
+} // namespace
+
+TEST(LruCacheTest, GetReturnsStoredValues)
+{
+	Cache cache(4);
+	EXPECT_FALSE(cache.get("a"));
+	cache.put("a", 1);
+	cache.put("b", 2);
+	EXPECT_EQ(cache.get("a"), 1);
+	EXPECT_EQ(cache.get("b"), 2);
+	EXPECT_EQ(cache.size(), 2);
+}
+
+TEST(LruCacheTest, EvictsLeastRecentlyUsed)
+{
+	Cache cache(3);
+	cache.put("a", 1);
+	cache.put("b", 2);
+	cache.put("c", 3);
+
+	// Reading a makes b the oldest
+	EXPECT_EQ(cache.get("a"), 1);
+	cache.put("d", 4);
+	EXPECT_FALSE(cache.get("b"));
+	EXPECT_EQ(cache.get("a"), 1);
+	EXPECT_EQ(cache.get("c"), 3);
+	EXPECT_EQ(cache.get("d"), 4);
+
+	// Order is now a, c, d from oldest to newest
+	cache.put("e", 5);
+	EXPECT_FALSE(cache.get("a"));
+	cache.put("f", 6);
+	EXPECT_FALSE(cache.get("c"));
+	EXPECT_EQ(cache.size(), 3);
+}
+
+TEST(LruCacheTest, ReplacingKeyUpdatesValueCostAndOrder)
+{
+	Cache cache(3);
+	cache.put("a", 1, {}, 2);
+	cache.put("b", 2);
+	cache.put("a", 10, {}, 1);
+	EXPECT_EQ(cache.get("a"), 10);
+	EXPECT_EQ(cache.size(), 2);
+
+	// Only the new cost of a counts, so c still fits
+	cache.put("c", 3);
+	EXPECT_EQ(cache.get("b"), 2);
+	EXPECT_EQ(cache.size(), 3);
+
+	// Replacing moves a to the front, c is the oldest now
+	cache.put("a", 11);
+	cache.put("d", 4);
+	EXPECT_FALSE(cache.get("c"));
+	EXPECT_EQ(cache.get("a"), 11);
+	EXPECT_EQ(cache.get("b"), 2);
+}
+
+TEST(LruCacheTest, CostOverCapacityIsNotStored)
+{
+	Cache cache(4);
+	cache.put("a", 1);
+	cache.put("b", 2);
+	cache.put("big", 3, {}, 5);
+	EXPECT_FALSE(cache.get("big"));
+	// Nothing was evicted for it
+	EXPECT_EQ(cache.get("a"), 1);
+	EXPECT_EQ(cache.get("b"), 2);
+
+	// Replacing with an entry that does not fit drops the old one
+	cache.put("a", 10, {}, 5);
+	EXPECT_FALSE(cache.get("a"));
+	EXPECT_EQ(cache.size(), 1);
+}
+
+TEST(LruCacheTest, CostlyEntryEvictsSeveral)
+{
+	Cache cache(4);
+	cache.put("a", 1);
+	cache.put("b", 2);
+	cache.put("c", 3);
+	cache.put("d", 4);
+	cache.put("big", 5, {}, 3);
+	EXPECT_FALSE(cache.get("a"));
+	EXPECT_FALSE(cache.get("b"));
+	EXPECT_FALSE(cache.get("c"));
+	EXPECT_EQ(cache.get("d"), 4);
+	EXPECT_EQ(cache.get("big"), 5);
+
+	// Exactly at capacity is allowed
+	cache.put("full", 6, {}, 4);
+	EXPECT_EQ(cache.get("full"), 6);
+	EXPECT_EQ(cache.size(), 1);
+}
+
+TEST(LruCacheTest, EntriesExpire)
+{
+	Cache cache(4, milliseconds(50));
+	cache.put("a", 1);
+	cache.put("forever", 2, Cache::clock::duration::zero());
+	cache.put("long", 3, std::chrono::hours(1));
+	EXPECT_EQ(cache.get("a"), 1);
+
+	std::this_thread::sleep_for(milliseconds(80));
+	// Expired entries stay until they are looked up
+	EXPECT_EQ(cache.size(), 3);
+	EXPECT_FALSE(cache.get("a"));
+	EXPECT_EQ(cache.size(), 2);
+	EXPECT_EQ(cache.get("forever"), 2);
+	EXPECT_EQ(cache.get("long"), 3);
+
+	// Storing again starts a new lifetime
+	cache.put("a", 4);
+	EXPECT_EQ(cache.get("a"), 4);
+}
+
+TEST(LruCacheTest, ZeroTtlNeverExpires)
+{
+	Cache cache(4);
+	cache.put("a", 1);
+	std::this_thread::sleep_for(milliseconds(20));
+	EXPECT_EQ(cache.get("a"), 1);
+}
+
+TEST(LruCacheTest, EraseAndClear)
+{
+	Cache cache(2);
+	cache.put("a", 1);
+	cache.put("b", 2);
+	cache.erase("a");
+	cache.erase("missing");
+	EXPECT_FALSE(cache.get("a"));
+	EXPECT_EQ(cache.size(), 1);
+
+	// The erased cost is given back
+	cache.put("c", 3);
+	EXPECT_EQ(cache.get("b"), 2);
+
+	cache.clear();
+	EXPECT_EQ(cache.size(), 0);
+	cache.put("d", 4, {}, 2);
+	EXPECT_EQ(cache.get("d"), 4);
+}
+
+TEST(LruCacheTest, ConcurrentAccess)
+{
+	Utils::LruCache<int, std::shared_ptr<const std::string>> cache(64);
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; t++)
+		threads.emplace_back(
+			[&cache, t]
+			{
+				for (int i = 0; i < 2000; i++)
+				{
+					const int key = (i * 7 + t) % 100;
+					if (auto value = cache.get(key))
+						EXPECT_EQ(**value, std::to_string(key));
+					else
+						cache.put(key, std::make_shared<const std::string>(std::to_string(key)));
+					if (i % 100 == 0) cache.erase(key);
+				}
+			});
+	for (auto& thread : threads)
+		thread.join();
+	EXPECT_LE(cache.size(), 64);
+}
+
+// NOLINTEND
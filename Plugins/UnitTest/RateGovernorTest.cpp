@@ -0,0 +1,219 @@
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include <PluginUtils/RateGovernor.hpp>
+
+// NOLINTBEGIN
+
+namespace
+{
+
+using Utils::RateGovernor;
+using clock_type = RateGovernor::clock;
+using std::chrono::milliseconds;
+
+constexpr auto SLACK = milliseconds(20);
+
+// Admission times of count requests taken back to back, the permits are kept so MaxConcurrent does not interfere
+std::vector<clock_type::time_point> Admit(RateGovernor& governor, const std::string& origin, std::size_t count,
+                                          std::vector<RateGovernor::Permit>& permits)
+{
+	std::vector<clock_type::time_point> starts;
+	for (std::size_t i = 0; i < count; i++)
+		governor.acquire(origin, [&](RateGovernor::Permit permit, clock_type::time_point start)
+		                 {
+							 permits.push_back(std::move(permit));
+							 starts.push_back(start);
+						 });
+	return starts;
+}
+
+double Rate(RateGovernor& governor, const std::string& origin)
+{
+	for (const auto& stats : governor.GetStats())
+		if (stats.origin == origin) return stats.rate;
+	ADD_FAILURE() << "No stats for " << origin;
+	return -1;
+}
+
+} // namespace
+
+TEST(RateGovernorTest, UnlimitedHostIsNotDelayed)
+{
+	RateGovernor governor;
+	std::vector<RateGovernor::Permit> permits;
+	const auto now = clock_type::now();
+	for (const auto& start : Admit(governor, "http://a", 20, permits))
+		EXPECT_LT(start - now, SLACK);
+}
+
+TEST(RateGovernorTest, GcraAllowsBurstThenOnePerInterval)
+{
+	RateGovernor governor;
+	governor.SetLimits("http://a", {.RequestsPerSecond = 10, .burst = 3});
+	std::vector<RateGovernor::Permit> permits;
+
+	const auto now = clock_type::now();
+	const auto starts = Admit(governor, "http://a", 6, permits);
+	ASSERT_EQ(starts.size(), 6);
+
+	const auto interval = milliseconds(100);
+	for (std::size_t i = 0; i < 3; i++)
+		EXPECT_LT(starts[i] - now, SLACK) << i;
+	for (std::size_t i = 3; i < starts.size(); i++)
+	{
+		const auto expected = interval * static_cast<int>(i - 2);
+		EXPECT_GE(starts[i] - now, expected - SLACK) << i;
+		EXPECT_LT(starts[i] - now, expected + SLACK) << i;
+	}
+}
+
+TEST(RateGovernorTest, GcraRefillsWhileIdle)
+{
+	RateGovernor governor;
+	governor.SetLimits("http://a", {.RequestsPerSecond = 20, .burst = 2});
+	std::vector<RateGovernor::Permit> permits;
+	Admit(governor, "http://a", 2, permits);
+
+	// Two intervals without requests earn the burst back
+	std::this_thread::sleep_for(milliseconds(110));
+	const auto now = clock_type::now();
+	const auto starts = Admit(governor, "http://a", 3, permits);
+	EXPECT_LT(starts[0] - now, SLACK);
+	EXPECT_LT(starts[1] - now, SLACK);
+	EXPECT_GE(starts[2] - now, milliseconds(50) - SLACK);
+}
+
+TEST(RateGovernorTest, MaxConcurrentQueuesInOrder)
+{
+	RateGovernor governor;
+	governor.SetLimits("http://a", {.MaxConcurrent = 1});
+
+	auto first = governor.acquire("http://a");
+	std::vector<int> order;
+	std::vector<RateGovernor::Permit> permits;
+	for (int i = 0; i < 3; i++)
+		governor.acquire("http://a", [&, i](RateGovernor::Permit permit, clock_type::time_point)
+		                 {
+							 order.push_back(i);
+							 permits.push_back(std::move(permit));
+						 });
+	EXPECT_TRUE(order.empty());
+	EXPECT_EQ(governor.GetStats().front().queued, 3);
+
+	// Releasing hands the slot to the oldest waiter, one at a time
+	first.release();
+	ASSERT_EQ(order, std::vector<int>{0});
+	permits.front().release();
+	ASSERT_EQ(order, (std::vector<int>{0, 1}));
+	permits.back().release();
+	ASSERT_EQ(order, (std::vector<int>{0, 1, 2}));
+	EXPECT_EQ(governor.GetStats().front().queued, 0);
+}
+
+TEST(RateGovernorTest, AimdHalvesOnThrottleAndRecoversStepwise)
+{
+	RateGovernor governor;
+	governor.SetLimits("http://a", {.RequestsPerSecond = 10});
+	auto permit = governor.acquire("http://a");
+
+	permit.report(429, "0");
+	EXPECT_DOUBLE_EQ(Rate(governor, "http://a"), 5);
+	permit.report(503, "0");
+	EXPECT_DOUBLE_EQ(Rate(governor, "http://a"), 2.5);
+
+	permit.report(200);
+	EXPECT_NEAR(Rate(governor, "http://a"), 2.5 + RateGovernor::RATE_STEP, 1e-9);
+
+	// Never above the configured rate
+	for (int i = 0; i < 200; i++)
+		permit.report(200);
+	EXPECT_DOUBLE_EQ(Rate(governor, "http://a"), 10);
+
+	// Nor below the minimum
+	for (int i = 0; i < 50; i++)
+		permit.report(429, "0");
+	EXPECT_DOUBLE_EQ(Rate(governor, "http://a"), RateGovernor::MIN_RATE);
+}
+
+TEST(RateGovernorTest, AimdUnconfiguredHostIsReleasedAfterRecovery)
+{
+	RateGovernor governor;
+	auto permit = governor.acquire("http://a");
+	EXPECT_EQ(Rate(governor, "http://a"), 0);
+
+	permit.report(429, "0");
+	EXPECT_DOUBLE_EQ(Rate(governor, "http://a"), RateGovernor::THROTTLED_RATE / 2);
+
+	int steps = 0;
+	while (Rate(governor, "http://a") > 0 && steps < 1000)
+	{
+		permit.report(200);
+		steps++;
+	}
+	EXPECT_EQ(Rate(governor, "http://a"), 0);
+	EXPECT_NEAR(steps, (RateGovernor::RECOVERED_RATE - RateGovernor::THROTTLED_RATE / 2) / RateGovernor::RATE_STEP, 2);
+}
+
+TEST(RateGovernorTest, RetryAfterPausesTheHost)
+{
+	RateGovernor governor;
+	auto permit = governor.acquire("http://a");
+	permit.report(429, "2");
+	permit.release();
+
+	std::vector<RateGovernor::Permit> permits;
+	const auto now = clock_type::now();
+	const auto starts = Admit(governor, "http://a", 1, permits);
+	EXPECT_GE(starts.front() - now, std::chrono::seconds(2) - SLACK);
+
+	const auto stats = governor.GetStats().front();
+	EXPECT_EQ(stats.throttled, 1);
+	EXPECT_EQ(stats.requests, 2);
+}
+
+TEST(RateGovernorTest, ReporterOutlivesPermit)
+{
+	RateGovernor governor;
+	governor.SetLimits("http://a", {.RequestsPerSecond = 10});
+	auto permit = governor.acquire("http://a");
+	auto report = permit.reporter();
+	permit.release();
+
+	report(429, "0");
+	EXPECT_DOUBLE_EQ(Rate(governor, "http://a"), 5);
+	EXPECT_EQ(governor.GetStats().front().active, 0);
+}
+
+TEST(RateGovernorTest, IdleHostsWithoutLimitsAreForgotten)
+{
+	RateGovernor governor(milliseconds(50));
+	governor.SetLimits("http://configured", {.RequestsPerSecond = 100});
+	governor.acquire("http://configured");
+	governor.acquire("http://idle");
+	auto held = governor.acquire("http://held");
+	governor.acquire("http://paused").report(429, "60");
+	EXPECT_EQ(governor.GetStats().size(), 4);
+
+	std::this_thread::sleep_for(milliseconds(100));
+	governor.acquire("http://other");
+
+	// Configured hosts keep their state, so do hosts with a permit out or a pause still running
+	std::vector<std::string> origins;
+	for (const auto& stats : governor.GetStats())
+		origins.push_back(stats.origin);
+	std::sort(origins.begin(), origins.end());
+	EXPECT_EQ(origins, (std::vector<std::string>{"http://configured", "http://held", "http://other", "http://paused"}));
+
+	// A forgotten host starts over
+	governor.acquire("http://idle");
+	for (const auto& stats : governor.GetStats())
+		if (stats.origin == "http://idle") EXPECT_EQ(stats.requests, 1);
+}
+
+// NOLINTEND
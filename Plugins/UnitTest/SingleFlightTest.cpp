@@ -0,0 +1,260 @@
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include <PluginUtils/NetworkUtils.hpp>
+#include <PluginUtils/SingleFlight.hpp>
+
+// NOLINTBEGIN
+
+namespace
+{
+
+using Utils::CachePolicy;
+using std::chrono::milliseconds;
+
+constexpr int CALLERS = 8;
+
+// Runs call on CALLERS threads at once. The first call to block() holds everyone until all threads are
+// inside call, so that they all see the same flight
+class Crowd
+{
+protected:
+	std::atomic<int> _arrived = 0;
+	std::promise<void> _release;
+	std::shared_future<void> _released = _release.get_future().share();
+
+public:
+	void block() const { this->_released.wait(); }
+
+	template<typename Func> void run(Func&& call)
+	{
+		std::vector<std::thread> threads;
+		for (int i = 0; i < CALLERS; i++)
+			threads.emplace_back(
+				[this, &call, i]
+				{
+					this->_arrived++;
+					call(i);
+				});
+		while (this->_arrived < CALLERS)
+			std::this_thread::yield();
+		// Arriving is not the same as waiting on the flight yet
+		std::this_thread::sleep_for(milliseconds(100));
+		this->_release.set_value();
+		for (auto& thread : threads)
+			thread.join();
+	}
+};
+
+// A new url on every call, the cache behind FetchGet is process-wide
+std::string Url()
+{
+	return "http://fetch.elanor.invalid/" + std::to_string(std::random_device{}());
+}
+
+httplib::Result Respond(int status, std::string body, httplib::Headers headers = {})
+{
+	auto response = std::make_unique<httplib::Response>();
+	response->status = status;
+	response->reason = status == 200 ? "OK" : "Error";
+	response->body = std::move(body);
+	response->headers = std::move(headers);
+	return httplib::Result(std::move(response), httplib::Error::Success);
+}
+
+const CachePolicy NO_STORE{.mode = CachePolicy::Mode::NO_STORE};
+
+} // namespace
+
+TEST(SingleFlightTest, ConcurrentCallersShareOneCall)
+{
+	Utils::SingleFlight<std::string, std::shared_ptr<int>> flight;
+	Crowd crowd;
+	std::atomic<int> calls = 0;
+	std::vector<std::shared_ptr<int>> results(CALLERS);
+	crowd.run(
+		[&](int i)
+		{
+			results[i] = flight.run("key",
+			                        [&]
+			                        {
+										calls++;
+										crowd.block();
+										return std::make_shared<int>(42);
+									});
+		});
+
+	EXPECT_EQ(calls, 1);
+	for (const auto& result : results)
+	{
+		ASSERT_NE(result, nullptr);
+		EXPECT_EQ(result, results.front());
+	}
+	EXPECT_EQ(*results.front(), 42);
+}
+
+TEST(SingleFlightTest, ExceptionsReachEveryCaller)
+{
+	Utils::SingleFlight<std::string, int> flight;
+	Crowd crowd;
+	std::atomic<int> calls = 0, failures = 0;
+	crowd.run(
+		[&](int)
+		{
+			try
+			{
+				flight.run("key",
+				           [&]() -> int
+				           {
+							   calls++;
+							   crowd.block();
+							   throw std::runtime_error("failed");
+						   });
+			}
+			catch (const std::runtime_error& e)
+			{
+				if (std::string(e.what()) == "failed") failures++;
+			}
+		});
+	EXPECT_EQ(calls, 1);
+	EXPECT_EQ(failures, CALLERS);
+}
+
+TEST(SingleFlightTest, OnlyCallsInFlightAreShared)
+{
+	Utils::SingleFlight<std::string, int> flight;
+	int calls = 0;
+	EXPECT_EQ(flight.run("a", [&] { return ++calls; }), 1);
+	EXPECT_EQ(flight.run("a", [&] { return ++calls; }), 2);
+
+	// Other keys get their own call, even from within a flight
+	EXPECT_EQ(flight.run("a", [&] { return flight.run("b", [&] { return ++calls; }) * 10; }), 30);
+
+	// A failure is not remembered either
+	EXPECT_THROW(flight.run("a", []() -> int { throw std::runtime_error("failed"); }), std::runtime_error);
+	EXPECT_EQ(flight.run("a", [&] { return ++calls; }), 4);
+}
+
+TEST(FetchGetTest, IdenticalRequestsAreSentOnce)
+{
+	Crowd crowd;
+	std::atomic<int> calls = 0;
+	std::vector<std::shared_ptr<const httplib::Response>> results(CALLERS);
+	const auto url = Url();
+	crowd.run(
+		[&](int i)
+		{
+			// Headers outside the key, such as the pixiv client hash, don't split the flight
+			httplib::Headers headers = {{"X-Client-Hash", std::to_string(i)}, {"Accept", "image/*"}};
+			results[i] = Utils::FetchGet(
+				url, headers,
+				[&](const httplib::Headers& request)
+				{
+					calls++;
+					EXPECT_EQ(request.count("If-None-Match"), 0);
+					crowd.block();
+					return Respond(200, "body");
+				},
+				NO_STORE);
+		});
+
+	EXPECT_EQ(calls, 1);
+	for (const auto& result : results)
+	{
+		ASSERT_NE(result, nullptr);
+		EXPECT_EQ(result, results.front());
+	}
+	EXPECT_EQ(results.front()->body, "body");
+}
+
+TEST(FetchGetTest, KeyHeadersSplitTheFlight)
+{
+	Crowd crowd;
+	std::atomic<int> calls = 0;
+	std::vector<std::string> bodies(CALLERS);
+	const auto url = Url();
+	crowd.run(
+		[&](int i)
+		{
+			const std::string range = "bytes=" + std::to_string(i % 2) + "-";
+			bodies[i] = Utils::FetchGet(url, {{"Range", range}},
+			                            [&](const httplib::Headers& request)
+			                            {
+											calls++;
+											crowd.block();
+											return Respond(200, request.find("Range")->second);
+										},
+			                            NO_STORE)
+			                ->body;
+		});
+
+	EXPECT_EQ(calls, 2);
+	for (int i = 0; i < CALLERS; i++)
+		EXPECT_EQ(bodies[i], "bytes=" + std::to_string(i % 2) + "-");
+
+	EXPECT_EQ(Utils::FetchKey("u", {{"Accept", "a"}, {"X-Client-Hash", "1"}}),
+	          Utils::FetchKey("u", {{"Accept", "a"}, {"X-Client-Hash", "2"}}));
+	EXPECT_NE(Utils::FetchKey("u", {{"Accept", "a"}}), Utils::FetchKey("u", {{"Accept", "b"}}));
+	EXPECT_NE(Utils::FetchKey("u", {}), Utils::FetchKey("v", {}));
+}
+
+TEST(FetchGetTest, FailuresReachEveryCaller)
+{
+	Crowd crowd;
+	std::atomic<int> calls = 0, failures = 0;
+	const auto url = Url();
+	crowd.run(
+		[&](int)
+		{
+			try
+			{
+				Utils::FetchGet(
+					url, {},
+					[&](const httplib::Headers&)
+					{
+						calls++;
+						crowd.block();
+						return Respond(503, "busy");
+					});
+			}
+			catch (const Utils::NetworkException& e)
+			{
+				if (e._code == 503) failures++;
+			}
+		});
+	EXPECT_EQ(calls, 1);
+	EXPECT_EQ(failures, CALLERS);
+
+	// Failed requests are not cached
+	EXPECT_EQ(Utils::FetchGet(url, {}, [](const httplib::Headers&) { return Respond(200, "ok"); })->body,
+	          "ok");
+}
+
+TEST(FetchGetTest, LaterCallersAreServedFromTheCache)
+{
+	int calls = 0;
+	auto fetch = [&calls](const httplib::Headers&)
+	{
+		calls++;
+		return Respond(200, "cached", {{"Cache-Control", "max-age=100"}});
+	};
+	const auto url = Url();
+	auto first = Utils::FetchGet(url, {}, fetch);
+	auto second = Utils::FetchGet(url, {}, fetch);
+	EXPECT_EQ(calls, 1);
+	EXPECT_EQ(second->body, "cached");
+
+	// Unless the policy bypasses the cache
+	Utils::FetchGet(url, {}, fetch, NO_STORE);
+	EXPECT_EQ(calls, 2);
+}
+
+// NOLINTEND
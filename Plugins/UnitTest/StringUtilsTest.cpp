@@ -0,0 +1,259 @@
+#include <algorithm>
+#include <array>
+#include <random>
+#include <iomanip>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include <PluginUtils/SimplePattern.hpp>
+#include <PluginUtils/StringUtils.hpp>
+
+// NOLINTBEGIN
+
+namespace
+{
+
+// ReplaceMark as it was before the single pass version, one search pass per mark
+std::string ReplaceMarkReference(std::string str)
+{
+	using std::string_view;
+	using std::string;
+
+	constexpr std::array<std::pair<string_view, string_view>, 12> MarkList{{
+		{"﹟", "#"},
+		{"？", "?"},
+		{"＃", "#"},
+		{"！", "!"},
+		{"。", "."},
+		{"，", ","},
+		{"“", "\""},
+		{"”", "\""},
+		{"‘", "\'"},
+		{"’", "\'"},
+		{"；", ";"},
+		{"：", ":"}
+	}};
+	for (const auto& p : MarkList)
+	{
+		string temp;
+		temp.reserve(str.size());
+		const auto end = str.end();
+		auto current = str.begin();
+		auto next = std::search(current, end, p.first.begin(), p.first.end());
+		while (next != end)
+		{
+			temp.append(current, next);
+			temp.append(p.second);
+			current = next + static_cast<long>(p.first.length());
+			next = std::search(current, end, p.first.begin(), p.first.end());
+		}
+		temp.append(current, next);
+		str.swap(temp);
+	}
+	return str;
+}
+
+// Tokenize is meant to split exactly like reading std::quoted from a stream
+std::vector<std::string> QuotedReference(const std::string& input)
+{
+	std::vector<std::string> tokens;
+	std::istringstream iss(input);
+	std::string s;
+	while (iss >> std::quoted(s))
+		tokens.push_back(s);
+	return tokens;
+}
+
+}
+
+TEST(StringUtilsTest, ReplaceMarkTest)
+{
+	EXPECT_EQ(Utils::ReplaceMark(""), "");
+	EXPECT_EQ(Utils::ReplaceMark("#pixiv id 1234"), "#pixiv id 1234");
+	EXPECT_EQ(Utils::ReplaceMark("＃pixiv id 1234"), "#pixiv id 1234");
+	EXPECT_EQ(Utils::ReplaceMark("﹟choyen “5000兆円” ‘欲しい！’"), "#choyen \"5000兆円\" \'欲しい!\'");
+	EXPECT_EQ(Utils::ReplaceMark("好的，知道了。真的？；："), "好的,知道了.真的?;:");
+	// Truncated and misaligned sequences
+	EXPECT_EQ(Utils::ReplaceMark("\xEF\xBC"), "\xEF\xBC");
+	EXPECT_EQ(Utils::ReplaceMark("\xE3\xEF\xBC\x9F"), "\xE3?");
+	// Long runs without marks for the vectorized path
+	std::string ascii(100, 'a');
+	EXPECT_EQ(Utils::ReplaceMark(ascii + "，" + ascii + "。"), ascii + "," + ascii + ".");
+	std::string cjk;
+	for (int i = 0; i < 20; i++)
+		cjk += "今天的活动好难打啊";
+	EXPECT_EQ(Utils::ReplaceMark(cjk + "！" + cjk), cjk + "!" + cjk);
+}
+
+TEST(StringUtilsTest, ReplaceMarkDifferentialTest)
+{
+	// Marks, their prefixes, other multi-byte characters, stray bytes and ASCII
+	const std::array<std::string_view, 24> pieces = {
+		"﹟", "？", "＃", "！", "。", "，", "“", "”", "‘", "’", "；", "：",
+		"\xEF\xBC", "\xE2\x80", "\xE3", "\x80", "\xBC\x9F",
+		"好", "円", "—", "a", "#", " ", "0123456789abcdefghijklmnopqrstuv"
+	};
+
+	std::mt19937 rng(42);
+	for (int iter = 0; iter < 20000; iter++)
+	{
+		std::string input;
+		const int count = rng() % 40;
+		for (int i = 0; i < count; i++)
+			input += pieces[rng() % pieces.size()];
+		ASSERT_EQ(Utils::ReplaceMark(input), ReplaceMarkReference(input)) << input;
+	}
+
+	// Random bytes biased towards the lead and continuation bytes of the marks
+	const std::array<unsigned char, 12> bytes = {0xEF, 0xE2, 0xE3, 0xBC, 0xB9, 0x80, 0x9F, 0x83, 0x9C, 0x82, 'a', ' '};
+	for (int iter = 0; iter < 20000; iter++)
+	{
+		std::string input;
+		const int count = rng() % 64;
+		for (int i = 0; i < count; i++)
+			input += static_cast<char>(bytes[rng() % bytes.size()]);
+		ASSERT_EQ(Utils::ReplaceMark(input), ReplaceMarkReference(input));
+	}
+}
+
+TEST(StringUtilsTest, TokenizeTest)
+{
+	std::vector<std::string> tokens;
+	EXPECT_EQ(Utils::Tokenize(R"(#pixiv  id "a \"b\"" c)", tokens), 4);
+	EXPECT_EQ(tokens, (std::vector<std::string>{"#pixiv", "id", R"(a "b")", "c"}));
+
+	tokens.clear();
+	EXPECT_EQ(Utils::Tokenize("#choyen a b c", tokens, 2), 2);
+	EXPECT_EQ(tokens, (std::vector<std::string>{"#choyen", "a b c"}));
+
+	Utils::TokenList<2> head("  #pixiv id 1234");
+	EXPECT_EQ(head.size(), 2);
+	EXPECT_EQ(head[0], "#pixiv");
+	EXPECT_EQ(head[1], "id");
+	EXPECT_FALSE(head.exact());
+	EXPECT_THROW(head[2], std::out_of_range);
+
+	Utils::TokenList<2> single("#pixiv ");
+	EXPECT_EQ(single.size(), 1);
+	EXPECT_TRUE(single.exact());
+	EXPECT_TRUE(Utils::TokenList<2>("  ").empty());
+
+	// Escaped tokens that do not fit in the buffer are kept with their escapes
+	Utils::TokenList<2, 4> small(R"("a\"b" "long\"er")");
+	EXPECT_EQ(small[0], R"(a"b)");
+	EXPECT_EQ(small[1], R"(long\"er)");
+	EXPECT_FALSE(small.exact());
+}
+
+TEST(StringUtilsTest, TokenizeDifferentialTest)
+{
+	constexpr std::size_t MAX_TOKENS = 4;
+	constexpr std::size_t BUFFER_SIZE = 8;
+	const std::array<char, 11> alphabet = {'a', 'B', ' ', '\t', '\n', '"', '\\', '\v', '\r', 'x', '\xe4'};
+
+	std::mt19937 rng(1);
+	for (int iter = 0; iter < 100000; iter++)
+	{
+		std::string input;
+		const int count = rng() % 16;
+		for (int i = 0; i < count; i++)
+			input += alphabet[rng() % alphabet.size()];
+		const auto expected = QuotedReference(input);
+
+		std::vector<std::string> tokens;
+		ASSERT_EQ(Utils::Tokenize(input, tokens), expected.size()) << input;
+		ASSERT_EQ(tokens, expected) << input;
+
+		std::vector<std::string> capped;
+		std::vector<std::string> ExpectedCapped;
+		Utils::Tokenize(input, capped, 2);
+		for (const auto& token : expected)
+		{
+			if (ExpectedCapped.size() >= 2)
+				ExpectedCapped[1] += ' ' + token;
+			else
+				ExpectedCapped.push_back(token);
+		}
+		ASSERT_EQ(capped, ExpectedCapped) << input;
+
+		Utils::TokenList<MAX_TOKENS, BUFFER_SIZE> list(input);
+		ASSERT_EQ(list.size(), std::min(expected.size(), MAX_TOKENS)) << input;
+		bool same = expected.size() <= MAX_TOKENS;
+		for (std::size_t i = 0; i < list.size(); i++)
+			same = same && list[i] == expected[i];
+		ASSERT_EQ(list.exact(), same) << input;
+	}
+}
+
+TEST(StringUtilsTest, NumberValidatorTest)
+{
+	EXPECT_TRUE(Utils::isUInt("0123"));
+	EXPECT_FALSE(Utils::isUInt("+1"));
+	EXPECT_TRUE(Utils::isInt("-42"));
+	EXPECT_TRUE(Utils::isInt("+99999999999999999999999"));
+	EXPECT_FALSE(Utils::isInt("-"));
+	EXPECT_FALSE(Utils::isInt("1e3"));
+	EXPECT_TRUE(Utils::isHex("0xDEADbeef"));
+	EXPECT_TRUE(Utils::isHex("-ff"));
+	EXPECT_FALSE(Utils::isHex("0x"));
+	EXPECT_FALSE(Utils::isHex("0xg"));
+	EXPECT_TRUE(Utils::isFloat("1."));
+	EXPECT_TRUE(Utils::isFloat(".5"));
+	EXPECT_FALSE(Utils::isFloat("."));
+	EXPECT_FALSE(Utils::isFloat("-1.5"));
+
+	// Same results as the regular expressions they replace
+	const std::regex r_float(R"((?:\d+(?:\.\d*)?|\.\d+))");
+	const std::regex r_int(R"([\+-]?\d+)");
+	const std::regex r_hex(R"([\+-]?(?:0[xX])?[0-9a-fA-F]+)");
+	const std::string_view alphabet = "0123456789+-.xXaFg ";
+	std::mt19937 rng(7);
+	for (int iter = 0; iter < 50000; iter++)
+	{
+		std::string input;
+		const int count = rng() % 8;
+		for (int i = 0; i < count; i++)
+			input += alphabet[rng() % alphabet.size()];
+		ASSERT_EQ(Utils::isFloat(input), std::regex_match(input, r_float)) << input;
+		ASSERT_EQ(Utils::isInt(input), std::regex_match(input, r_int)) << input;
+		ASSERT_EQ(Utils::isHex(input), std::regex_match(input, r_hex)) << input;
+	}
+}
+
+TEST(StringUtilsTest, SimplePatternTest)
+{
+	Utils::SimplePattern card(R"(^character/member/res\d+_no\d+$)");
+	EXPECT_TRUE(card.compiled());
+	EXPECT_TRUE(card.match("character/member/res001_no021"));
+	EXPECT_FALSE(card.match("character/member/res001_no"));
+	EXPECT_FALSE(card.match("character/member/res001_no021_rip"));
+	EXPECT_FALSE(Utils::SimplePattern("[ab]+").compiled());
+	EXPECT_THROW(Utils::SimplePattern("*"), std::regex_error);
+
+	const std::array<std::string, 16> patterns = {
+		"a*b", "a+b?c*", ".*", "", "$", "live2d/.*", R"(a\.b)", R"(a\$)",
+		"a.c", R"(\d*x\d?)", "ab*ab", "a.*b.*a", R"(a\\$)", "x?y?z?", "(a|b)*", "[ab]+"
+	};
+	const std::string_view alphabet = "ab.c$x\\09/_\nz";
+	std::mt19937 rng(3);
+	for (const auto& pattern : patterns)
+	{
+		Utils::SimplePattern compiled(pattern);
+		const std::regex regex(pattern, std::regex::ECMAScript);
+		for (int iter = 0; iter < 5000; iter++)
+		{
+			std::string input;
+			const int count = rng() % 10;
+			for (int i = 0; i < count; i++)
+				input += alphabet[rng() % alphabet.size()];
+			ASSERT_EQ(compiled.match(input), std::regex_match(input, regex)) << pattern << " " << input;
+		}
+	}
+}
+
+// NOLINTEND
@@ -0,0 +1,212 @@
+#include <chrono>
+#include <filesystem>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include <sys/wait.h>
+
+#include <PluginUtils/Subprocess.hpp>
+
+// NOLINTBEGIN
+
+namespace
+{
+
+using Utils::Subprocess;
+using Utils::SubprocessError;
+using Utils::WorkerPool;
+
+// Serves requests through pymodules/worker.py, the request picks what the handler does
+const std::string HANDLER = R"(
+import os, sys, time
+sys.path.insert(0, sys.argv[1])
+import worker
+
+def handle(request):
+	if request == b"pid":
+		return str(os.getpid()).encode()
+	if request == b"fail":
+		raise ValueError("bad request")
+	if request == b"crash":
+		os._exit(3)
+	if request == b"sleep":
+		time.sleep(5)
+	if request == b"noise":
+		print("stray output")
+		sys.stdout.flush()
+	return request[::-1]
+
+worker.serve(handle)
+)";
+
+std::vector<std::string> WorkerCmd()
+{
+	return {"python3", "-c", HANDLER, ELANOR_PYMODULES_DIR};
+}
+
+std::size_t OpenFds()
+{
+	std::size_t count = 0;
+	for ([[maybe_unused]] const auto& entry : std::filesystem::directory_iterator("/proc/self/fd"))
+		count++;
+	return count;
+}
+
+} // namespace
+
+TEST(SubprocessTest, ExecCmdCapturesOutputAndStatus)
+{
+	int status = -1;
+	EXPECT_EQ(Utils::ExecCmd({"sh", "-c", "echo hello; exit 3"}, status), "hello\n");
+	ASSERT_TRUE(WIFEXITED(status));
+	EXPECT_EQ(WEXITSTATUS(status), 3);
+
+	status = Utils::ExecCmd({"true"});
+	ASSERT_TRUE(WIFEXITED(status));
+	EXPECT_EQ(WEXITSTATUS(status), 0);
+}
+
+TEST(SubprocessTest, MissingCommandDoesNotLeakDescriptors)
+{
+	const auto before = OpenFds();
+	for (int i = 0; i < 10; i++)
+	{
+		EXPECT_THROW(Subprocess({"elanor-missing-command"}, Subprocess::Redirect::OUTPUT), SubprocessError);
+		EXPECT_THROW(Subprocess({"elanor-missing-command"}, Subprocess::Redirect::DUPLEX), SubprocessError);
+	}
+	EXPECT_EQ(OpenFds(), before);
+}
+
+TEST(SubprocessTest, ReadTimesOut)
+{
+	Subprocess process({"sleep", "5"}, Subprocess::Redirect::OUTPUT);
+	char buffer[16];
+	const auto start = std::chrono::steady_clock::now();
+	EXPECT_THROW(process.read(buffer, sizeof(buffer), std::chrono::milliseconds(50)), SubprocessError);
+	EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(2));
+}
+
+TEST(SubprocessTest, DuplexEchoesUntilChannelIsClosed)
+{
+	Subprocess process({"cat"}, Subprocess::Redirect::DUPLEX);
+	process.write("ping");
+	char buffer[4];
+	std::size_t received = 0;
+	while (received < sizeof(buffer))
+		received += process.read(buffer + received, sizeof(buffer) - received, std::chrono::seconds(5));
+	EXPECT_EQ(std::string(buffer, sizeof(buffer)), "ping");
+
+	// cat sees eof once our end of the socket is closed
+	process.CloseChannel();
+	const int status = process.wait();
+	ASSERT_TRUE(WIFEXITED(status));
+	EXPECT_EQ(WEXITSTATUS(status), 0);
+}
+
+TEST(WorkerPoolTest, RoundTripsFrames)
+{
+	WorkerPool pool(WorkerCmd(), 1);
+	EXPECT_EQ(pool.call("abc"), "cba");
+	EXPECT_EQ(pool.call(""), "");
+
+	// Payloads are binary and may need several reads
+	std::string payload(3 << 20, '\0');
+	for (std::size_t i = 0; i < payload.size(); i++)
+		payload[i] = static_cast<char>(i * 7);
+	EXPECT_EQ(pool.call(payload), std::string(payload.rbegin(), payload.rend()));
+}
+
+TEST(WorkerPoolTest, ReusesWorkers)
+{
+	WorkerPool pool(WorkerCmd(), 1);
+	const auto pid = pool.call("pid");
+	EXPECT_EQ(pool.call("abc"), "cba");
+	EXPECT_EQ(pool.call("pid"), pid);
+}
+
+TEST(WorkerPoolTest, StrayOutputDoesNotCorruptFrames)
+{
+	WorkerPool pool(WorkerCmd(), 1);
+	EXPECT_EQ(pool.call("noise"), "esion");
+	EXPECT_EQ(pool.call("abc"), "cba");
+}
+
+TEST(WorkerPoolTest, ErrorFramesKeepTheWorker)
+{
+	WorkerPool pool(WorkerCmd(), 1);
+	const auto pid = pool.call("pid");
+	try
+	{
+		pool.call("fail");
+		FAIL() << "Expected SubprocessError";
+	}
+	catch (const SubprocessError& e)
+	{
+		EXPECT_STREQ(e.what(), "bad request");
+	}
+	EXPECT_EQ(pool.call("pid"), pid);
+}
+
+TEST(WorkerPoolTest, CrashedWorkerIsReplaced)
+{
+	WorkerPool pool(WorkerCmd(), 1);
+	const auto pid = pool.call("pid");
+	try
+	{
+		pool.call("crash");
+		FAIL() << "Expected SubprocessError";
+	}
+	catch (const SubprocessError& e)
+	{
+		EXPECT_NE(std::string(e.what()).find("exited with status"), std::string::npos) << e.what();
+	}
+	const auto replaced = pool.call("pid");
+	EXPECT_NE(replaced, pid);
+}
+
+TEST(WorkerPoolTest, TimedOutWorkerIsReplaced)
+{
+	WorkerPool pool(WorkerCmd(), 1);
+	const auto pid = pool.call("pid");
+	const auto start = std::chrono::steady_clock::now();
+	EXPECT_THROW(pool.call("sleep", std::chrono::milliseconds(200)), SubprocessError);
+	EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(3));
+	EXPECT_NE(pool.call("pid"), pid);
+}
+
+TEST(WorkerPoolTest, RunsAtMostSizeWorkers)
+{
+	WorkerPool pool(WorkerCmd(), 2);
+	std::mutex mtx;
+	std::set<std::string> pids;
+	std::vector<std::thread> threads;
+	for (int i = 0; i < 4; i++)
+		threads.emplace_back(
+			[&]
+			{
+				for (int j = 0; j < 10; j++)
+				{
+					auto pid = pool.call("pid");
+					std::lock_guard<std::mutex> lk(mtx);
+					pids.insert(std::move(pid));
+				}
+			});
+	for (auto& thread : threads)
+		thread.join();
+	EXPECT_GE(pids.size(), 1);
+	EXPECT_LE(pids.size(), 2);
+}
+
+TEST(WorkerPoolTest, MissingCommandThrows)
+{
+	WorkerPool pool({"elanor-missing-command"}, 1);
+	EXPECT_THROW(pool.call("abc"), SubprocessError);
+	// The failed start does not take up the only slot
+	EXPECT_THROW(pool.call("abc"), SubprocessError);
+}
+
+// NOLINTEND
@@ -0,0 +1,245 @@
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include <gtest/gtest.h>
+#include <zlib.h>
+
+#include <PluginUtils/ZipReader.hpp>
+
+// NOLINTBEGIN
+
+namespace
+{
+
+using Entries = std::vector<std::pair<std::string, std::string>>;
+
+struct Entry
+{
+	std::string name;
+	std::string data;
+	bool deflate = false;
+	uint16_t flags = 0;
+	uint16_t method = 0;	// Overrides the method of deflate when set
+};
+
+void Put(std::string& out, uint64_t value, size_t bytes)
+{
+	for (size_t i = 0; i < bytes; i++)
+		out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+}
+
+std::string Deflate(const std::string& data)
+{
+	z_stream strm{};
+	EXPECT_EQ(deflateInit2(&strm, Z_BEST_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY), Z_OK);
+	std::string out(deflateBound(&strm, data.size()), '\0');
+	strm.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+	strm.avail_in = data.size();
+	strm.next_out = reinterpret_cast<Bytef*>(out.data());
+	strm.avail_out = out.size();
+	EXPECT_EQ(deflate(&strm, Z_FINISH), Z_STREAM_END);
+	out.resize(strm.total_out);
+	deflateEnd(&strm);
+	return out;
+}
+
+// Local entries followed by the central directory, the way pixiv serves ugoira archives
+std::string Archive(const std::vector<Entry>& entries)
+{
+	std::string out, directory;
+	for (const auto& entry : entries)
+	{
+		const uint32_t crc = crc32(0, reinterpret_cast<const Bytef*>(entry.data.data()), entry.data.size());
+		const std::string stored = entry.deflate ? Deflate(entry.data) : entry.data;
+		const uint16_t method = entry.method ? entry.method : (entry.deflate ? Z_DEFLATED : 0);
+		const uint32_t offset = out.size();
+
+		Put(out, 0x04034b50, 4);
+		Put(out, 20, 2);
+		Put(out, entry.flags, 2);
+		Put(out, method, 2);
+		Put(out, 0, 4);
+		Put(out, crc, 4);
+		Put(out, stored.size(), 4);
+		Put(out, entry.data.size(), 4);
+		Put(out, entry.name.size(), 2);
+		Put(out, 0, 2);
+		out += entry.name;
+		out += stored;
+
+		Put(directory, 0x02014b50, 4);
+		Put(directory, 20, 2);
+		Put(directory, 20, 2);
+		Put(directory, entry.flags, 2);
+		Put(directory, method, 2);
+		Put(directory, 0, 4);
+		Put(directory, crc, 4);
+		Put(directory, stored.size(), 4);
+		Put(directory, entry.data.size(), 4);
+		Put(directory, entry.name.size(), 2);
+		Put(directory, 0, 8);
+		Put(directory, 0, 4);
+		Put(directory, offset, 4);
+		directory += entry.name;
+	}
+
+	const uint32_t start = out.size();
+	out += directory;
+	Put(out, 0x06054b50, 4);
+	Put(out, 0, 4);
+	Put(out, entries.size(), 2);
+	Put(out, entries.size(), 2);
+	Put(out, directory.size(), 4);
+	Put(out, start, 4);
+	Put(out, 0, 2);
+	return out;
+}
+
+std::vector<Entry> Frames()
+{
+	std::string large;
+	for (int i = 0; i < 5000; i++)
+		large += "frame " + std::to_string(i % 97) + "\n";
+	return {
+		{"000000.jpg", std::string("\xff\xd8\0stored\xff\xd9", 11)},
+		{"000001.jpg", large, true},
+		{"000002.jpg", "", false},
+		{"000003.jpg", "short", true},
+	};
+}
+
+Entries Expected(const std::vector<Entry>& entries)
+{
+	Entries result;
+	for (const auto& entry : entries)
+		result.emplace_back(entry.name, entry.data);
+	return result;
+}
+
+// Feeds archive in chunks of chunk bytes, entries handed out so far are in result
+bool Read(const std::string& archive, size_t chunk, Entries& result)
+{
+	Utils::ZipReader zip([&result](std::string name, std::string data)
+	                     { result.emplace_back(std::move(name), std::move(data)); });
+	for (size_t i = 0; i < archive.size(); i += chunk)
+		zip.feed(archive.data() + i, std::min(chunk, archive.size() - i));
+	return zip.done();
+}
+
+} // namespace
+
+TEST(ZipReaderTest, ReadsStoredAndDeflatedEntries)
+{
+	const auto frames = Frames();
+	Entries result;
+	EXPECT_TRUE(Read(Archive(frames), SIZE_MAX, result));
+	EXPECT_EQ(result, Expected(frames));
+}
+
+TEST(ZipReaderTest, SameEntriesForEveryChunkSize)
+{
+	const auto frames = Frames();
+	const auto archive = Archive(frames);
+	for (size_t chunk : {1, 2, 3, 7, 29, 30, 31, 512, 4096})
+	{
+		Entries result;
+		EXPECT_TRUE(Read(archive, chunk, result)) << "chunk " << chunk;
+		EXPECT_EQ(result, Expected(frames)) << "chunk " << chunk;
+	}
+}
+
+TEST(ZipReaderTest, EntriesAreHandedOutOnceComplete)
+{
+	const auto frames = Frames();
+	const auto archive = Archive(frames);
+	Entries result;
+	Utils::ZipReader zip([&result](std::string name, std::string data)
+	                     { result.emplace_back(std::move(name), std::move(data)); });
+
+	// The first entry is 30 bytes of header, 10 of name and 11 of data
+	zip.feed(archive.data(), 50);
+	EXPECT_TRUE(result.empty());
+	zip.feed(archive.data() + 50, 1);
+	ASSERT_EQ(result.size(), 1);
+	EXPECT_EQ(result.front().first, "000000.jpg");
+	EXPECT_FALSE(zip.done());
+}
+
+TEST(ZipReaderTest, TruncatedArchiveIsNotDone)
+{
+	const auto frames = Frames();
+	const auto archive = Archive(frames);
+	const auto expected = Expected(frames);
+	for (size_t len = 0; len < archive.size(); len += 13)
+	{
+		Entries result;
+		const bool done = Read(archive.substr(0, len), 64, result);
+		// Done once the central directory starts, every entry is out by then
+		if (done)
+			EXPECT_EQ(result, expected) << "length " << len;
+		else
+		{
+			ASSERT_LE(result.size(), expected.size()) << "length " << len;
+			EXPECT_EQ(result, Entries(expected.begin(), expected.begin() + result.size())) << "length " << len;
+		}
+	}
+
+	Entries result;
+	EXPECT_FALSE(Read(archive.substr(0, archive.find("000003.jpg") + 4), 64, result));
+	EXPECT_EQ(result.size(), 3);
+}
+
+TEST(ZipReaderTest, EmptyArchive)
+{
+	Entries result;
+	EXPECT_TRUE(Read(Archive({}), 1, result));
+	EXPECT_TRUE(result.empty());
+}
+
+TEST(ZipReaderTest, DataAfterTheEntriesIsIgnored)
+{
+	const auto frames = Frames();
+	Entries result;
+	Utils::ZipReader zip([&result](std::string name, std::string data)
+	                     { result.emplace_back(std::move(name), std::move(data)); });
+	const auto archive = Archive(frames);
+	zip.feed(archive.data(), archive.size());
+	ASSERT_TRUE(zip.done());
+	EXPECT_NO_THROW(zip.feed("garbage", 7));
+	EXPECT_EQ(result, Expected(frames));
+}
+
+TEST(ZipReaderTest, RejectsDataDescriptorsAndEncryption)
+{
+	Entries result;
+	// Sizes of entries with a data descriptor are only known after their data
+	EXPECT_THROW(Read(Archive({{"a.jpg", "abc", true, 0x8}}), 1, result), std::runtime_error);
+	EXPECT_THROW(Read(Archive({{"a.jpg", "abc", false, 0x1}}), SIZE_MAX, result), std::runtime_error);
+	EXPECT_TRUE(result.empty());
+
+	// Entries before it are still handed out
+	auto entries = Frames();
+	entries.push_back({"b.jpg", "abc", true, 0x8});
+	EXPECT_THROW(Read(Archive(entries), 16, result), std::runtime_error);
+	EXPECT_EQ(result, Expected(Frames()));
+}
+
+TEST(ZipReaderTest, RejectsMalformedArchives)
+{
+	Entries result;
+	// An error page instead of an archive
+	EXPECT_THROW(Read("<html>Forbidden</html>", 4, result), std::runtime_error);
+	// Unsupported compression
+	EXPECT_THROW(Read(Archive({{"a.jpg", "abc", false, 0, 12}}), SIZE_MAX, result), std::runtime_error);
+
+	// Corrupted deflated data
+	auto archive = Archive({{"a.jpg", std::string(1000, 'a'), true}});
+	archive[30 + 5] = static_cast<char>(archive[30 + 5] ^ 0xff);
+	EXPECT_THROW(Read(archive, SIZE_MAX, result), std::runtime_error);
+	EXPECT_TRUE(result.empty());
+}
+
+// NOLINTEND
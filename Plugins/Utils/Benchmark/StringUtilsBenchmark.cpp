@@ -0,0 +1,205 @@
+#include <iomanip>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <PluginUtils/SimplePattern.hpp>
+#include <PluginUtils/StringUtils.hpp>
+
+namespace
+{
+
+const std::vector<std::string>& ChatLines()
+{
+	static const std::vector<std::string> lines = []
+	{
+		std::string chat;
+		for (int i = 0; i < 40; i++)	// NOLINT(*-avoid-magic-numbers)
+			chat += "今天的活动好难打啊 有没有人一起 ";
+		return std::vector<std::string>{
+			"#pixiv id 101010101 all",
+			"#PIXIV search \"blue archive\" 10",
+			"#trig set \"recall\" on",
+			"#roll 3d6",
+			"#choyen \"5000兆円\" \"欲しい!\"",
+			"#auth set \"pixiv \\\"id\\\"\" 20",
+			"好的",
+			chat,
+		};
+	}();
+	return lines;
+}
+
+// What every command did before: istringstream + std::quoted, then toLower
+std::size_t StreamTokenize(const std::string& input, std::vector<std::string>& tokens)
+{
+	std::istringstream iss(input);
+	std::string s;
+	while (iss >> std::quoted(s))
+		tokens.push_back(s);
+	return tokens.size();
+}
+
+void BM_StreamMatch(benchmark::State& state)
+{
+	const auto& line = ChatLines().at(state.range(0));
+	for (auto _ : state)
+	{
+		std::vector<std::string> tokens;
+		bool matched = StreamTokenize(line, tokens) >= 2 && Utils::toLower(tokens[0]) == "#pixiv";
+		benchmark::DoNotOptimize(matched);
+	}
+}
+
+void BM_VectorMatch(benchmark::State& state)
+{
+	const auto& line = ChatLines().at(state.range(0));
+	for (auto _ : state)
+	{
+		std::vector<std::string> tokens;
+		bool matched = Utils::Tokenize(line, tokens) >= 2 && Utils::toLower(tokens[0]) == "#pixiv";
+		benchmark::DoNotOptimize(matched);
+	}
+}
+
+void BM_TokenListMatch(benchmark::State& state)
+{
+	const auto& line = ChatLines().at(state.range(0));
+	for (auto _ : state)
+	{
+		Utils::TokenList<2> head(line);
+		bool matched = head.size() >= 2 && Utils::iequals(head[0], "#pixiv");
+		benchmark::DoNotOptimize(matched);
+	}
+}
+
+void BM_StreamTokenize(benchmark::State& state)
+{
+	const auto& line = ChatLines().at(state.range(0));
+	for (auto _ : state)
+	{
+		std::vector<std::string> tokens;
+		benchmark::DoNotOptimize(StreamTokenize(line, tokens));
+	}
+}
+
+void BM_Tokenize(benchmark::State& state)
+{
+	const auto& line = ChatLines().at(state.range(0));
+	for (auto _ : state)
+	{
+		std::vector<std::string> tokens;
+		benchmark::DoNotOptimize(Utils::Tokenize(line, tokens));
+	}
+}
+
+void BM_TokenList(benchmark::State& state)
+{
+	const auto& line = ChatLines().at(state.range(0));
+	for (auto _ : state)
+	{
+		Utils::TokenList<8> tokens(line);	// NOLINT(*-avoid-magic-numbers)
+		benchmark::DoNotOptimize(tokens);
+	}
+}
+
+void Lines(benchmark::internal::Benchmark* bench)
+{
+	for (std::size_t i = 0; i < ChatLines().size(); i++)
+		bench->Arg(static_cast<std::int64_t>(i));
+}
+
+} // namespace
+
+BENCHMARK(BM_StreamMatch)->Apply(Lines);
+BENCHMARK(BM_VectorMatch)->Apply(Lines);
+BENCHMARK(BM_TokenListMatch)->Apply(Lines);
+BENCHMARK(BM_StreamTokenize)->Apply(Lines);
+BENCHMARK(BM_Tokenize)->Apply(Lines);
+BENCHMARK(BM_TokenList)->Apply(Lines);
+
+namespace
+{
+
+void BM_ReplaceMark(benchmark::State& state)
+{
+	const auto& line = ChatLines().at(state.range(0));
+	for (auto _ : state)
+		benchmark::DoNotOptimize(Utils::ReplaceMark(line));
+}
+
+} // namespace
+
+BENCHMARK(BM_ReplaceMark)->Apply(Lines);
+
+namespace
+{
+
+const std::vector<std::string> NUMBERS = {"7", "-1024", "1234567890123", "12a", "not a number"};
+
+const std::vector<std::string> ASSET_KEYS = {
+	"character/member/res001_no021",
+	"character/member_cutout/res001_no021",
+	"live2d/motion/21miku_motion_base",
+	"music/long/se_0001_01",
+	"event_story/event_aprilfool_2022/scenario",
+};
+
+void BM_RegexIsInt(benchmark::State& state)
+{
+	const static std::regex r_int(R"([\+-]?\d+)");
+	for (auto _ : state)
+		for (const auto& str : NUMBERS)
+			benchmark::DoNotOptimize(std::regex_match(str, r_int));
+}
+
+void BM_IsInt(benchmark::State& state)
+{
+	for (auto _ : state)
+		for (const auto& str : NUMBERS)
+			benchmark::DoNotOptimize(Utils::isInt(str));
+}
+
+void BM_RegexCardKey(benchmark::State& state)
+{
+	const static std::regex reg(R"(^character/member/res\d+_no\d+$)", std::regex_constants::ECMAScript);
+	for (auto _ : state)
+		for (const auto& key : ASSET_KEYS)
+			benchmark::DoNotOptimize(std::regex_match(key, reg));
+}
+
+void BM_PatternCardKey(benchmark::State& state)
+{
+	const static Utils::SimplePattern pattern(R"(^character/member/res\d+_no\d+$)");
+	for (auto _ : state)
+		for (const auto& key : ASSET_KEYS)
+			benchmark::DoNotOptimize(pattern.match(key));
+}
+
+void BM_RegexFilter(benchmark::State& state)
+{
+	const static std::regex reg("live2d/.*", std::regex_constants::ECMAScript);
+	for (auto _ : state)
+		for (const auto& key : ASSET_KEYS)
+			benchmark::DoNotOptimize(std::regex_match(key, reg));
+}
+
+void BM_PatternFilter(benchmark::State& state)
+{
+	const static Utils::SimplePattern pattern("live2d/.*");
+	for (auto _ : state)
+		for (const auto& key : ASSET_KEYS)
+			benchmark::DoNotOptimize(pattern.match(key));
+}
+
+} // namespace
+
+BENCHMARK(BM_RegexIsInt);
+BENCHMARK(BM_IsInt);
+BENCHMARK(BM_RegexCardKey);
+BENCHMARK(BM_PatternCardKey);
+BENCHMARK(BM_RegexFilter);
+BENCHMARK(BM_PatternFilter);
@@ -0,0 +1,867 @@
+#include "AsyncHttp.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <string_view>
+#include <system_error>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#include <openssl/x509v3.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "RateGovernor.hpp"
+#include "UrlComponents.hpp"
+
+namespace Utils
+{
+
+using namespace std::literals;
+
+EventLoop::EventLoop(std::size_t threads, std::size_t workers)
+{
+	// SSL_write goes through write(2) and would raise SIGPIPE on a reset connection
+	std::signal(SIGPIPE, SIG_IGN);
+
+	this->_epoll = epoll_create1(EPOLL_CLOEXEC);
+	if (this->_epoll < 0) throw std::system_error(errno, std::generic_category(), "epoll_create1");
+	this->_wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (this->_wake < 0)
+	{
+		int err = errno;
+		close(this->_epoll);
+		throw std::system_error(err, std::generic_category(), "eventfd");
+	}
+
+	epoll_event ev{};
+	ev.events = EPOLLIN;
+	ev.data.u64 = 0;
+	epoll_ctl(this->_epoll, EPOLL_CTL_ADD, this->_wake, &ev);
+
+	threads = std::max<std::size_t>(threads, 1);
+	for (std::size_t i = 0; i < threads; i++)
+		this->_threads.emplace_back([this] { this->_run(); });
+	workers = std::max<std::size_t>(workers, 1);
+	for (std::size_t i = 0; i < workers; i++)
+		this->_workers.emplace_back([this] { this->_work(); });
+}
+
+EventLoop::~EventLoop()
+{
+	this->_stop = true;
+	std::uint64_t one = 1;
+	(void)!write(this->_wake, &one, sizeof(one));
+	for (auto& th : this->_threads)
+		if (th.joinable()) th.join();
+	{
+		std::lock_guard<std::mutex> lk(this->_JobMtx);
+		this->_JobStop = true;
+	}
+	this->_JobCv.notify_all();
+	for (auto& th : this->_workers)
+		if (th.joinable()) th.join();
+	close(this->_wake);
+	close(this->_epoll);
+}
+
+EventLoop& EventLoop::GetInstance()
+{
+	static EventLoop loop(std::clamp<std::size_t>(std::thread::hardware_concurrency() / 2, 2, 4));	// NOLINT(*-avoid-magic-numbers)
+	return loop;
+}
+
+void EventLoop::post(std::coroutine_handle<> handle)
+{
+	{
+		std::lock_guard<std::mutex> lk(this->_mtx);
+		this->_ready.push_back(handle);
+	}
+	std::uint64_t one = 1;
+	(void)!write(this->_wake, &one, sizeof(one));
+}
+
+void EventLoop::_submit(std::function<void()> job)
+{
+	{
+		std::lock_guard<std::mutex> lk(this->_JobMtx);
+		this->_jobs.push_back(std::move(job));
+	}
+	this->_JobCv.notify_one();
+}
+
+void EventLoop::_work()
+{
+	while (true)
+	{
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lk(this->_JobMtx);
+			this->_JobCv.wait(lk, [this] { return !this->_jobs.empty() || this->_JobStop; });
+			// Jobs left at shutdown are dropped, nothing would resume their coroutines anyway
+			if (this->_JobStop) return;
+			job = std::move(this->_jobs.front());
+			this->_jobs.pop_front();
+		}
+		job();
+	}
+}
+
+void EventLoop::_register(Waiter& waiter, std::uint32_t events, clock::time_point deadline)
+{
+	bool earliest = false;
+	{
+		std::lock_guard<std::mutex> lk(this->_mtx);
+		auto id = this->_NextId++;
+		waiter.timer = this->_timers.emplace(deadline, id);
+		this->_waiters.emplace(id, &waiter);
+		if (waiter.fd >= 0)
+		{
+			epoll_event ev{};
+			ev.events = events | EPOLLONESHOT;
+			ev.data.u64 = id;
+			if (epoll_ctl(this->_epoll, EPOLL_CTL_ADD, waiter.fd, &ev) < 0)
+			{
+				int err = errno;
+				this->_timers.erase(waiter.timer);
+				this->_waiters.erase(id);
+				throw std::system_error(err, std::generic_category(), "epoll_ctl");
+			}
+		}
+		earliest = (waiter.timer == this->_timers.begin());
+	}
+
+	// Loop threads may be sleeping past the new deadline
+	if (earliest)
+	{
+		std::uint64_t one = 1;
+		(void)!write(this->_wake, &one, sizeof(one));
+	}
+}
+
+void EventLoop::_run()
+{
+	constexpr int MAX_EVENTS = 64;
+	constexpr auto MAX_WAIT = 100ms;
+
+	std::array<epoll_event, MAX_EVENTS> events{};
+	std::vector<std::coroutine_handle<>> resume;
+	while (!this->_stop)
+	{
+		int timeout = MAX_WAIT.count();
+		{
+			std::lock_guard<std::mutex> lk(this->_mtx);
+			if (!this->_ready.empty())
+				timeout = 0;
+			else if (!this->_timers.empty())
+			{
+				auto remaining = std::chrono::ceil<std::chrono::milliseconds>(this->_timers.begin()->first - clock::now());
+				timeout = (int)std::clamp<std::chrono::milliseconds::rep>(remaining.count(), 0, MAX_WAIT.count());
+			}
+		}
+
+		int n = epoll_wait(this->_epoll, events.data(), MAX_EVENTS, timeout);
+		if (n < 0) n = 0;
+
+		resume.clear();
+		{
+			std::lock_guard<std::mutex> lk(this->_mtx);
+			for (int i = 0; i < n; i++)
+			{
+				auto id = events[i].data.u64;	// NOLINT(*-union-access)
+				if (id == 0)
+				{
+					std::uint64_t count{};
+					(void)!read(this->_wake, &count, sizeof(count));
+					continue;
+				}
+
+				auto it = this->_waiters.find(id);
+				if (it == this->_waiters.end()) continue;
+				Waiter* waiter = it->second;
+				this->_waiters.erase(it);
+				this->_timers.erase(waiter->timer);
+				epoll_ctl(this->_epoll, EPOLL_CTL_DEL, waiter->fd, nullptr);
+				resume.push_back(waiter->handle);
+			}
+
+			auto now = clock::now();
+			while (!this->_timers.empty() && this->_timers.begin()->first <= now)
+			{
+				auto it = this->_waiters.find(this->_timers.begin()->second);
+				this->_timers.erase(this->_timers.begin());
+				if (it == this->_waiters.end()) continue;
+				Waiter* waiter = it->second;
+				this->_waiters.erase(it);
+				if (waiter->fd >= 0) epoll_ctl(this->_epoll, EPOLL_CTL_DEL, waiter->fd, nullptr);
+				waiter->TimedOut = true;
+				resume.push_back(waiter->handle);
+			}
+
+			resume.insert(resume.end(), this->_ready.begin(), this->_ready.end());
+			this->_ready.clear();
+		}
+
+		for (auto h : resume)
+			h.resume();
+	}
+}
+
+
+
+namespace
+{
+
+std::string SslError()
+{
+	std::string msg;
+	while (auto err = ERR_get_error())
+	{
+		std::array<char, 256> buf{};	// NOLINT(*-avoid-magic-numbers)
+		ERR_error_string_n(err, buf.data(), buf.size());
+		if (!msg.empty()) msg += "; ";
+		msg += buf.data();
+	}
+	return msg.empty() ? "unknown error" : msg;
+}
+
+SSL_CTX* GetSslContext()
+{
+	static std::unique_ptr<SSL_CTX, decltype(&SSL_CTX_free)> ctx = []
+	{
+		std::unique_ptr<SSL_CTX, decltype(&SSL_CTX_free)> ctx(SSL_CTX_new(TLS_client_method()), &SSL_CTX_free);
+		if (!ctx) throw AsyncHttpError("Failed to create SSL context: " + SslError());
+		SSL_CTX_set_default_verify_paths(ctx.get());
+		SSL_CTX_set_verify(ctx.get(), SSL_VERIFY_PEER, nullptr);
+		SSL_CTX_set_mode(ctx.get(), SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+		return ctx;
+	}();
+	return ctx.get();
+}
+
+struct Address
+{
+	sockaddr_storage addr{};
+	socklen_t len{};
+};
+
+// getaddrinfo has no non-blocking form, results are cached briefly so a burst of requests resolves once
+Task<std::vector<Address>> Resolve(EventLoop& loop, const std::string& host, int port)
+{
+	struct Entry
+	{
+		std::vector<Address> addrs;
+		EventLoop::clock::time_point expire;
+	};
+	static std::mutex mtx;
+	static std::unordered_map<std::string, Entry> cache;
+	constexpr auto TTL = 60s;
+
+	std::string key = host + ":" + std::to_string(port);
+	{
+		std::lock_guard<std::mutex> lk(mtx);
+		auto it = cache.find(key);
+		if (it != cache.end() && it->second.expire > EventLoop::clock::now()) co_return it->second.addrs;
+	}
+
+	// Kept as a named local, gcc mishandles lambda temporaries inside co_await expressions
+	auto resolver = [host, port]() -> std::vector<Address>
+	{
+		addrinfo hints{};
+		hints.ai_family = AF_UNSPEC;
+		hints.ai_socktype = SOCK_STREAM;
+		addrinfo* res = nullptr;
+		int err = getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &res);
+		if (err != 0) throw AsyncHttpError("Failed to resolve " + host + ": " + gai_strerror(err));
+
+		std::vector<Address> addrs;
+		for (auto* p = res; p; p = p->ai_next)
+		{
+			Address a;
+			std::memcpy(&a.addr, p->ai_addr, p->ai_addrlen);
+			a.len = p->ai_addrlen;
+			addrs.push_back(a);
+		}
+		freeaddrinfo(res);
+		return addrs;
+	};
+	auto addrs = co_await loop.offload(std::move(resolver));
+
+	{
+		std::lock_guard<std::mutex> lk(mtx);
+		cache[key] = {addrs, EventLoop::clock::now() + TTL};
+	}
+	co_return addrs;
+}
+
+std::string Inflate(const std::string& data, std::size_t limit)
+{
+	z_stream strm{};
+	// 15 + 32 detects zlib and gzip headers automatically
+	if (inflateInit2(&strm, 15 + 32) != Z_OK) throw AsyncHttpError("Failed to initialize zlib");	// NOLINT(*-avoid-magic-numbers)
+
+	std::string out;
+	std::array<char, 16384> buf{};	// NOLINT(*-avoid-magic-numbers)
+	strm.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));	// NOLINT
+	strm.avail_in = (uInt)data.size();
+	int ret = Z_OK;
+	bool raw = false;
+	while (ret != Z_STREAM_END)
+	{
+		strm.next_out = reinterpret_cast<Bytef*>(buf.data());	// NOLINT(*-reinterpret-cast)
+		strm.avail_out = (uInt)buf.size();
+		ret = inflate(&strm, Z_NO_FLUSH);
+		// Plenty of servers send raw deflate data for Content-Encoding: deflate, which fails the header check
+		if (ret == Z_DATA_ERROR && !raw && strm.total_out == 0)
+		{
+			raw = true;
+			if (inflateReset2(&strm, -15) != Z_OK)	// NOLINT(*-avoid-magic-numbers)
+			{
+				inflateEnd(&strm);
+				throw AsyncHttpError("Failed to initialize zlib");
+			}
+			strm.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));	// NOLINT
+			strm.avail_in = (uInt)data.size();
+			ret = Z_OK;
+			continue;
+		}
+		if (ret != Z_OK && ret != Z_STREAM_END)
+		{
+			inflateEnd(&strm);
+			throw AsyncHttpError("Failed to decompress response body");
+		}
+		out.append(buf.data(), buf.size() - strm.avail_out);
+		if (out.size() > limit)
+		{
+			inflateEnd(&strm);
+			throw AsyncHttpError("Response body exceeds size limit");
+		}
+		if (ret == Z_OK && strm.avail_in == 0 && strm.avail_out != 0) break;
+	}
+	inflateEnd(&strm);
+	return out;
+}
+
+bool HeaderContains(const std::string& value, std::string_view token)
+{
+	std::string lower(value);
+	std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return std::tolower(c); });
+	return lower.find(token) != std::string::npos;
+}
+
+// Waits for RateGovernor without blocking a loop thread
+class PermitAwaiter
+{
+protected:
+	EventLoop& _loop;
+	std::string _origin;
+	RateGovernor::Permit _permit;
+
+public:
+	EventLoop::clock::time_point start{};
+
+	PermitAwaiter(EventLoop& loop, std::string origin) : _loop(loop), _origin(std::move(origin)) {}
+
+	bool await_ready() const noexcept { return false; }
+	void await_suspend(std::coroutine_handle<> h)
+	{
+		// The callback may run right here, nothing in the frame is touched after post
+		RateGovernor::GetInstance().acquire(this->_origin,
+		                                    [this, h](RateGovernor::Permit permit, EventLoop::clock::time_point start)
+		                                    {
+												this->_permit = std::move(permit);
+												this->start = start;
+												this->_loop.post(h);
+											});
+	}
+	RateGovernor::Permit await_resume() { return std::move(this->_permit); }
+};
+
+} // namespace
+
+
+
+class AsyncHttpClient::Stream
+{
+protected:
+	EventLoop& _loop;
+	int _fd;
+	SSL* _ssl = nullptr;
+	std::string _buffer;
+	std::size_t _pos = 0;
+
+	Task<void> _WaitIo(std::uint32_t events, std::chrono::milliseconds timeout)
+	{
+		// gcc 12 miscompiles co_await inside the condition of an if that throws, hence the named results here
+		bool ready = co_await this->_loop.wait(this->_fd, events, EventLoop::clock::now() + timeout);
+		if (!ready) throw AsyncHttpError("Operation timed out");
+	}
+
+	Task<std::size_t> _ReadSome(char* buf, std::size_t len, std::chrono::milliseconds timeout)
+	{
+		while (true)
+		{
+			if (this->_ssl)
+			{
+				ERR_clear_error();
+				std::size_t n = 0;
+				if (SSL_read_ex(this->_ssl, buf, len, &n) == 1) co_return n;
+				int err = SSL_get_error(this->_ssl, 0);
+				if (err == SSL_ERROR_WANT_READ)
+					co_await this->_WaitIo(EPOLLIN, timeout);
+				else if (err == SSL_ERROR_WANT_WRITE)
+					co_await this->_WaitIo(EPOLLOUT, timeout);
+				// Plenty of servers close without close_notify
+				else if (err == SSL_ERROR_ZERO_RETURN || (err == SSL_ERROR_SYSCALL && ERR_peek_error() == 0))
+					co_return 0;
+				else
+					throw AsyncHttpError("TLS read failed: " + SslError());
+			}
+			else
+			{
+				auto n = recv(this->_fd, buf, len, 0);
+				if (n >= 0) co_return static_cast<std::size_t>(n);
+				if (errno == EAGAIN || errno == EWOULDBLOCK)
+					co_await this->_WaitIo(EPOLLIN, timeout);
+				else if (errno != EINTR)
+					throw AsyncHttpError("Read failed: "s + std::strerror(errno));
+			}
+		}
+	}
+
+	// Appends more data to the buffer, false on EOF
+	Task<bool> _fill(std::chrono::milliseconds timeout)
+	{
+		constexpr std::size_t CHUNK = 16384;
+		if (this->_pos > 0 && this->_pos == this->_buffer.size())
+		{
+			this->_buffer.clear();
+			this->_pos = 0;
+		}
+		auto size = this->_buffer.size();
+		this->_buffer.resize(size + CHUNK);
+		auto n = co_await this->_ReadSome(this->_buffer.data() + size, CHUNK, timeout);
+		this->_buffer.resize(size + n);
+		co_return n > 0;
+	}
+
+public:
+	Stream(EventLoop& loop, int fd) : _loop(loop), _fd(fd) {}
+	Stream(const Stream&) = delete;
+	Stream& operator=(const Stream&) = delete;
+	Stream(Stream&&) = delete;
+	Stream& operator=(Stream&&) = delete;
+	~Stream()
+	{
+		if (this->_ssl) SSL_free(this->_ssl);
+		if (this->_fd >= 0) close(this->_fd);
+	}
+
+	Task<void> handshake(const std::string& host, std::chrono::milliseconds timeout)
+	{
+		this->_ssl = SSL_new(GetSslContext());
+		if (!this->_ssl) throw AsyncHttpError("Failed to create SSL session: " + SslError());
+		SSL_set_fd(this->_ssl, this->_fd);
+
+		in6_addr addr{};
+		if (inet_pton(AF_INET, host.c_str(), &addr) == 1 || inet_pton(AF_INET6, host.c_str(), &addr) == 1)
+			X509_VERIFY_PARAM_set1_ip_asc(SSL_get0_param(this->_ssl), host.c_str());
+		else
+		{
+			SSL_set_tlsext_host_name(this->_ssl, host.c_str());
+			SSL_set1_host(this->_ssl, host.c_str());
+		}
+		SSL_set_connect_state(this->_ssl);
+
+		auto deadline = EventLoop::clock::now() + timeout;
+		while (true)
+		{
+			ERR_clear_error();
+			int ret = SSL_connect(this->_ssl);
+			if (ret == 1) break;
+
+			int err = SSL_get_error(this->_ssl, ret);
+			std::uint32_t events = 0;
+			if (err == SSL_ERROR_WANT_READ)
+				events = EPOLLIN;
+			else if (err == SSL_ERROR_WANT_WRITE)
+				events = EPOLLOUT;
+			else
+				throw AsyncHttpError("TLS handshake with " + host + " failed: " + SslError());
+			bool ready = co_await this->_loop.wait(this->_fd, events, deadline);
+			if (!ready) throw AsyncHttpError("TLS handshake with " + host + " timed out");
+		}
+	}
+
+	Task<void> write(std::string_view data, std::chrono::milliseconds timeout)
+	{
+		while (!data.empty())
+		{
+			if (this->_ssl)
+			{
+				ERR_clear_error();
+				std::size_t n = 0;
+				if (SSL_write_ex(this->_ssl, data.data(), data.size(), &n) == 1)
+				{
+					data.remove_prefix(n);
+					continue;
+				}
+				int err = SSL_get_error(this->_ssl, 0);
+				if (err == SSL_ERROR_WANT_WRITE)
+					co_await this->_WaitIo(EPOLLOUT, timeout);
+				else if (err == SSL_ERROR_WANT_READ)
+					co_await this->_WaitIo(EPOLLIN, timeout);
+				else
+					throw AsyncHttpError("TLS write failed: " + SslError());
+			}
+			else
+			{
+				auto n = send(this->_fd, data.data(), data.size(), MSG_NOSIGNAL);
+				if (n >= 0)
+					data.remove_prefix(n);
+				else if (errno == EAGAIN || errno == EWOULDBLOCK)
+					co_await this->_WaitIo(EPOLLOUT, timeout);
+				else if (errno != EINTR)
+					throw AsyncHttpError("Write failed: "s + std::strerror(errno));
+			}
+		}
+	}
+
+	// Reads a CRLF terminated line without the terminator
+	Task<std::string> ReadLine(std::chrono::milliseconds timeout)
+	{
+		constexpr std::size_t MAX_LINE = 65536;
+		while (true)
+		{
+			auto n = this->_buffer.find("\r\n", this->_pos);
+			if (n != std::string::npos)
+			{
+				std::string line = this->_buffer.substr(this->_pos, n - this->_pos);
+				this->_pos = n + 2;
+				co_return line;
+			}
+			if (this->_buffer.size() - this->_pos > MAX_LINE) throw AsyncHttpError("Header line too long");
+			bool more = co_await this->_fill(timeout);
+			if (!more) throw AsyncHttpError("Connection closed unexpectedly");
+		}
+	}
+
+	Task<void> ReadExact(std::size_t len, std::string& out, std::chrono::milliseconds timeout)
+	{
+		while (len > 0)
+		{
+			if (this->_pos == this->_buffer.size())
+			{
+				bool more = co_await this->_fill(timeout);
+				if (!more) throw AsyncHttpError("Connection closed unexpectedly");
+			}
+			auto n = std::min(len, this->_buffer.size() - this->_pos);
+			out.append(this->_buffer, this->_pos, n);
+			this->_pos += n;
+			len -= n;
+		}
+	}
+
+	Task<void> ReadToEof(std::string& out, std::size_t limit, std::chrono::milliseconds timeout)
+	{
+		while (true)
+		{
+			out.append(this->_buffer, this->_pos);
+			this->_pos = this->_buffer.size();
+			if (out.size() > limit) throw AsyncHttpError("Response body exceeds size limit");
+			bool more = co_await this->_fill(timeout);
+			if (!more) break;
+		}
+	}
+
+	bool buffered() const { return this->_pos < this->_buffer.size(); }
+
+	// Idle connections closed by the peer show up as readable with EOF
+	bool alive() const
+	{
+		char c{};
+		auto n = recv(this->_fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+		if (n == 0) return false;
+		if (n < 0) return errno == EAGAIN || errno == EWOULDBLOCK;
+		// Pending bytes on a plain connection are garbage, on TLS they may be a session ticket
+		return this->_ssl != nullptr;
+	}
+};
+
+
+
+AsyncHttpClient::AsyncHttpClient(EventLoop& loop) : _loop(loop) {}
+
+AsyncHttpClient::~AsyncHttpClient() = default;
+
+AsyncHttpClient& AsyncHttpClient::GetInstance()
+{
+	static AsyncHttpClient client(EventLoop::GetInstance());
+	return client;
+}
+
+void AsyncHttpClient::clear()
+{
+	std::lock_guard<std::mutex> lk(this->_mtx);
+	this->_idle.clear();
+}
+
+std::unique_ptr<AsyncHttpClient::Stream> AsyncHttpClient::_TakeIdle(const std::string& key)
+{
+	std::lock_guard<std::mutex> lk(this->_mtx);
+	auto it = this->_idle.find(key);
+	if (it == this->_idle.end()) return nullptr;
+
+	auto& idle = it->second;
+	auto now = EventLoop::clock::now();
+	while (!idle.empty())
+	{
+		auto conn = std::move(idle.back());
+		idle.pop_back();
+		if (now - conn.LastUsed < IDLE_TIMEOUT && conn.stream->alive()) return std::move(conn.stream);
+	}
+	return nullptr;
+}
+
+void AsyncHttpClient::_PutIdle(const std::string& key, std::unique_ptr<Stream> stream)
+{
+	std::lock_guard<std::mutex> lk(this->_mtx);
+	auto& idle = this->_idle[key];
+	if (idle.size() >= MAX_IDLE_PER_HOST) idle.erase(idle.begin());
+	idle.push_back({std::move(stream), EventLoop::clock::now()});
+}
+
+Task<std::unique_ptr<AsyncHttpClient::Stream>> AsyncHttpClient::_connect(const std::string& scheme,
+                                                                         const std::string& host, int port,
+                                                                         const AsyncHttpOptions& opts)
+{
+	const bool UseProxy = !opts.ProxyHost.empty() && opts.ProxyPort > 0;
+	const auto deadline = EventLoop::clock::now() + opts.ConnectTimeout;
+
+	auto addrs = co_await Resolve(this->_loop, UseProxy ? opts.ProxyHost : host, UseProxy ? opts.ProxyPort : port);
+
+	std::unique_ptr<Stream> stream;
+	std::string error = "no address";
+	for (const auto& addr : addrs)
+	{
+		int fd = socket(addr.addr.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+		if (fd < 0)
+		{
+			error = std::strerror(errno);
+			continue;
+		}
+		auto candidate = std::make_unique<Stream>(this->_loop, fd);
+		int one = 1;
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+		// NOLINTNEXTLINE(*-reinterpret-cast)
+		if (::connect(fd, reinterpret_cast<const sockaddr*>(&addr.addr), addr.len) < 0)
+		{
+			if (errno != EINPROGRESS)
+			{
+				error = std::strerror(errno);
+				continue;
+			}
+			bool ready = co_await this->_loop.wait(fd, EPOLLOUT, deadline);
+			if (!ready) throw AsyncHttpError("Connection to " + host + " timed out");
+
+			int err = 0;
+			socklen_t len = sizeof(err);
+			getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len);
+			if (err != 0)
+			{
+				error = std::strerror(err);
+				continue;
+			}
+		}
+		stream = std::move(candidate);
+		break;
+	}
+	if (!stream) throw AsyncHttpError("Failed to connect to " + host + ": " + error);
+
+	auto remaining = [deadline]
+	{ return std::max(std::chrono::ceil<std::chrono::milliseconds>(deadline - EventLoop::clock::now()), 1ms); };
+
+	if (scheme == "https")
+	{
+		if (UseProxy)
+		{
+			std::string authority = host + ":" + std::to_string(port);
+			std::string tunnel = "CONNECT " + authority + " HTTP/1.1\r\nHost: " + authority + "\r\n\r\n";
+			co_await stream->write(tunnel, remaining());
+			auto status = co_await stream->ReadLine(remaining());
+			while (true)
+			{
+				auto line = co_await stream->ReadLine(remaining());
+				if (line.empty()) break;
+			}
+			if (status.size() < 12 || status.compare(9, 3, "200") != 0)	// NOLINT(*-avoid-magic-numbers)
+				throw AsyncHttpError("Proxy refused tunnel to " + authority + ": " + status);
+		}
+		co_await stream->handshake(host, remaining());
+	}
+	co_return stream;
+}
+
+Task<AsyncHttpResponse> AsyncHttpClient::request(AsyncHttpRequest req, AsyncHttpOptions opts)
+{
+	UrlComponent comp = UrlComponent::ParseUrl(req.url);
+	if (comp.scheme != "http" && comp.scheme != "https") throw AsyncHttpError("Unsupported url: " + req.url);
+	auto [host, port] = comp.GetHostPost();
+	if (port <= 0) throw AsyncHttpError("Invalid port in url: " + req.url);
+	if (host.size() > 2 && host.front() == '[' && host.back() == ']') host = host.substr(1, host.size() - 2);
+
+	const bool UseProxy = !opts.ProxyHost.empty() && opts.ProxyPort > 0;
+	const std::string key = comp.GetOrigin() + (UseProxy ? "|" + opts.ProxyHost + ":" + std::to_string(opts.ProxyPort) : "");
+
+	std::string head = req.method + " ";
+	// Plain http through a proxy uses the absolute form, https goes through a CONNECT tunnel instead
+	head += (UseProxy && comp.scheme == "http") ? comp.GetOrigin() + comp.path : comp.path;
+	if (comp.path.empty()) head += "/";
+	if (!comp.query.empty()) head += "?" + comp.query;
+	head += " HTTP/1.1\r\n";
+	if (req.headers.find("Host") == req.headers.end()) head += "Host: " + comp.authority + "\r\n";
+	if (req.headers.find("Accept") == req.headers.end()) head += "Accept: */*\r\n";
+	if (opts.decompress && req.headers.find("Accept-Encoding") == req.headers.end())
+		head += "Accept-Encoding: gzip, deflate\r\n";
+	head += "Connection: keep-alive\r\n";
+	if (!req.ContentType.empty()) head += "Content-Type: " + req.ContentType + "\r\n";
+	if (!req.body.empty() || req.method == "POST" || req.method == "PUT" || req.method == "PATCH")
+		head += "Content-Length: " + std::to_string(req.body.size()) + "\r\n";
+	for (const auto& [name, value] : req.headers)
+		head += name + ": " + value + "\r\n";
+	head += "\r\n";
+	head += req.body;
+
+	PermitAwaiter admission(this->_loop, comp.GetOrigin());
+	auto permit = co_await admission;
+	if (admission.start > EventLoop::clock::now())
+	{
+		bool woken = co_await this->_loop.sleep(admission.start);
+		(void)woken;
+	}
+
+	// A pooled connection may have been closed by the server meanwhile, retry once on a fresh one
+	for (int attempt = 0;; attempt++)
+	{
+		std::unique_ptr<Stream> stream = (attempt == 0) ? this->_TakeIdle(key) : nullptr;
+		const bool reused = static_cast<bool>(stream);
+		if (!stream) stream = co_await this->_connect(comp.scheme, host, port, opts);
+
+		bool received = false;
+		std::exception_ptr error;
+		AsyncHttpResponse resp;
+		bool reusable = false;
+		try
+		{
+			co_await stream->write(head, opts.WriteTimeout);
+
+			std::string status;
+			do
+			{
+				status = co_await stream->ReadLine(opts.ReadTimeout);
+				received = true;
+
+				// HTTP/1.1 200 OK
+				if (status.size() < 12 || status.compare(0, 5, "HTTP/") != 0)	// NOLINT(*-avoid-magic-numbers)
+					throw AsyncHttpError("Malformed status line: " + status);
+				resp.status = std::stoi(status.substr(9, 3));	// NOLINT(*-avoid-magic-numbers)
+				resp.reason = status.size() > 13 ? status.substr(13) : std::string{};	// NOLINT(*-avoid-magic-numbers)
+				resp.headers.clear();
+
+				while (true)
+				{
+					auto line = co_await stream->ReadLine(opts.ReadTimeout);
+					if (line.empty()) break;
+
+					auto n = line.find(':');
+					if (n == std::string::npos) continue;
+					auto value = line.substr(n + 1);
+					value.erase(0, value.find_first_not_of(" \t"));
+					value.erase(value.find_last_not_of(" \t") + 1);
+					resp.headers.emplace(line.substr(0, n), std::move(value));
+				}
+			} while (resp.status >= 100 && resp.status < 200);	// NOLINT(*-avoid-magic-numbers)
+
+			reusable = status.compare(0, 8, "HTTP/1.1") == 0	// NOLINT(*-avoid-magic-numbers)
+			           && !HeaderContains(resp.get_header_value("Connection"), "close");
+
+			const bool HasBody = req.method != "HEAD" && resp.status != 204 && resp.status != 304;	// NOLINT(*-avoid-magic-numbers)
+			if (!HasBody)
+				resp.body.clear();
+			else if (HeaderContains(resp.get_header_value("Transfer-Encoding"), "chunked"))
+			{
+				while (true)
+				{
+					auto line = co_await stream->ReadLine(opts.ReadTimeout);
+					std::size_t size = std::stoull(line, nullptr, 16);	// NOLINT(*-avoid-magic-numbers)
+					if (size == 0) break;
+					if (resp.body.size() + size > opts.MaxBodySize) throw AsyncHttpError("Response body exceeds size limit");
+					co_await stream->ReadExact(size, resp.body, opts.ReadTimeout);
+					co_await stream->ReadLine(opts.ReadTimeout);
+				}
+				// Trailers
+				while (true)
+				{
+					auto line = co_await stream->ReadLine(opts.ReadTimeout);
+					if (line.empty()) break;
+				}
+			}
+			else if (resp.has_header("Content-Length"))
+			{
+				std::size_t size = std::stoull(resp.get_header_value("Content-Length"));
+				if (size > opts.MaxBodySize) throw AsyncHttpError("Response body exceeds size limit");
+				resp.body.reserve(size);
+				co_await stream->ReadExact(size, resp.body, opts.ReadTimeout);
+			}
+			else
+			{
+				co_await stream->ReadToEof(resp.body, opts.MaxBodySize, opts.ReadTimeout);
+				reusable = false;
+			}
+		}
+		catch (const std::invalid_argument&)
+		{
+			error = std::make_exception_ptr(AsyncHttpError("Malformed response from " + comp.GetOrigin()));
+		}
+		catch (const std::out_of_range&)
+		{
+			error = std::make_exception_ptr(AsyncHttpError("Malformed response from " + comp.GetOrigin()));
+		}
+		catch (...)
+		{
+			error = std::current_exception();
+		}
+
+		if (error)
+		{
+			if (reused && !received) continue;
+			std::rethrow_exception(error);
+		}
+
+		if (reusable && !stream->buffered()) this->_PutIdle(key, std::move(stream));
+		permit.report(resp.status, resp.get_header_value("Retry-After"));
+
+		if (opts.decompress)
+		{
+			auto encoding = resp.get_header_value("Content-Encoding");
+			if (HeaderContains(encoding, "gzip") || HeaderContains(encoding, "deflate"))
+				resp.body = Inflate(resp.body, opts.MaxBodySize);
+		}
+		co_return resp;
+	}
+}
+
+} // namespace Utils
@@ -0,0 +1,280 @@
+#ifndef _UTILS_ASYNC_HTTP_HPP_
+#define _UTILS_ASYNC_HTTP_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <httplib.h>
+
+#include "Coroutine.hpp"
+
+namespace Utils
+{
+
+// epoll based reactor shared by all plugins, a handful of threads resume every suspended request
+class EventLoop
+{
+public:
+	using clock = std::chrono::steady_clock;
+
+protected:
+	struct Waiter
+	{
+		std::coroutine_handle<> handle{};
+		int fd = -1;
+		bool TimedOut = false;
+		std::multimap<clock::time_point, std::uint64_t>::iterator timer{};
+	};
+
+	int _epoll = -1;
+	int _wake = -1;
+	std::atomic<bool> _stop = false;
+	std::vector<std::thread> _threads;
+
+	// Waiters are looked up by id so that a late epoll event never touches a resumed coroutine frame
+	std::mutex _mtx;
+	std::uint64_t _NextId = 1;
+	std::unordered_map<std::uint64_t, Waiter*> _waiters;
+	std::multimap<clock::time_point, std::uint64_t> _timers;
+	std::deque<std::coroutine_handle<>> _ready;
+
+	// Fixed pool for blocking calls handed over by offload, joined with the loop
+	std::vector<std::thread> _workers;
+	std::mutex _JobMtx;
+	std::condition_variable _JobCv;
+	std::deque<std::function<void()>> _jobs;
+	bool _JobStop = false;
+
+	void _run();
+	void _work();
+	void _submit(std::function<void()> job);
+	void _register(Waiter& waiter, std::uint32_t events, clock::time_point deadline);
+
+public:
+	explicit EventLoop(std::size_t threads, std::size_t workers = 4);	// NOLINT(*-avoid-magic-numbers)
+	EventLoop(const EventLoop&) = delete;
+	EventLoop& operator=(const EventLoop&) = delete;
+	EventLoop(EventLoop&&) = delete;
+	EventLoop& operator=(EventLoop&&) = delete;
+	~EventLoop();
+
+	static EventLoop& GetInstance();
+
+	// Resumes handle on one of the loop threads
+	void post(std::coroutine_handle<> handle);
+
+	struct WaitAwaiter
+	{
+		EventLoop& loop;
+		Waiter waiter;
+		std::uint32_t events;
+		clock::time_point deadline;
+
+		bool await_ready() const noexcept { return false; }
+		void await_suspend(std::coroutine_handle<> h)
+		{
+			this->waiter.handle = h;
+			this->loop._register(this->waiter, this->events, this->deadline);
+		}
+		// false if the deadline passed before fd became ready
+		bool await_resume() const noexcept { return !this->waiter.TimedOut; }
+	};
+
+	// Suspends until fd reports one of events (EPOLLIN/EPOLLOUT) or deadline passes
+	WaitAwaiter wait(int fd, std::uint32_t events, clock::time_point deadline)
+	{
+		return {*this, {.fd = fd}, events, deadline};
+	}
+
+	WaitAwaiter sleep(clock::time_point deadline) { return {*this, {}, 0, deadline}; }
+
+	struct ScheduleAwaiter
+	{
+		EventLoop& loop;
+		bool await_ready() const noexcept { return false; }
+		void await_suspend(std::coroutine_handle<> h) const { this->loop.post(h); }
+		void await_resume() const noexcept {}
+	};
+
+	// Moves the awaiting coroutine onto a loop thread
+	ScheduleAwaiter schedule() { return {*this}; }
+
+	template<typename Func> struct OffloadAwaiter
+	{
+		using R = decltype(std::declval<Func&>()());
+
+		EventLoop& loop;
+		Func func;
+		std::optional<std::conditional_t<std::is_void_v<R>, bool, R>> result{};
+		std::exception_ptr exception{};
+
+		bool await_ready() const noexcept { return false; }
+		void await_suspend(std::coroutine_handle<> h)
+		{
+			this->loop._submit(
+				[this, h]
+				{
+					try
+					{
+						if constexpr (std::is_void_v<R>)
+						{
+							this->func();
+							this->result.emplace(true);
+						}
+						else
+							this->result.emplace(this->func());
+					}
+					catch (...)
+					{
+						this->exception = std::current_exception();
+					}
+					this->loop.post(h);
+				});
+		}
+		R await_resume()
+		{
+			if (this->exception) std::rethrow_exception(this->exception);
+			if constexpr (!std::is_void_v<R>) return std::move(*this->result);
+		}
+	};
+
+	// Runs func on the worker pool (for blocking calls such as getaddrinfo or file I/O) and resumes on the loop.
+	// Jobs queue up once every worker is busy
+	template<typename Func> OffloadAwaiter<Func> offload(Func func) { return {*this, std::move(func)}; }
+};
+
+class AsyncHttpError : public std::runtime_error
+{
+public:
+	using std::runtime_error::runtime_error;
+};
+
+// Request and options have constructors on purpose, gcc 12 destroys aggregate temporaries
+// created inside a co_await expression twice
+struct AsyncHttpOptions
+{
+	AsyncHttpOptions() {}	// NOLINT(*-use-equals-default)
+
+	std::chrono::milliseconds ConnectTimeout{std::chrono::seconds(CPPHTTPLIB_CONNECTION_TIMEOUT_SECOND)};
+	std::chrono::milliseconds ReadTimeout{std::chrono::seconds(CPPHTTPLIB_READ_TIMEOUT_SECOND)};
+	std::chrono::milliseconds WriteTimeout{std::chrono::seconds(CPPHTTPLIB_WRITE_TIMEOUT_SECOND)};
+	std::string ProxyHost{};
+	int ProxyPort = -1;
+	bool decompress = true;
+	std::size_t MaxBodySize = std::size_t(256) << 20;	// NOLINT(*-avoid-magic-numbers)
+};
+
+struct AsyncHttpRequest
+{
+	std::string method = "GET";
+	std::string url;
+	httplib::Headers headers{};
+	std::string body{};
+	std::string ContentType{};
+
+	AsyncHttpRequest() {}	// NOLINT(*-use-equals-default)
+	AsyncHttpRequest(std::string method, std::string url, httplib::Headers headers = {}, std::string body = {},
+	                 std::string ContentType = {})
+		: method(std::move(method)), url(std::move(url)), headers(std::move(headers)), body(std::move(body)),
+		  ContentType(std::move(ContentType))
+	{
+	}
+};
+
+struct AsyncHttpResponse
+{
+	int status = -1;
+	std::string reason{};
+	httplib::Headers headers{};
+	std::string body{};
+
+	bool has_header(const std::string& key) const { return this->headers.find(key) != this->headers.end(); }
+	std::string get_header_value(const std::string& key) const
+	{
+		auto it = this->headers.find(key);
+		return it == this->headers.end() ? std::string{} : it->second;
+	}
+	bool ok() const { return this->status >= 200 && this->status <= 299; }	// NOLINT(*-avoid-magic-numbers)
+};
+
+// Non-blocking HTTP/1.1 client on top of EventLoop, keep-alive connections are reused across calls.
+// Handlers combine several requests with WhenAll and block on the result with SyncWait
+class AsyncHttpClient
+{
+public:
+	class Stream;
+
+protected:
+	struct IdleStream
+	{
+		std::unique_ptr<Stream> stream;
+		EventLoop::clock::time_point LastUsed;
+	};
+
+	EventLoop& _loop;
+	std::mutex _mtx;
+	std::unordered_map<std::string, std::vector<IdleStream>> _idle;
+
+	std::unique_ptr<Stream> _TakeIdle(const std::string& key);
+	void _PutIdle(const std::string& key, std::unique_ptr<Stream> stream);
+	Task<std::unique_ptr<Stream>> _connect(const std::string& scheme, const std::string& host, int port,
+	                                       const AsyncHttpOptions& opts);
+
+public:
+	static constexpr std::size_t MAX_IDLE_PER_HOST = 8;
+	static constexpr std::chrono::seconds IDLE_TIMEOUT{30};
+
+	explicit AsyncHttpClient(EventLoop& loop);
+	AsyncHttpClient(const AsyncHttpClient&) = delete;
+	AsyncHttpClient& operator=(const AsyncHttpClient&) = delete;
+	AsyncHttpClient(AsyncHttpClient&&) = delete;
+	AsyncHttpClient& operator=(AsyncHttpClient&&) = delete;
+	~AsyncHttpClient();
+
+	static AsyncHttpClient& GetInstance();
+
+	// Throws AsyncHttpError on transport failures, any status code is returned as is
+	Task<AsyncHttpResponse> request(AsyncHttpRequest req, AsyncHttpOptions opts = {});
+
+	Task<AsyncHttpResponse> Get(std::string url, httplib::Headers headers = {}, AsyncHttpOptions opts = {})
+	{
+		return this->request({"GET", std::move(url), std::move(headers)}, std::move(opts));
+	}
+
+	Task<AsyncHttpResponse> Post(std::string url, httplib::Headers headers, std::string body, std::string ContentType,
+	                             AsyncHttpOptions opts = {})
+	{
+		return this->request({"POST", std::move(url), std::move(headers), std::move(body), std::move(ContentType)},
+		                     std::move(opts));
+	}
+
+	// Closes all idle connections
+	void clear();
+};
+
+// Blocking wrapper for code that is not a coroutine
+inline AsyncHttpResponse FetchSync(AsyncHttpRequest req, AsyncHttpOptions opts = {})
+{
+	return SyncWait(AsyncHttpClient::GetInstance().request(std::move(req), std::move(opts)));
+}
+
+} // namespace Utils
+
+#endif
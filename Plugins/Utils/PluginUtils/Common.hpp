@@ -18,6 +18,8 @@
 #include <Core/States/AccessCtrlList.hpp>
 #include <Core/Utils/Logger.hpp>
 
+#include "Subprocess.hpp"
+
 namespace Bot
 {
 
@@ -28,84 +30,6 @@ class Group;
 namespace Utils
 {
 
-inline std::string ExecCmd(std::vector<std::string> cmd, int& status)
-{
-	if (cmd.empty()) return {};
-
-	std::string result = "";
-	std::vector<char *> param(cmd.size() + 1);
-	std::transform(cmd.begin(), cmd.end(), param.begin(),
-		[](std::string& str) { return str.data(); });
-	param.back() = nullptr;
-
-	pid_t pid{};
-	int p[2];	// NOLINT(*-avoid-c-arrays)
-	if (pipe(p) == -1)
-	{
-		throw std::runtime_error("Failed to open pipe");
-	}
-	if ((pid = fork()) == -1)
-	{
-		throw std::runtime_error("Failed to fork program");
-	}
-	if (pid == 0)
-	{
-		dup2(p[1], STDOUT_FILENO);
-		close(p[0]);
-		close(p[1]);
-		execvp(param[0], param.data());
-		perror(("Failed to execute " + cmd[0]).c_str());
-		exit(1);
-	}
-	close(p[1]);
-
-	constexpr size_t BUFFER_SIZE = 1024;
-	char buffer[BUFFER_SIZE];	// NOLINT(*-avoid-c-arrays)
-	size_t c{};
-	while ((c = read(p[0], buffer, BUFFER_SIZE)) > 0)
-		result.append(buffer, c);
-	close(p[0]);
-
-	if (waitpid(pid, &status, 0) == -1)
-	{
-		throw std::runtime_error("Waitpid failed");
-	}
-
-	return result;
-}
-
-inline int ExecCmd(std::vector<std::string> cmd)
-{
-	if (cmd.empty()) return {};
-
-	std::string result = "";
-	std::vector<char *> param(cmd.size() + 1);
-	std::transform(cmd.begin(), cmd.end(), param.begin(),
-		[](std::string& str) { return str.data(); });
-	param.back() = nullptr;
-
-	pid_t pid{};
-	if ((pid = fork()) == -1)
-	{
-		throw std::runtime_error("Failed to fork program");
-	}
-	if (pid == 0)
-	{
-		execvp(param[0], param.data());
-		perror(("Failed to execute " + cmd[0]).c_str());
-		exit(1);
-	}
-
-	int status{};
-
-	if (waitpid(pid, &status, 0) == -1)
-	{
-		throw std::runtime_error("Waitpid failed");
-	}
-
-	return status;
-}
-
 inline bool CheckAuth(const Mirai::GroupMember& member, const Bot::Group& group, int permission)
 {
 	auto ACList = group.GetState<State::AccessCtrlList>();
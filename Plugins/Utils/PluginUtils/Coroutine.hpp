@@ -0,0 +1,253 @@
+#ifndef _UTILS_COROUTINE_HPP_
+#define _UTILS_COROUTINE_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Utils
+{
+
+template<typename T = void> class Task;
+
+namespace detail
+{
+
+struct TaskPromiseBase
+{
+	std::coroutine_handle<> continuation{};
+	std::exception_ptr exception{};
+
+	struct FinalAwaiter
+	{
+		bool await_ready() const noexcept { return false; }
+		template<typename Promise> std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept
+		{
+			auto next = h.promise().continuation;
+			return next ? next : std::noop_coroutine();
+		}
+		void await_resume() const noexcept {}
+	};
+
+	std::suspend_always initial_suspend() const noexcept { return {}; }
+	FinalAwaiter final_suspend() const noexcept { return {}; }
+	void unhandled_exception() noexcept { this->exception = std::current_exception(); }
+};
+
+template<typename T> struct TaskPromise : public TaskPromiseBase
+{
+	std::optional<T> value{};
+
+	Task<T> get_return_object() noexcept;
+
+	template<typename U> void return_value(U&& v) { this->value.emplace(std::forward<U>(v)); }
+
+	T result()
+	{
+		if (this->exception) std::rethrow_exception(this->exception);
+		return std::move(*this->value);
+	}
+};
+
+template<> struct TaskPromise<void> : public TaskPromiseBase
+{
+	Task<void> get_return_object() noexcept;
+
+	void return_void() const noexcept {}
+
+	void result() const
+	{
+		if (this->exception) std::rethrow_exception(this->exception);
+	}
+};
+
+} // namespace detail
+
+// Lazily started coroutine, runs when awaited and resumes the awaiting coroutine on completion
+template<typename T> class [[nodiscard]] Task
+{
+public:
+	using promise_type = detail::TaskPromise<T>;
+	using value_type = T;
+
+private:
+	std::coroutine_handle<promise_type> _handle{};
+
+	explicit Task(std::coroutine_handle<promise_type> handle) : _handle(handle) {}
+	friend promise_type;
+
+public:
+	Task() = default;
+	Task(const Task&) = delete;
+	Task& operator=(const Task&) = delete;
+	Task(Task&& rhs) noexcept : _handle(std::exchange(rhs._handle, {})) {}
+	Task& operator=(Task&& rhs) noexcept
+	{
+		if (this == &rhs) return *this;
+		if (this->_handle) this->_handle.destroy();
+		this->_handle = std::exchange(rhs._handle, {});
+		return *this;
+	}
+	~Task()
+	{
+		if (this->_handle) this->_handle.destroy();
+	}
+
+	bool valid() const { return static_cast<bool>(this->_handle); }
+
+	bool await_ready() const noexcept { return !this->_handle || this->_handle.done(); }
+	std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+	{
+		this->_handle.promise().continuation = awaiting;
+		return this->_handle;
+	}
+	T await_resume() { return this->_handle.promise().result(); }
+};
+
+namespace detail
+{
+
+template<typename T> Task<T> TaskPromise<T>::get_return_object() noexcept
+{
+	return Task<T>{std::coroutine_handle<TaskPromise<T>>::from_promise(*this)};
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() noexcept
+{
+	return Task<void>{std::coroutine_handle<TaskPromise<void>>::from_promise(*this)};
+}
+
+// Eagerly started, self-destroying coroutine used to drive a Task from non-coroutine code
+struct DetachedTask
+{
+	struct promise_type
+	{
+		DetachedTask get_return_object() const noexcept { return {}; }
+		std::suspend_never initial_suspend() const noexcept { return {}; }
+		std::suspend_never final_suspend() const noexcept { return {}; }
+		void return_void() const noexcept {}
+		void unhandled_exception() const noexcept { std::terminate(); }
+	};
+};
+
+struct SyncWaitState
+{
+	std::mutex mtx;
+	std::condition_variable cv;
+	bool done = false;
+	std::exception_ptr exception{};
+};
+
+template<typename T, typename Result> DetachedTask RunSyncWait(Task<T>& task, Result& result, SyncWaitState& state)
+{
+	try
+	{
+		if constexpr (std::is_void_v<T>)
+			co_await task;
+		else
+			result.emplace(co_await task);
+	}
+	catch (...)
+	{
+		state.exception = std::current_exception();
+	}
+
+	// Notify under the lock, the waiting thread may destroy state right after it is released
+	std::lock_guard<std::mutex> lk(state.mtx);
+	state.done = true;
+	state.cv.notify_all();
+}
+
+struct WhenAllState
+{
+	std::atomic<std::size_t> remaining;
+	std::coroutine_handle<> parent{};
+
+	explicit WhenAllState(std::size_t count) : remaining(count + 1) {}
+
+	void arrive()
+	{
+		auto h = this->parent;
+		if (this->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) h.resume();
+	}
+};
+
+template<typename T> DetachedTask RunWhenAllChild(Task<T>& task, std::optional<T>& result, std::exception_ptr& error,
+                                                  WhenAllState& state)
+{
+	try
+	{
+		result.emplace(co_await task);
+	}
+	catch (...)
+	{
+		error = std::current_exception();
+	}
+	state.arrive();
+}
+
+template<typename T> struct WhenAllAwaiter
+{
+	std::vector<Task<T>>& tasks;
+	std::vector<std::optional<T>>& results;
+	std::vector<std::exception_ptr>& errors;
+	WhenAllState& state;
+
+	bool await_ready() const noexcept { return false; }
+	bool await_suspend(std::coroutine_handle<> h)
+	{
+		this->state.parent = h;
+		for (std::size_t i = 0; i < this->tasks.size(); i++)
+			RunWhenAllChild(this->tasks[i], this->results[i], this->errors[i], this->state);
+		// The extra count keeps children finishing synchronously from resuming us before we suspend
+		return this->state.remaining.fetch_sub(1, std::memory_order_acq_rel) != 1;
+	}
+	void await_resume() const noexcept {}
+};
+
+} // namespace detail
+
+// Blocks the calling thread until task finishes, must not be called from an event loop thread
+template<typename T> T SyncWait(Task<T> task)
+{
+	detail::SyncWaitState state;
+	std::optional<std::conditional_t<std::is_void_v<T>, char, T>> result;
+	detail::RunSyncWait(task, result, state);
+	{
+		std::unique_lock<std::mutex> lk(state.mtx);
+		state.cv.wait(lk, [&state] { return state.done; });
+	}
+	if (state.exception) std::rethrow_exception(state.exception);
+	if constexpr (!std::is_void_v<T>) return std::move(*result);
+}
+
+// Runs all tasks concurrently and returns their results in order, rethrows the first failure by index
+template<typename T> Task<std::vector<T>> WhenAll(std::vector<Task<T>> tasks)
+{
+	std::vector<T> out;
+	if (tasks.empty()) co_return out;
+
+	std::vector<std::optional<T>> results(tasks.size());
+	std::vector<std::exception_ptr> errors(tasks.size());
+	detail::WhenAllState state(tasks.size());
+	co_await detail::WhenAllAwaiter<T>{tasks, results, errors, state};
+
+	for (const auto& e : errors)
+		if (e) std::rethrow_exception(e);
+
+	out.reserve(results.size());
+	for (auto& r : results)
+		out.push_back(std::move(*r));
+	co_return out;
+}
+
+} // namespace Utils
+
+#endif
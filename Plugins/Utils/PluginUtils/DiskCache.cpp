@@ -0,0 +1,241 @@
+#include "DiskCache.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <exception>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <system_error>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <openssl/evp.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <Core/Utils/Logger.hpp>
+
+namespace Utils
+{
+
+namespace
+{
+
+constexpr std::size_t HASH_LENGTH = 64;
+
+bool IsHash(const std::string& name)
+{
+	return name.size() == HASH_LENGTH
+	       && std::all_of(name.begin(), name.end(),
+	                      [](char c) { return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'); });
+}
+
+void WriteSynced(const std::filesystem::path& path, std::string_view data)
+{
+	const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);	// NOLINT(*-vararg, *-avoid-magic-numbers)
+	if (fd == -1) throw std::system_error(errno, std::generic_category(), "Unable to open " + path.string());
+
+	auto fail = [fd, &path](const std::string& what)
+	{
+		const int err = errno;
+		::close(fd);
+		throw std::system_error(err, std::generic_category(), what + " " + path.string());
+	};
+	while (!data.empty())
+	{
+		const ssize_t count = ::write(fd, data.data(), data.size());
+		if (count == -1)
+		{
+			if (errno == EINTR) continue;
+			fail("Unable to write");
+		}
+		data.remove_prefix(static_cast<std::size_t>(count));
+	}
+	if (::fsync(fd) == -1) fail("Unable to sync");
+	if (::close(fd) == -1) throw std::system_error(errno, std::generic_category(), "Unable to close " + path.string());
+}
+
+} // namespace
+
+std::string Sha256(std::string_view data)
+{
+	std::array<unsigned char, EVP_MAX_MD_SIZE> md{};
+	unsigned int len = 0;
+	if (!EVP_Digest(data.data(), data.size(), md.data(), &len, EVP_sha256(), nullptr))
+		throw std::runtime_error("EVP_Digest failed");
+
+	constexpr std::string_view HEX = "0123456789abcdef";
+	std::string result;
+	result.reserve(len * 2);
+	for (unsigned int i = 0; i < len; i++)
+	{
+		result += HEX[md[i] >> 4];	  // NOLINT(*-avoid-magic-numbers)
+		result += HEX[md[i] & 0xf]; // NOLINT(*-avoid-magic-numbers)
+	}
+	return result;
+}
+
+DiskCache::DiskCache(std::filesystem::path dir, std::size_t limit) : _dir(std::move(dir)), _limit(limit)
+{
+	std::lock_guard<std::mutex> lk(this->_mtx);
+	this->_scan();
+	this->_evict();
+}
+
+std::filesystem::path DiskCache::_path(const std::string& hash) const
+{
+	return this->_dir / hash.substr(0, 2) / hash;
+}
+
+void DiskCache::_scan()
+{
+	std::vector<std::tuple<std::filesystem::file_time_type, std::string, std::size_t>> files;
+	// The range-for would advance with the throwing operator++, a file vanishing mid-walk must not abort startup.
+	// Errors of single files get their own code so that they don't end the walk
+	std::error_code ec;
+	for (std::filesystem::recursive_directory_iterator it(this->_dir, ec), end; !ec && it != end; it.increment(ec))
+	{
+		std::error_code FileEc;
+		if (!it->is_regular_file(FileEc)) continue;
+		const std::string name = it->path().filename().string();
+		if (name.find(".tmp") != std::string::npos)
+		{
+			// Left behind by an interrupted write
+			std::filesystem::remove(it->path(), FileEc);
+			continue;
+		}
+		if (!IsHash(name) || it->path().parent_path().filename() != name.substr(0, 2)) continue;
+
+		auto size = it->file_size(FileEc);
+		if (FileEc) continue;
+		auto time = it->last_write_time(FileEc);
+		if (FileEc) continue;
+		files.emplace_back(time, name, size);
+	}
+
+	// Oldest first, so the newest ends up at the front
+	std::sort(files.begin(), files.end());
+	for (auto& [time, hash, size] : files)
+	{
+		this->_order.push_front(hash);
+		this->_index.emplace(std::move(hash), Node{size, this->_order.begin()});
+		this->_bytes += size;
+	}
+	LOG_INFO(GetLogger(), "Loaded " + std::to_string(files.size()) + " files (" + std::to_string(this->_bytes >> 20)
+	                          + " MiB) from cache " + this->_dir.string());
+}
+
+void DiskCache::_drop(const std::string& hash)
+{
+	auto it = this->_index.find(hash);
+	if (it == this->_index.end()) return;
+	this->_bytes -= it->second.size;
+	this->_order.erase(it->second.pos);
+	this->_index.erase(it);
+}
+
+void DiskCache::_evict()
+{
+	std::error_code ec;
+	while (this->_bytes > this->_limit && !this->_order.empty())
+	{
+		const std::string hash = this->_order.back();
+		std::filesystem::remove(this->_path(hash), ec);
+		this->_drop(hash);
+	}
+}
+
+std::optional<std::string> DiskCache::get(std::string_view key)
+{
+	const std::string hash = Sha256(key);
+	{
+		std::lock_guard<std::mutex> lk(this->_mtx);
+		auto it = this->_index.find(hash);
+		if (it == this->_index.end()) return std::nullopt;
+		this->_order.splice(this->_order.begin(), this->_order, it->second.pos);
+	}
+
+	const auto path = this->_path(hash);
+	std::ifstream file(path, std::ios::binary);
+	if (file)
+	{
+		std::string content(std::istreambuf_iterator<char>(file), {});
+		if (!file.bad())
+		{
+			std::error_code ec;
+			std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ec);
+			return content;
+		}
+	}
+
+	// Evicted in the meantime or removed from outside
+	std::error_code ec;
+	if (!std::filesystem::exists(path, ec))
+	{
+		std::lock_guard<std::mutex> lk(this->_mtx);
+		this->_drop(hash);
+	}
+	return std::nullopt;
+}
+
+void DiskCache::put(std::string_view key, std::string_view value)
+{
+	if (value.size() > this->_limit) return;
+
+	const std::string hash = Sha256(key);
+	const auto path = this->_path(hash);
+	auto temp = path;
+	{
+		std::lock_guard<std::mutex> lk(this->_mtx);
+		temp += ".tmp." + std::to_string(this->_serial++);
+	}
+
+	try
+	{
+		std::filesystem::create_directories(path.parent_path());
+		// Synced before the rename, otherwise a crash can leave an empty or partial file under the final name
+		WriteSynced(temp, value);
+		std::filesystem::rename(temp, path);
+	}
+	catch (const std::exception& e)
+	{
+		LOG_WARN(GetLogger(), "Failed to write cache file for " + std::string(key) + ": " + e.what());
+		std::error_code ec;
+		std::filesystem::remove(temp, ec);
+		return;
+	}
+
+	std::lock_guard<std::mutex> lk(this->_mtx);
+	this->_drop(hash);
+	this->_order.push_front(hash);
+	this->_index.emplace(hash, Node{value.size(), this->_order.begin()});
+	this->_bytes += value.size();
+	this->_evict();
+}
+
+void DiskCache::erase(std::string_view key)
+{
+	const std::string hash = Sha256(key);
+	std::lock_guard<std::mutex> lk(this->_mtx);
+	std::error_code ec;
+	std::filesystem::remove(this->_path(hash), ec);
+	this->_drop(hash);
+}
+
+std::size_t DiskCache::bytes()
+{
+	std::lock_guard<std::mutex> lk(this->_mtx);
+	return this->_bytes;
+}
+
+std::size_t DiskCache::count()
+{
+	std::lock_guard<std::mutex> lk(this->_mtx);
+	return this->_index.size();
+}
+
+} // namespace Utils
@@ -0,0 +1,69 @@
+#ifndef _UTILS_DISK_CACHE_HPP_
+#define _UTILS_DISK_CACHE_HPP_
+
+#include <cstddef>
+#include <filesystem>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace Utils
+{
+
+// Lowercase hex sha256 digest
+std::string Sha256(std::string_view data);
+
+// Size bounded on-disk store for immutable blobs, e.g. images behind urls that never change.
+// Files are named <dir>/<sha256 of key>[0:2]/<sha256 of key> and written atomically (temporary file + rename).
+// The LRU index is kept in memory and rebuilt from the modification times when the cache is created, reads
+// touch the file so the order survives restarts. I/O errors only turn into misses
+class DiskCache
+{
+public:
+	static constexpr std::size_t DEFAULT_LIMIT = std::size_t(2) << 30;	// NOLINT(*-avoid-magic-numbers)
+
+protected:
+	struct Node
+	{
+		std::size_t size;
+		std::list<std::string>::iterator pos;
+	};
+
+	const std::filesystem::path _dir;
+	const std::size_t _limit;
+
+	std::mutex _mtx;
+	std::list<std::string> _order;	// Hashes, most recently used at the front
+	std::unordered_map<std::string, Node> _index;
+	std::size_t _bytes = 0;
+	std::size_t _serial = 0;	// Distinguishes temporary files of concurrent writers
+
+	std::filesystem::path _path(const std::string& hash) const;
+	void _scan();
+	void _drop(const std::string& hash);
+	void _evict();
+
+public:
+	explicit DiskCache(std::filesystem::path dir, std::size_t limit = DEFAULT_LIMIT);
+	DiskCache(const DiskCache&) = delete;
+	DiskCache& operator=(const DiskCache&) = delete;
+	DiskCache(DiskCache&&) = delete;
+	DiskCache& operator=(DiskCache&&) = delete;
+	~DiskCache() = default;
+
+	std::optional<std::string> get(std::string_view key);
+	// Values larger than the limit are not stored
+	void put(std::string_view key, std::string_view value);
+	void erase(std::string_view key);
+
+	const std::filesystem::path& directory() const { return this->_dir; }
+	std::size_t bytes();
+	std::size_t count();
+};
+
+} // namespace Utils
+
+#endif
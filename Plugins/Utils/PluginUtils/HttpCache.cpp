@@ -0,0 +1,463 @@
+#include "HttpCache.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <exception>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <string_view>
+#include <system_error>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+#include <Core/Utils/Logger.hpp>
+
+#include "DiskCache.hpp"
+#include "NetworkUtils.hpp"
+#include "StringUtils.hpp"
+
+namespace Utils
+{
+
+namespace
+{
+
+using clock = HttpCache::clock;
+
+struct CacheControl
+{
+	bool NoStore = false;
+	bool NoCache = false;
+	std::optional<std::chrono::seconds> MaxAge;
+};
+
+CacheControl ParseCacheControl(const httplib::Response& response)
+{
+	CacheControl cc;
+	const std::string header = response.get_header_value("Cache-Control");
+	std::string_view value = header;
+	while (!value.empty())
+	{
+		auto pos = value.find(',');
+		std::string directive = toLower(std::string(trim(value.substr(0, pos), " \t")));
+		value = (pos == std::string_view::npos) ? std::string_view{} : value.substr(pos + 1);
+
+		if (directive == "no-store")
+			cc.NoStore = true;
+		else if (directive == "no-cache")
+			cc.NoCache = true;
+		else if (directive.starts_with("max-age="))
+		{
+			long long seconds{};
+			if (Str2Num(std::string_view(directive).substr(std::string_view("max-age=").size()), seconds))
+				cc.MaxAge = std::chrono::seconds(std::max(seconds, 0LL));
+		}
+	}
+	return cc;
+}
+
+clock::time_point GetExpiry(const httplib::Response& response, const CachePolicy& policy, clock::time_point now)
+{
+	auto cc = ParseCacheControl(response);
+	if (cc.NoCache) return now;
+
+	if (cc.MaxAge)
+	{
+		long long age{};
+		if (!Str2Num(response.get_header_value("Age"), age)) age = 0;
+		return now + *cc.MaxAge - std::chrono::seconds(std::max(age, 0LL));
+	}
+
+	auto date = ParseHttpDate(response.get_header_value("Date")).value_or(now);
+	if (auto expires = ParseHttpDate(response.get_header_value("Expires")))
+		return now + (*expires - date);
+
+	if (policy.DefaultTtl.count() > 0) return now + policy.DefaultTtl;
+
+	// Heuristic freshness (RFC 9111 4.2.2): a tenth of the time since the last modification
+	if (auto modified = ParseHttpDate(response.get_header_value("Last-Modified")); modified && *modified < date)
+		return now + std::min<clock::duration>((date - *modified) / 10, std::chrono::hours(24)); // NOLINT(*-avoid-magic-numbers)
+
+	return now;
+}
+
+// Hop-by-hop headers and the ones describing the encoded body are not kept, bodies are stored decoded
+bool IsStoredHeader(const std::string& name)
+{
+	static const std::array<std::string, 7> SKIPPED = {"connection",     "keep-alive", "transfer-encoding",
+	                                                   "content-length", "content-encoding", "set-cookie",
+	                                                   "proxy-connection"};
+	return std::find(SKIPPED.begin(), SKIPPED.end(), toLower(name)) == SKIPPED.end();
+}
+
+void WriteFile(const std::filesystem::path& path, std::string_view content)
+{
+	std::filesystem::create_directories(path.parent_path());
+	auto temp = path;
+	temp += ".tmp";
+	{
+		std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+		if (!file) throw std::runtime_error("Unable to open " + temp.string());
+		file.write(content.data(), static_cast<std::streamsize>(content.size()));
+		if (!file) throw std::runtime_error("Unable to write " + temp.string());
+	}
+	std::filesystem::rename(temp, path);
+}
+
+std::optional<std::string> ReadFile(const std::filesystem::path& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file) return std::nullopt;
+	return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+std::filesystem::path ShardedPath(const std::filesystem::path& dir, const std::string& hash)
+{
+	return dir / hash.substr(0, 2) / hash;
+}
+
+} // namespace
+
+bool HttpCache::Entry::fresh(const CachePolicy& policy) const
+{
+	switch (policy.mode)
+	{
+	case CachePolicy::Mode::IMMUTABLE:
+		return true;
+	case CachePolicy::Mode::NO_STORE:
+	case CachePolicy::Mode::NO_CACHE:
+		return false;
+	default:
+		return clock::now() < this->expires;
+	}
+}
+
+HttpCache& HttpCache::GetInstance()
+{
+	static HttpCache cache;
+	return cache;
+}
+
+void HttpCache::SetDirectory(std::filesystem::path dir)
+{
+	std::lock_guard<std::mutex> lk(this->_DiskMtx);
+	if (this->_dir == dir) return;
+	this->_dir = std::move(dir);
+	this->_DiskScanned = false;
+}
+
+void HttpCache::WatchConfig(const BotConfig& config)
+{
+	static const ConfigKey MEDIA_KEY("/path/MediaFiles");
+	std::call_once(this->_WatchOnce,
+	               [this, &config]
+	               {
+					   // Only config runs the callback, so the reference is alive whenever it does
+					   auto update = [this, &config]
+					   { this->SetDirectory(config.Get(MEDIA_KEY, std::filesystem::path("MediaFiles")) / "cache/http"); };
+					   update();
+					   this->_MediaSubscription = config.Subscribe(MEDIA_KEY, update);
+				   });
+}
+
+void HttpCache::SetLimits(std::size_t MemoryBytes, std::size_t DiskBytes)
+{
+	{
+		std::lock_guard<std::mutex> lk(this->_mtx);
+		this->_MemoryLimit = MemoryBytes;
+	}
+	{
+		std::lock_guard<std::mutex> lk(this->_DiskMtx);
+		this->_DiskLimit = DiskBytes;
+	}
+}
+
+std::shared_ptr<const HttpCache::Entry> HttpCache::find(const std::string& key)
+{
+	{
+		std::lock_guard<std::mutex> lk(this->_mtx);
+		auto it = this->_memory.find(key);
+		if (it != this->_memory.end())
+		{
+			this->_order.splice(this->_order.begin(), this->_order, it->second.pos);
+			return it->second.entry;
+		}
+	}
+
+	auto entry = this->_load(key);
+	if (entry) this->_remember(key, entry);
+	return entry;
+}
+
+std::shared_ptr<const HttpCache::Entry> HttpCache::store(const std::string& key,
+                                                         std::shared_ptr<const httplib::Response> response,
+                                                         const CachePolicy& policy)
+{
+	if (policy.mode == CachePolicy::Mode::NO_STORE || response->status != 200) // NOLINT(*-avoid-magic-numbers)
+		return nullptr;
+	if (policy.mode != CachePolicy::Mode::IMMUTABLE
+	    && (ParseCacheControl(*response).NoStore || response->get_header_value("Vary") == "*"))
+		return nullptr;
+
+	auto entry = std::make_shared<Entry>();
+	entry->expires = GetExpiry(*response, policy, clock::now());
+	entry->ETag = response->get_header_value("ETag");
+	entry->LastModified = response->get_header_value("Last-Modified");
+	if (policy.mode == CachePolicy::Mode::DEFAULT && entry->expires <= clock::now() && !entry->HasValidator())
+		return nullptr;
+
+	entry->ObjectId = Sha256(response->body);
+	entry->response = std::move(response);
+
+	this->_remember(key, entry);
+	this->_save(key, *entry);
+	return entry;
+}
+
+std::shared_ptr<const HttpCache::Entry> HttpCache::refresh(const std::string& key, const Entry& entry,
+                                                           const httplib::Response& NotModified,
+                                                           const CachePolicy& policy)
+{
+	auto response = std::make_shared<httplib::Response>(*entry.response);
+	for (const auto& [name, value] : NotModified.headers)
+	{
+		if (!IsStoredHeader(name)) continue;
+		response->headers.erase(name);
+	}
+	for (const auto& [name, value] : NotModified.headers)
+	{
+		if (!IsStoredHeader(name)) continue;
+		response->headers.emplace(name, value);
+	}
+
+	auto updated = std::make_shared<Entry>(entry);
+	updated->expires = GetExpiry(*response, policy, clock::now());
+	updated->ETag = response->get_header_value("ETag");
+	updated->LastModified = response->get_header_value("Last-Modified");
+	updated->response = std::move(response);
+
+	this->_remember(key, updated);
+	this->_save(key, *updated);
+	return updated;
+}
+
+void HttpCache::erase(const std::string& key)
+{
+	{
+		std::lock_guard<std::mutex> lk(this->_mtx);
+		auto it = this->_memory.find(key);
+		if (it != this->_memory.end())
+		{
+			this->_MemoryBytes -= it->second.entry->response->body.size();
+			this->_order.erase(it->second.pos);
+			this->_memory.erase(it);
+		}
+	}
+
+	std::lock_guard<std::mutex> lk(this->_DiskMtx);
+	if (this->_dir.empty()) return;
+	std::error_code ec;
+	std::filesystem::remove(ShardedPath(this->_dir / "meta", Sha256(key)), ec);
+}
+
+void HttpCache::clear()
+{
+	std::lock_guard<std::mutex> lk(this->_mtx);
+	this->_memory.clear();
+	this->_order.clear();
+	this->_MemoryBytes = 0;
+}
+
+void HttpCache::_remember(const std::string& key, std::shared_ptr<const Entry> entry)
+{
+	std::lock_guard<std::mutex> lk(this->_mtx);
+
+	auto it = this->_memory.find(key);
+	if (it != this->_memory.end())
+	{
+		this->_MemoryBytes -= it->second.entry->response->body.size();
+		this->_order.erase(it->second.pos);
+		this->_memory.erase(it);
+	}
+
+	const std::size_t size = entry->response->body.size();
+	if (size > MEMORY_ENTRY_LIMIT || size > this->_MemoryLimit) return;
+
+	this->_order.push_front(key);
+	this->_memory.emplace(key, Node{std::move(entry), this->_order.begin()});
+	this->_MemoryBytes += size;
+
+	while (this->_MemoryBytes > this->_MemoryLimit)
+	{
+		auto victim = this->_memory.find(this->_order.back());
+		this->_MemoryBytes -= victim->second.entry->response->body.size();
+		this->_memory.erase(victim);
+		this->_order.pop_back();
+	}
+}
+
+std::shared_ptr<const HttpCache::Entry> HttpCache::_load(const std::string& key)
+{
+	using json = nlohmann::json;
+
+	std::lock_guard<std::mutex> lk(this->_DiskMtx);
+	if (this->_dir.empty()) return nullptr;
+	const auto MetaPath = ShardedPath(this->_dir / "meta", Sha256(key));
+	try
+	{
+		auto meta = ReadFile(MetaPath);
+		if (!meta) return nullptr;
+
+		json content = json::parse(*meta);
+		if (content.at("key").get<std::string>() != key) return nullptr;
+
+		auto entry = std::make_shared<Entry>();
+		entry->ObjectId = content.at("object").get<std::string>();
+		entry->expires = clock::time_point(std::chrono::seconds(content.at("expires").get<long long>()));
+		entry->ETag = content.at("etag").get<std::string>();
+		entry->LastModified = content.at("last_modified").get<std::string>();
+
+		const auto ObjectPath = ShardedPath(this->_dir / "objects", entry->ObjectId);
+		auto body = ReadFile(ObjectPath);
+		if (!body)
+		{
+			// The body was pruned
+			std::filesystem::remove(MetaPath);
+			return nullptr;
+		}
+		std::filesystem::last_write_time(ObjectPath, std::filesystem::file_time_type::clock::now());
+
+		auto response = std::make_shared<httplib::Response>();
+		response->status = content.at("status").get<int>();
+		response->reason = content.at("reason").get<std::string>();
+		for (const auto& header : content.at("headers"))
+			response->headers.emplace(header.at(0).get<std::string>(), header.at(1).get<std::string>());
+		response->body = std::move(*body);
+		entry->response = std::move(response);
+		return entry;
+	}
+	catch (const std::exception& e)
+	{
+		LOG_WARN(GetLogger(), "Dropping unreadable cache entry " + MetaPath.string() + ": " + e.what());
+		std::error_code ec;
+		std::filesystem::remove(MetaPath, ec);
+		return nullptr;
+	}
+}
+
+void HttpCache::_save(const std::string& key, const Entry& entry)
+{
+	using json = nlohmann::json;
+
+	std::lock_guard<std::mutex> lk(this->_DiskMtx);
+	if (this->_dir.empty()) return;
+	try
+	{
+		if (!this->_DiskScanned)
+		{
+			this->_DiskBytes = 0;
+			// The range-for would advance with the throwing operator++
+			std::error_code ec;
+			for (std::filesystem::recursive_directory_iterator it(this->_dir / "objects", ec), end; !ec && it != end;
+			     it.increment(ec))
+			{
+				std::error_code FileEc;
+				if (!it->is_regular_file(FileEc)) continue;
+				auto size = it->file_size(FileEc);
+				if (!FileEc) this->_DiskBytes += size;
+			}
+			this->_DiskScanned = true;
+		}
+
+		const auto ObjectPath = ShardedPath(this->_dir / "objects", entry.ObjectId);
+		if (!std::filesystem::exists(ObjectPath))
+		{
+			WriteFile(ObjectPath, entry.response->body);
+			this->_DiskBytes += entry.response->body.size();
+		}
+
+		json headers = json::array();
+		for (const auto& [name, value] : entry.response->headers)
+			if (IsStoredHeader(name)) headers.push_back({name, value});
+
+		json meta = {
+			{"key", key},
+			{"status", entry.response->status},
+			{"reason", entry.response->reason},
+			{"headers", std::move(headers)},
+			{"object", entry.ObjectId},
+			{"expires", std::chrono::duration_cast<std::chrono::seconds>(entry.expires.time_since_epoch()).count()},
+			{"etag", entry.ETag},
+			{"last_modified", entry.LastModified}
+		};
+		WriteFile(ShardedPath(this->_dir / "meta", Sha256(key)), meta.dump());
+
+		if (this->_DiskBytes > this->_DiskLimit) this->_prune();
+	}
+	catch (const std::exception& e)
+	{
+		LOG_WARN(GetLogger(), "Failed to write cache entry for " + key + ": " + e.what());
+	}
+}
+
+void HttpCache::_prune()
+{
+	using json = nlohmann::json;
+
+	// Least recently read objects go first, reads touch the modification time
+	std::vector<std::tuple<std::filesystem::file_time_type, std::filesystem::path, std::uintmax_t>> objects;
+	std::error_code ec;
+	for (std::filesystem::recursive_directory_iterator it(this->_dir / "objects", ec), end; !ec && it != end;
+	     it.increment(ec))
+	{
+		// Errors of single files must not end the walk
+		std::error_code FileEc;
+		if (!it->is_regular_file(FileEc)) continue;
+		auto size = it->file_size(FileEc);
+		if (FileEc) continue;
+		auto time = it->last_write_time(FileEc);
+		if (FileEc) continue;
+		objects.emplace_back(time, it->path(), size);
+	}
+	std::sort(objects.begin(), objects.end());
+
+	const std::size_t target = this->_DiskLimit / 10 * 9; // NOLINT(*-avoid-magic-numbers)
+	std::size_t removed = 0;
+	for (const auto& [time, path, size] : objects)
+	{
+		if (this->_DiskBytes <= target) break;
+		if (std::filesystem::remove(path, ec))
+		{
+			this->_DiskBytes -= std::min<std::size_t>(size, this->_DiskBytes);
+			removed++;
+		}
+	}
+	if (removed == 0) return;
+
+	// Metadata of removed bodies would only ever be a miss
+	for (std::filesystem::recursive_directory_iterator it(this->_dir / "meta", ec), end; !ec && it != end;
+	     it.increment(ec))
+	{
+		std::error_code FileEc;
+		if (!it->is_regular_file(FileEc)) continue;
+		try
+		{
+			auto meta = ReadFile(it->path());
+			if (!meta) continue;
+			auto id = json::parse(*meta).at("object").get<std::string>();
+			if (!std::filesystem::exists(ShardedPath(this->_dir / "objects", id)))
+				std::filesystem::remove(it->path(), FileEc);
+		}
+		catch (const std::exception&)
+		{
+			std::filesystem::remove(it->path(), FileEc);
+		}
+	}
+	LOG_INFO(GetLogger(), "Pruned " + std::to_string(removed) + " objects from the http cache");
+}
+
+} // namespace Utils
@@ -0,0 +1,123 @@
+#ifndef _UTILS_HTTP_CACHE_HPP_
+#define _UTILS_HTTP_CACHE_HPP_
+
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <httplib.h>
+
+#include <Core/Utils/Common.hpp>
+
+namespace Utils
+{
+
+// Per-call override of how responses are cached
+struct CachePolicy
+{
+	enum class Mode
+	{
+		DEFAULT,	// Follow Cache-Control/Expires/Last-Modified from the server
+		NO_STORE,	// Bypass the cache completely
+		NO_CACHE,	// Store, but revalidate stored responses on every use
+		IMMUTABLE	// Stored responses never expire, e.g. content addressed urls
+	};
+
+	Mode mode = Mode::DEFAULT;
+	// Freshness lifetime for responses that come without any
+	std::chrono::seconds DefaultTtl{0};
+};
+
+// Two tier cache for GET responses: a memory LRU in front of an on-disk store.
+// Bodies on disk are content addressed (objects/<sha256 of body>), metadata is kept per request key
+class HttpCache
+{
+public:
+	using clock = std::chrono::system_clock;
+
+	struct Entry
+	{
+		std::shared_ptr<const httplib::Response> response;
+		std::string ObjectId;
+		clock::time_point expires;
+		std::string ETag;
+		std::string LastModified;
+
+		bool fresh(const CachePolicy& policy) const;
+		bool HasValidator() const { return !this->ETag.empty() || !this->LastModified.empty(); }
+	};
+
+	static constexpr std::size_t MEMORY_LIMIT = std::size_t(64) << 20;	// NOLINT(*-avoid-magic-numbers)
+	static constexpr std::size_t DISK_LIMIT = std::size_t(1) << 30;	// NOLINT(*-avoid-magic-numbers)
+	// Larger bodies only go to disk
+	static constexpr std::size_t MEMORY_ENTRY_LIMIT = std::size_t(8) << 20;	// NOLINT(*-avoid-magic-numbers)
+
+protected:
+	struct Node
+	{
+		std::shared_ptr<const Entry> entry;
+		std::list<std::string>::iterator pos;
+	};
+
+	std::mutex _mtx;
+	std::filesystem::path _dir;	// Empty while the disk tier is off
+	std::size_t _MemoryLimit = MEMORY_LIMIT;
+	std::size_t _DiskLimit = DISK_LIMIT;
+
+	std::list<std::string> _order;	// Most recently used at the front
+	std::unordered_map<std::string, Node> _memory;
+	std::size_t _MemoryBytes = 0;
+
+	std::mutex _DiskMtx;
+	std::size_t _DiskBytes = 0;
+	bool _DiskScanned = false;
+
+	std::once_flag _WatchOnce;
+	BotConfig::Subscription _MediaSubscription;
+
+	void _remember(const std::string& key, std::shared_ptr<const Entry> entry);
+	std::shared_ptr<const Entry> _load(const std::string& key);
+	void _save(const std::string& key, const Entry& entry);
+	void _prune();
+
+public:
+	HttpCache() = default;
+	HttpCache(const HttpCache&) = delete;
+	HttpCache& operator=(const HttpCache&) = delete;
+	HttpCache(HttpCache&&) = delete;
+	HttpCache& operator=(HttpCache&&) = delete;
+	~HttpCache() = default;
+
+	static HttpCache& GetInstance();
+
+	// The disk tier is off until this is called. Setting the same directory again is a no-op
+	void SetDirectory(std::filesystem::path dir);
+	// Puts the disk tier in cache/http under /path/MediaFiles and moves it along when the path changes.
+	// Plugins call this from InitPlugin, only the first call does anything
+	void WatchConfig(const BotConfig& config);
+	void SetLimits(std::size_t MemoryBytes, std::size_t DiskBytes);
+
+	// Returns the stored entry for key even if it is stale, nullptr on miss
+	std::shared_ptr<const Entry> find(const std::string& key);
+
+	// Stores a 200 response, returns nullptr if the response is not cacheable under policy
+	std::shared_ptr<const Entry> store(const std::string& key, std::shared_ptr<const httplib::Response> response,
+	                                   const CachePolicy& policy = {});
+
+	// Updates the lifetime and validators of entry from a 304 response
+	std::shared_ptr<const Entry> refresh(const std::string& key, const Entry& entry,
+	                                     const httplib::Response& NotModified, const CachePolicy& policy = {});
+
+	void erase(const std::string& key);
+
+	// Drops the memory tier, the disk tier is kept
+	void clear();
+};
+
+} // namespace Utils
+
+#endif
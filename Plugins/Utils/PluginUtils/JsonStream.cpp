@@ -0,0 +1,436 @@
+#include "JsonStream.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+
+#include "NetworkUtils.hpp"
+
+namespace Utils
+{
+
+namespace
+{
+
+using json = nlohmann::json;
+
+// SAX handler that tracks the JSON pointer of the current value and only materializes selected subtrees
+class JsonSelector
+{
+protected:
+	struct Frame
+	{
+		bool array;
+		std::size_t index = 0;
+		std::string key;
+		std::string path;
+	};
+
+	std::vector<std::string> _pointers;	// Sorted
+	std::vector<Frame> _frames;
+	json _result;
+
+	// Containers being built, non-empty while inside a selected value
+	std::vector<json*> _capture;
+	std::string _error;
+
+	static std::string _escape(const std::string& token)
+	{
+		std::string escaped;
+		escaped.reserve(token.size());
+		for (char c : token)
+		{
+			if (c == '~')
+				escaped += "~0";
+			else if (c == '/')
+				escaped += "~1";
+			else
+				escaped += c;
+		}
+		return escaped;
+	}
+
+	std::string _ChildPath() const
+	{
+		if (this->_frames.empty()) return {};
+		const auto& frame = this->_frames.back();
+		return frame.path + "/" + (frame.array ? std::to_string(frame.index) : _escape(frame.key));
+	}
+
+	bool _selected(const std::string& path) const
+	{
+		return std::binary_search(this->_pointers.begin(), this->_pointers.end(), path);
+	}
+
+	// Places value at the current position and returns where it ended up, nullptr if it is not selected
+	json* _place(json&& value)
+	{
+		if (!this->_capture.empty())
+		{
+			json* parent = this->_capture.back();
+			if (parent->is_array())
+			{
+				parent->push_back(std::move(value));
+				return &parent->back();
+			}
+			return &((*parent)[this->_frames.back().key] = std::move(value));
+		}
+
+		auto path = this->_ChildPath();
+		if (!this->_selected(path)) return nullptr;
+		return &(this->_result[json::json_pointer(path)] = std::move(value));
+	}
+
+	void _next()
+	{
+		if (!this->_frames.empty() && this->_frames.back().array) this->_frames.back().index++;
+	}
+
+	bool _scalar(json&& value)
+	{
+		this->_place(std::move(value));
+		this->_next();
+		return true;
+	}
+
+	bool _start(bool array)
+	{
+		const bool capturing = !this->_capture.empty();
+		json* node = this->_place(array ? json::array() : json::object());
+		if (node != nullptr) this->_capture.push_back(node);
+
+		// Frames of captured containers only need the key, the path is not looked at anymore
+		this->_frames.push_back({array, 0, {}, capturing || node != nullptr ? std::string{} : this->_ChildPath()});
+		return true;
+	}
+
+	bool _end()
+	{
+		this->_frames.pop_back();
+		if (!this->_capture.empty()) this->_capture.pop_back();
+		this->_next();
+		return true;
+	}
+
+public:
+	explicit JsonSelector(std::vector<std::string> pointers) : _pointers(std::move(pointers))
+	{
+		if (this->_pointers.empty()) this->_pointers.emplace_back();
+		std::sort(this->_pointers.begin(), this->_pointers.end());
+	}
+
+	json release() { return std::move(this->_result); }
+	const std::string& error() const { return this->_error; }
+
+	bool null() { return this->_scalar(nullptr); }
+	bool boolean(bool val) { return this->_scalar(val); }
+	bool number_integer(json::number_integer_t val) { return this->_scalar(val); }
+	bool number_unsigned(json::number_unsigned_t val) { return this->_scalar(val); }
+	bool number_float(json::number_float_t val, const json::string_t& /*unused*/) { return this->_scalar(val); }
+	bool string(json::string_t& val) { return this->_scalar(std::move(val)); }
+	bool binary(json::binary_t& val) { return this->_scalar(json::binary(std::move(val))); }
+
+	bool start_object(std::size_t /*unused*/) { return this->_start(false); }
+	bool end_object() { return this->_end(); }
+	bool start_array(std::size_t /*unused*/) { return this->_start(true); }
+	bool end_array() { return this->_end(); }
+
+	bool key(json::string_t& val)
+	{
+		this->_frames.back().key = std::move(val);
+		return true;
+	}
+
+	bool parse_error(std::size_t /*unused*/, const std::string& /*unused*/, const nlohmann::detail::exception& ex)
+	{
+		this->_error = ex.what();
+		return false;
+	}
+};
+
+// Incremental parser for chunks as they arrive, drives a JsonSelector with the same events as json::sax_parse.
+// Only the structure is tracked here, complete scalars are handed to nlohmann's parser
+class JsonPushParser
+{
+protected:
+	enum class Expect
+	{
+		VALUE,
+		FIRST_VALUE,	// Right after '[', ']' is allowed
+		FIRST_KEY,		// Right after '{', '}' is allowed
+		KEY,
+		COLON,
+		NEXT,			// ',' or the end of the container
+		END
+	};
+
+	enum class Token
+	{
+		NONE,
+		STRING,
+		NUMBER,
+		LITERAL
+	};
+
+	JsonSelector& _sax;
+	std::vector<bool> _arrays;	// Open containers, true for arrays
+	Expect _expect = Expect::VALUE;
+	Token _token = Token::NONE;
+	bool _key = false;
+	bool _escaped = false;
+	std::string _buffer;	// The scalar being received
+	std::size_t _offset = 0;
+	std::string _error;
+
+	bool _fail(std::string error)
+	{
+		this->_error = std::move(error);
+		return false;
+	}
+
+	bool _unexpected(char c)
+	{
+		return this->_fail("syntax error at byte " + std::to_string(this->_offset) + ": unexpected '" + std::string(1, c)
+		                   + "'");
+	}
+
+	void _value()
+	{
+		this->_expect = this->_arrays.empty() ? Expect::END : Expect::NEXT;
+	}
+
+	bool _scalar()
+	{
+		const Token token = std::exchange(this->_token, Token::NONE);
+		if (token == Token::STRING && this->_key)
+		{
+			try
+			{
+				auto key = json::parse(this->_buffer).get<std::string>();
+				this->_sax.key(key);
+			}
+			catch (const json::exception& e)
+			{
+				return this->_fail(e.what());
+			}
+			this->_expect = Expect::COLON;
+			return true;
+		}
+
+		if (!json::sax_parse(this->_buffer, &this->_sax)) return this->_fail(this->_sax.error());
+		this->_value();
+		return true;
+	}
+
+	bool _close(bool array)
+	{
+		if (this->_arrays.empty() || this->_arrays.back() != array) return this->_unexpected(array ? ']' : '}');
+		if (array)
+			this->_sax.end_array();
+		else
+			this->_sax.end_object();
+		this->_arrays.pop_back();
+		this->_value();
+		return true;
+	}
+
+	bool _begin(char c)
+	{
+		if (c == '-' || (c >= '0' && c <= '9'))
+		{
+			this->_token = Token::NUMBER;
+			this->_buffer.assign(1, c);
+			return true;
+		}
+
+		switch (c)
+		{
+		case '{':
+			this->_sax.start_object(static_cast<std::size_t>(-1));
+			this->_arrays.push_back(false);
+			this->_expect = Expect::FIRST_KEY;
+			return true;
+		case '[':
+			this->_sax.start_array(static_cast<std::size_t>(-1));
+			this->_arrays.push_back(true);
+			this->_expect = Expect::FIRST_VALUE;
+			return true;
+		case '"':
+			this->_token = Token::STRING;
+			this->_key = false;
+			break;
+		case 't':
+		case 'f':
+		case 'n':
+			this->_token = Token::LITERAL;
+			break;
+		default:
+			return this->_unexpected(c);
+		}
+		this->_buffer.assign(1, c);
+		return true;
+	}
+
+	// Structural character outside of any scalar
+	bool _structure(char c)
+	{
+		if (c == ' ' || c == '\t' || c == '\n' || c == '\r') return true;
+
+		switch (this->_expect)
+		{
+		case Expect::FIRST_VALUE:
+			if (c == ']') return this->_close(true);
+			[[fallthrough]];
+		case Expect::VALUE:
+			return this->_begin(c);
+		case Expect::FIRST_KEY:
+			if (c == '}') return this->_close(false);
+			[[fallthrough]];
+		case Expect::KEY:
+			if (c != '"') return this->_unexpected(c);
+			this->_token = Token::STRING;
+			this->_key = true;
+			this->_buffer.assign(1, c);
+			return true;
+		case Expect::COLON:
+			if (c != ':') return this->_unexpected(c);
+			this->_expect = Expect::VALUE;
+			return true;
+		case Expect::NEXT:
+			if (c == ',')
+			{
+				this->_expect = this->_arrays.back() ? Expect::VALUE : Expect::KEY;
+				return true;
+			}
+			if (c == ']' || c == '}') return this->_close(c == ']');
+			return this->_unexpected(c);
+		case Expect::END:
+			return this->_unexpected(c);
+		}
+		return true;
+	}
+
+	static bool _InNumber(char c)
+	{
+		return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+	}
+
+public:
+	explicit JsonPushParser(JsonSelector& sax) : _sax(sax) {}
+
+	// Returns false on malformed input, the parser is unusable afterwards
+	bool feed(const char* data, std::size_t len)
+	{
+		if (!this->_error.empty()) return false;
+
+		std::size_t i = 0;
+		while (i < len)
+		{
+			if (this->_token == Token::STRING)
+			{
+				// Copy up to the closing quote in one go, only escapes need a closer look
+				std::size_t j = i;
+				while (j < len)
+				{
+					const char c = data[j++];
+					if (this->_escaped)
+						this->_escaped = false;
+					else if (c == '\\')
+						this->_escaped = true;
+					else if (c == '"')
+					{
+						this->_buffer.append(data + i, j - i);
+						this->_offset += j - i;
+						i = j;
+						if (!this->_scalar()) return false;
+						break;
+					}
+				}
+				if (this->_token == Token::STRING)
+				{
+					this->_buffer.append(data + i, j - i);
+					this->_offset += j - i;
+					i = j;
+				}
+				continue;
+			}
+
+			const char c = data[i];
+			if (this->_token == Token::NUMBER && _InNumber(c))
+				this->_buffer += c;
+			else if (this->_token == Token::LITERAL && c >= 'a' && c <= 'z')
+				this->_buffer += c;
+			else
+			{
+				// The character after a number or a literal ends it and is looked at again
+				if (this->_token != Token::NONE && !this->_scalar()) return false;
+				if (!this->_structure(c)) return false;
+			}
+			i++;
+			this->_offset++;
+		}
+		return true;
+	}
+
+	// No more data, returns false if the document is incomplete
+	bool finish()
+	{
+		if (!this->_error.empty()) return false;
+		if (this->_token == Token::NUMBER || this->_token == Token::LITERAL)
+			if (!this->_scalar()) return false;
+		if (this->_expect != Expect::END || this->_token != Token::NONE)
+			return this->_fail("syntax error at byte " + std::to_string(this->_offset) + ": unexpected end of input");
+		return true;
+	}
+
+	bool failed() const { return !this->_error.empty(); }
+	const std::string& error() const { return this->_error; }
+};
+
+} // namespace
+
+json ParseJsonSelected(std::istream& in, std::vector<std::string> pointers)
+{
+	JsonSelector selector(std::move(pointers));
+	if (!json::sax_parse(in, &selector)) throw ParseError(selector.error(), "<stream>");
+	return selector.release();
+}
+
+json GetJsonStreaming(const StreamingRequest& request, std::vector<std::string> pointers)
+{
+	JsonSelector selector(std::move(pointers));
+	JsonPushParser parser(selector);
+
+	bool success = true;
+	std::string ErrorBody;
+	auto result = request(
+		[&success](const httplib::Response& response)
+		{
+			success = response.status >= 200 && response.status <= 299;	// NOLINT(*-avoid-magic-numbers)
+			return true;
+		},
+		[&](const char* data, size_t len)
+		{
+			// Error bodies are kept for the exception message instead
+			if (!success)
+			{
+				ErrorBody.append(data, len);
+				return true;
+			}
+			return parser.feed(data, len);
+		});
+
+	if (result && !VerifyResponse(result))
+	{
+		result->body = std::move(ErrorBody);
+		throw NetworkException(result);
+	}
+	// Parse errors cancel the download, that is not a network failure
+	if (parser.failed() || (result && !parser.finish()))
+		throw ParseError(parser.error(), "<stream>");
+	if (!result) throw NetworkException(result);
+
+	return selector.release();
+}
+
+} // namespace Utils
@@ -0,0 +1,28 @@
+#ifndef _UTILS_JSON_STREAM_HPP_
+#define _UTILS_JSON_STREAM_HPP_
+
+#include <functional>
+#include <istream>
+#include <string>
+#include <vector>
+#include <httplib.h>
+#include <nlohmann/json.hpp>
+
+namespace Utils
+{
+
+// Parses in with a SAX parser and only builds the values at the given JSON pointers (e.g. "/illusts"),
+// everything else is skipped. The result keeps the layout of the document, so the same accessors work.
+// An empty list keeps the whole document. Throws ParseError
+nlohmann::json ParseJsonSelected(std::istream& in, std::vector<std::string> pointers = {});
+
+using StreamingRequest = std::function<httplib::Result(httplib::ResponseHandler, httplib::ContentReceiver)>;
+
+// Same as GetJsonResponse, but the body is parsed chunk by chunk on the receiving thread instead of
+// being buffered first. request must pass both handlers to the httplib call, e.g.
+// [&](auto handler, auto receiver) { return cli->Get(path, params, headers, handler, receiver); }
+nlohmann::json GetJsonStreaming(const StreamingRequest& request, std::vector<std::string> pointers = {});
+
+} // namespace Utils
+
+#endif
@@ -0,0 +1,116 @@
+#ifndef _UTILS_LRU_CACHE_HPP_
+#define _UTILS_LRU_CACHE_HPP_
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+
+namespace Utils
+{
+
+// Thread-safe LRU cache whose entries also expire after a ttl. Every entry has a cost (1 by default),
+// the least recently used entries are evicted once the total cost exceeds the capacity.
+// Values are returned by copy, store a shared_ptr for large values
+template<typename Key, typename Value, typename Hash = std::hash<Key>> class LruCache
+{
+public:
+	using clock = std::chrono::steady_clock;
+
+protected:
+	struct Entry
+	{
+		Key key;
+		Value value;
+		clock::time_point expire;	// time_point::max() for no expiry
+		std::size_t cost;
+	};
+
+	const std::size_t _capacity;
+	const clock::duration _ttl;
+
+	mutable std::mutex _mtx;
+	std::list<Entry> _entries;	// Most recently used first
+	std::unordered_map<Key, typename std::list<Entry>::iterator, Hash> _index;
+	std::size_t _cost = 0;
+
+	void _erase(typename std::list<Entry>::iterator it)
+	{
+		this->_cost -= it->cost;
+		this->_index.erase(it->key);
+		this->_entries.erase(it);
+	}
+
+public:
+	// A zero ttl never expires
+	explicit LruCache(std::size_t capacity, clock::duration ttl = {}) : _capacity(capacity), _ttl(ttl) {}
+	LruCache(const LruCache&) = delete;
+	LruCache& operator=(const LruCache&) = delete;
+	LruCache(LruCache&&) = delete;
+	LruCache& operator=(LruCache&&) = delete;
+	~LruCache() = default;
+
+	std::optional<Value> get(const Key& key)
+	{
+		std::lock_guard<std::mutex> lk(this->_mtx);
+		auto it = this->_index.find(key);
+		if (it == this->_index.end()) return std::nullopt;
+
+		auto entry = it->second;
+		if (entry->expire <= clock::now())
+		{
+			this->_erase(entry);
+			return std::nullopt;
+		}
+		this->_entries.splice(this->_entries.begin(), this->_entries, entry);
+		return entry->value;
+	}
+
+	void put(const Key& key, Value value) { this->put(key, std::move(value), this->_ttl); }
+
+	// Entries costing more than the whole capacity are not stored
+	void put(const Key& key, Value value, clock::duration ttl, std::size_t cost = 1)
+	{
+		std::lock_guard<std::mutex> lk(this->_mtx);
+		auto it = this->_index.find(key);
+		if (it != this->_index.end()) this->_erase(it->second);
+		if (cost > this->_capacity) return;
+
+		auto expire = ttl > clock::duration::zero() ? clock::now() + ttl : clock::time_point::max();
+		this->_entries.push_front({key, std::move(value), expire, cost});
+		this->_index.emplace(key, this->_entries.begin());
+		this->_cost += cost;
+
+		while (this->_cost > this->_capacity) this->_erase(std::prev(this->_entries.end()));
+	}
+
+	void erase(const Key& key)
+	{
+		std::lock_guard<std::mutex> lk(this->_mtx);
+		auto it = this->_index.find(key);
+		if (it != this->_index.end()) this->_erase(it->second);
+	}
+
+	void clear()
+	{
+		std::lock_guard<std::mutex> lk(this->_mtx);
+		this->_index.clear();
+		this->_entries.clear();
+		this->_cost = 0;
+	}
+
+	// Includes expired entries that have not been looked up since
+	std::size_t size() const
+	{
+		std::lock_guard<std::mutex> lk(this->_mtx);
+		return this->_entries.size();
+	}
+};
+
+} // namespace Utils
+
+#endif
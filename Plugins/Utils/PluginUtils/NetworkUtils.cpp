@@ -0,0 +1,230 @@
+#include "NetworkUtils.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "SingleFlight.hpp"
+
+namespace Utils
+{
+
+HttpPool& HttpPool::GetInstance()
+{
+	static HttpPool pool;
+	return pool;
+}
+
+HttpPool::Lease HttpPool::acquire(const std::string& origin, const std::string& ProxyHost, int ProxyPort)
+{
+	// Wait for the governor before taking a connection so that paced requests do not hold one idle
+	auto permit = RateGovernor::GetInstance().acquire(origin);
+
+	const bool UseProxy = !ProxyHost.empty() && ProxyPort > 0;
+	std::shared_ptr<Host> host;
+	{
+		std::string key = UseProxy ? origin + "|" + ProxyHost + ":" + std::to_string(ProxyPort) : origin;
+
+		std::lock_guard<std::mutex> lk(this->_mtx);
+		this->_sweep();
+		auto it = this->_hosts.find(key);
+		if (it == this->_hosts.end())
+		{
+			auto opt = this->_options.find(origin);
+			it = this->_hosts
+			         .emplace(std::move(key),
+			                  std::make_shared<Host>(origin, UseProxy ? ProxyHost : std::string{}, UseProxy ? ProxyPort : -1,
+			                                         opt == this->_options.end() ? HostOptions{} : opt->second))
+			         .first;
+		}
+		host = it->second;
+	}
+
+	std::unique_ptr<httplib::Client> client;
+	{
+		std::unique_lock<std::mutex> lk(host->mtx);
+		if (!host->cv.wait_for(lk, host->opts.AcquireTimeout,
+		                       [&host] { return !host->idle.empty() || host->active < host->opts.MaxConnections; }))
+			throw std::runtime_error("Timed out waiting for a connection to " + host->origin);
+		if (!host->idle.empty())
+		{
+			client = std::move(host->idle.back().client);
+			host->idle.pop_back();
+		}
+		host->active++;
+	}
+
+	if (!client)
+	{
+		client = std::make_unique<httplib::Client>(host->origin);
+		if (!host->ProxyHost.empty()) client->set_proxy(host->ProxyHost, host->ProxyPort);
+	}
+
+	client->set_keep_alive(true);
+	client->set_default_headers({});
+	client->set_compress(false);
+	client->set_decompress(true);
+	client->set_follow_location(false);
+	client->set_connection_timeout(CPPHTTPLIB_CONNECTION_TIMEOUT_SECOND, CPPHTTPLIB_CONNECTION_TIMEOUT_USECOND);
+	client->set_read_timeout(CPPHTTPLIB_READ_TIMEOUT_SECOND, CPPHTTPLIB_READ_TIMEOUT_USECOND);
+	client->set_write_timeout(CPPHTTPLIB_WRITE_TIMEOUT_SECOND, CPPHTTPLIB_WRITE_TIMEOUT_USECOND);
+
+	return {std::move(host), std::move(client), std::move(permit)};
+}
+
+void HttpPool::_sweep()
+{
+	const auto now = std::chrono::steady_clock::now();
+	std::vector<std::pair<std::chrono::steady_clock::time_point, std::string>> unused;
+	for (auto it = this->_hosts.begin(); it != this->_hosts.end();)
+	{
+		const auto& host = it->second;
+		bool empty = false;
+		std::chrono::steady_clock::time_point LastUsed;
+		{
+			std::lock_guard<std::mutex> lk(host->mtx);
+			auto expired = std::find_if(host->idle.begin(), host->idle.end(), [&host, now](const Connection& conn)
+			                            { return now - conn.LastUsed < host->opts.IdleTimeout; });
+			host->idle.erase(host->idle.begin(), expired);
+			empty = host->idle.empty();
+			LastUsed = host->LastUsed;
+		}
+
+		// Leases and callers of acquire hold a reference, the map is the only owner otherwise
+		if (host.use_count() > 1)
+			++it;
+		else if (empty)
+			it = this->_hosts.erase(it);
+		else
+		{
+			unused.emplace_back(LastUsed, it->first);
+			++it;
+		}
+	}
+
+	if (this->_hosts.size() < MAX_HOSTS) return;
+	std::sort(unused.begin(), unused.end());
+	for (const auto& [LastUsed, key] : unused)
+	{
+		if (this->_hosts.size() < MAX_HOSTS) break;
+		this->_hosts.erase(key);
+	}
+}
+
+void HttpPool::SetHostOptions(const std::string& origin, HostOptions opts)
+{
+	std::lock_guard<std::mutex> lk(this->_mtx);
+	this->_options[origin] = opts;
+}
+
+void HttpPool::clear()
+{
+	std::lock_guard<std::mutex> lk(this->_mtx);
+	for (auto& [key, host] : this->_hosts)
+	{
+		std::lock_guard<std::mutex> host_lk(host->mtx);
+		host->idle.clear();
+	}
+}
+
+std::size_t HttpPool::size()
+{
+	std::lock_guard<std::mutex> lk(this->_mtx);
+	return this->_hosts.size();
+}
+
+void HttpPool::Lease::_watch() const
+{
+	this->_spent = std::make_shared<bool>(false);
+	this->_client->set_logger(
+		[report = this->_permit.reporter(), spent = this->_spent, logger = this->_logger](const httplib::Request& req,
+		                                                                                   const httplib::Response& res)
+		{
+			report(res.status, res.get_header_value("Retry-After"));
+			*spent = true;
+			if (*logger) (*logger)(req, res);
+		});
+}
+
+void HttpPool::Lease::_admit() const
+{
+	if (!this->_host || !*this->_spent) return;
+	// Release first, the host may allow a single request at a time
+	this->_permit.release();
+	this->_permit = RateGovernor::GetInstance().acquire(this->_host->origin);
+	this->_watch();
+}
+
+void HttpPool::Lease::release()
+{
+	if (!this->_host) return;
+
+	{
+		std::lock_guard<std::mutex> lk(this->_host->mtx);
+		const auto now = std::chrono::steady_clock::now();
+		if (this->_client) this->_host->idle.push_back({std::move(this->_client), now});
+		this->_host->active--;
+		this->_host->LastUsed = now;
+	}
+	this->_host->cv.notify_one();
+	this->_host.reset();
+	this->_permit.release();
+}
+
+std::string FetchKey(const std::string& url, const httplib::Headers& headers, const std::vector<std::string>& KeyHeaders)
+{
+	std::string key = "GET " + url;
+	for (const auto& name : KeyHeaders)
+	{
+		auto range = headers.equal_range(name);
+		for (auto it = range.first; it != range.second; ++it)
+		{
+			key += '\n';
+			key += name;
+			key += ": ";
+			key += it->second;
+		}
+	}
+	return key;
+}
+
+std::shared_ptr<const httplib::Response> FetchGet(const std::string& url, const httplib::Headers& headers,
+                                                  const std::function<httplib::Result(const httplib::Headers&)>& fetch,
+                                                  const CachePolicy& policy, const std::vector<std::string>& KeyHeaders)
+{
+	static SingleFlight<std::string, std::shared_ptr<const httplib::Response>> flight;
+
+	auto& cache = HttpCache::GetInstance();
+	const bool UseCache = policy.mode != CachePolicy::Mode::NO_STORE;
+	std::string key = FetchKey(url, headers, KeyHeaders);
+	if (UseCache)
+	{
+		auto entry = cache.find(key);
+		if (entry && entry->fresh(policy)) return entry->response;
+	}
+
+	return flight.run(key,
+	                  [&]() -> std::shared_ptr<const httplib::Response>
+	                  {
+						  // Another flight may have just refreshed the entry
+						  auto entry = UseCache ? cache.find(key) : nullptr;
+						  if (entry && entry->fresh(policy)) return entry->response;
+
+						  httplib::Headers request = headers;
+						  if (entry && !entry->ETag.empty()) request.emplace("If-None-Match", entry->ETag);
+						  if (entry && !entry->LastModified.empty())
+							  request.emplace("If-Modified-Since", entry->LastModified);
+
+						  auto result = fetch(request);
+						  if (entry && result && result->status == 304) // NOLINT(*-avoid-magic-numbers)
+							  return cache.refresh(key, *entry, *result, policy)->response;
+						  if (!VerifyResponse(result)) throw NetworkException(result);
+
+						  auto response = std::make_shared<const httplib::Response>(std::move(result.value()));
+						  if (UseCache) cache.store(key, response, policy);
+						  return response;
+					  });
+}
+
+} // namespace Utils
@@ -1,13 +1,27 @@
 #ifndef _UTILS_NETWORK_UTILS_HPP_
 #define _UTILS_NETWORK_UTILS_HPP_
 
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <ctime>
+#include <functional>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 #include <httplib.h>
 #include <nlohmann/json.hpp>
 
 #include <libmirai/mirai.hpp>
 
+#include "HttpCache.hpp"
+#include "RateGovernor.hpp"
+
 namespace Utils
 {
 
@@ -49,23 +63,28 @@ inline bool VerifyResponse(const httplib::Result& result)
 }
 
 
-inline nlohmann::json GetJsonResponse(const httplib::Result& result)
+inline nlohmann::json ParseJson(const std::string& body)
 {
 	using json = nlohmann::json;
 
-	if (!VerifyResponse(result))
-		throw NetworkException(result);
-	
 	try
 	{
-		return json::parse(result->body);
+		return json::parse(body);
 	}
 	catch (const json::parse_error& e)
 	{
-		throw ParseError(e.what(), result->body);
+		throw ParseError(e.what(), body);
 	}
 }
 
+inline nlohmann::json GetJsonResponse(const httplib::Result& result)
+{
+	if (!VerifyResponse(result))
+		throw NetworkException(result);
+	
+	return ParseJson(result->body);
+}
+
 inline std::string EncodeUri(const std::string& value)
 {
 	std::ostringstream escaped;
@@ -90,6 +109,16 @@ inline std::string EncodeUri(const std::string& value)
 	return escaped.str();
 }
 
+inline std::optional<std::chrono::system_clock::time_point> ParseHttpDate(const std::string& str)
+{
+	if (str.empty()) return std::nullopt;
+	std::tm tm{};
+	// Only the IMF-fixdate format, the obsolete ones are not sent by anything we talk to
+	const char* end = strptime(str.c_str(), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+	if (end == nullptr) return std::nullopt;
+	return std::chrono::system_clock::from_time_t(timegm(&tm));
+}
+
 using Params = std::multimap<std::string, std::string>;
 inline std::string Params2Query(const Params& params)
 {
@@ -107,6 +136,165 @@ inline std::string Params2Query(const Params& params)
 	}
 	return query;
 }
+
+// Process-wide pool of keep-alive clients, shared by all plugins through ElanorPluginUtils.
+// Connections are keyed by (origin, proxy) and handed out exclusively through a Lease.
+// Every acquire closes expired idle connections of all hosts and forgets hosts nobody uses any more
+class HttpPool
+{
+public:
+	struct HostOptions
+	{
+		std::size_t MaxConnections = 8;                 // NOLINT(*-avoid-magic-numbers)
+		std::chrono::seconds IdleTimeout{60};           // NOLINT(*-avoid-magic-numbers)
+		// acquire throws once it has waited this long for a free connection
+		std::chrono::milliseconds AcquireTimeout{std::chrono::seconds(30)};	// NOLINT(*-avoid-magic-numbers)
+	};
+
+	// Hosts kept with idle connections, the least recently used one is closed beyond that
+	static constexpr std::size_t MAX_HOSTS = 64;
+
+protected:
+	struct Connection
+	{
+		std::unique_ptr<httplib::Client> client;
+		std::chrono::steady_clock::time_point LastUsed;
+	};
+
+	struct Host
+	{
+		const std::string origin;
+		const std::string ProxyHost;
+		const int ProxyPort;
+		HostOptions opts;
+
+		std::mutex mtx;
+		std::condition_variable cv;
+		std::vector<Connection> idle;	// Most recently used at the back
+		std::size_t active = 0;
+		std::chrono::steady_clock::time_point LastUsed = std::chrono::steady_clock::now();
+
+		Host(std::string origin, std::string ProxyHost, int ProxyPort, HostOptions opts)
+			: origin(std::move(origin)), ProxyHost(std::move(ProxyHost)), ProxyPort(ProxyPort), opts(opts)
+		{
+		}
+	};
+
+	std::mutex _mtx;
+	std::unordered_map<std::string, std::shared_ptr<Host>> _hosts;
+	std::unordered_map<std::string, HostOptions> _options;
+
+	// Closes expired idle connections and drops unused hosts, called with _mtx held
+	void _sweep();
+
+public:
+	class Lease
+	{
+	private:
+		std::shared_ptr<Host> _host;
+		std::unique_ptr<httplib::Client> _client;
+		// Renewed on the first use after a response, see operator->
+		mutable RateGovernor::Permit _permit;
+		mutable std::shared_ptr<bool> _spent;
+		// Logger of the caller, invoked by the hook installed in _watch
+		std::shared_ptr<httplib::Logger> _logger = std::make_shared<httplib::Logger>();
+
+		Lease(std::shared_ptr<Host> host, std::unique_ptr<httplib::Client> client, RateGovernor::Permit permit)
+			: _host(std::move(host)), _client(std::move(client)), _permit(std::move(permit))
+		{
+			this->_watch();
+		}
+		friend class HttpPool;
+
+		// Reports responses to the permit, marks it spent and passes them on to _logger
+		void _watch() const;
+		// Waits for a new permit once the current one is spent
+		void _admit() const;
+
+	public:
+		Lease(const Lease&) = delete;
+		Lease& operator=(const Lease&) = delete;
+		Lease(Lease&& rhs) noexcept = default;
+		Lease& operator=(Lease&& rhs) noexcept
+		{
+			if (this == &rhs) return *this;
+			this->release();
+			this->_host = std::move(rhs._host);
+			this->_client = std::move(rhs._client);
+			this->_permit = std::move(rhs._permit);
+			this->_spent = std::move(rhs._spent);
+			this->_logger = std::move(rhs._logger);
+			return *this;
+		}
+		~Lease() { this->release(); }
+
+		// Returns the connection to the pool, the lease is unusable afterwards
+		void release();
+
+		// Use this instead of lease->set_logger, which would replace the hook feeding responses to RateGovernor
+		void set_logger(httplib::Logger logger) { *this->_logger = std::move(logger); }
+
+		// Requests go through the client directly (lease->Get(...)), braced arguments such as
+		// {} or {{"Accept", "*/*"}} cannot pass through a forwarding wrapper.
+		// Each permit admits one request: the first access after a response blocks on RateGovernor again
+		httplib::Client* operator->() const
+		{
+			this->_admit();
+			return this->_client.get();
+		}
+		httplib::Client& operator*() const
+		{
+			this->_admit();
+			return *this->_client;
+		}
+	};
+
+	HttpPool() = default;
+	HttpPool(const HttpPool&) = delete;
+	HttpPool& operator=(const HttpPool&) = delete;
+	HttpPool(HttpPool&&) = delete;
+	HttpPool& operator=(HttpPool&&) = delete;
+	~HttpPool() = default;
+
+	static HttpPool& GetInstance();
+
+	// Blocks while MaxConnections connections to the host are leased out, or while RateGovernor holds the origin back.
+	// Throws std::runtime_error if no connection is free within AcquireTimeout, e.g. when the caller holds all of them.
+	// Client options (timeouts, default headers, compression) are reset to the httplib defaults on every lease
+	Lease acquire(const std::string& origin, const std::string& ProxyHost = {}, int ProxyPort = -1);
+
+	// Applies to hosts created afterwards, e.g. call it in InitPlugin
+	void SetHostOptions(const std::string& origin, HostOptions opts);
+
+	// Closes all idle connections
+	void clear();
+
+	// Number of hosts currently kept
+	std::size_t size();
+};
+
+inline HttpPool::Lease GetHttpClient(const std::string& origin, const std::string& ProxyHost = {}, int ProxyPort = -1)
+{
+	return HttpPool::GetInstance().acquire(origin, ProxyHost, ProxyPort);
+}
+
+// Headers that can change the response, only these take part in the FetchGet key
+inline const std::vector<std::string> FETCH_KEY_HEADERS = {"Authorization",   "Accept", "Accept-Encoding",
+                                                           "Accept-Language", "Cookie", "Range"};
+
+// Request key from the url and the values of KeyHeaders
+std::string FetchKey(const std::string& url, const httplib::Headers& headers,
+                     const std::vector<std::string>& KeyHeaders = FETCH_KEY_HEADERS);
+
+// GET through HttpCache: fresh cached responses are returned without a request, stale ones are
+// revalidated with If-None-Match/If-Modified-Since. fetch receives the headers to send.
+// Identical concurrent requests (same url and key headers) are sent only once, all callers get
+// the same response or the same NetworkException for failed and non-2xx results
+std::shared_ptr<const httplib::Response> FetchGet(const std::string& url, const httplib::Headers& headers,
+                                                  const std::function<httplib::Result(const httplib::Headers&)>& fetch,
+                                                  const CachePolicy& policy = {},
+                                                  const std::vector<std::string>& KeyHeaders = FETCH_KEY_HEADERS);
+
 }
 
 
@@ -0,0 +1,250 @@
+#include "RateGovernor.hpp"
+
+#include <algorithm>
+#include <future>
+#include <iterator>
+#include <optional>
+#include <thread>
+#include <utility>
+
+#include <Core/Utils/Logger.hpp>
+
+#include "NetworkUtils.hpp"
+#include "StringUtils.hpp"
+
+namespace Utils
+{
+
+namespace
+{
+
+constexpr auto DEFAULT_RETRY_AFTER = std::chrono::seconds(1);
+constexpr auto MAX_RETRY_AFTER = std::chrono::minutes(10);
+
+std::chrono::steady_clock::duration ParseRetryAfter(const std::string& value)
+{
+	long long seconds{};
+	if (Str2Num(value, seconds))
+		return std::clamp<std::chrono::steady_clock::duration>(std::chrono::seconds(seconds), {}, MAX_RETRY_AFTER);
+	if (auto date = ParseHttpDate(value))
+		return std::clamp<std::chrono::steady_clock::duration>(*date - std::chrono::system_clock::now(), {},
+		                                                        MAX_RETRY_AFTER);
+	return DEFAULT_RETRY_AFTER;
+}
+
+} // namespace
+
+RateGovernor::clock::time_point RateGovernor::Host::admit(clock::time_point queued)
+{
+	auto now = clock::now();
+	auto start = std::max(now, this->PausedUntil);
+	if (this->rate > 0)
+	{
+		// GCRA: up to `burst` requests may start back to back, after that one per interval
+		const auto interval = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1 / this->rate));
+		const auto tolerance = interval * static_cast<long>(std::max<std::size_t>(this->limits.burst, 1) - 1);
+		auto next = std::max(this->NextSlot, now);
+		start = std::max(start, next - tolerance);
+		this->NextSlot = std::max(next, start) + interval;
+	}
+
+	auto wait = std::chrono::duration_cast<std::chrono::microseconds>(start - queued);
+	this->LastUsed = std::max(now, start);
+	this->stats.requests++;
+	this->stats.active++;
+	this->stats.TotalWait += wait;
+	this->stats.MaxWait = std::max(this->stats.MaxWait, wait);
+	if (wait > std::chrono::seconds(1))
+		LOG_DEBUG(GetLogger(), "Request to " + this->stats.origin + " delayed for "
+		                           + std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(wait).count())
+		                           + "ms <RateGovernor>");
+	return start;
+}
+
+void RateGovernor::Host::report(int status, const std::string& RetryAfter)
+{
+	if (status == 429 || status == 503) // NOLINT(*-avoid-magic-numbers)
+	{
+		this->stats.throttled++;
+		this->rate = std::max(MIN_RATE, (this->rate > 0 ? this->rate : THROTTLED_RATE) / 2);
+		this->PausedUntil = std::max(this->PausedUntil, clock::now() + ParseRetryAfter(RetryAfter));
+		LOG_INFO(GetLogger(), "Throttled by " + this->stats.origin + " <" + std::to_string(status)
+		                          + ">, rate lowered to " + std::to_string(this->rate) + "/s <RateGovernor>");
+	}
+	else if (this->rate > 0 && status > 0)
+	{
+		this->rate += RATE_STEP;
+		if (this->limits.RequestsPerSecond > 0)
+			this->rate = std::min(this->rate, this->limits.RequestsPerSecond);
+		else if (this->rate >= RECOVERED_RATE)
+			this->rate = 0;
+	}
+}
+
+RateGovernor& RateGovernor::GetInstance()
+{
+	static RateGovernor governor;
+	return governor;
+}
+
+std::shared_ptr<RateGovernor::Host> RateGovernor::_GetHost(const std::string& origin)
+{
+	std::lock_guard<std::mutex> lk(this->_mtx);
+	const auto now = clock::now();
+	if (now >= this->_NextSweep)
+	{
+		this->_sweep(now);
+		this->_NextSweep = now + this->_IdleTimeout / 2;
+	}
+
+	auto it = this->_hosts.find(origin);
+	if (it == this->_hosts.end())
+	{
+		auto host = std::make_shared<Host>();
+		auto limits = this->_limits.find(origin);
+		if (limits != this->_limits.end()) host->limits = limits->second;
+		host->rate = host->limits.RequestsPerSecond;
+		host->stats.origin = origin;
+		it = this->_hosts.emplace(origin, std::move(host)).first;
+	}
+	return it->second;
+}
+
+void RateGovernor::_sweep(clock::time_point now)
+{
+	for (auto it = this->_hosts.begin(); it != this->_hosts.end();)
+	{
+		const auto& host = it->second;
+		// Permits and queued requests hold a reference, the map is the only owner otherwise
+		bool idle = !this->_limits.contains(it->first) && host.use_count() == 1;
+		if (idle)
+		{
+			std::lock_guard<std::mutex> lk(host->mtx);
+			// A paused host would otherwise be let through early
+			idle = now - host->LastUsed >= this->_IdleTimeout && host->PausedUntil <= now;
+		}
+		it = idle ? this->_hosts.erase(it) : std::next(it);
+	}
+}
+
+void RateGovernor::SetLimits(const std::string& origin, Limits limits)
+{
+	std::shared_ptr<Host> host;
+	{
+		std::lock_guard<std::mutex> lk(this->_mtx);
+		this->_limits[origin] = limits;
+		auto it = this->_hosts.find(origin);
+		if (it == this->_hosts.end()) return;
+		host = it->second;
+	}
+
+	std::vector<Waiter> admitted;
+	std::vector<clock::time_point> starts;
+	{
+		std::lock_guard<std::mutex> lk(host->mtx);
+		host->limits = limits;
+		host->rate = limits.RequestsPerSecond;
+		host->NextSlot = {};
+		while (!host->waiters.empty() && host->CanEnter())
+		{
+			starts.push_back(host->admit(host->waiters.front().queued));
+			admitted.push_back(std::move(host->waiters.front()));
+			host->waiters.pop_front();
+		}
+		host->stats.queued = host->waiters.size();
+	}
+	for (std::size_t i = 0; i < admitted.size(); i++)
+		admitted[i].admit(starts[i]);
+}
+
+RateGovernor::Permit RateGovernor::acquire(const std::string& origin)
+{
+	std::promise<std::pair<Permit, clock::time_point>> promise;
+	auto future = promise.get_future();
+	this->acquire(origin, [&promise](Permit permit, clock::time_point start)
+	              { promise.set_value({std::move(permit), start}); });
+
+	auto [permit, start] = future.get();
+	std::this_thread::sleep_until(start);
+	return std::move(permit);
+}
+
+void RateGovernor::acquire(const std::string& origin, std::function<void(Permit, clock::time_point)> admitted)
+{
+	auto host = this->_GetHost(origin);
+	auto queued = clock::now();
+
+	std::optional<clock::time_point> start;
+	{
+		std::lock_guard<std::mutex> lk(host->mtx);
+		if (host->waiters.empty() && host->CanEnter())
+			start = host->admit(queued);
+		else
+		{
+			host->waiters.push_back({queued, [host, admitted = std::move(admitted)](clock::time_point start) mutable
+			                         { admitted(Permit(std::move(host)), start); }});
+			host->stats.queued = host->waiters.size();
+		}
+	}
+	if (start) admitted(Permit(std::move(host)), *start);
+}
+
+std::vector<RateGovernor::Stats> RateGovernor::GetStats()
+{
+	std::vector<std::shared_ptr<Host>> hosts;
+	{
+		std::lock_guard<std::mutex> lk(this->_mtx);
+		for (const auto& [origin, host] : this->_hosts)
+			hosts.push_back(host);
+	}
+
+	std::vector<Stats> stats;
+	for (const auto& host : hosts)
+	{
+		std::lock_guard<std::mutex> lk(host->mtx);
+		stats.push_back(host->stats);
+		stats.back().rate = host->rate;
+	}
+	return stats;
+}
+
+void RateGovernor::Permit::report(int status, const std::string& RetryAfter) const
+{
+	if (!this->_host) return;
+	std::lock_guard<std::mutex> lk(this->_host->mtx);
+	this->_host->report(status, RetryAfter);
+}
+
+std::function<void(int, const std::string&)> RateGovernor::Permit::reporter() const
+{
+	return [host = this->_host](int status, const std::string& RetryAfter)
+	{
+		if (!host) return;
+		std::lock_guard<std::mutex> lk(host->mtx);
+		host->report(status, RetryAfter);
+	};
+}
+
+void RateGovernor::Permit::release()
+{
+	if (!this->_host) return;
+
+	std::optional<Waiter> next;
+	clock::time_point start;
+	{
+		std::lock_guard<std::mutex> lk(this->_host->mtx);
+		this->_host->stats.active--;
+		this->_host->LastUsed = std::max(this->_host->LastUsed, clock::now());
+		if (!this->_host->waiters.empty() && this->_host->CanEnter())
+		{
+			next = std::move(this->_host->waiters.front());
+			this->_host->waiters.pop_front();
+			this->_host->stats.queued = this->_host->waiters.size();
+			start = this->_host->admit(next->queued);
+		}
+	}
+	this->_host.reset();
+	if (next) next->admit(start);
+}
+
+} // namespace Utils
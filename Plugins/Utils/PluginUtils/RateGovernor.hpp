@@ -0,0 +1,142 @@
+#ifndef _UTILS_RATE_GOVERNOR_HPP_
+#define _UTILS_RATE_GOVERNOR_HPP_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Utils
+{
+
+// Process-wide pacing of outbound requests per origin, shared by HttpPool and AsyncHttpClient.
+// Requests over the limits are queued (FIFO) instead of failing. 429/503 responses halve the
+// allowed rate and pause the host for Retry-After, successful ones raise it again step by step
+class RateGovernor
+{
+public:
+	using clock = std::chrono::steady_clock;
+
+	struct Limits
+	{
+		double RequestsPerSecond = 0;	// 0 for no limit
+		std::size_t burst = 1;
+		std::size_t MaxConcurrent = 0;	// 0 for no limit
+	};
+
+	struct Stats
+	{
+		std::string origin;
+		std::uint64_t requests = 0;
+		std::uint64_t throttled = 0;	// 429/503 responses
+		std::chrono::microseconds TotalWait{0};
+		std::chrono::microseconds MaxWait{0};
+		std::size_t active = 0;
+		std::size_t queued = 0;
+		double rate = 0;	// Current allowed rate, 0 for no limit
+	};
+
+	// Rate a host without a configured limit drops to after its first 429
+	static constexpr double THROTTLED_RATE = 4;
+	static constexpr double MIN_RATE = 0.05;
+	static constexpr double RATE_STEP = 0.1;
+	// Unconfigured hosts that climb back to this rate are no longer limited
+	static constexpr double RECOVERED_RATE = 50;
+	// Unconfigured hosts unused for this long are forgotten
+	static constexpr std::chrono::minutes IDLE_TIMEOUT{10};
+
+protected:
+	struct Waiter
+	{
+		clock::time_point queued;
+		std::function<void(clock::time_point)> admit;
+	};
+
+	struct Host
+	{
+		std::mutex mtx;
+		Limits limits;
+		double rate;
+		clock::time_point NextSlot{};
+		clock::time_point PausedUntil{};
+		std::deque<Waiter> waiters;
+		Stats stats;
+		clock::time_point LastUsed = clock::now();
+
+		bool CanEnter() const { return this->limits.MaxConcurrent == 0 || this->stats.active < this->limits.MaxConcurrent; }
+		// Takes a slot and returns when the request may start
+		clock::time_point admit(clock::time_point queued);
+		void report(int status, const std::string& RetryAfter);
+	};
+
+	std::mutex _mtx;
+	std::unordered_map<std::string, std::shared_ptr<Host>> _hosts;
+	std::unordered_map<std::string, Limits> _limits;
+	const clock::duration _IdleTimeout;
+	clock::time_point _NextSweep{};
+
+	std::shared_ptr<Host> _GetHost(const std::string& origin);
+	// Drops idle hosts without configured limits, called with _mtx held
+	void _sweep(clock::time_point now);
+
+public:
+	class Permit
+	{
+	private:
+		std::shared_ptr<Host> _host;
+
+		explicit Permit(std::shared_ptr<Host> host) : _host(std::move(host)) {}
+		friend class RateGovernor;
+
+	public:
+		Permit() = default;
+		Permit(const Permit&) = delete;
+		Permit& operator=(const Permit&) = delete;
+		Permit(Permit&& rhs) noexcept = default;
+		Permit& operator=(Permit&& rhs) noexcept
+		{
+			if (this == &rhs) return *this;
+			this->release();
+			this->_host = std::move(rhs._host);
+			return *this;
+		}
+		~Permit() { this->release(); }
+
+		// Feeds the response back into the rate adaption, RetryAfter is the raw header value
+		void report(int status, const std::string& RetryAfter = {}) const;
+		// Same as report, usable after the permit has been moved or released
+		std::function<void(int, const std::string&)> reporter() const;
+		void release();
+	};
+
+	explicit RateGovernor(clock::duration IdleTimeout = IDLE_TIMEOUT) : _IdleTimeout(IdleTimeout) {}
+	RateGovernor(const RateGovernor&) = delete;
+	RateGovernor& operator=(const RateGovernor&) = delete;
+	RateGovernor(RateGovernor&&) = delete;
+	RateGovernor& operator=(RateGovernor&&) = delete;
+	~RateGovernor() = default;
+
+	static RateGovernor& GetInstance();
+
+	// Resets the adaptive state of the host, e.g. call it in InitPlugin
+	void SetLimits(const std::string& origin, Limits limits);
+
+	// Blocks until the request may be sent
+	Permit acquire(const std::string& origin);
+
+	// Non-blocking variant, admitted is called with the permit and the time the request may start
+	// once a slot is free. It may run on the thread releasing another permit
+	void acquire(const std::string& origin, std::function<void(Permit, clock::time_point)> admitted);
+
+	std::vector<Stats> GetStats();
+};
+
+} // namespace Utils
+
+#endif
@@ -0,0 +1,157 @@
+#include "SimplePattern.hpp"
+
+#include <regex>
+#include <utility>
+#include <vector>
+
+#include "StringUtils.hpp"
+
+namespace Utils
+{
+
+struct SimplePattern::Fallback
+{
+	std::regex regex;
+};
+
+SimplePattern::SimplePattern(std::string pattern) : _pattern(std::move(pattern))
+{
+	if (!this->_compile())
+		this->_fallback = std::make_shared<Fallback>(Fallback{std::regex(this->_pattern, std::regex::ECMAScript)});
+}
+
+bool SimplePattern::_compile()
+{
+	enum class Atom : std::uint8_t
+	{
+		CHAR,
+		ANY,
+		DIGIT
+	};
+	enum class Repeat : std::uint8_t
+	{
+		ONE,
+		OPTIONAL,
+		STAR
+	};
+	struct Node
+	{
+		Atom atom;
+		Repeat repeat;
+		char c;
+	};
+	std::vector<Node> nodes;
+
+	std::string_view pattern = this->_pattern;
+	if (!pattern.empty() && pattern.front() == '^') pattern.remove_prefix(1);
+	// A trailing $ is an anchor unless escaped, full matches do not need it
+	if (!pattern.empty() && pattern.back() == '$')
+	{
+		std::size_t escapes = 0;
+		while (escapes + 1 < pattern.size() && pattern[pattern.size() - escapes - 2] == '\\')
+			escapes++;
+		if (escapes % 2 == 0) pattern.remove_suffix(1);
+	}
+
+	for (std::size_t i = 0; i < pattern.size(); i++)
+	{
+		const char c = pattern[i];
+		switch (c)
+		{
+		case '*':
+		case '+':
+		case '?':
+		{
+			if (nodes.empty() || nodes.back().repeat != Repeat::ONE) return false;
+			// Lazy and other modifiers after the quantifier
+			if (i + 1 < pattern.size() && (pattern[i + 1] == '?' || pattern[i + 1] == '*' || pattern[i + 1] == '+'))
+				return false;
+			if (c == '*')
+				nodes.back().repeat = Repeat::STAR;
+			else if (c == '?')
+				nodes.back().repeat = Repeat::OPTIONAL;
+			else
+				nodes.push_back({nodes.back().atom, Repeat::STAR, nodes.back().c});	// x+ is xx*
+			break;
+		}
+		case '.':
+			nodes.push_back({Atom::ANY, Repeat::ONE, 0});
+			break;
+		case '\\':
+		{
+			if (i + 1 >= pattern.size()) return false;
+			const char next = pattern[++i];
+			if (next == 'd')
+				nodes.push_back({Atom::DIGIT, Repeat::ONE, 0});
+			// Character classes, back references, control escapes, ...
+			else if ((next >= 'a' && next <= 'z') || (next >= 'A' && next <= 'Z') || isDigit(next))
+				return false;
+			else
+				nodes.push_back({Atom::CHAR, Repeat::ONE, next});
+			break;
+		}
+		case '^':
+		case '$':
+		case '[':
+		case ']':
+		case '(':
+		case ')':
+		case '{':
+		case '}':
+		case '|':
+			return false;
+		default:
+			nodes.push_back({Atom::CHAR, Repeat::ONE, c});
+		}
+		if (nodes.size() > MAX_NODES) return false;
+	}
+
+	this->_size = nodes.size();
+	for (std::size_t i = 0; i < nodes.size(); i++)
+	{
+		const std::uint64_t bit = std::uint64_t(1) << i;
+		switch (nodes[i].atom)
+		{
+		case Atom::CHAR:
+			this->_masks.at(static_cast<unsigned char>(nodes[i].c)) |= bit;
+			break;
+		case Atom::ANY:
+			for (std::size_t c = 0; c < this->_masks.size(); c++)
+				if (c != '\n' && c != '\r') this->_masks.at(c) |= bit;	// ECMAScript line terminators
+			break;
+		case Atom::DIGIT:
+			for (char c = '0'; c <= '9'; c++)
+				this->_masks.at(static_cast<unsigned char>(c)) |= bit;
+			break;
+		}
+		if (nodes[i].repeat == Repeat::STAR) this->_repeat |= bit;
+		if (nodes[i].repeat != Repeat::ONE) this->_optional |= bit;
+	}
+	return true;
+}
+
+std::uint64_t SimplePattern::_closure(std::uint64_t states) const
+{
+	while (true)
+	{
+		const std::uint64_t next = states | ((states & this->_optional) << 1);
+		if (next == states) return states;
+		states = next;
+	}
+}
+
+bool SimplePattern::match(std::string_view str) const
+{
+	if (this->_fallback) return std::regex_match(str.begin(), str.end(), this->_fallback->regex);
+
+	std::uint64_t states = this->_closure(1);
+	for (char c : str)
+	{
+		const std::uint64_t matched = states & this->_masks[static_cast<unsigned char>(c)];	// NOLINT
+		states = this->_closure(((matched & ~this->_repeat) << 1) | (matched & this->_repeat));
+		if (states == 0) return false;
+	}
+	return (states >> this->_size & 1) != 0;
+}
+
+} // namespace Utils
@@ -0,0 +1,51 @@
+#ifndef _UTILS_SIMPLE_PATTERN_HPP_
+#define _UTILS_SIMPLE_PATTERN_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace Utils
+{
+
+// Full match (like std::regex_match) of an ECMAScript regex without the cost of std::regex for
+// the common simple patterns: literals, escaped punctuation, '.', \d and the quantifiers *, + and ?,
+// optionally wrapped in ^...$. These are matched by simulating the NFA with bitwise operations,
+// a few per input byte and without allocating. Anything else (classes, groups, alternation, ...)
+// falls back to std::regex
+class SimplePattern
+{
+protected:
+	static constexpr std::size_t MAX_NODES = 63;
+
+	std::string _pattern;
+
+	// Bit i is the state waiting for node i, bit _size the accepting one
+	std::size_t _size = 0;
+	std::array<std::uint64_t, 256> _masks{};	// Nodes matching each byte	// NOLINT(*-avoid-magic-numbers)
+	std::uint64_t _repeat{};	// Nodes that stay in their state after matching (x*)
+	std::uint64_t _optional{};	// Nodes that may be skipped (x*, x?)
+
+	struct Fallback;
+	std::shared_ptr<const Fallback> _fallback;
+
+	bool _compile();
+	std::uint64_t _closure(std::uint64_t states) const;
+
+public:
+	// Throws std::regex_error for invalid patterns, same as std::regex
+	explicit SimplePattern(std::string pattern);
+
+	bool match(std::string_view str) const;
+
+	const std::string& pattern() const { return this->_pattern; }
+	// Whether the pattern runs without std::regex
+	bool compiled() const { return !this->_fallback; }
+};
+
+} // namespace Utils
+
+#endif
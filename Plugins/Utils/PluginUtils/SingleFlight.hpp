@@ -0,0 +1,61 @@
+#ifndef _UTILS_SINGLE_FLIGHT_HPP_
+#define _UTILS_SINGLE_FLIGHT_HPP_
+
+#include <exception>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace Utils
+{
+
+// Coalesces concurrent calls with the same key, only the first caller does the work
+// and the others block until its result is available
+template<typename Key, typename Value, typename Hash = std::hash<Key>> class SingleFlight
+{
+protected:
+	std::mutex _mtx;
+	std::unordered_map<Key, std::shared_future<Value>, Hash> _calls;
+
+public:
+	// Exceptions thrown by func are rethrown in every caller sharing the call.
+	// func must not call run() with the same key
+	template<typename Func> Value run(const Key& key, Func&& func)
+	{
+		std::promise<Value> promise;
+		std::shared_future<Value> future;
+		{
+			std::unique_lock<std::mutex> lk(this->_mtx);
+			auto it = this->_calls.find(key);
+			if (it != this->_calls.end())
+			{
+				future = it->second;
+				lk.unlock();
+				return future.get();
+			}
+			future = promise.get_future().share();
+			this->_calls.emplace(key, future);
+		}
+
+		try
+		{
+			promise.set_value(std::forward<Func>(func)());
+		}
+		catch (...)
+		{
+			promise.set_exception(std::current_exception());
+		}
+
+		{
+			std::lock_guard<std::mutex> lk(this->_mtx);
+			this->_calls.erase(key);
+		}
+		return future.get();
+	}
+};
+
+} // namespace Utils
+
+#endif
@@ -1,10 +1,14 @@
 #ifndef _UTILS_STRING_UTILS_HPP_
 #define _UTILS_STRING_UTILS_HPP_
 
+#include <algorithm>
 #include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
 #include <exception>
 #include <iomanip>
-#include <regex>
+#include <iterator>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -12,20 +16,60 @@
 #include <charconv>
 #include <vector>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace Utils
 {
 
-inline bool isFloat(std::string_view str)
+constexpr bool isDigit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+constexpr bool isHexDigit(char c)
+{
+	return isDigit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+// The validators below only check the syntax, values of any length are accepted.
+// Use Str2Num to also check that the value fits into a type
+
+// \d+
+constexpr bool isUInt(std::string_view str)
+{
+	return !str.empty() && std::all_of(str.begin(), str.end(), isDigit);
+}
+
+// [\+-]?\d+
+constexpr bool isInt(std::string_view str)
+{
+	if (!str.empty() && (str.front() == '+' || str.front() == '-')) str.remove_prefix(1);
+	return isUInt(str);
+}
+
+// [\+-]?(?:0[xX])?[0-9a-fA-F]+
+constexpr bool isHex(std::string_view str)
 {
-	const static std::regex r_float =
-		std::regex(R"((?:\d+(?:\.\d*)?|\.\d+))", std::regex::icase);
-	return std::regex_match(str.cbegin(), str.cend(), r_float);
+	if (!str.empty() && (str.front() == '+' || str.front() == '-')) str.remove_prefix(1);
+	if (str.size() > 2 && str[0] == '0' && (str[1] == 'x' || str[1] == 'X')) str.remove_prefix(2);
+	return !str.empty() && std::all_of(str.begin(), str.end(), isHexDigit);
 }
 
-inline bool isInt(std::string_view str)
+// \d+(?:\.\d*)?|\.\d+, no sign or exponent
+constexpr bool isFloat(std::string_view str)
 {
-	const static std::regex r_int = std::regex(R"([\+-]?\d+)", std::regex::icase);
-	return std::regex_match(str.cbegin(), str.cend(), r_int);
+	const auto dot = str.find('.');
+	if (dot == std::string_view::npos) return isUInt(str);
+
+	const auto integral = str.substr(0, dot);
+	const auto fraction = str.substr(dot + 1);
+	if (!integral.empty() && !isUInt(integral)) return false;
+	if (!fraction.empty() && !isUInt(fraction)) return false;
+	return !integral.empty() || !fraction.empty();
 }
 
 template <typename T>
@@ -45,42 +89,138 @@ constexpr std::string_view trim(std::string_view str, std::string_view whitespac
 	return str.substr(begin, end - begin + 1);
 }
 
+namespace detail
+{
+
+// Full-width marks replaced by ReplaceMark, all of them 3 byte UTF-8 sequences
+constexpr std::array<std::pair<std::string_view, char>, 12> MARK_LIST{{
+	{"﹟", '#'},
+	{"？", '?'},
+	{"＃", '#'},
+	{"！", '!'},
+	{"。", '.'},
+	{"，", ','},
+	{"“", '\"'},
+	{"”", '\"'},
+	{"‘", '\''},
+	{"’", '\''},
+	{"；", ';'},
+	{"：", ':'}
+}};
+
+// Two level lookup built from MARK_LIST: (lead byte, second byte) selects a row of 64 entries
+// indexed by the low bits of the third byte, 0 for no replacement
+struct MarkTable
+{
+	static constexpr std::size_t MAX_ROWS = 8;
+
+	std::array<std::uint8_t, 256> lead{};	// NOLINT(*-avoid-magic-numbers)
+	std::array<std::array<std::uint8_t, 64>, MAX_ROWS> second{};	// NOLINT(*-avoid-magic-numbers)
+	std::array<std::array<char, 64>, MAX_ROWS> rows{};	// NOLINT(*-avoid-magic-numbers)
+
+	constexpr MarkTable()
+	{
+		std::size_t leads = 0;
+		std::size_t used = 0;
+		for (const auto& [mark, replacement] : MARK_LIST)
+		{
+			const auto b1 = static_cast<std::uint8_t>(mark[0]);
+			const auto b2 = static_cast<std::uint8_t>(mark[1]);
+			const auto b3 = static_cast<std::uint8_t>(mark[2]);
+			if (this->lead.at(b1) == 0) this->lead.at(b1) = static_cast<std::uint8_t>(++leads);
+
+			auto& row = this->second.at(this->lead.at(b1) - 1).at(b2 & 0x3F);	// NOLINT(*-avoid-magic-numbers)
+			if (row == 0) row = static_cast<std::uint8_t>(++used);
+			this->rows.at(row - 1).at(b3 & 0x3F) = replacement;	// NOLINT(*-avoid-magic-numbers)
+		}
+	}
+
+	// data has at least 3 bytes available
+	constexpr char find(const char* data) const
+	{
+		const auto b1 = static_cast<std::uint8_t>(data[0]);
+		const auto b2 = static_cast<std::uint8_t>(data[1]);	// NOLINT(*-pointer-arithmetic)
+		const auto b3 = static_cast<std::uint8_t>(data[2]);	// NOLINT(*-pointer-arithmetic)
+		const std::uint8_t l = this->lead[b1];	// NOLINT(*-constant-array-index)
+		// Both trailing bytes have to be continuation bytes
+		if (l == 0 || (b2 & 0xC0) != 0x80 || (b3 & 0xC0) != 0x80) return 0;	// NOLINT(*-avoid-magic-numbers)
+		const std::uint8_t row = this->second[l - 1][b2 & 0x3F];	// NOLINT
+		return (row == 0) ? 0 : this->rows[row - 1][b3 & 0x3F];	// NOLINT
+	}
+};
+
+inline constexpr MarkTable MARK_TABLE{};
+
+// Every mark starts with one of these, anything else is copied as is
+constexpr std::array<char, 3> MARK_LEADS{'\xE2', '\xE3', '\xEF'};
+
+static_assert(std::all_of(MARK_LIST.begin(), MARK_LIST.end(),
+                          [](const auto& p)
+                          {
+                              return p.first.size() == 3
+                                     && std::find(MARK_LEADS.begin(), MARK_LEADS.end(), p.first[0]) != MARK_LEADS.end();
+                          }));
+
+// Offset of the first byte in [data, data + len) that may start a mark, len if there is none
+inline std::size_t FindMarkLead(const char* data, std::size_t len)
+{
+	std::size_t i = 0;
+#if defined(__AVX2__)
+	for (; i + 32 <= len; i += 32)	// NOLINT(*-avoid-magic-numbers)
+	{
+		const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));	// NOLINT
+		__m256i found = _mm256_setzero_si256();
+		for (char lead : MARK_LEADS)
+			found = _mm256_or_si256(found, _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(lead)));
+		const auto mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(found));
+		if (mask != 0) return i + std::countr_zero(mask);
+	}
+#endif
+#if defined(__SSE2__)
+	for (; i + 16 <= len; i += 16)	// NOLINT(*-avoid-magic-numbers)
+	{
+		const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));	// NOLINT
+		__m128i found = _mm_setzero_si128();
+		for (char lead : MARK_LEADS)
+			found = _mm_or_si128(found, _mm_cmpeq_epi8(chunk, _mm_set1_epi8(lead)));
+		const auto mask = static_cast<std::uint32_t>(_mm_movemask_epi8(found));
+		if (mask != 0) return i + std::countr_zero(mask);
+	}
+#endif
+	while (i < len && MARK_TABLE.lead[static_cast<std::uint8_t>(data[i])] == 0)	// NOLINT
+		i++;
+	return i;
+}
+
+} // namespace detail
+
+// Replaces full-width punctuation with its ASCII counterpart in a single in-place pass.
+// Matches at any byte offset, same as searching for each mark in turn
 inline std::string ReplaceMark(std::string str)
 {
-	using std::string_view;
-	using std::string;
-
-	constexpr std::array<std::pair<string_view, string_view>, 12> MarkList{{
-		{"﹟", "#"},
-		{"？", "?"},
-		{"＃", "#"},
-		{"！", "!"},
-		{"。", "."},
-		{"，", ","},
-		{"“", "\""},
-		{"”", "\""},
-		{"‘", "\'"},
-		{"’", "\'"},
-		{"；", ";"},
-		{"：", ":"}
-	}};
-	for (const auto& p : MarkList)
+	char* data = str.data();
+	const std::size_t len = str.size();
+	std::size_t read = 0;
+	std::size_t write = 0;
+	while (read < len)
 	{
-		string temp;
-		temp.reserve(str.size());
-		const auto end = str.end();
-		auto current = str.begin();
-		auto next = std::search(current, end, p.first.begin(), p.first.end());
-		while (next != end)
+		// Skip to the next possible mark, in large steps if SSE2/AVX2 is enabled
+		const std::size_t skip = detail::FindMarkLead(data + read, len - read);	// NOLINT(*-pointer-arithmetic)
+		if (write != read) std::memmove(data + write, data + read, skip);	// NOLINT(*-pointer-arithmetic)
+		read += skip;
+		write += skip;
+		if (read >= len) break;
+
+		const char replacement = (len - read >= 3) ? detail::MARK_TABLE.find(data + read) : 0;	// NOLINT
+		if (replacement != 0)
 		{
-			temp.append(current, next);
-			temp.append(p.second);
-			current = next + static_cast<long>(p.first.length());
-			next = std::search(current, end, p.first.begin(), p.first.end());
+			data[write++] = replacement;	// NOLINT(*-pointer-arithmetic)
+			read += 3;
 		}
-		temp.append(current, next);
-		str.swap(temp);
+		else
+			data[write++] = data[read++];	// NOLINT(*-pointer-arithmetic)
 	}
+	str.resize(write);
 	return str;
 }
 
@@ -111,23 +251,169 @@ constexpr bool toBool(std::string_view str)
 	throw UnknownInput(std::string(str));
 }
 
-inline size_t Tokenize(const std::string& input, std::vector<std::string>& tokens, size_t max_count = 0)
+// Whitespace as seen by operator>> in the classic locale
+constexpr bool isSpace(char c)
+{
+	return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+constexpr char toLowerAscii(char c)
 {
-	std::istringstream iss(input);
-	std::string s;
+	return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
 
+// Same as toLower(a) == toLower(b), without the copies
+constexpr bool iequals(std::string_view a, std::string_view b)
+{
+	if (a.size() != b.size()) return false;
+	for (std::size_t i = 0; i < a.size(); i++)
+		if (toLowerAscii(a[i]) != toLowerAscii(b[i])) return false;
+	return true;
+}
+
+namespace detail
+{
+
+// Scans the next token the way operator>>(std::quoted) does. For quoted tokens raw is the text
+// between the quotes with the escapes still in place. Returns false at the end of input, the token
+// after an unterminated quote is dropped as std::quoted fails the stream there
+constexpr bool NextToken(std::string_view& input, std::string_view& raw, bool& escaped)
+{
+	std::size_t pos = 0;
+	while (pos < input.size() && isSpace(input[pos]))
+		pos++;
+	escaped = false;
+	if (pos == input.size())
+	{
+		input = {};
+		return false;
+	}
+
+	if (input[pos] != '"')
+	{
+		std::size_t end = pos;
+		while (end < input.size() && !isSpace(input[end]))
+			end++;
+		raw = input.substr(pos, end - pos);
+		input.remove_prefix(end);
+		return true;
+	}
+
+	for (std::size_t end = pos + 1; end < input.size(); end++)
+	{
+		if (input[end] == '\\')
+		{
+			escaped = true;
+			end++;
+		}
+		else if (input[end] == '"')
+		{
+			raw = input.substr(pos + 1, end - pos - 1);
+			input.remove_prefix(end + 1);
+			return true;
+		}
+	}
+	input = {};
+	return false;
+}
+
+// raw as given by NextToken, never ends with a lone backslash
+template <typename OutputIt>
+constexpr OutputIt Unescape(std::string_view raw, OutputIt out)
+{
+	for (std::size_t i = 0; i < raw.size(); i++)
+	{
+		if (raw[i] == '\\') i++;
+		*out++ = raw[i];
+	}
+	return out;
+}
+
+} // namespace detail
+
+inline size_t Tokenize(std::string_view input, std::vector<std::string>& tokens, size_t max_count = 0)
+{
 	if (max_count > 0) tokens.reserve(max_count);
 
-	while (iss >> std::quoted(s))
+	std::string_view raw;
+	bool escaped{};
+	while (detail::NextToken(input, raw, escaped))
 	{
+		std::string s;
+		if (escaped)
+		{
+			s.reserve(raw.size());
+			detail::Unescape(raw, std::back_inserter(s));
+		}
+		else
+			s = raw;
+
 		if (max_count > 0 && tokens.size() >= max_count) tokens[max_count - 1] += ' ' + s;
 		else
-			tokens.push_back(s);
+			tokens.push_back(std::move(s));
 	}
 
 	return tokens.size();
 }
 
+// Allocation free counterpart of Tokenize for matching commands, with the same quoting rules.
+// Lives on the caller's stack: tokens are views into input, except quoted ones containing escapes,
+// which are unescaped into the inline buffer. Scanning stops after the first MaxTokens, so size()
+// is at most MaxTokens: use TokenList<2> to check for a command followed by arguments
+template <std::size_t MaxTokens, std::size_t BufferSize = 256>	// NOLINT(*-avoid-magic-numbers)
+class TokenList
+{
+protected:
+	std::array<std::string_view, MaxTokens> _tokens{};
+	std::array<char, BufferSize> _buffer{};
+	std::size_t _count = 0;
+	std::size_t _used = 0;
+	bool _exact = true;
+
+public:
+	constexpr explicit TokenList(std::string_view input)
+	{
+		std::string_view raw;
+		bool escaped{};
+		while (detail::NextToken(input, raw, escaped))
+		{
+			if (this->_count >= MaxTokens)
+			{
+				// One more token is enough to know the list is not complete
+				this->_exact = false;
+				return;
+			}
+			// Escaped tokens that do not fit are kept as is
+			if (escaped && raw.size() <= BufferSize - this->_used)
+			{
+				char* begin = this->_buffer.data() + this->_used;	// NOLINT(*-pointer-arithmetic)
+				char* end = detail::Unescape(raw, begin);
+				raw = {begin, static_cast<std::size_t>(end - begin)};
+				this->_used += raw.size();
+			}
+			else if (escaped)
+				this->_exact = false;
+			this->_tokens[this->_count++] = raw;	// NOLINT(*-constant-array-index)
+		}
+	}
+
+	// Number of stored tokens, at most MaxTokens
+	constexpr std::size_t size() const { return this->_count; }
+	constexpr bool empty() const { return this->_count == 0; }
+	// Whether the input has no further tokens and every token is unescaped, i.e. matches Tokenize
+	constexpr bool exact() const { return this->_exact; }
+
+	// Throws std::out_of_range past the stored tokens
+	constexpr std::string_view operator[](std::size_t i) const
+	{
+		if (i >= this->_count) throw std::out_of_range("Token index out of range");
+		return this->_tokens[i];	// NOLINT(*-constant-array-index)
+	}
+
+	constexpr auto begin() const { return this->_tokens.begin(); }
+	constexpr auto end() const { return this->_tokens.begin() + this->_count; }
+};
+
 } // namespace Utils
 
 #endif
\ No newline at end of file
@@ -0,0 +1,399 @@
+#include "Subprocess.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <Core/Utils/Logger.hpp>
+
+extern char** environ;	// NOLINT(*-avoid-non-const-global-variables)
+
+namespace Utils
+{
+
+namespace
+{
+
+std::string ErrorString(const std::string& what, int err = errno)
+{
+	return what + ": " + std::strerror(err);	// NOLINT(concurrency-mt-unsafe)
+}
+
+// Owns the spawn attributes for the duration of posix_spawnp
+struct SpawnConfig
+{
+	posix_spawn_file_actions_t actions{};
+	posix_spawnattr_t attr{};
+
+	SpawnConfig()
+	{
+		posix_spawn_file_actions_init(&this->actions);
+		posix_spawnattr_init(&this->attr);
+
+		// Threads of the bot may block signals and AsyncHttp ignores SIGPIPE,
+		// neither should leak into the child
+		sigset_t mask;
+		sigemptyset(&mask);
+		posix_spawnattr_setsigmask(&this->attr, &mask);
+		sigset_t def;
+		sigemptyset(&def);
+		sigaddset(&def, SIGPIPE);
+		posix_spawnattr_setsigdefault(&this->attr, &def);
+		posix_spawnattr_setflags(&this->attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+	}
+	SpawnConfig(const SpawnConfig&) = delete;
+	SpawnConfig& operator=(const SpawnConfig&) = delete;
+	SpawnConfig(SpawnConfig&&) = delete;
+	SpawnConfig& operator=(SpawnConfig&&) = delete;
+	~SpawnConfig()
+	{
+		posix_spawn_file_actions_destroy(&this->actions);
+		posix_spawnattr_destroy(&this->attr);
+	}
+};
+
+enum FrameType : std::uint8_t
+{
+	FRAME_DATA = 0,
+	FRAME_ERROR = 1
+};
+
+constexpr std::size_t FRAME_HEADER_SIZE = 5;
+
+void WriteFrame(Subprocess& process, FrameType type, std::string_view payload)
+{
+	std::string frame(FRAME_HEADER_SIZE, '\0');
+	frame[0] = static_cast<char>(type);
+	const auto len = static_cast<std::uint32_t>(payload.size());
+	for (int i = 0; i < 4; i++)
+		frame[4 - i] = static_cast<char>((len >> (8 * i)) & 0xFF);	// NOLINT(*-avoid-magic-numbers)
+	frame.append(payload);
+	process.write(frame);
+}
+
+void ReadExact(Subprocess& process, char* buffer, std::size_t len, WorkerPool::clock::time_point deadline)
+{
+	while (len > 0)
+	{
+		std::chrono::milliseconds timeout{};
+		if (deadline != WorkerPool::clock::time_point{})
+		{
+			timeout = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - WorkerPool::clock::now());
+			if (timeout <= std::chrono::milliseconds::zero()) throw SubprocessError("Worker timed out");
+		}
+		std::size_t count = process.read(buffer, len, timeout);
+		if (count == 0) throw SubprocessError("Worker closed the channel");
+		buffer += count;	// NOLINT(*-pointer-arithmetic)
+		len -= count;
+	}
+}
+
+std::pair<FrameType, std::string> ReadFrame(Subprocess& process, WorkerPool::clock::time_point deadline)
+{
+	unsigned char header[FRAME_HEADER_SIZE];	// NOLINT(*-avoid-c-arrays)
+	ReadExact(process, reinterpret_cast<char*>(header), FRAME_HEADER_SIZE, deadline);	// NOLINT(*-reinterpret-cast)
+
+	std::size_t len = 0;
+	for (int i = 1; i <= 4; i++)
+		len = (len << 8) | header[i];	// NOLINT(*-avoid-magic-numbers)
+	if (header[0] > FRAME_ERROR) throw SubprocessError("Invalid frame type " + std::to_string(header[0]));
+	if (len > WorkerPool::MAX_FRAME_SIZE) throw SubprocessError("Frame too large: " + std::to_string(len));
+
+	std::string payload(len, '\0');
+	ReadExact(process, payload.data(), len, deadline);
+	return {static_cast<FrameType>(header[0]), std::move(payload)};
+}
+
+} // namespace
+
+Subprocess::Subprocess(std::vector<std::string> cmd, Redirect redirect)
+{
+	if (cmd.empty()) throw SubprocessError("Empty command");
+
+	std::vector<char*> param(cmd.size() + 1);
+	std::transform(cmd.begin(), cmd.end(), param.begin(), [](std::string& str) { return str.data(); });
+	param.back() = nullptr;
+
+	// Both ends are close-on-exec, dup2 clears the flag on the child's copy
+	int fds[2] = {-1, -1};	// NOLINT(*-avoid-c-arrays)
+	if (redirect == Redirect::OUTPUT && pipe2(fds, O_CLOEXEC) == -1)
+		throw SubprocessError(ErrorString("Failed to open pipe"));
+	if (redirect == Redirect::DUPLEX && socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) == -1)
+		throw SubprocessError(ErrorString("Failed to open socket"));
+
+	int err{};
+	{
+		SpawnConfig config;
+		if (redirect == Redirect::OUTPUT)
+			posix_spawn_file_actions_adddup2(&config.actions, fds[1], STDOUT_FILENO);
+		if (redirect == Redirect::DUPLEX)
+		{
+			posix_spawn_file_actions_adddup2(&config.actions, fds[1], STDIN_FILENO);
+			posix_spawn_file_actions_adddup2(&config.actions, fds[1], STDOUT_FILENO);
+		}
+		err = posix_spawnp(&this->_pid, param[0], &config.actions, &config.attr, param.data(), environ);
+	}
+
+	if (redirect != Redirect::NONE) ::close(fds[1]);
+	if (err != 0)
+	{
+		// The destructor does not run for a throwing constructor
+		if (redirect != Redirect::NONE) ::close(fds[0]);
+		this->_pid = 0;
+		throw SubprocessError(ErrorString("Failed to execute " + cmd[0], err));
+	}
+	if (redirect != Redirect::NONE) this->_fd = fds[0];
+}
+
+Subprocess::Subprocess(Subprocess&& rhs) noexcept : _pid(rhs._pid), _fd(rhs._fd)
+{
+	rhs._pid = 0;
+	rhs._fd = -1;
+}
+
+Subprocess& Subprocess::operator=(Subprocess&& rhs) noexcept
+{
+	if (this == &rhs) return *this;
+	Subprocess discarded(std::move(*this));
+	this->_pid = rhs._pid;
+	this->_fd = rhs._fd;
+	rhs._pid = 0;
+	rhs._fd = -1;
+	return *this;
+}
+
+Subprocess::~Subprocess()
+{
+	this->CloseChannel();
+	if (this->_pid > 0)
+	{
+		this->kill();
+		while (waitpid(this->_pid, nullptr, 0) == -1 && errno == EINTR)
+			;
+	}
+}
+
+std::size_t Subprocess::read(char* buffer, std::size_t len, std::chrono::milliseconds timeout)
+{
+	if (timeout > std::chrono::milliseconds::zero())
+	{
+		pollfd pfd{this->_fd, POLLIN, 0};
+		int ready{};
+		while ((ready = poll(&pfd, 1, static_cast<int>(timeout.count()))) == -1 && errno == EINTR)
+			;
+		if (ready == -1) throw SubprocessError(ErrorString("Failed to poll"));
+		if (ready == 0) throw SubprocessError("Worker timed out");
+	}
+
+	ssize_t count{};
+	while ((count = ::read(this->_fd, buffer, len)) == -1 && errno == EINTR)
+		;
+	if (count == -1) throw SubprocessError(ErrorString("Failed to read from child"));
+	return count;
+}
+
+void Subprocess::write(std::string_view data)
+{
+	while (!data.empty())
+	{
+		// MSG_NOSIGNAL: a dead worker should fail the call, not raise SIGPIPE in the bot
+		ssize_t count = send(this->_fd, data.data(), data.size(), MSG_NOSIGNAL);
+		if (count == -1)
+		{
+			if (errno == EINTR) continue;
+			throw SubprocessError(ErrorString("Failed to write to child"));
+		}
+		data.remove_prefix(count);
+	}
+}
+
+std::string Subprocess::ReadAll()
+{
+	constexpr std::size_t CHUNK_SIZE = 64 * 1024;	// NOLINT(*-avoid-magic-numbers)
+	std::string result;
+	while (true)
+	{
+		const std::size_t size = result.size();
+		result.resize(size + CHUNK_SIZE);
+		const std::size_t count = this->read(result.data() + size, CHUNK_SIZE);	// NOLINT(*-pointer-arithmetic)
+		result.resize(size + count);
+		if (count == 0) return result;
+	}
+}
+
+void Subprocess::CloseChannel()
+{
+	if (this->_fd >= 0) ::close(this->_fd);
+	this->_fd = -1;
+}
+
+void Subprocess::kill(int sig) const
+{
+	if (this->_pid > 0) ::kill(this->_pid, sig);
+}
+
+int Subprocess::wait()
+{
+	if (this->_pid <= 0) return -1;
+	int status{};
+	pid_t pid{};
+	while ((pid = waitpid(this->_pid, &status, 0)) == -1 && errno == EINTR)
+		;
+	this->_pid = 0;
+	if (pid == -1) throw SubprocessError(ErrorString("Waitpid failed"));
+	return status;
+}
+
+std::string ExecCmd(std::vector<std::string> cmd, int& status)
+{
+	if (cmd.empty()) return {};
+	Subprocess process(std::move(cmd), Subprocess::Redirect::OUTPUT);
+	std::string result = process.ReadAll();
+	process.CloseChannel();
+	status = process.wait();
+	return result;
+}
+
+int ExecCmd(std::vector<std::string> cmd)
+{
+	if (cmd.empty()) return {};
+	Subprocess process(std::move(cmd), Subprocess::Redirect::NONE);
+	return process.wait();
+}
+
+WorkerPool::WorkerPool(std::vector<std::string> cmd, std::size_t size, std::chrono::seconds IdleTimeout)
+	: _cmd(std::move(cmd)), _size(std::max<std::size_t>(size, 1)), _IdleTimeout(IdleTimeout)
+{
+	if (this->_IdleTimeout > std::chrono::seconds::zero())
+		this->_reaper = std::thread([this] { this->_reap(); });
+}
+
+WorkerPool::~WorkerPool()
+{
+	std::vector<std::unique_ptr<Worker>> idle;
+	{
+		std::lock_guard<std::mutex> lk(this->_mtx);
+		this->_stop = true;
+		idle.swap(this->_idle);
+	}
+	this->_cv.notify_all();
+	if (this->_reaper.joinable()) this->_reaper.join();
+
+	// Workers exit once their stdin is closed
+	for (auto& worker : idle)
+		worker->process.CloseChannel();
+	for (auto& worker : idle)
+		(void)worker->process.wait();
+}
+
+void WorkerPool::_release(std::unique_ptr<Worker> worker)
+{
+	worker->LastUsed = clock::now();
+	{
+		std::lock_guard<std::mutex> lk(this->_mtx);
+		this->_idle.push_back(std::move(worker));
+	}
+	this->_cv.notify_all();
+}
+
+int WorkerPool::_discard(std::unique_ptr<Worker> worker)
+{
+	int status = -1;
+	if (worker)
+	{
+		worker->process.kill();
+		status = worker->process.wait();
+	}
+	{
+		std::lock_guard<std::mutex> lk(this->_mtx);
+		this->_workers--;
+	}
+	this->_cv.notify_all();
+	return status;
+}
+
+void WorkerPool::_reap()
+{
+	std::unique_lock<std::mutex> lk(this->_mtx);
+	while (!this->_stop)
+	{
+		this->_cv.wait_for(lk, this->_IdleTimeout / 2);
+		if (this->_stop) break;
+
+		// _idle is ordered by LastUsed
+		const auto threshold = clock::now() - this->_IdleTimeout;
+		auto it = std::find_if(this->_idle.begin(), this->_idle.end(),
+		                       [threshold](const auto& worker) { return worker->LastUsed > threshold; });
+		std::vector<std::unique_ptr<Worker>> expired(std::make_move_iterator(this->_idle.begin()),
+		                                             std::make_move_iterator(it));
+		if (expired.empty()) continue;
+		this->_idle.erase(this->_idle.begin(), it);
+		this->_workers -= expired.size();
+
+		lk.unlock();
+		this->_cv.notify_all();
+		for (auto& worker : expired)
+			worker->process.CloseChannel();
+		for (auto& worker : expired)
+			(void)worker->process.wait();
+		LOG_DEBUG(GetLogger(), "Stopped " + std::to_string(expired.size()) + " idle " + this->_cmd.front()
+		                           + " workers <WorkerPool>");
+		lk.lock();
+	}
+}
+
+std::string WorkerPool::call(std::string_view request, std::chrono::milliseconds timeout)
+{
+	std::unique_ptr<Worker> worker;
+	{
+		std::unique_lock<std::mutex> lk(this->_mtx);
+		this->_cv.wait(lk, [this] { return !this->_idle.empty() || this->_workers < this->_size; });
+		if (!this->_idle.empty())
+		{
+			worker = std::move(this->_idle.back());
+			this->_idle.pop_back();
+		}
+		else
+			this->_workers++;
+	}
+
+	std::pair<FrameType, std::string> reply;
+	try
+	{
+		if (!worker)
+		{
+			worker = std::make_unique<Worker>();
+			worker->process = Subprocess(this->_cmd, Subprocess::Redirect::DUPLEX);
+			LOG_DEBUG(GetLogger(), "Started " + this->_cmd.front() + " worker <" + std::to_string(worker->process.pid())
+			                           + "> <WorkerPool>");
+		}
+
+		const auto deadline = (timeout > std::chrono::milliseconds::zero()) ? clock::now() + timeout : clock::time_point{};
+		WriteFrame(worker->process, FRAME_DATA, request);
+		reply = ReadFrame(worker->process, deadline);
+	}
+	catch (const SubprocessError& e)
+	{
+		int status = this->_discard(std::move(worker));
+		throw SubprocessError(std::string(e.what()) + ", worker exited with status " + std::to_string(status));
+	}
+	catch (...)
+	{
+		(void)this->_discard(std::move(worker));
+		throw;
+	}
+
+	this->_release(std::move(worker));
+	if (reply.first == FRAME_ERROR) throw SubprocessError(reply.second);
+	return std::move(reply.second);
+}
+
+} // namespace Utils
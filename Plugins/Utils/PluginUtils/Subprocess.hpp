@@ -0,0 +1,123 @@
+#ifndef _UTILS_SUBPROCESS_HPP_
+#define _UTILS_SUBPROCESS_HPP_
+
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <sys/types.h>
+
+namespace Utils
+{
+
+class SubprocessError : public std::runtime_error
+{
+public:
+	using std::runtime_error::runtime_error;
+};
+
+// Child process started with posix_spawnp. Unlike fork() this does not copy the page tables of the
+// whole (large, multi-threaded) bot process. The child is killed and reaped on destruction if wait()
+// has not been called
+class Subprocess
+{
+public:
+	enum class Redirect : std::uint8_t
+	{
+		NONE,	// Inherit stdin and stdout
+		OUTPUT,	// Capture stdout
+		DUPLEX	// stdin and stdout are both connected to one socket
+	};
+
+protected:
+	pid_t _pid = 0;
+	int _fd = -1;
+
+public:
+	Subprocess() = default;
+	Subprocess(std::vector<std::string> cmd, Redirect redirect);
+	Subprocess(const Subprocess&) = delete;
+	Subprocess& operator=(const Subprocess&) = delete;
+	Subprocess(Subprocess&& rhs) noexcept;
+	Subprocess& operator=(Subprocess&& rhs) noexcept;
+	~Subprocess();
+
+	// Returns 0 at eof. A non-zero timeout throws SubprocessError if nothing arrives in time
+	std::size_t read(char* buffer, std::size_t len, std::chrono::milliseconds timeout = {});
+	void write(std::string_view data);
+	std::string ReadAll();
+
+	// The child sees eof on stdin
+	void CloseChannel();
+	void kill(int sig = SIGKILL) const;
+	// Returns the status from waitpid
+	int wait();
+
+	pid_t pid() const { return this->_pid; }
+};
+
+// Runs cmd and returns its stdout, the waitpid status is stored in status
+std::string ExecCmd(std::vector<std::string> cmd, int& status);
+
+// Runs cmd and returns the waitpid status
+int ExecCmd(std::vector<std::string> cmd);
+
+// Long-lived child processes answering framed requests on stdin/stdout, so the startup cost of the
+// command (e.g. a python interpreter importing PIL) is paid once instead of per call.
+// Frame: 1 byte type (0 data, 1 error), 4 byte big-endian length, payload.
+// Workers are started on demand, at most size at a time, and stopped after idling for IdleTimeout
+class WorkerPool
+{
+public:
+	using clock = std::chrono::steady_clock;
+
+	static constexpr std::size_t MAX_FRAME_SIZE = std::size_t(256) << 20;	// NOLINT(*-avoid-magic-numbers)
+
+protected:
+	struct Worker
+	{
+		Subprocess process;
+		clock::time_point LastUsed;
+	};
+
+	const std::vector<std::string> _cmd;
+	const std::size_t _size;
+	const std::chrono::seconds _IdleTimeout;
+
+	std::mutex _mtx;
+	std::condition_variable _cv;
+	std::vector<std::unique_ptr<Worker>> _idle;	// Most recently used last
+	std::size_t _workers = 0;	// Idle and busy
+	bool _stop = false;
+	std::thread _reaper;
+
+	void _release(std::unique_ptr<Worker> worker);
+	int _discard(std::unique_ptr<Worker> worker);
+	void _reap();
+
+public:
+	WorkerPool(std::vector<std::string> cmd, std::size_t size,
+	           std::chrono::seconds IdleTimeout = std::chrono::minutes(5));	// NOLINT(*-avoid-magic-numbers)
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+	WorkerPool(WorkerPool&&) = delete;
+	WorkerPool& operator=(WorkerPool&&) = delete;
+	~WorkerPool();
+
+	// Sends request to an idle worker and returns its reply. Throws SubprocessError with the message
+	// of an error frame, or if the worker died or missed the timeout (it is then replaced)
+	std::string call(std::string_view request, std::chrono::milliseconds timeout = {});
+};
+
+} // namespace Utils
+
+#endif
@@ -0,0 +1,124 @@
+#ifndef _UTILS_ZIP_READER_HPP_
+#define _UTILS_ZIP_READER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <zlib.h>
+
+namespace Utils
+{
+
+// Push parser for a zip archive that is still downloading, every entry is handed out once it is complete.
+// Only what ugoira archives use is supported: stored or deflated entries whose sizes are in the local header
+class ZipReader
+{
+public:
+	using EntryFunc = std::function<void(std::string name, std::string data)>;
+
+protected:
+	static constexpr uint32_t LOCAL_HEADER = 0x04034b50;
+	static constexpr uint32_t CENTRAL_HEADER = 0x02014b50;
+	static constexpr uint32_t END_OF_DIRECTORY = 0x06054b50;
+	static constexpr size_t LOCAL_HEADER_SIZE = 30;
+
+	EntryFunc _entry;
+	std::string _buffer;
+	bool _done = false;
+
+	static uint32_t _read(std::string_view data, size_t offset, size_t bytes)
+	{
+		uint32_t value = 0;
+		for (size_t i = 0; i < bytes; i++)
+			value |= static_cast<uint32_t>(static_cast<unsigned char>(data[offset + i])) << (8 * i);	// NOLINT(*-avoid-magic-numbers)
+		return value;
+	}
+
+	static std::string _inflate(std::string_view data, size_t size)
+	{
+		std::string result(size, '\0');
+		z_stream strm{};
+		// Raw deflate, zip entries have no zlib header
+		if (inflateInit2(&strm, -MAX_WBITS) != Z_OK)
+			throw std::runtime_error("inflateInit2 failed");
+		strm.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));	// NOLINT(*-reinterpret-cast, *-const-cast)
+		strm.avail_in = static_cast<uInt>(data.size());
+		strm.next_out = reinterpret_cast<Bytef*>(result.data());	// NOLINT(*-reinterpret-cast)
+		strm.avail_out = static_cast<uInt>(result.size());
+		int ret = inflate(&strm, Z_FINISH);
+		inflateEnd(&strm);
+		if (ret != Z_STREAM_END || strm.avail_out != 0)
+			throw std::runtime_error("Corrupted zip entry");
+		return result;
+	}
+
+	// Hands out the entry at the front of the buffer, false if it has not arrived completely
+	bool _parse()
+	{
+		// NOLINTBEGIN(*-avoid-magic-numbers)
+		if (this->_buffer.size() < 4) return false;
+		const uint32_t signature = _read(this->_buffer, 0, 4);
+		if (signature == CENTRAL_HEADER || signature == END_OF_DIRECTORY)
+		{
+			// Every entry is out, the directory only repeats them
+			this->_done = true;
+			this->_buffer.clear();
+			return false;
+		}
+		if (signature != LOCAL_HEADER)
+			throw std::runtime_error("Invalid zip entry");
+		if (this->_buffer.size() < LOCAL_HEADER_SIZE) return false;
+
+		const uint32_t flags = _read(this->_buffer, 6, 2);
+		const uint32_t method = _read(this->_buffer, 8, 2);
+		const uint32_t CompressedSize = _read(this->_buffer, 18, 4);
+		const uint32_t size = _read(this->_buffer, 22, 4);
+		const size_t NameLength = _read(this->_buffer, 26, 2);
+		const size_t ExtraLength = _read(this->_buffer, 28, 2);
+		// NOLINTEND(*-avoid-magic-numbers)
+		if (flags & 0x9)	// NOLINT(*-avoid-magic-numbers)
+			throw std::runtime_error("Encrypted zip entries or entries followed by a data descriptor are not supported");
+		if (CompressedSize == UINT32_MAX || size == UINT32_MAX)
+			throw std::runtime_error("Zip64 entries are not supported");
+
+		const size_t offset = LOCAL_HEADER_SIZE + NameLength + ExtraLength;
+		if (this->_buffer.size() < offset + CompressedSize) return false;
+
+		std::string name = this->_buffer.substr(LOCAL_HEADER_SIZE, NameLength);
+		std::string_view data = std::string_view(this->_buffer).substr(offset, CompressedSize);
+		std::string content;
+		if (method == 0)
+			content = data;
+		else if (method == Z_DEFLATED)
+			content = _inflate(data, size);
+		else
+			throw std::runtime_error("Unsupported zip compression method " + std::to_string(method));
+
+		this->_buffer.erase(0, offset + CompressedSize);
+		this->_entry(std::move(name), std::move(content));
+		return true;
+	}
+
+public:
+	explicit ZipReader(EntryFunc entry) : _entry(std::move(entry)) {}
+
+	// Throws on malformed archives, data after the entries is ignored
+	void feed(const char* data, size_t len)
+	{
+		if (this->_done) return;
+		this->_buffer.append(data, len);
+		while (!this->_done && this->_parse())
+			;
+	}
+
+	// Whether all entries have been handed out
+	bool done() const { return this->_done; }
+};
+
+} // namespace Utils
+
+#endif
@@ -1,24 +1,40 @@
-import sys
+import io, json, sys
 from .generator import genImage
 from PIL import Image
 import argparse
 
+def render(line1: str, line2: str, rupper: bool, rlower: bool) -> bytes:
+	image = genImage(
+		word_a=line1, 
+		word_b=line2, 
+		rainbow_upper=rupper,
+		rainbow_lower=rlower
+	)
+
+	image.resize((int(image.size[0] * 0.75), int(image.size[1] * 0.75)), Image.Resampling.LANCZOS)
+
+	output = io.BytesIO()
+	image.save(output, "jpeg")
+	return output.getvalue()
+
+def HandleRequest(request: bytes) -> bytes:
+	args = json.loads(request)
+	return render(args["upper"], args["lower"], args.get("rupper", False), args.get("rlower", False))
+
 parser = argparse.ArgumentParser()
 
-parser.add_argument("line1")
-parser.add_argument("line2")
+parser.add_argument("line1", nargs="?")
+parser.add_argument("line2", nargs="?")
 parser.add_argument("--rupper", action="store_true")
 parser.add_argument("--rlower", action="store_true")
+parser.add_argument("--serve", action="store_true", help="answer framed json requests on stdin, see worker.py")
 
 args = parser.parse_args()
 
-image = genImage(
-	word_a=args.line1, 
-	word_b=args.line2, 
-	rainbow_upper=args.rupper,
-	rainbow_lower=args.rlower
-)
-
-image.resize((int(image.size[0] * 0.75), int(image.size[1] * 0.75)), Image.Resampling.LANCZOS)
-
-image.save(sys.stdout.buffer, "jpeg")
\ No newline at end of file
+if args.serve:
+	from ..worker import serve
+	serve(HandleRequest)
+else:
+	if args.line1 is None or args.line2 is None:
+		parser.error("line1 and line2 are required")
+	sys.stdout.buffer.write(render(args.line1, args.line2, args.rupper, args.rlower))
@@ -1,15 +1,9 @@
-import os, pathlib
+import json, os, pathlib
 import UnityPy
 UnityPy.config.FALLBACK_UNITY_VERSION = "2020.3.32f1"
 
 from .extract import *
-
-def GetInput() -> str:
-	s = input()
-	if s == "exit":
-		print("exit")
-		exit(0)
-	return s
+from ..worker import serve
 
 def UnpackObj(key: str, prefix: str, file: str):
 	prefix = pathlib.Path(prefix)
@@ -34,29 +28,14 @@ def UnpackObj(key: str, prefix: str, file: str):
 			obj = obj.read()
 			export_func(obj, output_path)
 
-while True:
-	try:
-		s = ""
-		while s != "start":
-			s = GetInput()
-		key = GetInput()
-		prefix = GetInput()
-		file = GetInput()
-		end = GetInput()
-		if end != "finish":
-			raise Exception(message="Unexpected input: " + end)
-
-		BlockPrint()
-
-		UnpackObj(key, prefix, file)
+def HandleRequest(request: bytes) -> bytes:
+	args = json.loads(request)
 
+	BlockPrint()
+	try:
+		UnpackObj(args["key"], args["prefix"], args["file"])
+	finally:
 		EnablePrint()
-		print("ok")
-	
-	except Exception as e:
-		EnablePrint()
-		if hasattr(e, 'message'):
-			print("Exception occured", e.message)
-		else:
-			print("Exception occured", e)
+	return b"ok"
 
+serve(HandleRequest)
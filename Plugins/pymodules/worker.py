@@ -0,0 +1,40 @@
+import os, struct, sys
+
+# Framed request/response loop used by Utils::WorkerPool
+# Frame: 1 byte type (0 data, 1 error), 4 byte big-endian length, payload
+
+FRAME_DATA = 0
+FRAME_ERROR = 1
+_HEADER = struct.Struct(">BI")
+
+def _ReadExact(f, size: int) -> bytes:
+	data = f.read(size)
+	if len(data) != size:
+		raise EOFError()
+	return data
+
+def serve(handler):
+	"""Calls handler(request: bytes) -> bytes for every request until stdin is closed"""
+	channel_in = os.fdopen(os.dup(0), "rb")
+	channel_out = os.fdopen(os.dup(1), "wb")
+	# Stray output (including from C extensions) must not end up inside the frames
+	os.dup2(2, 1)
+	devnull = os.open(os.devnull, os.O_RDONLY)
+	os.dup2(devnull, 0)
+	os.close(devnull)
+
+	while True:
+		try:
+			_, size = _HEADER.unpack(_ReadExact(channel_in, _HEADER.size))
+			request = _ReadExact(channel_in, size)
+		except EOFError:
+			return
+
+		try:
+			response, type = handler(request), FRAME_DATA
+		except Exception as e:
+			response, type = str(e).encode("utf-8", "replace"), FRAME_ERROR
+
+		channel_out.write(_HEADER.pack(type, len(response)))
+		channel_out.write(response)
+		channel_out.flush()